@@ -0,0 +1,106 @@
+package com.prettysimple.audio;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * Batch of player commands applied with a single JNI call, the layout must match AudioCommand.h
+ */
+public class AudioCommandBuffer {
+
+    private static final int TYPE_PLAY = 1;
+    private static final int TYPE_STOP = 2;
+    private static final int TYPE_PAUSE = 3;
+    private static final int TYPE_RESUME = 4;
+    private static final int TYPE_SET_VOLUME = 5;
+    private static final int TYPE_SET_PARAMS = 6;
+    private static final int TYPE_SET_BUS_VOLUME = 7;
+    private static final int TYPE_PAUSE_BUS = 8;
+    private static final int TYPE_RESUME_BUS = 9;
+    private static final int TYPE_STOP_BUS = 10;
+
+    public AudioCommandBuffer(final int capacity) {
+        _buffer = ByteBuffer.allocateDirect(capacity).order(ByteOrder.nativeOrder());
+    }
+
+    public boolean play(final AudioPlayer player) {
+        return put(TYPE_PLAY, player.getPlayerId(), 0);
+    }
+
+    public boolean stop(final AudioPlayer player) {
+        return put(TYPE_STOP, player.getPlayerId(), 0);
+    }
+
+    public boolean pause(final AudioPlayer player) {
+        return put(TYPE_PAUSE, player.getPlayerId(), 0);
+    }
+
+    public boolean resume(final AudioPlayer player) {
+        return put(TYPE_RESUME, player.getPlayerId(), 0);
+    }
+
+    public boolean setVolume(final AudioPlayer player, final float volume) {
+        if (!put(TYPE_SET_VOLUME, player.getPlayerId(), 1)) {
+            return false;
+        }
+        _buffer.putFloat(volume);
+        return true;
+    }
+
+    public boolean setParams(final AudioPlayer player, final float pitch, final float pan, final float volume) {
+        if (!put(TYPE_SET_PARAMS, player.getPlayerId(), 3)) {
+            return false;
+        }
+        _buffer.putFloat(pitch);
+        _buffer.putFloat(pan);
+        _buffer.putFloat(volume);
+        return true;
+    }
+
+    /**
+     * The bus commands take the id of the bus in place of the audioId
+     */
+    public boolean setBusVolume(final int bus, final float volume) {
+        if (!put(TYPE_SET_BUS_VOLUME, bus, 1)) {
+            return false;
+        }
+        _buffer.putFloat(volume);
+        return true;
+    }
+
+    public boolean pauseBus(final int bus) {
+        return put(TYPE_PAUSE_BUS, bus, 0);
+    }
+
+    public boolean resumeBus(final int bus) {
+        return put(TYPE_RESUME_BUS, bus, 0);
+    }
+
+    public boolean stopBus(final int bus) {
+        return put(TYPE_STOP_BUS, bus, 0);
+    }
+
+    /**
+     * Send the pending commands to the engine and empty the buffer
+     * @return the number of commands queued for the engine command thread
+     */
+    public int submit() {
+        final int ret = AudioEngine.getInstance().submit(_buffer, _buffer.position());
+        _buffer.clear();
+        return ret;
+    }
+
+    /**
+     * Write the header of a command, return false if the buffer is full: submit() then retry
+     */
+    private boolean put(final int type, final int audioId, final int floats) {
+        if (_buffer.remaining() < 8 + floats * 4) {
+            return false;
+        }
+        _buffer.putInt(type);
+        _buffer.putInt(audioId);
+        return true;
+    }
+
+    private final ByteBuffer _buffer;
+}
@@ -1,9 +1,32 @@
 package com.prettysimple.audio;
 
+import android.content.Context;
 import android.content.res.AssetManager;
+import android.media.AudioManager;
+import android.os.Build;
+
+import java.nio.ByteBuffer;
 
 public class AudioEngine {
 
+    /**
+     * Latency stages of getLatencyStats
+     */
+    public static final int LATENCY_CREATE = 0; // create request to the player ready
+    public static final int LATENCY_REALIZE = 1; // CreateAudioPlayer and Realize of an OpenSL player
+    public static final int LATENCY_PREFETCH = 2; // init of a streamed asset player to its prefetch sufficient
+    public static final int LATENCY_START = 3; // play request to the player playing
+    public static final int LATENCY_SOUND = 4; // play request to the first head movement: the trigger to sound latency
+
+    /**
+     * Built-in buses, music, sfx, voice and UI are children of the master bus
+     */
+    public static final int BUS_MASTER = 0;
+    public static final int BUS_MUSIC = 1;
+    public static final int BUS_SFX = 2;
+    public static final int BUS_VOICE = 3;
+    public static final int BUS_UI = 4;
+
     private static AudioEngine instance = null;
 
     public static AudioEngine getInstance() {
@@ -13,14 +36,224 @@ public class AudioEngine {
         return instance;
     }
 
+    /**
+     * stopAll, pauseAll and resumeAll run on the engine command thread after the commands already queued
+     * @return true once queued
+     */
     public native boolean stopAll();
 
     public native boolean pauseAll();
 
     public native boolean resumeAll();
 
+    public boolean playOneShot(final String path, final float volume, final float pan, final float pitch) {
+        return playOneShot(path, volume, pan, pitch, 0, BUS_MASTER);
+    }
+
+    /**
+     * Play a sound once without any AudioPlayer: a single call, nothing to keep and nothing left for the garbage collector
+     * The engine owns the sound until it ends, only its bus can pause or stop it before
+     * pan goes from -1 (left) to 1 (right), pitch is a playback rate clamped to [0.5, 2]
+     * @return true once queued, false if the bus is unknown or the engine can't take one more sound
+     */
+    public native boolean playOneShot(final String path, final float volume, final float pan, final float pitch, final int priority, final int bus);
+
+    /**
+     * Create a bus under parent for the next sounds, a name already in use returns its bus
+     * @return the id of the bus, -1 if there are already 32 buses or the parent is unknown
+     */
+    public native int createBus(final String name, final int parent);
+
+    /**
+     * @return the id of the bus of this name, -1 if there is none
+     */
+    public native int findBus(final String name);
+
+    /**
+     * The bus calls act on the bus and on its descendants with a single command, whatever the number of sounds on them
+     * The gain of a bus (0 -> 1) multiplies the volume of its sounds, e.g. to duck the music under a dialog
+     * @return true once queued
+     */
+    public native boolean setBusVolume(final int bus, final float volume);
+
+    /**
+     * The sounds played on a paused bus wait for resumeBus
+     */
+    public native boolean pauseBus(final int bus);
+
+    public native boolean resumeBus(final int bus);
+
+    public native boolean stopBus(final int bus);
+
     public native void setAssetManager(final AssetManager assetManager);
 
+    /**
+     * Native sample rate and burst size of the device output, to call before the first sound
+     * The decoded sounds are converted to this rate and the buffers sized in bursts so they can get a fast track
+     */
+    public native void setOutputConfig(final int sampleRate, final int framesPerBurst);
+
+    /**
+     * Pass the output config of the AudioManager, nothing is known before API 17
+     */
+    public void setOutputConfig(final Context context) {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.JELLY_BEAN_MR1) {
+            final AudioManager audioManager = (AudioManager) context.getSystemService(Context.AUDIO_SERVICE);
+            final int sampleRate = parseProperty(audioManager.getProperty(AudioManager.PROPERTY_OUTPUT_SAMPLE_RATE));
+            final int framesPerBurst = parseProperty(audioManager.getProperty(AudioManager.PROPERTY_OUTPUT_FRAMES_PER_BUFFER));
+            setOutputConfig(sampleRate, framesPerBurst);
+        }
+    }
+
+    private static int parseProperty(final String value) {
+        try {
+            return value != null ? Integer.parseInt(value) : 0;
+        } catch (NumberFormatException e) {
+            return 0;
+        }
+    }
+
+    /**
+     * Queue the size first bytes of a direct buffer written by AudioCommandBuffer in a single JNI call
+     * @return the number of commands queued, -1 if the buffer isn't direct
+     */
+    public native int submit(final ByteBuffer buffer, final int size);
+
+    /**
+     * @return [reclaimed players, total reclaim latency (ns), max reclaim latency (ns)]
+     */
+    public native long[] getReclaimStats();
+
+    /**
+     * Number of sounds allowed to hold an OpenSL player at the same time, the others are virtual
+     */
+    public native void setMaxRealVoices(final int count);
+
+    /**
+     * @return [real voices, virtual voices, stolen, promoted, culled]
+     */
+    public native long[] getVoiceStats();
+
+    /**
+     * Number of finished players kept realized to skip CreateAudioPlayer/Realize on the next play of the same path
+     */
+    public native void setPlayerPoolSize(final int size);
+
+    /**
+     * @return [hits, misses, evictions, idle players]
+     */
+    public native long[] getPlayerPoolStats();
+
+    /**
+     * Assets up to this compressed size (bytes) are decoded once and played from memory
+     */
+    public native void setSampleCacheThreshold(final int bytes);
+
+    public native void setSampleCacheCapacity(final int bytes);
+
+    /**
+     * @return [hits, misses, evictions, decoded bytes, samples]
+     */
+    public native long[] getSampleCacheStats();
+
+    /**
+     * Number of asset file descriptors kept open for the next plays once no player uses them
+     */
+    public native void setAssetCacheCapacity(final int count);
+
+    /**
+     * @return [hits, misses, evictions, open fds, cached descriptors]
+     */
+    public native long[] getAssetCacheStats();
+
+    /**
+     * Map a sound bank built by the asset conditioner, its sounds play from memory without being decoded
+     * The bank must be stored uncompressed in the APK (aaptOptions noCompress)
+     * @return false if the bank can't be opened or is not valid
+     */
+    public native boolean loadSoundBank(final String path);
+
+    /**
+     * The bank stays mapped until its last playing sound ends
+     */
+    public native boolean unloadSoundBank(final String path);
+
+    /**
+     * @return [banks, sounds, mapped bytes, hits]
+     */
+    public native long[] getSoundBankStats();
+
+    /**
+     * Mix the decoded samples in software through a single OpenSL player instead of one player per sound
+     */
+    public native boolean setMixerEnabled(final boolean enabled);
+
+    /**
+     * @return [renders, playing voices, total render time (ns), max render time (ns)]
+     */
+    public native long[] getMixerStats();
+
+    /**
+     * Assets from this compressed size (bytes) are decoded progressively by a streaming voice, 0 disables streaming
+     */
+    public native void setStreamingThreshold(final int bytes);
+
+    /**
+     * Ring size of the next streams and the fill level under which their decoder restarts, both in frames
+     */
+    public native void setStreamingBuffer(final int ringFrames, final int lowWatermarkFrames);
+
+    /**
+     * @return [underruns, underrun frames, refills, active streams]
+     */
+    public native long[] getStreamingStats();
+
+    /**
+     * Engine metrics, all zero but the polled gauges when the library is built with AUDIO_METRICS=0
+     * Counters: [players created, players destroyed, failed sounds, CreateAudioPlayer fails, Realize fails, GetInterface fails, configure fails, prefetch fails, stolen, reclaimed]
+     * Gauges: [live players, open fds, decoded bytes cached]
+     * Timers, 4 values each: [count, waits, total wait (ns), max wait (ns)] of the voices, gc, commands, banks and OpenSL locks then of the GC sweeps
+     * @return the counters, the gauges then the timers in a single array
+     */
+    public native long[] getStats();
+
+    /**
+     * Disabled, the commands run on the caller thread like before the command thread: only useful to compare the caller latency
+     */
+    public native void setCommandThreadEnabled(final boolean enabled);
+
+    /**
+     * stale counts the failed commands of sounds already gone, e.g. the stop of a sound that ended by itself
+     * @return [queued, succeeded, failed, dropped, calls, total caller time (ns), max caller time (ns), total queue time (ns), max queue time (ns), stale]
+     */
+    public native long[] getCommandStats();
+
+    /**
+     * The volume, pan and pitch changes only keep the latest value of each sound, the engine applies them every 10 ms with a 50 ms ramp
+     * @return [writes, ticks, voice updates]: far less updates than writes when a game sets a fade on every frame
+     */
+    public native long[] getParamsStats();
+
+    /**
+     * Percentiles of one of the LATENCY_ stages since the start or the last reset, about 12% precision
+     * @return [count, p50 (ns), p95 (ns), p99 (ns), max (ns)], null for an unknown stage
+     */
+    public native long[] getLatencyStats(final int stage);
+
+    public native void resetLatencyStats();
+
+    /**
+     * Warm the paths on background threads before their first play: decoded samples, prefetched players and durations
+     * The listener can be null
+     * @return the id of the batch given to the listener, -1 if the engine is destroyed
+     */
+    public native int preload(final String[] paths, final AudioPreloadListener listener);
+
+    /**
+     * Release what preload kept for the paths, the sounds still playing them are not affected
+     */
+    public native void unload(final String[] paths);
+
     static {
         System.loadLibrary("audio");
     }
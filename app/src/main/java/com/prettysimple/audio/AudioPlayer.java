@@ -6,17 +6,81 @@ public class AudioPlayer {
         _audioId = -1;
     }
 
-    public native boolean init(final String path, final float volume, final boolean loop);
-    public native boolean stop();
-    public native boolean play();
-    public native boolean pause();
-    public native boolean resume();
-    public native boolean setParams(final float pitch, final float pan, final float volume);
-    public native boolean setVolume(final float volume);
+    public boolean init(final String path, final float volume, final boolean loop) {
+        return init(path, volume, loop, 0);
+    }
+
+    public boolean init(final String path, final float volume, final boolean loop, final int priority) {
+        return init(path, volume, loop, priority, AudioEngine.BUS_MASTER);
+    }
+
+    /**
+     * Once the real voice budget of the engine is reached, a sound with a higher priority steals the player of a lower one
+     * The sound stays on its bus (AudioEngine.BUS_ or createBus) until it ends, the gain of the bus scales its volume
+     * The player is created later by the engine command thread, the call never waits on OpenSL
+     */
+    public boolean init(final String path, final float volume, final boolean loop, final int priority, final int bus) {
+        if (_audioId < 0) {
+            _audioId = nativeInit(path, volume, loop, priority, bus);
+            return _audioId >= 0;
+        }
+        return false;
+    }
+
+    public boolean stop() {
+        if (nativeStop(_audioId)) {
+            _audioId = -1;
+            return true;
+        }
+        return false;
+    }
+
+    public boolean play() {
+        return nativePlay(_audioId);
+    }
+
+    public boolean pause() {
+        return nativePause(_audioId);
+    }
+
+    public boolean resume() {
+        return nativeResume(_audioId);
+    }
+
+    /**
+     * pitch is a playback rate clamped to [0.5, 2], it is ignored if the device can't change the rate of this sound
+     */
+    public boolean setParams(final float pitch, final float pan, final float volume) {
+        return nativeSetParams(_audioId, pitch, pan, volume);
+    }
+
+    public boolean setVolume(final float volume) {
+        return nativeSetVolume(_audioId, volume);
+    }
 
     public int getPlayerId() {
         return _audioId;
     }
 
+    /**
+     * @return true while the sound plays through a low latency fast track, false until the engine created its player
+     */
+    public boolean isFastPath() {
+        return nativeIsFastPath(_audioId);
+    }
+
+    /**
+     * The natives only take the audioId: the engine never keeps a reference on this object
+     * They queue the command and return true once queued, a stale audioId is ignored by the command thread
+     */
+    private static native int nativeInit(final String path, final float volume, final boolean loop, final int priority, final int bus);
+    private static native boolean nativeStop(final int audioId);
+    private static native boolean nativePlay(final int audioId);
+    private static native boolean nativePause(final int audioId);
+    private static native boolean nativeResume(final int audioId);
+    private static native boolean nativeSetParams(final int audioId, final float pitch, final float pan, final float volume);
+    private static native boolean nativeSetVolume(final int audioId, final float volume);
+    private static native boolean nativeIsFastPath(final int audioId);
+
     private int _audioId;
 }
@@ -0,0 +1,17 @@
+package com.prettysimple.audio;
+
+/**
+ * Progress of AudioEngine.preload, called from the preload threads of the engine and never from the UI thread
+ */
+public interface AudioPreloadListener {
+
+    /**
+     * Can be called by several threads at once
+     */
+    void onPathLoaded(final int batchId, final String path, final boolean loaded);
+
+    /**
+     * Last call for this batch, after every onPathLoaded of the batch
+     */
+    void onBatchLoaded(final int batchId, final int loaded, final int failed);
+}
@@ -29,6 +29,7 @@ public class MainActivity extends AppCompatActivity implements View.OnClickListe
 
         _players = new Vector<>();
 
+        AudioEngine.getInstance().setOutputConfig(this);
         AudioEngine.getInstance().setAssetManager(getAssets());
 
         _btnPlay = (Button)findViewById(R.id.bt_play);
@@ -0,0 +1,148 @@
+#include "AudioAssetCache.h"
+#include "AudioUtils.h"
+#include <unistd.h>
+
+using namespace audio;
+
+AudioAssetCache::AudioAssetCache() : _capacity(DEFAULT_CAPACITY)
+, _clock(0)
+, _hits(0)
+, _misses(0)
+, _evictions(0)
+, _openFds(0)
+{
+}
+
+AudioAssetCache::~AudioAssetCache()
+{
+    clear();
+}
+
+/**
+ * Return the descriptor of an asset of the APK, opening it on the first call
+ * Return nullptr for an absolute path or an asset that can't be opened as fd (compressed in the APK)
+ */
+std::shared_ptr<AudioAsset> AudioAssetCache::acquire(const std::string &fileFullPath, AAssetManager *assetManager) noexcept
+{
+    if (fileFullPath.empty() || fileFullPath[0] == '/' || assetManager == nullptr)
+    {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto &it = _assets.find(fileFullPath);
+        if (it != _assets.end())
+        {
+            it->second.lastUse = ++_clock;
+            ++_hits;
+            return it->second.asset;
+        }
+        ++_misses;
+    }
+
+    std::shared_ptr<AudioAsset> asset = open(fileFullPath, assetManager); // The syscalls run outside of the lock
+    if (asset == nullptr)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto &it = _assets.find(fileFullPath);
+    if (it != _assets.end()) // Opened by another thread in the meantime, our fd is closed on return
+    {
+        it->second.lastUse = ++_clock;
+        return it->second.asset;
+    }
+    _assets[fileFullPath] = {asset, ++_clock};
+    evict();
+    return asset;
+}
+
+/**
+ * Open the fd of an asset, the deleter closes it
+ */
+std::shared_ptr<AudioAsset> AudioAssetCache::open(const std::string &fileFullPath, AAssetManager *assetManager) noexcept
+{
+    AAsset *asset = AAssetManager_open(assetManager, assetRelativePath(fileFullPath).c_str(), AASSET_MODE_UNKNOWN);
+    if (asset == nullptr)
+    {
+        LOGEX("AAssetManager_open fail");
+        return nullptr;
+    }
+    off64_t start = 0, length = 0;
+    const int fd = AAsset_openFileDescriptor64(asset, &start, &length);
+    AAsset_close(asset);
+    if (fd <= 0)
+    {
+        LOGEX("AAsset_openFileDescriptor64 fail");
+        return nullptr;
+    }
+
+    ++_openFds;
+    return std::shared_ptr<AudioAsset>(new AudioAsset{fd, start, length}, [this](AudioAsset *asset)
+    {
+        close(asset->fd);
+        --_openFds;
+        delete asset;
+    });
+}
+
+/**
+ * Drop the least recently used descriptors no player holds until the cache fits its capacity, _mutex must be held
+ * Note: The dropped fds are closed right away as the cache held their last reference
+ */
+void AudioAssetCache::evict() noexcept
+{
+    while (_assets.size() > _capacity)
+    {
+        auto oldest = _assets.end();
+        for (auto it = _assets.begin(); it != _assets.end(); ++it)
+        {
+            if (it->second.asset.use_count() == 1 && (oldest == _assets.end() || it->second.lastUse < oldest->second.lastUse))
+            {
+                oldest = it;
+            }
+        }
+        if (oldest == _assets.end()) // Every descriptor is in use, the cache shrinks on a later insertion
+        {
+            break;
+        }
+        _assets.erase(oldest);
+        ++_evictions;
+    }
+}
+
+/**
+ * Forget the descriptor of a path, the players holding it keep it open
+ */
+bool AudioAssetCache::remove(const std::string &fileFullPath) noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _assets.erase(fileFullPath) > 0;
+}
+
+void AudioAssetCache::setCapacity(const size_t capacity) noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _capacity = capacity;
+    evict();
+}
+
+void AudioAssetCache::clear() noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _assets.clear();
+}
+
+AudioAssetCache::Stats AudioAssetCache::getStats() const noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Stats stats;
+    stats.hits = _hits;
+    stats.misses = _misses;
+    stats.evictions = _evictions;
+    stats.openFds = _openFds.load(std::memory_order_relaxed);
+    stats.cached = _assets.size();
+    return stats;
+}
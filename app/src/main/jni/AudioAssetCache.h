@@ -0,0 +1,95 @@
+#ifndef __AudioAssetCache__
+#define __AudioAssetCache__
+
+#include <android/asset_manager.h>
+#include <sys/types.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace audio
+{
+    /**
+     * File descriptor of an APK asset with the range of the asset in the file
+     * Shared by all the players of the path, the fd is closed when the last reference goes away
+     */
+    struct AudioAsset
+    {
+        int fd;
+        off64_t start;
+        off64_t length;
+    };
+
+    /**
+     * Path keyed cache of the asset descriptors, a hit skips AAssetManager_open/AAsset_openFileDescriptor64 and costs no fd
+     * Only the descriptors that no player holds anymore are evicted, the least recently used first
+     * Note: The cache must outlive the assets it handed out, they count its open fds
+     */
+    class AudioAssetCache
+    {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 32; // descriptors
+
+        struct Stats
+        {
+            uint64_t hits;
+            uint64_t misses;
+            uint64_t evictions;
+            size_t openFds; // cached or still held by a player
+            size_t cached;
+        };
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr<AudioAsset> asset;
+            uint64_t lastUse;
+        };
+
+    public:
+        AudioAssetCache();
+
+        AudioAssetCache(const AudioAssetCache &) = delete;
+
+        AudioAssetCache &operator=(const AudioAssetCache &) & = delete;
+
+        AudioAssetCache(AudioAssetCache &&) = delete;
+
+        AudioAssetCache &operator=(AudioAssetCache &&) & = delete;
+
+        ~AudioAssetCache();
+
+    public:
+        std::shared_ptr<AudioAsset> acquire(const std::string &fileFullPath, AAssetManager *assetManager) noexcept;
+
+        bool remove(const std::string &fileFullPath) noexcept;
+
+        void setCapacity(const size_t capacity) noexcept;
+
+        void clear() noexcept;
+
+        Stats getStats() const noexcept;
+
+    private:
+        std::shared_ptr<AudioAsset> open(const std::string &fileFullPath, AAssetManager *assetManager) noexcept;
+
+        void evict() noexcept;
+
+    private:
+        mutable std::mutex _mutex;
+        std::unordered_map<std::string, Entry> _assets;
+        size_t _capacity;
+        uint64_t _clock;
+
+        uint64_t _hits;
+        uint64_t _misses;
+        uint64_t _evictions;
+        std::atomic<size_t> _openFds;
+    };
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef __AudioBackend__
+#define __AudioBackend__
+
+#include <SLES/OpenSLES.h>
+#include <SLES/OpenSLES_Android.h>
+#include <android/asset_manager.h>
+#include <jni.h>
+
+namespace audio
+{
+    /**
+     * Platform under the AudioEngine: it creates the OpenSL engine object and gives access to the assets
+     * Everything else (output mix, players, play state, volume, buffer queues and callbacks) goes through the interfaces of this engine object,
+     * so a backend replaces the whole OpenSL implementation: AudioOpenSLBackend on a device, AudioHostBackend on a Linux host
+     */
+    class AudioBackend
+    {
+    public:
+        AudioBackend() = default;
+
+        AudioBackend(const AudioBackend &) = delete;
+
+        AudioBackend &operator=(const AudioBackend &) & = delete;
+
+        AudioBackend(AudioBackend &&) = delete;
+
+        AudioBackend &operator=(AudioBackend &&) & = delete;
+
+        virtual ~AudioBackend() = default;
+
+    public:
+        /**
+         * Create the engine object like slCreateEngine with SL_ENGINEOPTION_THREADSAFE, the AudioEngine realizes it
+         */
+        virtual SLresult createEngine(SLObjectItf *engineObject) noexcept = 0;
+
+        /**
+         * Return nullptr while the assets are unknown
+         */
+        virtual AAssetManager *getAssetManager() const noexcept = 0;
+
+        /**
+         * AssetManager given by the Java side, ignored by a backend that doesn't run in a JVM
+         */
+        virtual void setAssetManager(const jobject assetManager) noexcept
+        {
+        }
+
+        virtual const char *getName() const noexcept = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,144 @@
+#include "AudioBusTable.h"
+
+using namespace audio;
+
+AudioBusTable::AudioBusTable() : _count(0)
+{
+    add("master", -1);
+    add("music", BUS_MASTER);
+    add("sfx", BUS_MASTER);
+    add("voice", BUS_MASTER);
+    add("ui", BUS_MASTER);
+}
+
+AudioBusTable::~AudioBusTable()
+{
+}
+
+/**
+ * Create a user bus under parent, return its id or -1 if the table is full or the parent unknown
+ * A name already in use returns the bus it names, whatever its parent
+ */
+int AudioBusTable::create(const std::string &name, const int parent) noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (int bus = 0, count = _count.load(std::memory_order_relaxed); bus < count; ++bus)
+    {
+        if (_buses[bus].name == name)
+        {
+            return bus;
+        }
+    }
+    return name.empty() || !isValid(parent) ? -1 : add(name, parent);
+}
+
+/**
+ * Append a bus, _mutex must be held except in the constructor
+ */
+int AudioBusTable::add(const std::string &name, const int parent) noexcept
+{
+    const int ret = _count.load(std::memory_order_relaxed);
+    if (ret >= CAPACITY)
+    {
+        return -1;
+    }
+    Bus &bus = _buses[ret];
+    bus.name = name;
+    bus.parent = parent;
+    bus.gain.store(1.f, std::memory_order_relaxed);
+    bus.paused.store(false, std::memory_order_relaxed);
+    _count.store(ret + 1, std::memory_order_release); // Publishes the name and the parent to the lock-free readers
+    return ret;
+}
+
+/**
+ * Id of the bus of this name, -1 if there is none
+ */
+int AudioBusTable::find(const std::string &name) const noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (int bus = 0, count = _count.load(std::memory_order_relaxed); bus < count; ++bus)
+    {
+        if (_buses[bus].name == name)
+        {
+            return bus;
+        }
+    }
+    return -1;
+}
+
+bool AudioBusTable::isValid(const int bus) const noexcept
+{
+    return bus >= 0 && bus < _count.load(std::memory_order_acquire);
+}
+
+/**
+ * Gain of the bus itself (0 -> 1), its players get the product of the gains up to the master
+ */
+bool AudioBusTable::setGain(const int bus, const float gain) noexcept
+{
+    if (!isValid(bus))
+    {
+        return false;
+    }
+    _buses[bus].gain.store(gain < 0.f ? 0.f : (gain > 1.f ? 1.f : gain), std::memory_order_relaxed);
+    return true;
+}
+
+float AudioBusTable::getGain(const int bus) const noexcept
+{
+    return isValid(bus) ? _buses[bus].gain.load(std::memory_order_relaxed) : 1.f;
+}
+
+/**
+ * Product of the gains of the bus and of its ancestors, the gain applied on top of the volume of its players
+ */
+float AudioBusTable::getEffectiveGain(const int bus) const noexcept
+{
+    float ret = 1.f;
+    for (int current = isValid(bus) ? bus : -1; current >= 0; current = _buses[current].parent)
+    {
+        ret *= _buses[current].gain.load(std::memory_order_relaxed);
+    }
+    return ret;
+}
+
+bool AudioBusTable::setPaused(const int bus, const bool paused) noexcept
+{
+    if (!isValid(bus))
+    {
+        return false;
+    }
+    _buses[bus].paused.store(paused, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * Whether the bus or one of its ancestors is paused: its players are held paused
+ */
+bool AudioBusTable::isPaused(const int bus) const noexcept
+{
+    for (int current = isValid(bus) ? bus : -1; current >= 0; current = _buses[current].parent)
+    {
+        if (_buses[current].paused.load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Whether bus is ancestor or one of its descendants
+ */
+bool AudioBusTable::contains(const int ancestor, const int bus) const noexcept
+{
+    for (int current = isValid(bus) ? bus : -1; current >= 0; current = _buses[current].parent)
+    {
+        if (current == ancestor)
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,82 @@
+#ifndef __AudioBusTable__
+#define __AudioBusTable__
+
+#include <atomic>
+#include <string>
+#include <mutex>
+#include <cstddef>
+
+namespace audio
+{
+    /**
+     * Hierarchy of the mix buses a player is attached to at its creation, the master bus is the root of all of them
+     * A bus only holds a gain and a pause flag: its effective gain is the product of the gains up to the master
+     * A bus is never destroyed and its parent is created before it, so the reads walk the chain without any lock
+     */
+    class AudioBusTable
+    {
+    public:
+        enum Builtin
+        {
+            BUS_MASTER = 0,
+            BUS_MUSIC,
+            BUS_SFX,
+            BUS_VOICE,
+            BUS_UI,
+            BUILTIN_COUNT
+        };
+
+        static constexpr int CAPACITY = 32;
+
+    private:
+        struct Bus
+        {
+            std::string name; // written once before the bus is counted in _count
+            int parent; // -1 for the master bus
+            std::atomic<float> gain;
+            std::atomic<bool> paused;
+        };
+
+    public:
+        AudioBusTable();
+
+        AudioBusTable(const AudioBusTable &) = delete;
+
+        AudioBusTable &operator=(const AudioBusTable &) & = delete;
+
+        AudioBusTable(AudioBusTable &&) = delete;
+
+        AudioBusTable &operator=(AudioBusTable &&) & = delete;
+
+        ~AudioBusTable();
+
+    public:
+        int create(const std::string &name, const int parent) noexcept;
+
+        int find(const std::string &name) const noexcept;
+
+        bool isValid(const int bus) const noexcept;
+
+        bool setGain(const int bus, const float gain) noexcept;
+
+        float getGain(const int bus) const noexcept;
+
+        float getEffectiveGain(const int bus) const noexcept;
+
+        bool setPaused(const int bus, const bool paused) noexcept;
+
+        bool isPaused(const int bus) const noexcept;
+
+        bool contains(const int ancestor, const int bus) const noexcept;
+
+    private:
+        int add(const std::string &name, const int parent) noexcept;
+
+    private:
+        mutable std::mutex _mutex; // serializes the creations and the lookups by name
+        Bus _buses[CAPACITY];
+        std::atomic<int> _count;
+    };
+}
+
+#endif
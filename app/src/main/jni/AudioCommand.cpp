@@ -0,0 +1,65 @@
+#include "AudioCommand.h"
+#include <cstring>
+
+using namespace audio;
+
+AudioCommand AudioCommand::make(const int32_t type, const int32_t audioId, const float arg0, const float arg1, const float arg2) noexcept
+{
+    AudioCommand ret;
+    ret.type = type;
+    ret.audioId = audioId;
+    ret.args[0] = arg0;
+    ret.args[1] = arg1;
+    ret.args[2] = arg2;
+    return ret;
+}
+
+/**
+ * Size in bytes of a command of this type in the stream, 0 for an unknown or engine only type
+ */
+size_t AudioCommand::getSize(const int32_t type) noexcept
+{
+    size_t ret = 0;
+    switch (type)
+    {
+        case TYPE_PLAY:
+        case TYPE_STOP:
+        case TYPE_PAUSE:
+        case TYPE_RESUME:
+        case TYPE_PAUSE_BUS:
+        case TYPE_RESUME_BUS:
+        case TYPE_STOP_BUS:
+            ret = 2 * sizeof(int32_t);
+            break;
+        case TYPE_SET_VOLUME:
+        case TYPE_SET_BUS_VOLUME:
+            ret = 2 * sizeof(int32_t) + sizeof(float);
+            break;
+        case TYPE_SET_PARAMS:
+            ret = 2 * sizeof(int32_t) + 3 * sizeof(float);
+            break;
+        default:
+            break;
+    }
+    return ret;
+}
+
+/**
+ * Decode the command at the beginning of data, return the number of bytes read or 0 if the command is malformed or truncated
+ */
+size_t AudioCommand::read(const uint8_t *data, const size_t size, AudioCommand &command) noexcept
+{
+    if (size < 2 * sizeof(int32_t))
+    {
+        return 0;
+    }
+    memcpy(&command.type, data, sizeof(int32_t)); // memcpy: the stream has no alignment guarantee
+    const size_t ret = getSize(command.type);
+    if (ret == 0 || ret > size)
+    {
+        return 0;
+    }
+    memcpy(&command.audioId, data + sizeof(int32_t), sizeof(int32_t));
+    memcpy(command.args, data + 2 * sizeof(int32_t), ret - 2 * sizeof(int32_t));
+    return ret;
+}
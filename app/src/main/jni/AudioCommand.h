@@ -0,0 +1,50 @@
+#ifndef __AudioCommand__
+#define __AudioCommand__
+
+#include <cstdint>
+#include <cstddef>
+
+namespace audio
+{
+    /**
+     * Command of the binary stream written by AudioCommandBuffer.java and run by the engine command thread
+     * Layout in native byte order: int32 type, int32 audioId, then 0, 1 or 3 float32 arguments depending on the type
+     * The bus commands carry the id of the bus in place of the audioId
+     */
+    struct AudioCommand
+    {
+        enum Type
+        {
+            TYPE_PLAY = 1,
+            TYPE_STOP,
+            TYPE_PAUSE,
+            TYPE_RESUME,
+            TYPE_SET_VOLUME, // volume
+            TYPE_SET_PARAMS, // pitch, pan, volume
+            TYPE_SET_BUS_VOLUME, // volume
+            TYPE_PAUSE_BUS,
+            TYPE_RESUME_BUS,
+            TYPE_STOP_BUS,
+
+            // Only queued by the engine itself, never read from the stream
+            TYPE_CREATE = 64, // volume
+            TYPE_STOP_ALL,
+            TYPE_PAUSE_ALL,
+            TYPE_RESUME_ALL,
+            TYPE_UNLOAD,
+            TYPE_PLAY_ONE_SHOT // pitch, pan, volume
+        };
+
+        int32_t type;
+        int32_t audioId;
+        float args[3];
+
+        static AudioCommand make(const int32_t type, const int32_t audioId, const float arg0 = 0.f, const float arg1 = 0.f, const float arg2 = 0.f) noexcept;
+
+        static size_t getSize(const int32_t type) noexcept;
+
+        static size_t read(const uint8_t *data, const size_t size, AudioCommand &command) noexcept;
+    };
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include "AudioCommandQueue.h"
+#include <utility>
+
+using namespace audio;
+
+AudioCommandQueue::AudioCommandQueue() : _tail(0)
+, _head(0)
+{
+    for (uint32_t i = 0; i < CAPACITY; ++i)
+    {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+AudioCommandQueue::~AudioCommandQueue()
+{
+}
+
+/**
+ * Enqueue a command, return false if the queue is full
+ */
+bool AudioCommandQueue::push(Entry &&entry) noexcept
+{
+    uint32_t position = _tail.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell &cell = _cells[position & (CAPACITY - 1)];
+        const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const int32_t diff = (int32_t) (sequence - position);
+        if (diff == 0)
+        {
+            if (_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                cell.entry = std::move(entry);
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) // The command thread didn't free this cell yet
+        {
+            return false;
+        }
+        else
+        {
+            position = _tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Dequeue the oldest command, must only be called by the command thread
+ */
+bool AudioCommandQueue::pop(Entry &entry) noexcept
+{
+    Cell &cell = _cells[_head & (CAPACITY - 1)];
+    const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != _head + 1)
+    {
+        return false;
+    }
+    entry = std::move(cell.entry);
+    cell.sequence.store(_head + CAPACITY, std::memory_order_release);
+    ++_head;
+    return true;
+}
+
+bool AudioCommandQueue::empty() const noexcept
+{
+    return _cells[_head & (CAPACITY - 1)].sequence.load(std::memory_order_acquire) != _head + 1;
+}
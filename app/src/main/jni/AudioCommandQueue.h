@@ -0,0 +1,64 @@
+#ifndef __AudioCommandQueue__
+#define __AudioCommandQueue__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "AudioCommand.h"
+
+namespace audio
+{
+    /**
+     * Bounded lock-free multi-producer single-consumer queue of the commands run by the engine command thread
+     * Producers are the Java callers, a push only costs a CAS and the copy of the command
+     */
+    class AudioCommandQueue
+    {
+    public:
+        static constexpr uint32_t CAPACITY = 1024; // Must be a power of 2
+
+        struct Entry
+        {
+            AudioCommand command;
+            std::string path; // TYPE_CREATE, TYPE_PLAY_ONE_SHOT and TYPE_UNLOAD only
+            bool loop; // TYPE_CREATE only
+            int priority; // TYPE_CREATE and TYPE_PLAY_ONE_SHOT only
+            int bus; // TYPE_CREATE and TYPE_PLAY_ONE_SHOT only
+            int64_t queuedAt; // steady_clock in nanoseconds
+        };
+
+    private:
+        struct Cell
+        {
+            std::atomic<uint32_t> sequence;
+            Entry entry;
+        };
+
+    public:
+        AudioCommandQueue();
+
+        AudioCommandQueue(const AudioCommandQueue &) = delete;
+
+        AudioCommandQueue &operator=(const AudioCommandQueue &) & = delete;
+
+        AudioCommandQueue(AudioCommandQueue &&) = delete;
+
+        AudioCommandQueue &operator=(AudioCommandQueue &&) & = delete;
+
+        ~AudioCommandQueue();
+
+    public:
+        bool push(Entry &&entry) noexcept;
+
+        bool pop(Entry &entry) noexcept;
+
+        bool empty() const noexcept;
+
+    private:
+        Cell _cells[CAPACITY];
+        std::atomic<uint32_t> _tail; // next position written by the producers
+        uint32_t _head; // next position read by the command thread
+    };
+}
+
+#endif
@@ -0,0 +1,245 @@
+#include "AudioDecoder.h"
+#include "AudioUtils.h"
+#include <cstring>
+#include <algorithm>
+
+using namespace audio;
+
+constexpr int AudioDecoder::TIMEOUT_MS;
+
+/**
+ * Decode the whole source synchronously, return nullptr if the decoder failed or timed out
+ * Note: The PCM format is the one of the source, it's read from the Android metadata keys
+ */
+std::shared_ptr<AudioSample> AudioDecoder::decode(const SLEngineItf &engineEngine, const int fd, const off64_t start, const off64_t length) noexcept
+{
+    if (engineEngine == nullptr || fd <= 0)
+    {
+        return nullptr;
+    }
+
+    SLDataLocator_AndroidFD loc_fd = {SL_DATALOCATOR_ANDROIDFD, fd, start, length};
+    SLDataFormat_MIME format_mime = {SL_DATAFORMAT_MIME, NULL, SL_CONTAINERTYPE_UNSPECIFIED};
+    SLDataSource audioSrc = {&loc_fd, &format_mime};
+
+    // The decoder ignores the values of the PCM format, it outputs the format of the source
+    SLDataLocator_AndroidSimpleBufferQueue loc_bq = {SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, 2};
+    SLDataFormat_PCM format_pcm = {SL_DATAFORMAT_PCM, 2, SL_SAMPLINGRATE_44_1, SL_PCMSAMPLEFORMAT_FIXED_16, SL_PCMSAMPLEFORMAT_FIXED_16, SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT, SL_BYTEORDER_LITTLEENDIAN};
+    SLDataSink audioSnk = {&loc_bq, &format_pcm};
+
+    const SLInterfaceID ids[2] = {SL_IID_ANDROIDSIMPLEBUFFERQUEUE, SL_IID_METADATAEXTRACTION};
+    const SLboolean req[2] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE};
+    SLObjectItf decoderObject = nullptr;
+    SLresult result = (*engineEngine)->CreateAudioPlayer(engineEngine, &decoderObject, &audioSrc, &audioSnk, 2, ids, req);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("CreateAudioPlayer decoderObject fail");
+        return nullptr;
+    }
+
+    std::unique_ptr<Context> context(new Context());
+    context->done = false;
+    context->next = 0;
+    std::shared_ptr<AudioSample> ret;
+
+    SLPlayItf decoderPlay = nullptr;
+    SLAndroidSimpleBufferQueueItf decoderBufferQueue = nullptr;
+    SLMetadataExtractionItf decoderMetadata = nullptr;
+    bool error = true;
+
+    result = (*decoderObject)->Realize(decoderObject, SL_BOOLEAN_FALSE);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("Realize decoderObject fail");
+    }
+    else if (SL_RESULT_SUCCESS != (*decoderObject)->GetInterface(decoderObject, SL_IID_PLAY, &decoderPlay)
+             || SL_RESULT_SUCCESS != (*decoderObject)->GetInterface(decoderObject, SL_IID_ANDROIDSIMPLEBUFFERQUEUE, &decoderBufferQueue)
+             || SL_RESULT_SUCCESS != (*decoderObject)->GetInterface(decoderObject, SL_IID_METADATAEXTRACTION, &decoderMetadata))
+    {
+        LOGEX("GetInterface decoderObject fail");
+    }
+    else if (SL_RESULT_SUCCESS != (*decoderBufferQueue)->RegisterCallback(decoderBufferQueue, AudioDecoder::bufferQueueCallback, context.get())
+             || SL_RESULT_SUCCESS != (*decoderPlay)->SetCallbackEventsMask(decoderPlay, SL_PLAYEVENT_HEADATEND)
+             || SL_RESULT_SUCCESS != (*decoderPlay)->RegisterCallback(decoderPlay, AudioDecoder::playEventCallback, context.get()))
+    {
+        LOGEX("RegisterCallback decoderObject fail");
+    }
+    else
+    {
+        memset(context->buffers, 0, sizeof(context->buffers));
+        result = (*decoderBufferQueue)->Enqueue(decoderBufferQueue, context->buffers[0], sizeof(context->buffers[0]));
+        if (SL_RESULT_SUCCESS == result)
+        {
+            result = (*decoderBufferQueue)->Enqueue(decoderBufferQueue, context->buffers[1], sizeof(context->buffers[1]));
+        }
+        if (SL_RESULT_SUCCESS == result)
+        {
+            result = (*decoderPlay)->SetPlayState(decoderPlay, SL_PLAYSTATE_PLAYING);
+        }
+        if (SL_RESULT_SUCCESS != result)
+        {
+            LOGEX("Enqueue decoderBufferQueue fail");
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(context->mutex);
+            error = !context->condition.wait_for(lock, std::chrono::milliseconds(TIMEOUT_MS), [&context]() { return context->done; });
+            if (error)
+            {
+                LOGEX("decode timeout");
+            }
+        }
+    }
+
+    if (!error)
+    {
+        const SLuint32 channels = getMetadataValue(decoderMetadata, ANDROID_KEY_PCMFORMAT_NUMCHANNELS);
+        const SLuint32 sampleRate = getMetadataValue(decoderMetadata, ANDROID_KEY_PCMFORMAT_SAMPLERATE);
+        SLmillisecond duration = SL_TIME_UNKNOWN;
+        (*decoderPlay)->GetDuration(decoderPlay, &duration);
+
+        (*decoderPlay)->SetPlayState(decoderPlay, SL_PLAYSTATE_STOPPED);
+        (*decoderObject)->Destroy(decoderObject); // No callback can touch the context anymore
+        decoderObject = nullptr;
+
+        if (channels > 0 && sampleRate > 0)
+        {
+            ret = std::make_shared<AudioSample>();
+            ret->channels = channels;
+            ret->sampleRate = sampleRate;
+            ret->pcm.swap(context->pcm);
+            if (duration != SL_TIME_UNKNOWN) // The last buffer is only partially filled by the decoder
+            {
+                const size_t frames = (size_t) ((uint64_t) duration * sampleRate / 1000);
+                if (frames * channels < ret->pcm.size())
+                {
+                    ret->pcm.resize(frames * channels);
+                }
+            }
+            ret->pcm.shrink_to_fit();
+        }
+        else
+        {
+            LOGEX("GetValue decoderMetadata fail");
+        }
+    }
+
+    if (decoderObject != nullptr)
+    {
+        (*decoderObject)->Destroy(decoderObject);
+    }
+    return ret;
+}
+
+/**
+ * Convert a decoded sample to another rate with a cubic (Catmull-Rom) interpolation, done once when it's cached
+ * Return the sample itself if it's already at this rate
+ */
+std::shared_ptr<AudioSample> AudioDecoder::resample(const std::shared_ptr<AudioSample> &sample, const SLuint32 sampleRate) noexcept
+{
+    if (sample == nullptr || sampleRate == 0 || sample->sampleRate == 0 || sample->sampleRate == sampleRate || sample->getFrames() == 0)
+    {
+        return sample;
+    }
+    const size_t channels = sample->channels;
+    const size_t inFrames = sample->getFrames();
+    const size_t outFrames = (size_t) ((uint64_t) inFrames * sampleRate / sample->sampleRate);
+    const int16_t *in = sample->getData();
+    const double step = (double) sample->sampleRate / sampleRate;
+    std::shared_ptr<AudioSample> ret = std::make_shared<AudioSample>();
+    ret->channels = sample->channels;
+    ret->sampleRate = sampleRate;
+    ret->pcm.resize(outFrames * channels);
+    auto at = [in, inFrames, channels](const int64_t frame, const size_t channel)
+    {
+        const int64_t clamped = frame < 0 ? 0 : (frame >= (int64_t) inFrames ? (int64_t) inFrames - 1 : frame);
+        return (float) in[(size_t) clamped * channels + channel];
+    };
+    for (size_t n = 0; n < outFrames; ++n)
+    {
+        const double position = n * step;
+        const int64_t i = (int64_t) position;
+        const float t = (float) (position - i);
+        for (size_t c = 0; c < channels; ++c)
+        {
+            const float xm1 = at(i - 1, c), x0 = at(i, c), x1 = at(i + 1, c), x2 = at(i + 2, c);
+            const float value = x0 + 0.5f * t * (x1 - xm1 + t * (2.f * xm1 - 5.f * x0 + 4.f * x1 - x2 + t * (3.f * (x0 - x1) + x2 - xm1)));
+            ret->pcm[n * channels + c] = (int16_t) std::max(-32768.f, std::min(32767.f, value));
+        }
+    }
+    return ret;
+}
+
+/**
+ * Read an SLuint32 value of the Android PCM metadata keys
+ */
+SLuint32 AudioDecoder::getMetadataValue(SLMetadataExtractionItf metadata, const char *key) noexcept
+{
+    SLuint32 ret = 0;
+    SLuint32 count = 0;
+    if (SL_RESULT_SUCCESS != (*metadata)->GetItemCount(metadata, &count))
+    {
+        return 0;
+    }
+
+    const size_t keyLength = strlen(key);
+    union
+    {
+        SLMetadataInfo info;
+        char bytes[sizeof(SLMetadataInfo) + 64];
+    } buffer;
+
+    for (SLuint32 i = 0; i < count; ++i)
+    {
+        SLuint32 size = 0;
+        if (SL_RESULT_SUCCESS != (*metadata)->GetKeySize(metadata, i, &size) || size > sizeof(buffer))
+        {
+            continue;
+        }
+        if (SL_RESULT_SUCCESS != (*metadata)->GetKey(metadata, i, size, &buffer.info))
+        {
+            continue;
+        }
+        if (0 == strncmp((const char *) buffer.info.data, key, keyLength))
+        {
+            if (SL_RESULT_SUCCESS == (*metadata)->GetValueSize(metadata, i, &size) && size <= sizeof(buffer)
+                && SL_RESULT_SUCCESS == (*metadata)->GetValue(metadata, i, size, &buffer.info))
+            {
+                memcpy(&ret, buffer.info.data, sizeof(ret));
+            }
+            break;
+        }
+    }
+    return ret;
+}
+
+/**
+ * A buffer has been filled by the decoder: append it and give it back
+ */
+void AudioDecoder::bufferQueueCallback(SLAndroidSimpleBufferQueueItf caller, void *context) noexcept
+{
+    Context *ctx = static_cast<Context *>(context);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    if (ctx->done)
+    {
+        return;
+    }
+    int16_t *buffer = ctx->buffers[ctx->next];
+    ctx->pcm.insert(ctx->pcm.end(), buffer, buffer + BUFFER_FRAMES * 2);
+    memset(buffer, 0, sizeof(ctx->buffers[0]));
+    (*caller)->Enqueue(caller, buffer, sizeof(ctx->buffers[0]));
+    ctx->next = 1 - ctx->next;
+}
+
+void AudioDecoder::playEventCallback(SLPlayItf caller, void *context, SLuint32 playEvent) noexcept
+{
+    if ((playEvent & SL_PLAYEVENT_HEADATEND) == SL_PLAYEVENT_HEADATEND)
+    {
+        Context *ctx = static_cast<Context *>(context);
+        {
+            std::lock_guard<std::mutex> lock(ctx->mutex);
+            ctx->done = true;
+        }
+        ctx->condition.notify_all();
+    }
+}
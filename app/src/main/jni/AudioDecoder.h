@@ -0,0 +1,53 @@
+#ifndef __AudioDecoder__
+#define __AudioDecoder__
+
+#include <SLES/OpenSLES.h>
+#include <SLES/OpenSLES_Android.h>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <sys/types.h>
+#include "AudioSample.h"
+
+namespace audio
+{
+    /**
+     * Decode a compressed source to PCM 16 bits with the OpenSL decoder (Android buffer queue sink)
+     */
+    class AudioDecoder
+    {
+    public:
+        static constexpr size_t BUFFER_FRAMES = 4096;
+        static constexpr int TIMEOUT_MS = 5000;
+
+    private:
+        struct Context
+        {
+            std::mutex mutex;
+            std::condition_variable condition;
+            bool done;
+            size_t next; // index of the buffer that completes next
+            std::vector<int16_t> pcm;
+            int16_t buffers[2][BUFFER_FRAMES * 2]; // sized for stereo
+        };
+
+    public:
+        AudioDecoder() = delete;
+
+    public:
+        static std::shared_ptr<AudioSample> decode(const SLEngineItf &engineEngine, const int fd, const off64_t start, const off64_t length) noexcept;
+
+        static std::shared_ptr<AudioSample> resample(const std::shared_ptr<AudioSample> &sample, const SLuint32 sampleRate) noexcept;
+
+        static SLuint32 getMetadataValue(SLMetadataExtractionItf metadata, const char *key) noexcept;
+
+    private:
+
+        static void bufferQueueCallback(SLAndroidSimpleBufferQueueItf caller, void *context) noexcept;
+
+        static void playEventCallback(SLPlayItf caller, void *context, SLuint32 playEvent) noexcept;
+    };
+}
+
+#endif
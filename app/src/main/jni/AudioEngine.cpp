@@ -1,701 +1,2619 @@
 #include "AudioEngine.h"
 #include "AudioUtils.h"
+#include "AudioTrace.h"
+#include "AudioOpenSLBackend.h"
+#include <unistd.h>
 
 using namespace audio;
 
-extern "C"
+namespace
 {
-    static JavaVM *gVm = nullptr;
+    JavaVM *gVm = nullptr;
+
+    // Cached once in JNI_OnLoad, the natives are registered on them
+    jclass gAudioPlayerClass = nullptr;
+    jclass gAudioEngineClass = nullptr;
+    jclass gAudioPreloadListenerClass = nullptr;
+    jmethodID gOnPathLoaded = nullptr;
+    jmethodID gOnBatchLoaded = nullptr;
 
     /**
-     * Return the JNIEnv and handle multithreaded env for the code to interact with Java
+     * Forward the preload notifications to an AudioPreloadListener.java held as GlobalRef
      */
-    JNIEnv *getJNIEnv()
+    class JavaPreloadListener : public AudioPreloader::Listener
     {
-        JNIEnv *env = nullptr;
-        if (gVm != nullptr)
+    public:
+        JavaPreloadListener(JNIEnv *env, jobject listener) : _listener(env->NewGlobalRef(listener))
         {
-            jint ret = gVm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6);
-            switch (ret)
+        }
+
+        ~JavaPreloadListener()
+        {
+            JNIEnv *env = getJNIEnv();
+            if (env != nullptr && _listener != nullptr)
             {
-                case JNI_OK :
-                    break;
-                case JNI_EDETACHED :
-                    if (gVm->AttachCurrentThread(&env, NULL) < 0)
-                    {
-                        env = nullptr;
-                    }
-                    break;
-                case JNI_EVERSION :
-                default :
-                    env = nullptr;
-                    break;
+                env->DeleteGlobalRef(_listener);
             }
         }
-        return env;
+
+        void onPathLoaded(const int batchId, const std::string &fileFullPath, const bool loaded) noexcept override
+        {
+            JNIEnv *env = getJNIEnv();
+            if (env != nullptr && _listener != nullptr)
+            {
+                jstring path = env->NewStringUTF(fileFullPath.c_str());
+                env->CallVoidMethod(_listener, gOnPathLoaded, (jint) batchId, path, loaded ? JNI_TRUE : JNI_FALSE);
+                clearException(env);
+                env->DeleteLocalRef(path);
+            }
+        }
+
+        void onBatchLoaded(const int batchId, const int loaded, const int failed) noexcept override
+        {
+            JNIEnv *env = getJNIEnv();
+            if (env != nullptr && _listener != nullptr)
+            {
+                env->CallVoidMethod(_listener, gOnBatchLoaded, (jint) batchId, (jint) loaded, (jint) failed);
+                clearException(env);
+            }
+        }
+
+    private:
+        static void clearException(JNIEnv *env) noexcept
+        {
+            if (env->ExceptionCheck()) // An exception of the listener must not stay pending on a native thread
+            {
+                LOGEX("AudioPreloadListener exception");
+                env->ExceptionDescribe();
+                env->ExceptionClear();
+            }
+        }
+
+    private:
+        jobject _listener;
+    };
+
+    /**
+     * Queue the creation of a sound on its bus, return its audioId or -1
+     * Implementation of the nativeInit method in AudioPlayer.java
+     */
+    jint JNICALL audioPlayerInit(JNIEnv *env, jclass clazz, jstring path, jfloat volume, jboolean loop, jint priority, jint bus)
+    {
+        jint ret = -1;
+        const char *pathC = env->GetStringUTFChars(path, nullptr);
+        if (pathC != nullptr)
+        {
+            ret = AudioEngine::getInstance()->createPlayerAsync(pathC, (float) volume, loop == JNI_TRUE, (int) priority, (int) bus); // -1 if the assemanager is not set, the bus unknown or the queue is full
+            env->ReleaseStringUTFChars(path, pathC);
+        }
+        return ret;
+    }
+
+    /**
+     * Stop a sound
+     * Implementation of the nativeStop method in AudioPlayer.java
+     */
+    jboolean JNICALL audioPlayerStop(JNIEnv *env, jclass clazz, jint audioId)
+    {
+        return audioId > 0 && AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_STOP, audioId));
+    }
+
+    /**
+     * Play a sound
+     * Implementation of the nativePlay method in AudioPlayer.java
+     */
+    jboolean JNICALL audioPlayerPlay(JNIEnv *env, jclass clazz, jint audioId)
+    {
+        return audioId > 0 && AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_PLAY, audioId));
+    }
+
+    /**
+     * Resume a sound that has been paused
+     * Implementation of the nativeResume method in AudioPlayer.java
+     */
+    jboolean JNICALL audioPlayerResume(JNIEnv *env, jclass clazz, jint audioId)
+    {
+        return audioId > 0 && AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_RESUME, audioId));
+    }
+
+    /**
+     * Pause a sound
+     * Implementation of the nativePause method in AudioPlayer.java
+     */
+    jboolean JNICALL audioPlayerPause(JNIEnv *env, jclass clazz, jint audioId)
+    {
+        return audioId > 0 && AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_PAUSE, audioId));
+    }
+
+    /**
+     * Change pitch, pan and gain of a sound
+     * Implementation of the nativeSetParams method in AudioPlayer.java
+     */
+    jboolean JNICALL audioPlayerSetParams(JNIEnv *env, jclass clazz, jint audioId, jfloat pitch, jfloat pan, jfloat volume)
+    {
+        return audioId > 0 && AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_SET_PARAMS, audioId, (float) pitch, (float) pan, (float) volume));
+    }
+
+    /**
+     * Change volume of a sound
+     * Implementation of the nativeSetVolume method in AudioPlayer.java
+     */
+    jboolean JNICALL audioPlayerSetVolume(JNIEnv *env, jclass clazz, jint audioId, jfloat volume)
+    {
+        return audioId > 0 && AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_SET_VOLUME, audioId, (float) volume));
+    }
+
+    /**
+     * Whether the sound got a fast track, read directly since it's only a flag of the player
+     * Implementation of the nativeIsFastPath method in AudioPlayer.java
+     */
+    jboolean JNICALL audioPlayerIsFastPath(JNIEnv *env, jclass clazz, jint audioId)
+    {
+        return audioId > 0 && AudioEngine::getInstance()->isFastPath(audioId);
+    }
+
+    /**
+     * Implementation of the setAssetManager method in AudioEngine.java
+     * TODO: Optimize how we set the java AssetManager to reach sound in /assets
+     */
+    void JNICALL audioEngineSetAssetManager(JNIEnv *env, jobject thiz, jobject assetManager)
+    {
+        AudioEngine::getInstance()->setAssetManager(assetManager);
+    }
+
+    /**
+     * Implementation of pauseAll method in AudioEngine.java
+     * It's a convinient method to easily pause all the sounds at once
+     */
+    jboolean JNICALL audioEnginePauseAll(JNIEnv *env, jobject thiz)
+    {
+        return AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_PAUSE_ALL, 0));
+    }
+
+    /**
+      * Implementation of pauseAll method in AudioEngine.java
+      * It's a convinient method to easily pause all the sounds at once
+      */
+    jboolean JNICALL audioEngineResumeAll(JNIEnv *env, jobject thiz)
+    {
+        return AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_RESUME_ALL, 0));
+    }
+
+    jboolean JNICALL audioEngineStopAll(JNIEnv *env, jobject thiz)
+    {
+        return AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_STOP_ALL, 0));
     }
 
     /**
-     * Return the audioId memeber of AudioPlayer.java class
+     * Implementation of playOneShot method in AudioEngine.java
+     * The creation and the play in a single call: no AudioPlayer.java object and no audioId to keep on the Java side
      */
-    int getAudioId(JNIEnv *env, jobject javaAudioPlayer)
+    jboolean JNICALL audioEnginePlayOneShot(JNIEnv *env, jobject thiz, jstring path, jfloat volume, jfloat pan, jfloat pitch, jint priority, jint bus)
     {
-        int ret = -1;
-        if (env != nullptr)
+        jboolean ret = JNI_FALSE;
+        const char *pathC = env->GetStringUTFChars(path, nullptr);
+        if (pathC != nullptr)
         {
-            jclass audioPlayerClass = env->GetObjectClass(javaAudioPlayer);
-            if (audioPlayerClass != nullptr)
-            {
-                jfieldID audioIdField = env->GetFieldID(audioPlayerClass, "_audioId", "I");
-                if (audioIdField != nullptr)
-                {
-                    ret = env->GetIntField(javaAudioPlayer, audioIdField);
-                }
-            }
+            ret = AudioEngine::getInstance()->playOneShot(pathC, (float) volume, (float) pan, (float) pitch, (int) priority, (int) bus) ? JNI_TRUE : JNI_FALSE;
+            env->ReleaseStringUTFChars(path, pathC);
         }
         return ret;
     }
 
     /**
-     * Set audioId member of AudioPlayer.java
+     * Implementation of createBus method in AudioEngine.java
+     * Synchronous: the id is needed by the next creations, it doesn't touch any player
      */
-    bool setAudioId(JNIEnv *env, jobject javaAudioPlayer, int audioId)
+    jint JNICALL audioEngineCreateBus(JNIEnv *env, jobject thiz, jstring name, jint parent)
     {
-        bool ret = false;
-        if (env != nullptr)
+        jint ret = -1;
+        const char *nameC = env->GetStringUTFChars(name, nullptr);
+        if (nameC != nullptr)
         {
-            jclass audioPlayerClass = env->GetObjectClass(javaAudioPlayer);
-            if (audioPlayerClass != nullptr)
-            {
-                jfieldID audioIdField = env->GetFieldID(audioPlayerClass, "_audioId", "I");
-                if (audioIdField != nullptr)
-                {
-                    env->SetIntField(javaAudioPlayer, audioIdField, (jint) audioId);
-                    ret = true;
-                }
-            }
+            ret = AudioEngine::getInstance()->createBus(nameC, (int) parent);
+            env->ReleaseStringUTFChars(name, nameC);
         }
         return ret;
     }
 
     /**
-     * Init the libaudio
-     * Cache JavaVM*
-     * Note: Maybe it would better to also cache JNIEnv*
+     * Implementation of findBus method in AudioEngine.java
      */
-    JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved)
+    jint JNICALL audioEngineFindBus(JNIEnv *env, jobject thiz, jstring name)
     {
-        JNIEnv *env = nullptr;
-        if (vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) != JNI_OK)
+        jint ret = -1;
+        const char *nameC = env->GetStringUTFChars(name, nullptr);
+        if (nameC != nullptr)
         {
-            return JNI_ERR;
+            ret = AudioEngine::getInstance()->findBus(nameC);
+            env->ReleaseStringUTFChars(name, nameC);
         }
+        return ret;
+    }
 
-        gVm = vm;
+    /**
+     * Implementation of setBusVolume method in AudioEngine.java
+     * A single command whatever the number of sounds on the bus, the command thread applies it to each of them
+     */
+    jboolean JNICALL audioEngineSetBusVolume(JNIEnv *env, jobject thiz, jint bus, jfloat volume)
+    {
+        return AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_SET_BUS_VOLUME, bus, (float) volume));
+    }
 
-        return JNI_VERSION_1_6;
+    /**
+     * Implementation of pauseBus method in AudioEngine.java
+     */
+    jboolean JNICALL audioEnginePauseBus(JNIEnv *env, jobject thiz, jint bus)
+    {
+        return AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_PAUSE_BUS, bus));
     }
 
     /**
-     * Unload libaudio
-     * Make sure that we clean all our singletons correctly if the lib must be unload
+     * Implementation of resumeBus method in AudioEngine.java
      */
-    JNIEXPORT void JNICALL JNI_OnUnload(JavaVM *vm, void *reserved)
+    jboolean JNICALL audioEngineResumeBus(JNIEnv *env, jobject thiz, jint bus)
     {
-        gVm = nullptr;
-        AudioEngine::getInstance()->destroy();
+        return AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_RESUME_BUS, bus));
     }
 
     /**
-     * Init OpenSL to then interact with a sound (play/stop/pause/resume/setVolume/setParams)
-     * Implementation of the init method in AudioPlayer.java
+     * Implementation of stopBus method in AudioEngine.java
      */
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_init(JNIEnv *env, jobject thiz, jstring path, jfloat volume, jboolean loop)
+    jboolean JNICALL audioEngineStopBus(JNIEnv *env, jobject thiz, jint bus)
     {
-        bool ret = false;
+        return AudioEngine::getInstance()->post(AudioCommand::make(AudioCommand::TYPE_STOP_BUS, bus));
+    }
 
-        const int audioId = getAudioId(env, thiz); // try to recover the audioIde from the AudioPlayer.java object
+    /**
+     * Implementation of submit method in AudioEngine.java
+     * Apply the size first bytes of the direct ByteBuffer written by AudioCommandBuffer.java in a single JNI call
+     */
+    jint JNICALL audioEngineSubmit(JNIEnv *env, jobject thiz, jobject buffer, jint size)
+    {
+        jint ret = -1;
+        const uint8_t *data = static_cast<const uint8_t *>(env->GetDirectBufferAddress(buffer));
+        const jlong capacity = env->GetDirectBufferCapacity(buffer);
+        if (data != nullptr && size >= 0 && size <= capacity)
+        {
+            ret = AudioEngine::getInstance()->submit(data, (size_t) size);
+        }
+        return ret;
+    }
 
-        if (audioId < 0) {
-            const char *pathC = env->GetStringUTFChars(path, nullptr);
-            AudioPlayer *player = AudioEngine::getInstance()->createPlayerWithPath(pathC, (float) volume, (bool) loop); // Can return nullptr if the audio engine or the assemanager is not init correctly
-            env->ReleaseStringUTFChars(path, pathC);
+    /**
+     * Implementation of getReclaimStats method in AudioEngine.java
+     * Return [reclaimed players, total reclaim latency (ns), max reclaim latency (ns)]
+     */
+    jlongArray JNICALL audioEngineGetReclaimStats(JNIEnv *env, jobject thiz)
+    {
+        const AudioEngine::ReclaimStats stats = AudioEngine::getInstance()->getReclaimStats();
+        const jlong values[3] = {(jlong) stats.reclaimed, (jlong) stats.totalLatencyNs, (jlong) stats.maxLatencyNs};
+        jlongArray ret = env->NewLongArray(3);
+        if (ret != nullptr)
+        {
+            env->SetLongArrayRegion(ret, 0, 3, values);
+        }
+        return ret;
+    }
 
-            if (player != nullptr)
-            {
-                setAudioId(env, thiz, player->getPlayerId()); // Set the audioId member of java class AudioPlayer.java
-                player->setJavaAudioPlayerObj( thiz); // Store the jobject in GlobalRef to be able to easily set the audioId back when you stop a sound
+    /**
+     * Implementation of setMaxRealVoices method in AudioEngine.java
+     */
+    void JNICALL audioEngineSetMaxRealVoices(JNIEnv *env, jobject thiz, jint count)
+    {
+        AudioEngine::getInstance()->setMaxRealVoices(count > 0 ? (size_t) count : 0);
+    }
 
-                ret = true;
-            }
+    /**
+     * Implementation of getVoiceStats method in AudioEngine.java
+     * Return [real voices, virtual voices, stolen, promoted, culled]
+     */
+    jlongArray JNICALL audioEngineGetVoiceStats(JNIEnv *env, jobject thiz)
+    {
+        const AudioEngine::VoiceStats stats = AudioEngine::getInstance()->getVoiceStats();
+        const jlong values[5] = {(jlong) stats.real, (jlong) stats.virtuals, (jlong) stats.stolen, (jlong) stats.promoted, (jlong) stats.culled};
+        jlongArray ret = env->NewLongArray(5);
+        if (ret != nullptr)
+        {
+            env->SetLongArrayRegion(ret, 0, 5, values);
         }
         return ret;
     }
 
     /**
-     * Stop a sound
-     * Implementation of the stop method in AudioPlayer.java
+     * Implementation of setPlayerPoolSize method in AudioEngine.java
      */
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_stop(JNIEnv *env, jobject thiz)
+    void JNICALL audioEngineSetPlayerPoolSize(JNIEnv *env, jobject thiz, jint size)
     {
-        bool ret = false;
-        AudioEngine *engine = AudioEngine::getInstance();
-
-        const int audioId = getAudioId(env, thiz); // try to recover the audioIde from the AudioPlayer.java object
+        AudioEngine::getInstance()->setPlayerPoolSize(size > 0 ? (size_t) size : 0);
+    }
 
-        if (audioId > 0)
+    /**
+     * Implementation of getPlayerPoolStats method in AudioEngine.java
+     * Return [hits, misses, evictions, idle players]
+     */
+    jlongArray JNICALL audioEngineGetPlayerPoolStats(JNIEnv *env, jobject thiz)
+    {
+        const AudioPlayerPool::Stats stats = AudioEngine::getInstance()->getPlayerPoolStats();
+        const jlong values[4] = {(jlong) stats.hits, (jlong) stats.misses, (jlong) stats.evictions, (jlong) stats.idle};
+        jlongArray ret = env->NewLongArray(4);
+        if (ret != nullptr)
         {
-            ret = engine->stop(audioId);
+            env->SetLongArrayRegion(ret, 0, 4, values);
         }
         return ret;
     }
 
     /**
-     * Play a sound
-     * Implementation of the play method in AudioPlayer.java
-    */
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_play(JNIEnv *env, jobject thiz)
+     * Implementation of setSampleCacheThreshold method in AudioEngine.java
+     */
+    void JNICALL audioEngineSetSampleCacheThreshold(JNIEnv *env, jobject thiz, jint bytes)
     {
-        bool ret = false;
-        AudioEngine *engine = AudioEngine::getInstance();
+        AudioEngine::getInstance()->setSampleCacheThreshold(bytes > 0 ? (size_t) bytes : 0);
+    }
 
-        const int audioId = getAudioId(env, thiz); // try to recover the audioIde from the AudioPlayer.java object
+    /**
+     * Implementation of setSampleCacheCapacity method in AudioEngine.java
+     */
+    void JNICALL audioEngineSetSampleCacheCapacity(JNIEnv *env, jobject thiz, jint bytes)
+    {
+        AudioEngine::getInstance()->setSampleCacheCapacity(bytes > 0 ? (size_t) bytes : 0);
+    }
 
-        if (audioId > 0)
+    /**
+     * Implementation of getSampleCacheStats method in AudioEngine.java
+     * Return [hits, misses, evictions, decoded bytes, samples]
+     */
+    jlongArray JNICALL audioEngineGetSampleCacheStats(JNIEnv *env, jobject thiz)
+    {
+        const AudioSampleCache::Stats stats = AudioEngine::getInstance()->getSampleCacheStats();
+        const jlong values[5] = {(jlong) stats.hits, (jlong) stats.misses, (jlong) stats.evictions, (jlong) stats.bytes, (jlong) stats.samples};
+        jlongArray ret = env->NewLongArray(5);
+        if (ret != nullptr)
         {
-            ret = engine->play(audioId);
+            env->SetLongArrayRegion(ret, 0, 5, values);
         }
         return ret;
     }
 
     /**
-     * Resume a sound that has been paused
-     * Implementation of the resume method in AudioPlayer.java
+     * Implementation of setMixerEnabled method in AudioEngine.java
      */
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_resume(JNIEnv *env, jobject thiz)
+    jboolean JNICALL audioEngineSetMixerEnabled(JNIEnv *env, jobject thiz, jboolean enabled)
     {
-        bool ret = false;
-        AudioEngine *engine = AudioEngine::getInstance();
-
-        const int audioId = getAudioId(env, thiz);
+        return AudioEngine::getInstance()->setMixerEnabled(enabled == JNI_TRUE);
+    }
 
-        if (audioId > 0)
+    /**
+     * Implementation of getMixerStats method in AudioEngine.java
+     * Return [renders, playing voices, total render time (ns), max render time (ns)]
+     */
+    jlongArray JNICALL audioEngineGetMixerStats(JNIEnv *env, jobject thiz)
+    {
+        const AudioMixer::Stats stats = AudioEngine::getInstance()->getMixerStats();
+        const jlong values[4] = {(jlong) stats.renders, (jlong) stats.voices, (jlong) stats.totalRenderNs, (jlong) stats.maxRenderNs};
+        jlongArray ret = env->NewLongArray(4);
+        if (ret != nullptr)
         {
-            ret = engine->resume(audioId);
+            env->SetLongArrayRegion(ret, 0, 4, values);
         }
         return ret;
     }
 
     /**
-     * Pause a sound
-     * Implementation of the pause method in AudioPlayer.java
+     * Implementation of setStreamingThreshold method in AudioEngine.java
      */
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_pause(JNIEnv *env, jobject thiz)
+    void JNICALL audioEngineSetStreamingThreshold(JNIEnv *env, jobject thiz, jint bytes)
     {
-        bool ret = false;
-        AudioEngine *engine = AudioEngine::getInstance();
+        AudioEngine::getInstance()->setStreamingThreshold(bytes > 0 ? (size_t) bytes : 0);
+    }
 
-        const int audioId = getAudioId(env, thiz); // try to recover the audioIde from the AudioPlayer.java object
+    /**
+     * Implementation of setStreamingBuffer method in AudioEngine.java
+     */
+    void JNICALL audioEngineSetStreamingBuffer(JNIEnv *env, jobject thiz, jint ringFrames, jint lowWatermarkFrames)
+    {
+        AudioEngine::getInstance()->setStreamingBuffer(ringFrames > 0 ? (size_t) ringFrames : 0, lowWatermarkFrames > 0 ? (size_t) lowWatermarkFrames : 0);
+    }
 
-        if (audioId > 0)
+    /**
+     * Implementation of getStreamingStats method in AudioEngine.java
+     * Return [underruns, underrun frames, refills, active streams]
+     */
+    jlongArray JNICALL audioEngineGetStreamingStats(JNIEnv *env, jobject thiz)
+    {
+        const AudioEngine::StreamingStats stats = AudioEngine::getInstance()->getStreamingStats();
+        const jlong values[4] = {(jlong) stats.underruns, (jlong) stats.underrunFrames, (jlong) stats.refills, (jlong) stats.active};
+        jlongArray ret = env->NewLongArray(4);
+        if (ret != nullptr)
         {
-            ret = engine->pause(audioId);
+            env->SetLongArrayRegion(ret, 0, 4, values);
         }
         return ret;
     }
 
     /**
-     * Change pitch, pan and gain of a sound
-     * Implementation of the setParams method in AudioPlayer.java
+     * Implementation of getStats method in AudioEngine.java
+     * Return the counters, the gauges then [count, waits, total wait (ns), max wait (ns)] of each timer, in the order of AudioMetrics
      */
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_setParams(JNIEnv *env, jobject thiz, jfloat pitch, jfloat pan, jfloat volume) {
-        bool ret = false;
-        AudioEngine *engine = AudioEngine::getInstance();
+    jlongArray JNICALL audioEngineGetStats(JNIEnv *env, jobject thiz)
+    {
+        const AudioMetrics::Stats stats = AudioEngine::getInstance()->getStats();
+        constexpr jsize size = AudioMetrics::COUNTER_COUNT + AudioMetrics::GAUGE_COUNT + AudioMetrics::TIMER_COUNT * 4;
+        jlong values[size];
+        jsize i = 0;
+        for (const uint64_t counter : stats.counters)
+        {
+            values[i++] = (jlong) counter;
+        }
+        for (const int64_t gauge : stats.gauges)
+        {
+            values[i++] = (jlong) gauge;
+        }
+        for (const AudioMetrics::TimerStats &timer : stats.timers)
+        {
+            values[i++] = (jlong) timer.count;
+            values[i++] = (jlong) timer.waits;
+            values[i++] = (jlong) timer.totalNs;
+            values[i++] = (jlong) timer.maxNs;
+        }
+        jlongArray ret = env->NewLongArray(size);
+        if (ret != nullptr)
+        {
+            env->SetLongArrayRegion(ret, 0, size, values);
+        }
+        return ret;
+    }
 
-        const int audioId = getAudioId(env, thiz); // try to recover the audioIde from the AudioPlayer.java object
+    /**
+     * Implementation of setCommandThreadEnabled method in AudioEngine.java
+     */
+    void JNICALL audioEngineSetCommandThreadEnabled(JNIEnv *env, jobject thiz, jboolean enabled)
+    {
+        AudioEngine::getInstance()->setCommandThreadEnabled(enabled == JNI_TRUE);
+    }
 
-        if (audioId > 0)
+    /**
+     * Implementation of getCommandStats method in AudioEngine.java
+     * Return [queued, succeeded, failed, dropped, calls, total caller time (ns), max caller time (ns), total queue time (ns), max queue time (ns), stale]
+     */
+    jlongArray JNICALL audioEngineGetCommandStats(JNIEnv *env, jobject thiz)
+    {
+        const AudioEngine::CommandStats stats = AudioEngine::getInstance()->getCommandStats();
+        const jlong values[10] = {(jlong) stats.queued, (jlong) stats.succeeded, (jlong) stats.failed, (jlong) stats.dropped, (jlong) stats.calls,
+                                  (jlong) stats.totalCallerNs, (jlong) stats.maxCallerNs, (jlong) stats.totalQueueNs, (jlong) stats.maxQueueNs, (jlong) stats.stale};
+        jlongArray ret = env->NewLongArray(10);
+        if (ret != nullptr)
         {
-            ret = engine->setParams(audioId, (float) pitch, (float) pan, (float) volume);
+            env->SetLongArrayRegion(ret, 0, 10, values);
         }
         return ret;
     }
 
     /**
-     * Change volume of a sound
-     * Implementation of the setVolume method in AudioPlayer.java
+     * Implementation of getParamsStats method in AudioEngine.java
+     * Return [writes, ticks, voice updates]
      */
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_setVolume(JNIEnv *env, jobject thiz, jfloat volume)
+    jlongArray JNICALL audioEngineGetParamsStats(JNIEnv *env, jobject thiz)
     {
-        bool ret = false;
-        AudioEngine *engine = AudioEngine::getInstance();
+        const AudioEngine::ParamsStats stats = AudioEngine::getInstance()->getParamsStats();
+        const jlong values[3] = {(jlong) stats.writes, (jlong) stats.ticks, (jlong) stats.updates};
+        jlongArray ret = env->NewLongArray(3);
+        if (ret != nullptr)
+        {
+            env->SetLongArrayRegion(ret, 0, 3, values);
+        }
+        return ret;
+    }
 
-        const int audioId = getAudioId(env, thiz); // try to recover the audioIde from the AudioPlayer.java object
+    /**
+     * Implementation of setOutputConfig method in AudioEngine.java
+     */
+    void JNICALL audioEngineSetOutputConfig(JNIEnv *env, jobject thiz, jint sampleRate, jint framesPerBurst)
+    {
+        AudioEngine::getInstance()->setOutputConfig(sampleRate > 0 ? (SLuint32) sampleRate : 0, framesPerBurst > 0 ? (size_t) framesPerBurst : 0);
+    }
 
-        if (audioId > 0)
+    /**
+     * Implementation of getLatencyStats method in AudioEngine.java
+     * Return [count, p50 (ns), p95 (ns), p99 (ns), max (ns)], null for an unknown stage
+     */
+    jlongArray JNICALL audioEngineGetLatencyStats(JNIEnv *env, jobject thiz, jint stage)
+    {
+        if (stage < 0 || stage >= AudioEngine::LATENCY_COUNT)
+        {
+            return nullptr;
+        }
+        const AudioHistogram::Snapshot stats = AudioEngine::getInstance()->getLatencyStats((AudioEngine::LatencyStage) stage);
+        const jlong values[5] = {(jlong) stats.count, (jlong) stats.p50Ns, (jlong) stats.p95Ns, (jlong) stats.p99Ns, (jlong) stats.maxNs};
+        jlongArray ret = env->NewLongArray(5);
+        if (ret != nullptr)
         {
-            ret = engine->setVolume(audioId, (float) volume);
+            env->SetLongArrayRegion(ret, 0, 5, values);
         }
         return ret;
     }
 
     /**
-     * Implementation of the setAssetManager method in AudioEngine.java
-     * TODO: Optimize how we set the java AssetManager to reach sound in /assets
+     * Implementation of resetLatencyStats method in AudioEngine.java
      */
-    JNIEXPORT void JNICALL Java_com_prettysimple_audio_AudioEngine_setAssetManager(JNIEnv *env, jobject thiz, jobject assetManager)
+    void JNICALL audioEngineResetLatencyStats(JNIEnv *env, jobject thiz)
     {
-        AudioEngine::getInstance()->setAssetManager(assetManager);
+        AudioEngine::getInstance()->resetLatencyStats();
     }
 
     /**
-     * Implementation of pauseAll method in AudioEngine.java
-     * It's a convinient method to easily pause all the sounds at once
+     * Implementation of setAssetCacheCapacity method in AudioEngine.java
+     */
+    void JNICALL audioEngineSetAssetCacheCapacity(JNIEnv *env, jobject thiz, jint count)
+    {
+        AudioEngine::getInstance()->setAssetCacheCapacity(count > 0 ? (size_t) count : 0);
+    }
+
+    /**
+     * Implementation of getAssetCacheStats method in AudioEngine.java
+     * Return [hits, misses, evictions, open fds, cached descriptors]
      */
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioEngine_pauseAll(JNIEnv *env, jobject thiz)
+    jlongArray JNICALL audioEngineGetAssetCacheStats(JNIEnv *env, jobject thiz)
     {
-        return AudioEngine::getInstance()->pauseAll();
+        const AudioAssetCache::Stats stats = AudioEngine::getInstance()->getAssetCacheStats();
+        const jlong values[5] = {(jlong) stats.hits, (jlong) stats.misses, (jlong) stats.evictions, (jlong) stats.openFds, (jlong) stats.cached};
+        jlongArray ret = env->NewLongArray(5);
+        if (ret != nullptr)
+        {
+            env->SetLongArrayRegion(ret, 0, 5, values);
+        }
+        return ret;
+    }
+
+    /**
+     * Implementation of loadSoundBank method in AudioEngine.java
+     */
+    jboolean JNICALL audioEngineLoadSoundBank(JNIEnv *env, jobject thiz, jstring path)
+    {
+        jboolean ret = JNI_FALSE;
+        const char *pathC = env->GetStringUTFChars(path, nullptr);
+        if (pathC != nullptr)
+        {
+            ret = (jboolean) AudioEngine::getInstance()->loadSoundBank(pathC);
+            env->ReleaseStringUTFChars(path, pathC);
+        }
+        return ret;
+    }
+
+    /**
+     * Implementation of unloadSoundBank method in AudioEngine.java
+     */
+    jboolean JNICALL audioEngineUnloadSoundBank(JNIEnv *env, jobject thiz, jstring path)
+    {
+        jboolean ret = JNI_FALSE;
+        const char *pathC = env->GetStringUTFChars(path, nullptr);
+        if (pathC != nullptr)
+        {
+            ret = (jboolean) AudioEngine::getInstance()->unloadSoundBank(pathC);
+            env->ReleaseStringUTFChars(path, pathC);
+        }
+        return ret;
+    }
+
+    /**
+     * Implementation of getSoundBankStats method in AudioEngine.java
+     * Return [banks, sounds, mapped bytes, hits]
+     */
+    jlongArray JNICALL audioEngineGetSoundBankStats(JNIEnv *env, jobject thiz)
+    {
+        const AudioEngine::SoundBankStats stats = AudioEngine::getInstance()->getSoundBankStats();
+        const jlong values[4] = {(jlong) stats.banks, (jlong) stats.sounds, (jlong) stats.bytes, (jlong) stats.hits};
+        jlongArray ret = env->NewLongArray(4);
+        if (ret != nullptr)
+        {
+            env->SetLongArrayRegion(ret, 0, 4, values);
+        }
+        return ret;
+    }
+
+    /**
+     * Implementation of preload method in AudioEngine.java
+     */
+    jint JNICALL audioEnginePreload(JNIEnv *env, jobject thiz, jobjectArray paths, jobject listener)
+    {
+        std::vector<std::string> pathsC;
+        const jsize count = paths != nullptr ? env->GetArrayLength(paths) : 0;
+        pathsC.reserve((size_t) count);
+        for (jsize i = 0; i < count; ++i)
+        {
+            jstring path = static_cast<jstring>(env->GetObjectArrayElement(paths, i));
+            const char *pathC = path != nullptr ? env->GetStringUTFChars(path, nullptr) : nullptr;
+            if (pathC != nullptr)
+            {
+                pathsC.push_back(pathC);
+                env->ReleaseStringUTFChars(path, pathC);
+            }
+            env->DeleteLocalRef(path);
+        }
+        std::unique_ptr<AudioPreloader::Listener> listenerC;
+        if (listener != nullptr)
+        {
+            listenerC.reset(new JavaPreloadListener(env, listener));
+        }
+        return AudioEngine::getInstance()->preload(pathsC, std::move(listenerC));
+    }
+
+    /**
+     * Implementation of unload method in AudioEngine.java
+     */
+    void JNICALL audioEngineUnload(JNIEnv *env, jobject thiz, jobjectArray paths)
+    {
+        const jsize count = paths != nullptr ? env->GetArrayLength(paths) : 0;
+        for (jsize i = 0; i < count; ++i)
+        {
+            jstring path = static_cast<jstring>(env->GetObjectArrayElement(paths, i));
+            const char *pathC = path != nullptr ? env->GetStringUTFChars(path, nullptr) : nullptr;
+            if (pathC != nullptr)
+            {
+                AudioEngine::getInstance()->unload(pathC);
+                env->ReleaseStringUTFChars(path, pathC);
+            }
+            env->DeleteLocalRef(path);
+        }
+    }
+
+    const JNINativeMethod gAudioPlayerMethods[] = {
+        {"nativeInit", "(Ljava/lang/String;FZII)I", (void *) audioPlayerInit},
+        {"nativeStop", "(I)Z", (void *) audioPlayerStop},
+        {"nativePlay", "(I)Z", (void *) audioPlayerPlay},
+        {"nativePause", "(I)Z", (void *) audioPlayerPause},
+        {"nativeResume", "(I)Z", (void *) audioPlayerResume},
+        {"nativeSetParams", "(IFFF)Z", (void *) audioPlayerSetParams},
+        {"nativeSetVolume", "(IF)Z", (void *) audioPlayerSetVolume},
+        {"nativeIsFastPath", "(I)Z", (void *) audioPlayerIsFastPath}
+    };
+
+    const JNINativeMethod gAudioEngineMethods[] = {
+        {"setAssetManager", "(Landroid/content/res/AssetManager;)V", (void *) audioEngineSetAssetManager},
+        {"pauseAll", "()Z", (void *) audioEnginePauseAll},
+        {"resumeAll", "()Z", (void *) audioEngineResumeAll},
+        {"stopAll", "()Z", (void *) audioEngineStopAll},
+        {"playOneShot", "(Ljava/lang/String;FFFII)Z", (void *) audioEnginePlayOneShot},
+        {"createBus", "(Ljava/lang/String;I)I", (void *) audioEngineCreateBus},
+        {"findBus", "(Ljava/lang/String;)I", (void *) audioEngineFindBus},
+        {"setBusVolume", "(IF)Z", (void *) audioEngineSetBusVolume},
+        {"pauseBus", "(I)Z", (void *) audioEnginePauseBus},
+        {"resumeBus", "(I)Z", (void *) audioEngineResumeBus},
+        {"stopBus", "(I)Z", (void *) audioEngineStopBus},
+        {"submit", "(Ljava/nio/ByteBuffer;I)I", (void *) audioEngineSubmit},
+        {"getReclaimStats", "()[J", (void *) audioEngineGetReclaimStats},
+        {"setMaxRealVoices", "(I)V", (void *) audioEngineSetMaxRealVoices},
+        {"getVoiceStats", "()[J", (void *) audioEngineGetVoiceStats},
+        {"setPlayerPoolSize", "(I)V", (void *) audioEngineSetPlayerPoolSize},
+        {"getPlayerPoolStats", "()[J", (void *) audioEngineGetPlayerPoolStats},
+        {"setSampleCacheThreshold", "(I)V", (void *) audioEngineSetSampleCacheThreshold},
+        {"setSampleCacheCapacity", "(I)V", (void *) audioEngineSetSampleCacheCapacity},
+        {"getSampleCacheStats", "()[J", (void *) audioEngineGetSampleCacheStats},
+        {"setMixerEnabled", "(Z)Z", (void *) audioEngineSetMixerEnabled},
+        {"getMixerStats", "()[J", (void *) audioEngineGetMixerStats},
+        {"setStreamingThreshold", "(I)V", (void *) audioEngineSetStreamingThreshold},
+        {"setStreamingBuffer", "(II)V", (void *) audioEngineSetStreamingBuffer},
+        {"getStreamingStats", "()[J", (void *) audioEngineGetStreamingStats},
+        {"getStats", "()[J", (void *) audioEngineGetStats},
+        {"setCommandThreadEnabled", "(Z)V", (void *) audioEngineSetCommandThreadEnabled},
+        {"getCommandStats", "()[J", (void *) audioEngineGetCommandStats},
+        {"getParamsStats", "()[J", (void *) audioEngineGetParamsStats},
+        {"setOutputConfig", "(II)V", (void *) audioEngineSetOutputConfig},
+        {"getLatencyStats", "(I)[J", (void *) audioEngineGetLatencyStats},
+        {"resetLatencyStats", "()V", (void *) audioEngineResetLatencyStats},
+        {"setAssetCacheCapacity", "(I)V", (void *) audioEngineSetAssetCacheCapacity},
+        {"getAssetCacheStats", "()[J", (void *) audioEngineGetAssetCacheStats},
+        {"loadSoundBank", "(Ljava/lang/String;)Z", (void *) audioEngineLoadSoundBank},
+        {"unloadSoundBank", "(Ljava/lang/String;)Z", (void *) audioEngineUnloadSoundBank},
+        {"getSoundBankStats", "()[J", (void *) audioEngineGetSoundBankStats},
+        {"preload", "([Ljava/lang/String;Lcom/prettysimple/audio/AudioPreloadListener;)I", (void *) audioEnginePreload},
+        {"unload", "([Ljava/lang/String;)V", (void *) audioEngineUnload}
+    };
+
+    /**
+     * Cache a GlobalRef on the class and register its natives, return nullptr on failure
+     */
+    jclass registerNatives(JNIEnv *env, const char *className, const JNINativeMethod *methods, const jint count)
+    {
+        jclass ret = nullptr;
+        jclass clazz = env->FindClass(className);
+        if (clazz != nullptr)
+        {
+            if (env->RegisterNatives(clazz, methods, count) == JNI_OK)
+            {
+                ret = static_cast<jclass>(env->NewGlobalRef(clazz));
+            }
+            env->DeleteLocalRef(clazz);
+        }
+        if (ret == nullptr)
+        {
+            LOGEX("RegisterNatives fail");
+        }
+        return ret;
+    }
+}
+
+extern "C"
+{
+    /**
+     * Return the JNIEnv and handle multithreaded env for the code to interact with Java
+     */
+    JNIEnv *getJNIEnv()
+    {
+        JNIEnv *env = nullptr;
+        if (gVm != nullptr)
+        {
+            jint ret = gVm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6);
+            switch (ret)
+            {
+                case JNI_OK :
+                    break;
+                case JNI_EDETACHED :
+                    if (gVm->AttachCurrentThread(&env, NULL) < 0)
+                    {
+                        env = nullptr;
+                    }
+                    break;
+                case JNI_EVERSION :
+                default :
+                    env = nullptr;
+                    break;
+            }
+        }
+        return env;
+    }
+
+    /**
+     * Detach a native thread before it exits, it's a no-op for a thread that was never attached
+     */
+    void detachJNIEnv()
+    {
+        JNIEnv *env = nullptr;
+        if (gVm != nullptr && gVm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) == JNI_OK)
+        {
+            gVm->DetachCurrentThread();
+        }
+    }
+
+    /**
+     * Init the libaudio
+     * Cache JavaVM* and the classes, then register the natives explicitly so the calls skip the symbol lookup
+     */
+    JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved)
+    {
+        JNIEnv *env = nullptr;
+        if (vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) != JNI_OK)
+        {
+            return JNI_ERR;
+        }
+
+        gVm = vm;
+
+        gAudioPlayerClass = registerNatives(env, "com/prettysimple/audio/AudioPlayer", gAudioPlayerMethods, sizeof(gAudioPlayerMethods) / sizeof(gAudioPlayerMethods[0]));
+        gAudioEngineClass = registerNatives(env, "com/prettysimple/audio/AudioEngine", gAudioEngineMethods, sizeof(gAudioEngineMethods) / sizeof(gAudioEngineMethods[0]));
+        if (gAudioPlayerClass == nullptr || gAudioEngineClass == nullptr)
+        {
+            return JNI_ERR;
+        }
+
+        // FindClass only sees the classes of the app from a Java thread, the preload threads use these cached IDs
+        jclass listenerClass = env->FindClass("com/prettysimple/audio/AudioPreloadListener");
+        if (listenerClass == nullptr)
+        {
+            LOGEX("FindClass AudioPreloadListener fail");
+            return JNI_ERR;
+        }
+        gAudioPreloadListenerClass = static_cast<jclass>(env->NewGlobalRef(listenerClass));
+        env->DeleteLocalRef(listenerClass);
+        gOnPathLoaded = env->GetMethodID(gAudioPreloadListenerClass, "onPathLoaded", "(ILjava/lang/String;Z)V");
+        gOnBatchLoaded = env->GetMethodID(gAudioPreloadListenerClass, "onBatchLoaded", "(III)V");
+        if (gOnPathLoaded == nullptr || gOnBatchLoaded == nullptr)
+        {
+            LOGEX("GetMethodID AudioPreloadListener fail");
+            return JNI_ERR;
+        }
+
+        return JNI_VERSION_1_6;
+    }
+
+    /**
+     * Unload libaudio
+     * Make sure that we clean all our singletons correctly if the lib must be unload
+     */
+    JNIEXPORT void JNICALL JNI_OnUnload(JavaVM *vm, void *reserved)
+    {
+        JNIEnv *env = nullptr;
+        if (vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) == JNI_OK)
+        {
+            if (gAudioPlayerClass != nullptr)
+            {
+                env->UnregisterNatives(gAudioPlayerClass);
+                env->DeleteGlobalRef(gAudioPlayerClass);
+                gAudioPlayerClass = nullptr;
+            }
+            if (gAudioEngineClass != nullptr)
+            {
+                env->UnregisterNatives(gAudioEngineClass);
+                env->DeleteGlobalRef(gAudioEngineClass);
+                gAudioEngineClass = nullptr;
+            }
+        }
+        AudioEngine::destroy(); // Drops the pending preloads before the listener IDs go away
+        if (env != nullptr && gAudioPreloadListenerClass != nullptr)
+        {
+            env->DeleteGlobalRef(gAudioPreloadListenerClass);
+            gAudioPreloadListenerClass = nullptr;
+            gOnPathLoaded = nullptr;
+            gOnBatchLoaded = nullptr;
+        }
+        gVm = nullptr;
+    }
+}
+
+AudioEngine *AudioEngine::_instance = nullptr;
+constexpr int AudioEngine::COMMAND_WAIT_MS;
+
+AudioEngine::AudioEngine() : _bankHits(0)
+#ifdef __ANDROID__
+, _backend(new AudioOpenSLBackend())
+#endif
+, _engineObject(nullptr)
+, _engineEngine(nullptr)
+, _outputMixObject(nullptr)
+, _outputSampleRate(0)
+, _framesPerBurst(0)
+, _stopGc(false)
+, _doneGc(false)
+, _gcPending(false)
+, _sweepRequested(false)
+, _reclaimed(0)
+, _reclaimLatencyTotal(0)
+, _reclaimLatencyMax(0)
+, _maxRealVoices(DEFAULT_MAX_REAL_VOICES)
+, _realVoices(0)
+, _virtualVoices(0)
+, _stolen(0)
+, _promoted(0)
+, _culled(0)
+, _mixerEnabled(false)
+, _streamingThreshold(DEFAULT_STREAMING_THRESHOLD)
+, _streamingRingFrames(AudioStream::DEFAULT_RING_FRAMES)
+, _streamingLowWatermarkFrames(AudioStream::DEFAULT_LOW_WATERMARK_FRAMES)
+, _commandsWaiting(false)
+, _stopCommands(false)
+, _commandThreadEnabled(true)
+, _commandsQueued(0)
+, _commandsSucceeded(0)
+, _commandsFailed(0)
+, _commandsStale(0)
+, _commandsDropped(0)
+, _callerCalls(0)
+, _callerLatencyTotal(0)
+, _callerLatencyMax(0)
+, _queueLatencyTotal(0)
+, _queueLatencyMax(0)
+, _paramsWrites(0)
+, _paramsTicks(0)
+, _paramsUpdates(0)
+, _preloader([this](const std::string &fileFullPath) { return preloadPath(fileFullPath); })
+{
+    _streamingCounters.underruns = 0;
+    _streamingCounters.underrunFrames = 0;
+    _streamingCounters.refills = 0;
+    _streamingCounters.active = 0;
+    _paramsUpdating.reserve(AudioParamsQueue::CAPACITY); // The tick never allocates
+
+    _threadCommands = std::thread(&AudioEngine::audioCommandThread, this);
+}
+
+AudioEngine::~AudioEngine()
+{
+    _preloader.stop();
+    stopCommands(); // No caller can create or touch a player anymore
+    stopGc(); // The players must be destroyed before the OpenSL engine
+    { // Delete all the AudioPlayers stored in the engine
+        std::vector<int> audioIds;
+        _players.forEach([&audioIds](const int audioId, AudioPlayer *player)
+        {
+            audioIds.push_back(audioId);
+        });
+        for (const int audioId : audioIds)
+        {
+            AudioPlayer *player = _players.remove(audioId);
+            if (player != nullptr)
+            {
+                player->stop();
+                delete player;
+            }
+        }
+    }
+    _playerPool.clear();
+    _mixer.reset(); // After its voices
+    _sampleCache.clear(); // No player references the PCM anymore
+    {
+        AudioMetrics::Lock lock(_banksMutex, AudioMetrics::TIMER_BANKS_LOCK);
+        _banks.clear(); // Unmapped here, no sample views them anymore
+    }
+    _assetCache.clear(); // Closes the fds
+    clean();
+}
+
+/**
+ * Destroy OpenSL Objects and GC Thread running
+ */
+void AudioEngine::clean() noexcept
+{
+    stopGc();
+
+    if (_outputMixObject)
+    {
+        (*_outputMixObject)->Destroy(_outputMixObject);
+        _outputMixObject = nullptr;
+    }
+    if (_engineObject)
+    {
+        (*_engineObject)->Destroy(_engineObject);
+        _engineObject = nullptr;
+    }
+    _engineEngine = nullptr;
+}
+
+/**
+ * Kill the command thread, the commands still queued are dropped
+ */
+void AudioEngine::stopCommands() noexcept
+{
+    if (_threadCommands.joinable())
+    {
+        {
+            AudioMetrics::Lock lock(_commandsMutex, AudioMetrics::TIMER_COMMANDS_LOCK);
+            _stopCommands = true;
+        }
+        _commandsCondition.notify_all();
+        _threadCommands.join();
+    }
+}
+
+/**
+ * Kill the thread in charge of cleaning up the list of *AudioPlayer
+ */
+void AudioEngine::stopGc() noexcept
+{
+    if (!_doneGc && _threadGc.joinable())
+    {
+        {
+            AudioMetrics::Lock lock(_gcMutex, AudioMetrics::TIMER_GC_LOCK);
+            _stopGc = true;
+        }
+        _condition.notify_all();
+        _threadGc.join();
+        _doneGc = false;
+        _stopGc = false;
+    }
+}
+
+/**
+ * Cleanup the singleton, nothing to do if it was never created
+ * Static so that an unload without any engine doesn't create one with its threads just to delete it
+ */
+void AudioEngine::destroy() noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioEngine::destroy");
+    delete AudioEngine::_instance;
+    AudioEngine::_instance = nullptr;
+}
+
+AudioEngine *AudioEngine::getInstance() noexcept
+{
+    if (_instance == nullptr)
+    {
+        AudioEngine::_instance = new AudioEngine();
+    }
+
+    return AudioEngine::_instance;
+}
+
+/**
+ * Replace the platform under the engine, e.g. an AudioHostBackend on a Linux host
+ * Return false once the OpenSL engine is created: set it before the first sound
+ */
+bool AudioEngine::setBackend(std::unique_ptr<AudioBackend> backend) noexcept
+{
+    AudioMetrics::Lock lock(_openSLMutex, AudioMetrics::TIMER_OPENSL_LOCK);
+    if (_engineObject != nullptr)
+    {
+        return false;
+    }
+    _backend = std::move(backend);
+    return true;
+}
+
+AAssetManager *AudioEngine::getAssetManager() const noexcept
+{
+    return _backend != nullptr ? _backend->getAssetManager() : nullptr;
+}
+
+void AudioEngine::setAssetManager(const jobject assetManager)
+{
+    if (_backend != nullptr)
+    {
+        _backend->setAssetManager(assetManager);
+    }
+}
+
+/**
+ * Native sample rate and burst size of the output (AudioManager PROPERTY_OUTPUT_SAMPLE_RATE and PROPERTY_OUTPUT_FRAMES_PER_BUFFER)
+ * The samples are decoded at this rate and the buffer queues are sized in bursts so their players can get a fast track
+ * Note: Set it before the first sound and before enabling the mixer, the players already created keep their format
+ */
+void AudioEngine::setOutputConfig(const SLuint32 sampleRate, const size_t framesPerBurst) noexcept
+{
+    _outputSampleRate = sampleRate;
+    _framesPerBurst = framesPerBurst;
+    _sampleCache.setSampleRate(sampleRate);
+}
+
+SLuint32 AudioEngine::getOutputSampleRate() const noexcept
+{
+    return _outputSampleRate;
+}
+
+size_t AudioEngine::getFramesPerBurst() const noexcept
+{
+    return _framesPerBurst;
+}
+
+/**
+ * Factory to create *AudioPlayer and easily managed lifecycle of the objects
+ * Once the real voice budget is reached the sound steals a weaker voice or starts virtual, as it does when the platform refuses a player
+ * A source that can't be opened or decoded fails the creation instead
+ * Short assets are decoded once and played from memory, the others stream from their fd
+ */
+AudioPlayer *AudioEngine::createPlayerWithPath(const std::string &fileFullPath, const float volume, const bool loop, const int priority, const int bus) noexcept
+{
+    if (!_buses.isValid(bus))
+    {
+        return nullptr;
+    }
+    const int audioId = _players.reserve(); // -1 if there are already AudioHandleTable::CAPACITY players alive
+    return audioId > 0 ? createPlayer(audioId, fileFullPath, volume, loop, priority, bus) : nullptr;
+}
+
+/**
+ * Reserve an audioId and queue the creation of its player, return -1 if the engine can't take the sound
+ * The caller never waits on OpenSL: the player is created and published later by the command thread
+ */
+int AudioEngine::createPlayerAsync(const std::string &fileFullPath, const float volume, const bool loop, const int priority, const int bus) noexcept
+{
+    AudioCommandQueue::Entry entry;
+    entry.command = AudioCommand::make(AudioCommand::TYPE_CREATE, -1, volume);
+    entry.path = fileFullPath;
+    entry.loop = loop;
+    entry.priority = priority;
+    entry.bus = bus;
+    return enqueueCreate(std::move(entry));
+}
+
+/**
+ * Queue a sound that plays once and is forgotten: the creation and the play are a single command, no audioId is returned
+ * The engine owns the voice until its end, the bus is the only way to pause or stop it
+ * Return false if the engine can't take the sound
+ */
+bool AudioEngine::playOneShot(const std::string &fileFullPath, const float volume, const float pan, const float pitch, const int priority, const int bus) noexcept
+{
+    AudioCommandQueue::Entry entry;
+    entry.command = AudioCommand::make(AudioCommand::TYPE_PLAY_ONE_SHOT, -1, pitch, pan, volume);
+    entry.path = fileFullPath;
+    entry.loop = false;
+    entry.priority = priority;
+    entry.bus = bus;
+    return enqueueCreate(std::move(entry)) > 0;
+}
+
+/**
+ * Reserve the audioId of a TYPE_CREATE or TYPE_PLAY_ONE_SHOT entry and queue it, return -1 if the engine can't take the sound
+ */
+int AudioEngine::enqueueCreate(AudioCommandQueue::Entry &&entry) noexcept
+{
+    const int64_t start = nowNanos();
+    int ret = -1;
+    if (getAssetManager() != nullptr && _buses.isValid(entry.bus))
+    {
+        const int audioId = _players.reserve();
+        if (audioId > 0)
+        {
+            entry.command.audioId = audioId;
+            if (enqueue(std::move(entry)))
+            {
+                ret = audioId;
+            }
+            else if (_commandThreadEnabled) // A failed creation already cancelled the audioId
+            {
+                _players.cancel(audioId);
+            }
+        }
+    }
+    addLatency(_callerLatencyTotal, _callerLatencyMax, (uint64_t) (nowNanos() - start));
+    ++_callerCalls;
+    return ret;
+}
+
+/**
+ * Create the player of a reserved audioId and publish it, the audioId is cancelled on failure
+ * The player starts with the effective gain of its bus, the later changes of the bus are applied by setBusVolume
+ * pan and pitch are applied before the first play, without the ramp of setParams
+ */
+AudioPlayer *AudioEngine::createPlayer(const int audioId, const std::string &fileFullPath, const float volume, const bool loop, const int priority, const int bus,
+                                       const float pan, const float pitch) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioEngine::createPlayer");
+    AudioPlayer *ret = nullptr;
+    if (!initOpenSL() || getAssetManager() == nullptr)
+    {
+        _players.cancel(audioId);
+    }
+    else
+    {
+        const std::shared_ptr<AudioSample> sample = getSample(fileFullPath); // Decode outside of _voicesMutex
+        bool unplayable = sample == nullptr && !canOpen(fileFullPath); // Known before any voice is stolen for the sound
+        const float busGain = _buses.getEffectiveGain(bus);
+        AudioMetrics::Lock lock(_voicesMutex, AudioMetrics::TIMER_VOICES_LOCK);
+        bool init = false;
+        if (unplayable)
+        {
+            LOGEX("createPlayer source fail");
+        }
+        else if (sample == nullptr && isStreamable(fileFullPath)) // Long tracks are decoded progressively by their own thread
+        {
+            ret = new AudioPlayer();
+            ret->setBus(bus, busGain);
+            ret->setStartParams(pan, pitch);
+            init = ret->initStreamed(_engineEngine, _outputMixObject, getAssetManager(), audioId, fileFullPath, volume, loop, priority,
+                                     _streamingRingFrames, _streamingLowWatermarkFrames, &_streamingCounters);
+            if (!init)
+            {
+                delete ret;
+                ret = nullptr;
+            }
+        }
+        else if (_mixerEnabled && _mixer != nullptr && sample != nullptr && _mixer->accepts(*sample))
+        {
+            ret = new AudioPlayer();
+            ret->setBus(bus, busGain);
+            ret->setStartParams(pan, pitch);
+            init = ret->initMixed(_mixer.get(), audioId, fileFullPath, sample, volume, loop, priority);
+            if (!init) // All the voices of the mixer are busy, the sound gets its own player
+            {
+                delete ret;
+                ret = nullptr;
+            }
+        }
+        if (!init && !unplayable && (_realVoices < _maxRealVoices || stealVoice(priority, volume * busGain, false))) // Mixed and streamed voices don't count in the real voice budget
+        {
+            ret = _playerPool.acquire(AudioPlayer::makePoolKey(fileFullPath, sample)); // A pooled player is already realized, only the audioId, volume and loop change
+            if (ret != nullptr)
+            {
+                ret->setBus(bus, busGain);
+                ret->setStartParams(pan, pitch);
+                init = ret->reuse(audioId, fileFullPath, sample, volume, loop, priority);
+                if (!init)
+                {
+                    delete ret;
+                    ret = nullptr;
+                }
+            }
+            if (ret == nullptr)
+            {
+                ret = new AudioPlayer();
+                ret->setBus(bus, busGain);
+                ret->setStartParams(pan, pitch);
+                init = ret->initWithEngine(_engineEngine, _outputMixObject, getAssetManager(), audioId, fileFullPath, sample, volume, loop, priority);
+                while (!init && !ret->isUnplayable() && _playerPool.evictOldest()) // The platform may be out of player objects because of the idle ones
+                {
+                    delete ret;
+                    ret = new AudioPlayer();
+                    ret->setBus(bus, busGain);
+                    ret->setStartParams(pan, pitch);
+                    init = ret->initWithEngine(_engineEngine, _outputMixObject, getAssetManager(), audioId, fileFullPath, sample, volume, loop, priority);
+                }
+            }
+            if (init)
+            {
+                ++_realVoices;
+            }
+            else // The platform ran out of players before the budget: the sound starts virtual as if the budget was reached
+            {
+                unplayable = ret->isUnplayable(); // Unless the source itself failed, a virtual voice would never be promoted
+                delete ret;
+                ret = nullptr;
+            }
+        }
+        if (!init && !unplayable)
+        {
+            ret = new AudioPlayer();
+            ret->setBus(bus, busGain);
+            ret->setStartParams(pan, pitch);
+            init = ret->initVirtual(audioId, fileFullPath, sample, volume, loop, priority, sample != nullptr ? sample->getDurationMs() : getKnownDuration(fileFullPath));
+            if (init)
+            {
+                ++_virtualVoices;
+                notifyGc(); // The GC thread keeps track of the virtual voices
+            }
+        }
+        if (init)
+        {
+            _players.publish(audioId, ret); // /!\ from now on the thread audioPlayerGc can delete the instance
+        }
+        else
+        { // If we are not able to create the AudioPlayer we clean the memory
+            AudioMetrics::count(AudioMetrics::COUNTER_CREATE_FAILED);
+            _players.cancel(audioId);
+            delete ret;
+            ret = nullptr;
+        }
+    }
+    return ret;
+}
+
+/**
+ * Virtualize the weakest real voice if the candidate matters more, _voicesMutex must be held
+ * The weakest voice has the lowest priority, then the lowest audibility, then is the oldest
+ * A strict candidate must beat the weakest voice, a virtual voice taking the place of its equal would swap with it on every pass
+ */
+bool AudioEngine::stealVoice(const int priority, const float audibility, const bool strict) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioEngine::stealVoice");
+    int victimId = -1;
+    int victimPriority = 0;
+    float victimAudibility = 0.f;
+    int64_t victimCreatedAt = 0;
+    _players.forEach([&](const int audioId, AudioPlayer *player)
+    {
+        if (player->isVirtual() || player->isMixed() || player->isStreamed() || player->isRetired())
+        {
+            return;
+        }
+        const int playerPriority = player->getPriority();
+        const float playerAudibility = player->getAudibility();
+        const int64_t playerCreatedAt = player->getCreatedAt();
+        if (victimId < 0
+            || playerPriority < victimPriority
+            || (playerPriority == victimPriority && playerAudibility < victimAudibility)
+            || (playerPriority == victimPriority && playerAudibility == victimAudibility && playerCreatedAt < victimCreatedAt))
+        {
+            victimId = audioId;
+            victimPriority = playerPriority;
+            victimAudibility = playerAudibility;
+            victimCreatedAt = playerCreatedAt;
+        }
+    });
+
+    if (victimId < 0 || priority < victimPriority || (priority == victimPriority && (audibility < victimAudibility || (strict && audibility == victimAudibility))))
+    {
+        return false;
+    }
+
+    const AudioHandleTable::Ref victim = _players.acquire(victimId);
+    if (victim && victim->virtualize())
+    {
+        rememberDuration(victim->getPath(), victim->getDuration());
+        --_realVoices;
+        ++_virtualVoices;
+        ++_stolen;
+        AudioMetrics::count(AudioMetrics::COUNTER_STOLEN);
+        notifyGc();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Promote the virtual voices that matter more than the real ones and cull the virtual one-shots that ended
+ * Run by the GC thread while there are virtual voices
+ */
+void AudioEngine::updateVoices() noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioEngine::updateVoices");
+    AudioMetrics::Lock lock(_voicesMutex, AudioMetrics::TIMER_VOICES_LOCK);
+
+    struct Candidate
+    {
+        int audioId;
+        int priority;
+        float audibility;
+    };
+    std::vector<Candidate> candidates;
+    const int64_t now = nowNanos();
+    _players.forEach([this, &candidates, now](const int audioId, AudioPlayer *player)
+    {
+        if (!player->isVirtual() || player->isRetired())
+        {
+            return;
+        }
+        if (player->isVirtualFinished())
+        {
+            player->setHeadAtEnd(true);
+            if (player->setRetired())
+            {
+                ++_culled;
+                retire(audioId);
+            }
+        }
+        else if (player->isPromotable(now))
+        {
+            candidates.push_back({audioId, player->getPriority(), player->getAudibility()});
+        }
+    });
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+    {
+        return a.priority > b.priority || (a.priority == b.priority && a.audibility > b.audibility);
+    });
+    for (const Candidate &candidate : candidates)
+    {
+        if (_realVoices >= _maxRealVoices && !stealVoice(candidate.priority, candidate.audibility, true))
+        {
+            break;
+        }
+        const AudioHandleTable::Ref player = _players.acquire(candidate.audioId);
+        if (!player)
+        {
+            continue;
+        }
+        if (!player->devirtualize(_engineEngine, _outputMixObject, getAssetManager()))
+        {
+            if (player->isUnplayable()) // Backed off by the voice, the next candidates may play
+            {
+                continue;
+            }
+            break; // The platform is out of players below the budget, the next sweep tries again
+        }
+        ++_realVoices;
+        --_virtualVoices;
+        ++_promoted;
+    }
+}
+
+/**
+ * Change the number of voices allowed to hold an OpenSL player at the same time
+ */
+void AudioEngine::setMaxRealVoices(const size_t count) noexcept
+{
+    _maxRealVoices = (int) count;
+    notifyGc(); // Let the GC thread promote or steal voices against the new budget
+}
+
+AudioEngine::VoiceStats AudioEngine::getVoiceStats() const noexcept
+{
+    VoiceStats stats;
+    stats.real = (uint64_t) std::max(0, _realVoices.load());
+    stats.virtuals = (uint64_t) std::max(0, _virtualVoices.load());
+    stats.stolen = _stolen;
+    stats.promoted = _promoted;
+    stats.culled = _culled;
+    return stats;
+}
+
+/**
+ * Length of a source seen by a previous voice, SL_TIME_UNKNOWN otherwise
+ */
+SLmillisecond AudioEngine::getKnownDuration(const std::string &fileFullPath) noexcept
+{
+    std::lock_guard<std::mutex> lock(_durationsMutex);
+    const auto &it = _durations.find(fileFullPath);
+    return it != _durations.end() ? it->second : SL_TIME_UNKNOWN;
+}
+
+void AudioEngine::rememberDuration(const std::string &fileFullPath, const SLmillisecond duration) noexcept
+{
+    if (duration != SL_TIME_UNKNOWN)
+    {
+        std::lock_guard<std::mutex> lock(_durationsMutex);
+        _durations[fileFullPath] = duration;
+    }
+}
+
+/**
+ * Init the OpenSL audio engine and mix to be able to play sounds
+ */
+bool AudioEngine::initOpenSL() noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioEngine::initOpenSL");
+    AudioMetrics::Lock lock(_openSLMutex, AudioMetrics::TIMER_OPENSL_LOCK);
+    if (_engineEngine != nullptr && _outputMixObject != nullptr)
+    {
+        return true;
+    }
+
+    bool error = true;
+
+    // create engine
+    SLresult result = _backend != nullptr ? _backend->createEngine(&_engineObject) : SL_RESULT_PRECONDITIONS_VIOLATED;
+    if (SL_RESULT_SUCCESS == result)
+    {
+        // realize the engine
+        result = (*_engineObject)->Realize(_engineObject, SL_BOOLEAN_FALSE);
+        if (SL_RESULT_SUCCESS == result)
+        {
+            // get the engine interface, which is needed in order to create other objects
+            result = (*_engineObject)->GetInterface(_engineObject, SL_IID_ENGINE, &_engineEngine);
+            if (SL_RESULT_SUCCESS == result)
+            {
+                // create output mix
+                const SLInterfaceID outputMixIIDs[] = {};
+                const SLboolean outputMixReqs[] = {};
+                result = (*_engineEngine)->CreateOutputMix(_engineEngine, &_outputMixObject, 0, outputMixIIDs, outputMixReqs);
+                if (SL_RESULT_SUCCESS == result)
+                {
+                    // realize the output mix
+                    result = (*_outputMixObject)->Realize(_outputMixObject, SL_BOOLEAN_FALSE);
+                    if (SL_RESULT_SUCCESS == result)
+                    {
+                        if (!_doneGc)
+                        {
+                            _threadGc = std::thread(&AudioEngine::audioPlayerGc, this, 100);
+                        }
+                        error = false;
+                    }
+                    else
+                    {
+                        LOGEX("Realize _outputMixObject fail");
+                    }
+                }
+                else
+                {
+                    LOGEX("CreateOutputMix _engineEngine fail");
+                }
+            }
+            else
+            {
+                LOGEX("GetInterface _engineObject fail");
+            }
+        }
+        else
+        {
+            LOGEX("Realize _engineObject fail");
+        }
+    }
+    else
+    {
+        LOGEX("createEngine _engineObject fail");
+    }
+
+    if (error) // If there is an error I clean the memory
+    {
+        clean();
+    }
+    return !error;
+}
+
+/**
+ * Thread in charge of deleting the *AudioPlayer pushed in the retire queue
+ * It sleeps until a player is retired, players not prefetched enough yet are retried every `sleep` ms
+ */
+void AudioEngine::audioPlayerGc(const int sleep) noexcept
+{
+    std::vector<AudioRetireQueue::Entry> pending;
+    pending.reserve(64);
+    while (!_stopGc)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_gcMutex, std::defer_lock);
+            AudioMetrics::lock(lock, AudioMetrics::TIMER_GC_LOCK);
+            const auto hasWork = [this]() { return _stopGc || _gcPending; };
+            if (pending.empty() && _virtualVoices <= 0) // Put the thread in stasis if there is nothing to reclaim nor virtual voice to track
+            {
+                _condition.wait(lock, hasWork);
+            }
+            else
+            {
+                _condition.wait_for(lock, std::chrono::milliseconds(sleep), hasWork);
+            }
+            _gcPending = false;
+        }
+
+        AUDIO_TRACE_SCOPE("AudioEngine::audioPlayerGc");
+        const int64_t sweepStart = nowNanos();
+        if (_sweepRequested.exchange(false)) // The queue overflowed, fall back on a scan of the live players
+        {
+            const int64_t now = nowNanos();
+            _players.forEach([&pending, now](const int audioId, AudioPlayer *player)
+            {
+                if (player->isHeadAtEnd() && !player->isLooping())
+                {
+                    pending.push_back({audioId, now});
+                }
+            });
+        }
+
+        AudioRetireQueue::Entry entry;
+        while (_retired.pop(entry))
+        {
+            pending.push_back(entry);
+        }
+
+        for (auto it = pending.begin(); it != pending.end();)
+        {
+            if (reclaim(*it))
+            {
+                it = pending.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        if (_virtualVoices > 0)
+        {
+            updateVoices();
+        }
+        AudioMetrics::time(AudioMetrics::TIMER_GC_SWEEP, nowNanos() - sweepStart);
+    }
+    _doneGc = true;
+}
+
+/**
+ * Delete a retired player, return false if it must be retried later
+ */
+bool AudioEngine::reclaim(const AudioRetireQueue::Entry &entry) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioEngine::reclaim");
+    {
+        const AudioHandleTable::Ref player = _players.acquire(entry.audioId);
+        if (!player) // Already reclaimed, a player can be retired by stop() and HEADATEND
+        {
+            return true;
+        }
+        // Note: It's an extra security to only delete a sound that is in a stable enough state
+        // The prefetch callback gives up when the player is busy and OpenSL doesn't call it again, so the status is polled here
+        if (!player->isVirtual() && !player->isPrefetchedSufficient() && player->getPrefetchedStatus() != SL_PREFETCHSTATUS_SUFFICIENTDATA)
+        {
+            return false;
+        }
+    }
+
+    AudioPlayer *player = _players.remove(entry.audioId); // Wait for the callers still using the player before recycling it
+    if (player != nullptr)
+    {
+        if (player->isVirtual())
+        {
+            --_virtualVoices;
+        }
+        else if (!player->isMixed() && !player->isStreamed())
+        {
+            rememberDuration(player->getPath(), player->getDuration());
+            --_realVoices;
+        }
+        player->stop();
+        if (player->reset())
+        {
+            _playerPool.release(player->getPoolKey(), player);
+        }
+        else
+        {
+            delete player;
+        }
+
+        const uint64_t latency = (uint64_t) (nowNanos() - entry.retiredAt);
+        _reclaimed.fetch_add(1, std::memory_order_relaxed);
+        AudioMetrics::count(AudioMetrics::COUNTER_RECLAIMED);
+        _reclaimLatencyTotal.fetch_add(latency, std::memory_order_relaxed);
+        uint64_t max = _reclaimLatencyMax.load(std::memory_order_relaxed);
+        while (latency > max && !_reclaimLatencyMax.compare_exchange_weak(max, latency, std::memory_order_relaxed))
+        {
+        }
+    }
+    return true;
+}
+
+/**
+ * Hand a finished player to the reclaim thread
+ * Safe to call from an OpenSL callback: the queue doesn't allocate and the lock is only held to wake the thread up
+ */
+void AudioEngine::retire(const int audioId) noexcept
+{
+    if (!_retired.push(audioId, nowNanos()))
+    {
+        LOGEX("push _retired fail");
+        _sweepRequested = true;
+    }
+    notifyGc();
+}
+
+/**
+ * Wake the GC thread up
+ */
+void AudioEngine::notifyGc() noexcept
+{
+    {
+        AudioMetrics::Lock lock(_gcMutex, AudioMetrics::TIMER_GC_LOCK);
+        _gcPending = true;
+    }
+    _condition.notify_one();
+}
+
+/**
+ * Change the number of finished players kept realized for the next plays
+ */
+void AudioEngine::setPlayerPoolSize(const size_t size) noexcept
+{
+    _playerPool.setCapacity(size);
+}
+
+AudioPlayerPool::Stats AudioEngine::getPlayerPoolStats() const noexcept
+{
+    return _playerPool.getStats();
+}
+
+/**
+ * Assets up to this compressed size are decoded and played from memory
+ */
+void AudioEngine::setSampleCacheThreshold(const size_t threshold) noexcept
+{
+    _sampleCache.setThreshold(threshold);
+}
+
+/**
+ * Budget of decoded PCM in bytes, the least recently played samples are evicted
+ */
+void AudioEngine::setSampleCacheCapacity(const size_t capacity) noexcept
+{
+    _sampleCache.setCapacity(capacity);
+}
+
+AudioSampleCache::Stats AudioEngine::getSampleCacheStats() const noexcept
+{
+    return _sampleCache.getStats();
+}
+
+/**
+ * Descriptor of an asset of the APK shared by all its players, nullptr if it can't be opened as fd
+ */
+std::shared_ptr<AudioAsset> AudioEngine::acquireAsset(const std::string &fileFullPath) noexcept
+{
+    return _assetCache.acquire(fileFullPath, getAssetManager());
+}
+
+/**
+ * Number of asset descriptors kept open once no player uses them
+ */
+void AudioEngine::setAssetCacheCapacity(const size_t capacity) noexcept
+{
+    _assetCache.setCapacity(capacity);
+}
+
+AudioAssetCache::Stats AudioEngine::getAssetCacheStats() const noexcept
+{
+    return _assetCache.getStats();
+}
+
+/**
+ * Map a sound bank of the APK, its sounds are played from the mapping instead of being decoded
+ * Note: The bank must be stored uncompressed in the APK (noCompress) to be opened as fd
+ */
+bool AudioEngine::loadSoundBank(const std::string &fileFullPath) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioEngine::loadSoundBank");
+    bool ret = false;
+    AAssetManager *assetManager = getAssetManager();
+    if (assetManager != nullptr && !fileFullPath.empty() && fileFullPath[0] != '/')
+    {
+        AAsset *asset = AAssetManager_open(assetManager, assetRelativePath(fileFullPath).c_str(), AASSET_MODE_UNKNOWN);
+        if (asset != nullptr)
+        {
+            off64_t start = 0, length = 0;
+            const int fd = AAsset_openFileDescriptor64(asset, &start, &length);
+            if (fd > 0)
+            {
+                std::shared_ptr<AudioSoundBank> bank = AudioSoundBank::map(fd, start, length);
+                close(fd); // The mapping stays valid
+                if (bank != nullptr)
+                {
+                    AudioMetrics::Lock lock(_banksMutex, AudioMetrics::TIMER_BANKS_LOCK);
+                    auto it = std::find_if(_banks.begin(), _banks.end(), [&fileFullPath](const std::pair<std::string, std::shared_ptr<AudioSoundBank>> &entry)
+                    {
+                        return entry.first == fileFullPath;
+                    });
+                    if (it != _banks.end())
+                    {
+                        it->second = bank;
+                    }
+                    else
+                    {
+                        _banks.emplace_back(fileFullPath, bank);
+                    }
+                    ret = true;
+                }
+            }
+            else
+            {
+                LOGEX("AAsset_openFileDescriptor64 fail, the sound bank must not be compressed");
+            }
+            AAsset_close(asset);
+        }
+    }
+    return ret;
+}
+
+/**
+ * Forget a sound bank, it stays mapped until the last sound playing from it releases its sample
+ */
+bool AudioEngine::unloadSoundBank(const std::string &fileFullPath) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioEngine::unloadSoundBank");
+    AudioMetrics::Lock lock(_banksMutex, AudioMetrics::TIMER_BANKS_LOCK);
+    auto it = std::find_if(_banks.begin(), _banks.end(), [&fileFullPath](const std::pair<std::string, std::shared_ptr<AudioSoundBank>> &entry)
+    {
+        return entry.first == fileFullPath;
+    });
+    if (it == _banks.end())
+    {
+        return false;
+    }
+    _banks.erase(it);
+    return true;
+}
+
+AudioEngine::SoundBankStats AudioEngine::getSoundBankStats() const noexcept
+{
+    AudioMetrics::Lock lock(_banksMutex, AudioMetrics::TIMER_BANKS_LOCK);
+    SoundBankStats stats;
+    stats.banks = _banks.size();
+    stats.sounds = 0;
+    stats.bytes = 0;
+    for (const auto &entry : _banks)
+    {
+        stats.sounds += entry.second->getCount();
+        stats.bytes += entry.second->getBytes();
+    }
+    stats.hits = _bankHits;
+    return stats;
+}
+
+/**
+ * PCM of a path: from the last loaded sound bank having it, otherwise decoded by the sample cache
+ * Return nullptr if the path isn't played from memory
+ */
+std::shared_ptr<AudioSample> AudioEngine::getSample(const std::string &fileFullPath) noexcept
+{
+    {
+        AudioMetrics::Lock lock(_banksMutex, AudioMetrics::TIMER_BANKS_LOCK);
+        for (auto it = _banks.rbegin(); it != _banks.rend(); ++it)
+        {
+            std::shared_ptr<AudioSample> sample = it->second->find(fileFullPath);
+            if (sample != nullptr)
+            {
+                ++_bankHits;
+                return sample;
+            }
+        }
+    }
+    return _sampleCache.get(fileFullPath, _engineEngine, getAssetManager());
+}
+
+/**
+ * Mix the decoded samples in software through a single OpenSL player
+ * The sounds already playing keep their path, only the next ones are affected
+ */
+bool AudioEngine::setMixerEnabled(const bool enabled) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioEngine::setMixerEnabled");
+    if (enabled)
+    {
+        if (!initOpenSL())
+        {
+            return false;
+        }
+        AudioMetrics::Lock lock(_voicesMutex, AudioMetrics::TIMER_VOICES_LOCK);
+        if (_mixer == nullptr)
+        {
+            std::unique_ptr<AudioMixer> mixer(new AudioMixer());
+            const SLuint32 sampleRate = _outputSampleRate;
+            const size_t framesPerBurst = _framesPerBurst;
+            // One burst per buffer at the native rate: the fast mixer pulls a burst per callback
+            if (!mixer->init(_engineEngine, _outputMixObject, sampleRate > 0 ? sampleRate : AudioMixer::DEFAULT_SAMPLE_RATE,
+                             framesPerBurst > 0 ? framesPerBurst : AudioMixer::DEFAULT_BUFFER_FRAMES))
+            {
+                return false;
+            }
+            _mixer.swap(mixer);
+        }
+    }
+    _mixerEnabled = enabled;
+    return true;
+}
+
+/**
+ * Assets from this compressed size stream through a ring instead of an fd player, 0 disables streaming
+ */
+void AudioEngine::setStreamingThreshold(const size_t threshold) noexcept
+{
+    _streamingThreshold = threshold;
+}
+
+/**
+ * Size of the ring of the next streams and the fill level (both in frames) under which the decoder restarts
+ */
+void AudioEngine::setStreamingBuffer(const size_t ringFrames, const size_t lowWatermarkFrames) noexcept
+{
+    _streamingRingFrames = ringFrames;
+    _streamingLowWatermarkFrames = lowWatermarkFrames;
+}
+
+AudioEngine::StreamingStats AudioEngine::getStreamingStats() const noexcept
+{
+    StreamingStats stats;
+    stats.underruns = _streamingCounters.underruns.load(std::memory_order_relaxed);
+    stats.underrunFrames = _streamingCounters.underrunFrames.load(std::memory_order_relaxed);
+    stats.refills = _streamingCounters.refills.load(std::memory_order_relaxed);
+    stats.active = (uint64_t) _streamingCounters.active.load(std::memory_order_relaxed);
+    return stats;
+}
+
+/**
+ * Counters, gauges and lock timers of AudioMetrics, the cache gauges are polled here rather than on every change
+ */
+AudioMetrics::Stats AudioEngine::getStats() const noexcept
+{
+    AudioMetrics::set(AudioMetrics::GAUGE_OPEN_FDS, (int64_t) _assetCache.getStats().openFds);
+    AudioMetrics::set(AudioMetrics::GAUGE_CACHED_BYTES, (int64_t) _sampleCache.getStats().bytes);
+    return AudioMetrics::getStats();
+}
+
+/**
+ * True if the source of a sound can be opened: an asset of the APK openable as fd or a readable file
+ * Note: A source that opens may still fail to decode, the realize of its player tells
+ */
+bool AudioEngine::canOpen(const std::string &fileFullPath) noexcept
+{
+    if (fileFullPath.empty())
+    {
+        return false;
+    }
+    if (fileFullPath[0] == '/')
+    {
+        return access(fileFullPath.c_str(), R_OK) == 0;
+    }
+    return _assetCache.acquire(fileFullPath, getAssetManager()) != nullptr; // Cached for the player opening it right after
+}
+
+/**
+ * True for an asset of the APK at least as big as the streaming threshold
+ */
+bool AudioEngine::isStreamable(const std::string &fileFullPath) noexcept
+{
+    const size_t threshold = _streamingThreshold;
+    if (threshold == 0)
+    {
+        return false;
+    }
+    const std::shared_ptr<AudioAsset> asset = _assetCache.acquire(fileFullPath, getAssetManager()); // The player opens the same descriptor right after
+    return asset != nullptr && (size_t) asset->length >= threshold;
+}
+
+AudioMixer::Stats AudioEngine::getMixerStats() const noexcept
+{
+    AudioMixer::Stats stats = {0, 0, 0, 0};
+    if (_mixer != nullptr)
+    {
+        stats = _mixer->getStats();
+    }
+    return stats;
+}
+
+AudioEngine::ReclaimStats AudioEngine::getReclaimStats() const noexcept
+{
+    ReclaimStats stats;
+    stats.reclaimed = _reclaimed.load(std::memory_order_relaxed);
+    stats.totalLatencyNs = _reclaimLatencyTotal.load(std::memory_order_relaxed);
+    stats.maxLatencyNs = _reclaimLatencyMax.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool AudioEngine::stop(const int audioId) noexcept
+{
+    bool ret = false;
+    const AudioHandleTable::Ref player = _players.acquire(audioId);
+    if (player)
+    {
+        ret = player->stop();
+    }
+    return ret;
+}
+
+bool AudioEngine::play(const int audioId) noexcept
+{
+    bool ret = false;
+    const AudioHandleTable::Ref player = _players.acquire(audioId);
+    if (player)
+    {
+        ret = player->play();
+    }
+    return ret;
+}
+
+bool AudioEngine::pause(const int audioId) noexcept
+{
+    bool ret = false;
+    const AudioHandleTable::Ref player = _players.acquire(audioId);
+    if (player)
+    {
+        ret = player->pause();
+    }
+    return ret;
+}
+
+bool AudioEngine::resume(const int audioId) noexcept
+{
+    bool ret = false;
+    const AudioHandleTable::Ref player = _players.acquire(audioId);
+    if (player)
+    {
+        ret = player->resume();
+    }
+    return ret;
+}
+
+bool AudioEngine::setParams(const int audioId, const float pitch, const float pan, const float volume) noexcept
+{
+    bool ret = false;
+    const AudioHandleTable::Ref player = _players.acquire(audioId);
+    if (player)
+    {
+        ret = player->setParams(pitch, pan, volume);
+        ++_paramsWrites;
+    }
+    return ret;
+}
+
+bool AudioEngine::setVolume(const int audioId, const float volume) noexcept
+{
+    bool ret = false;
+    const AudioHandleTable::Ref player = _players.acquire(audioId);
+    if (player)
+    {
+        ret = player->setVolume(volume);
+        ++_paramsWrites;
+    }
+    return ret;
+}
+
+/**
+ * Queue a batch of commands, return the number of commands queued
+ * A malformed command ends the batch, the commands before it are queued
+ */
+int AudioEngine::submit(const uint8_t *data, const size_t size) noexcept
+{
+    const int64_t start = nowNanos();
+    int ret = 0;
+    size_t offset = 0;
+    AudioCommandQueue::Entry entry;
+    while (offset < size)
+    {
+        const size_t length = AudioCommand::read(data + offset, size - offset, entry.command);
+        if (length == 0)
+        {
+            LOGEX("submit malformed command");
+            break;
+        }
+        offset += length;
+        if (enqueue(std::move(entry)))
+        {
+            ++ret;
+        }
+    }
+    addLatency(_callerLatencyTotal, _callerLatencyMax, (uint64_t) (nowNanos() - start));
+    ++_callerCalls;
+    return ret;
+}
+
+/**
+ * Queue a command for the command thread, return false if it can't be queued
+ * Note: The result of the command itself is only known once it ran, see getCommandStats
+ */
+bool AudioEngine::post(const AudioCommand &command) noexcept
+{
+    const int64_t start = nowNanos();
+    AudioCommandQueue::Entry entry;
+    entry.command = command;
+    const bool ret = enqueue(std::move(entry));
+    addLatency(_callerLatencyTotal, _callerLatencyMax, (uint64_t) (nowNanos() - start));
+    ++_callerCalls;
+    return ret;
+}
+
+/**
+ * Hand a command to the command thread, or run it right away when the thread is disabled
+ */
+bool AudioEngine::enqueue(AudioCommandQueue::Entry &&entry) noexcept
+{
+    entry.queuedAt = nowNanos();
+    if (!_commandThreadEnabled)
+    {
+        return execute(entry);
+    }
+    if (!_commands.push(std::move(entry)))
+    {
+        LOGEX("push _commands fail");
+        ++_commandsDropped;
+        return false;
+    }
+    ++_commandsQueued;
+    notifyCommands();
+    return true;
+}
+
+/**
+ * Wake the command thread up if it sleeps, called once the work is visible to it
+ */
+void AudioEngine::notifyCommands() noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst); // Pairs with the fence of audioCommandThread, a wake-up can't be missed
+    if (_commandsWaiting.load(std::memory_order_relaxed))
+    {
+        AudioMetrics::Lock lock(_commandsMutex, AudioMetrics::TIMER_COMMANDS_LOCK);
+        _commandsCondition.notify_one();
+    }
+}
+
+/**
+ * Thread running the commands of the Java callers in order, all the OpenSL work they trigger happens here
+ * It also ticks every PARAMS_TICK_MS while voices wait for their volume, pan or pitch
+ * It sleeps while the queue is empty and no voice waits, the timed wait only bounds a lost wake-up
+ */
+void AudioEngine::audioCommandThread() noexcept
+{
+    AudioCommandQueue::Entry entry;
+    int64_t tickAt = 0;
+    while (!_stopCommands)
+    {
+        if (!_paramsPending.empty() && nowNanos() >= tickAt)
+        {
+            tickAt = nowNanos() + (int64_t) PARAMS_TICK_MS * 1000000;
+            updateParams();
+        }
+        if (_commands.pop(entry))
+        {
+            execute(entry);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(_commandsMutex, std::defer_lock);
+        AudioMetrics::lock(lock, AudioMetrics::TIMER_COMMANDS_LOCK);
+        _commandsWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_commands.empty() && !_stopCommands)
+        {
+            const int64_t waitNs = !_paramsPending.empty() ? tickAt - nowNanos() : (int64_t) COMMAND_WAIT_MS * 1000000; // Until the next tick while a ramp is in flight
+            if (waitNs > 0)
+            {
+                _commandsCondition.wait_for(lock, std::chrono::nanoseconds(waitNs));
+            }
+        }
+        _commandsWaiting.store(false, std::memory_order_relaxed);
+    }
+    while (_commands.pop(entry)) // The engine is destroyed, the pending sounds are never created
+    {
+        if (entry.command.type == AudioCommand::TYPE_CREATE || entry.command.type == AudioCommand::TYPE_PLAY_ONE_SHOT)
+        {
+            _players.cancel(entry.command.audioId);
+        }
+        ++_commandsDropped;
+    }
+    detachJNIEnv(); // getAssetManager attached the thread to the JavaVM
+}
+
+/**
+ * Queue a voice for the next tick, called once per voice by AudioPlayer::requestUpdate whatever the number of writes
+ * Lock-free and without allocation, only the write that makes the queue non-empty wakes the command thread up
+ * The tick runs on the command thread even when the commands run on the callers
+ */
+bool AudioEngine::requestParamsUpdate(const int audioId) noexcept
+{
+    bool wasEmpty = false;
+    if (!_paramsPending.push(audioId, wasEmpty))
+    {
+        LOGEX("push _paramsPending fail");
+        return false;
+    }
+    if (wasEmpty) // The writes of a fade or of the other voices find the thread awake until the queue drains
+    {
+        notifyCommands();
+    }
+    return true;
+}
+
+/**
+ * Tick of the command thread: one update of each voice written since the last tick, the ones still ramping stay queued
+ * The OpenSL calls of a frame are bounded by the number of voices that changed, not by the number of writes
+ */
+void AudioEngine::updateParams() noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioEngine::updateParams");
+    int pending = 0;
+    while (_paramsUpdating.size() < AudioParamsQueue::CAPACITY && _paramsPending.pop(pending)) // The voices still ramping are queued again for the next tick
+    {
+        _paramsUpdating.push_back(pending);
+    }
+    const float step = (float) PARAMS_TICK_MS / PARAMS_RAMP_MS;
+    uint64_t updates = 0;
+    for (const int audioId : _paramsUpdating)
+    {
+        const AudioHandleTable::Ref player = _players.acquire(audioId);
+        if (player)
+        {
+            ++updates;
+            if (player->updateParams(step))
+            {
+                player->requestUpdate();
+            }
+        }
+    }
+    _paramsUpdates.fetch_add(updates, std::memory_order_relaxed);
+    ++_paramsTicks;
+    _paramsUpdating.clear();
+}
+
+AudioEngine::ParamsStats AudioEngine::getParamsStats() const noexcept
+{
+    ParamsStats stats;
+    stats.writes = _paramsWrites.load(std::memory_order_relaxed);
+    stats.ticks = _paramsTicks.load(std::memory_order_relaxed);
+    stats.updates = _paramsUpdates.load(std::memory_order_relaxed);
+    return stats;
+}
+
+/**
+ * Run a command on the command thread (or the caller when the thread is disabled)
+ */
+bool AudioEngine::execute(const AudioCommandQueue::Entry &entry) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioEngine::execute");
+    bool ret = false;
+    const AudioCommand &command = entry.command;
+    switch (command.type)
+    {
+        case AudioCommand::TYPE_CREATE:
+            ret = createPlayer(command.audioId, entry.path, command.args[0], entry.loop, entry.priority, entry.bus) != nullptr;
+            if (ret)
+            {
+                recordLatency(LATENCY_CREATE, nowNanos() - entry.queuedAt);
+            }
+            break;
+        case AudioCommand::TYPE_PLAY_ONE_SHOT:
+            ret = createPlayer(command.audioId, entry.path, command.args[2], false, entry.priority, entry.bus, command.args[1], command.args[0]) != nullptr;
+            if (ret)
+            {
+                recordLatency(LATENCY_CREATE, nowNanos() - entry.queuedAt);
+                ret = apply(AudioCommand::make(AudioCommand::TYPE_PLAY, command.audioId), entry.queuedAt);
+                if (!ret) // Nobody else knows the audioId, a player that never plays would never end
+                {
+                    apply(AudioCommand::make(AudioCommand::TYPE_STOP, command.audioId), entry.queuedAt);
+                }
+            }
+            break;
+        case AudioCommand::TYPE_STOP_ALL:
+            ret = stopAll();
+            break;
+        case AudioCommand::TYPE_PAUSE_ALL:
+            ret = pauseAll();
+            break;
+        case AudioCommand::TYPE_RESUME_ALL:
+            ret = resumeAll();
+            break;
+        case AudioCommand::TYPE_UNLOAD:
+            ret = unloadPath(entry.path);
+            break;
+        case AudioCommand::TYPE_SET_BUS_VOLUME:
+            ret = setBusVolume(command.audioId, command.args[0]);
+            break;
+        case AudioCommand::TYPE_PAUSE_BUS:
+            ret = pauseBus(command.audioId);
+            break;
+        case AudioCommand::TYPE_RESUME_BUS:
+            ret = resumeBus(command.audioId);
+            break;
+        case AudioCommand::TYPE_STOP_BUS:
+            ret = stopBus(command.audioId);
+            break;
+        default:
+            ret = apply(command, entry.queuedAt);
+            break;
     }
-
-    /**
-      * Implementation of pauseAll method in AudioEngine.java
-      * It's a convinient method to easily pause all the sounds at once
-      */
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioEngine_resumeAll(JNIEnv *env, jobject thiz)
+    if (ret)
     {
-        return AudioEngine::getInstance()->resumeAll();
+        ++_commandsSucceeded;
     }
-
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioEngine_stopAll(JNIEnv *env, jobject thiz)
+    else
     {
-        return AudioEngine::getInstance()->stopAll();
+        ++_commandsFailed;
     }
+    addLatency(_queueLatencyTotal, _queueLatencyMax, (uint64_t) (nowNanos() - entry.queuedAt));
+    return ret;
 }
 
-AudioEngine *AudioEngine::_instance = nullptr;
-
-AudioEngine::AudioEngine() : _audioIds(0)
-, _engineObject(nullptr)
-, _engineEngine(nullptr)
-, _outputMixObject(nullptr)
-, _assetManager(nullptr)
-, _stopGc(false)
-, _doneGc(false)
-{
-}
-
-AudioEngine::~AudioEngine()
+/**
+ * Apply a command of the stream to its player, return false if the player is gone or refused it
+ * requestedAt is the time of the call of the caller, the latencies of a play are measured from it
+ * A play or a resume on a paused bus only pauses the player, it starts when the bus is resumed
+ */
+bool AudioEngine::apply(const AudioCommand &command, const int64_t requestedAt) noexcept
 {
-    clean();
-    { // Delete all the AudioPlayers stored in the engine
-        std::lock_guard<std::mutex> lock(_playersMutex);
-        for (auto it = _players.begin(); it != _players.end();)
+    bool ret = false;
+    const AudioHandleTable::Ref player = _players.acquire(command.audioId);
+    if (player)
+    {
+        switch (command.type)
         {
-            it->second->stop();
-            const AudioPlayer *tmp = it->second;
-            it = _players.erase(it);
-            delete tmp;
+            case AudioCommand::TYPE_PLAY:
+                if (_buses.isPaused(player->getBus()))
+                {
+                    ret = player->pause();
+                    break;
+                }
+                player->markPlayRequested(requestedAt);
+                ret = player->play();
+                if (ret)
+                {
+                    recordLatency(LATENCY_START, nowNanos() - requestedAt);
+                }
+                break;
+            case AudioCommand::TYPE_STOP:
+                ret = player->stop();
+                break;
+            case AudioCommand::TYPE_PAUSE:
+                ret = player->pause();
+                break;
+            case AudioCommand::TYPE_RESUME:
+                ret = _buses.isPaused(player->getBus()) ? player->pause() : player->resume();
+                break;
+            case AudioCommand::TYPE_SET_VOLUME:
+                ret = player->setVolume(command.args[0]);
+                ++_paramsWrites;
+                break;
+            case AudioCommand::TYPE_SET_PARAMS:
+                ret = player->setParams(command.args[0], command.args[1], command.args[2]);
+                ++_paramsWrites;
+                break;
+            default:
+                break;
         }
     }
-    JNIEnv *jenv = getJNIEnv(); // Delete the GlobalRef on AssetManager to be GC
-    if (jenv != nullptr && _assetManager != nullptr)
+    else
     {
-        jenv->DeleteGlobalRef(_assetManager);
-        _assetManager = nullptr;
+        ++_commandsStale; // Expected from a game that doesn't track the end of its sounds
     }
-    _audioIds = 0;
+    return ret;
 }
 
 /**
- * Destroy OpenSL Objects and GC Thread running
+ * Warm a batch of paths on the preload threads, return the id of the batch or -1
  */
-void AudioEngine::clean() noexcept
+int AudioEngine::preload(const std::vector<std::string> &paths, std::unique_ptr<AudioPreloader::Listener> listener) noexcept
 {
-    if (_outputMixObject)
+    return _preloader.preload(paths, std::move(listener));
+}
+
+/**
+ * Warm a path for its first play, run by a preload thread
+ * Short assets are decoded in the sample cache, the other ones leave a prefetched fd player in the AudioPlayerPool
+ * A long track only gets its asset checked: a stream opens its own decoder when it plays
+ */
+bool AudioEngine::preloadPath(const std::string &fileFullPath) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioEngine::preloadPath");
+    if (!initOpenSL() || getAssetManager() == nullptr)
     {
-        (*_outputMixObject)->Destroy(_outputMixObject);
-        _outputMixObject = nullptr;
+        return false;
     }
-    if (_engineObject)
+    const std::shared_ptr<AudioSample> sample = getSample(fileFullPath);
+    if (sample != nullptr)
     {
-        (*_engineObject)->Destroy(_engineObject);
-        _engineObject = nullptr;
+        return true;
+    }
+    if (isStreamable(fileFullPath))
+    {
+        return true;
     }
-    _engineEngine = nullptr;
 
-    if (!_doneGc && _threadGc.joinable()) // Kill the thread in charge of cleaning up the list of *AudioPlayer
+    AudioPlayer *player = new AudioPlayer();
+    if (!player->prefetch(_engineEngine, _outputMixObject, getAssetManager(), fileFullPath, PRELOAD_TIMEOUT_MS))
     {
-        _stopGc = true;
-        _condition.notify_all();
-        _threadGc.join();
-        _doneGc = false;
-        _stopGc = false;
+        delete player;
+        return false;
     }
+    rememberDuration(fileFullPath, player->getDuration()); // Lets a virtual voice of this path end on time
+    _playerPool.release(player->getPoolKey(), player); // Bounded by the pool capacity like any idle player
+    return true;
 }
 
 /**
- * Cleanup the singleton
+ * Queue the release of what preload() kept for a path, return false if it can't be queued
  */
-void AudioEngine::destroy() noexcept
+bool AudioEngine::unload(const std::string &fileFullPath) noexcept
 {
-    delete AudioEngine::_instance;
-    AudioEngine::_instance = nullptr;
+    AudioCommandQueue::Entry entry;
+    entry.command = AudioCommand::make(AudioCommand::TYPE_UNLOAD, 0);
+    entry.path = fileFullPath;
+    return enqueue(std::move(entry));
 }
 
-AudioEngine *AudioEngine::getInstance() noexcept
+/**
+ * Drop the decoded sample and the idle players of a path, the sounds still playing it keep theirs
+ */
+bool AudioEngine::unloadPath(const std::string &fileFullPath) noexcept
 {
-    if (_instance == nullptr)
-    {
-        AudioEngine::_instance = new AudioEngine();
-    }
-
-    return AudioEngine::_instance;
+    AUDIO_TRACE_SCOPE("AudioEngine::unloadPath");
+    const bool removed = _sampleCache.remove(fileFullPath);
+    const bool erased = _playerPool.erase(AudioPlayer::makePoolKey(fileFullPath, nullptr)) > 0;
+    return _assetCache.remove(fileFullPath) || removed || erased; // After the players, the fd closes with the last one
 }
 
 /**
- * Return the AAssetMaanger from the jobect stored as GlobalRef
+ * Run the commands on the caller thread when disabled, to measure the caller latency without the command thread
+ * Note: Disable it while no command is queued, the direct calls would overtake them
  */
-AAssetManager *AudioEngine::getAssetManager() const noexcept
+void AudioEngine::setCommandThreadEnabled(const bool enabled) noexcept
+{
+    _commandThreadEnabled = enabled;
+}
+
+AudioEngine::CommandStats AudioEngine::getCommandStats() const noexcept
+{
+    CommandStats stats;
+    stats.queued = _commandsQueued.load(std::memory_order_relaxed);
+    stats.succeeded = _commandsSucceeded.load(std::memory_order_relaxed);
+    stats.failed = _commandsFailed.load(std::memory_order_relaxed);
+    stats.stale = _commandsStale.load(std::memory_order_relaxed);
+    stats.dropped = _commandsDropped.load(std::memory_order_relaxed);
+    stats.calls = _callerCalls.load(std::memory_order_relaxed);
+    stats.totalCallerNs = _callerLatencyTotal.load(std::memory_order_relaxed);
+    stats.maxCallerNs = _callerLatencyMax.load(std::memory_order_relaxed);
+    stats.totalQueueNs = _queueLatencyTotal.load(std::memory_order_relaxed);
+    stats.maxQueueNs = _queueLatencyMax.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AudioEngine::addLatency(std::atomic<uint64_t> &total, std::atomic<uint64_t> &max, const uint64_t latency) noexcept
 {
-    JNIEnv *jenv = getJNIEnv();
-    AAssetManager *ret = nullptr;
-    if (_assetManager != nullptr && jenv != nullptr)
+    total.fetch_add(latency, std::memory_order_relaxed);
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (latency > current && !max.compare_exchange_weak(current, latency, std::memory_order_relaxed))
     {
-        ret = AAssetManager_fromJava(jenv, _assetManager);
     }
-    return ret;
 }
 
 /**
- * Store AssetManager jobject as GlobalRef
+ * Stop all AudioPlayers
  */
-void AudioEngine::setAssetManager(const jobject assetManager)
+bool AudioEngine::stopAll() noexcept
 {
-    JNIEnv *jenv = getJNIEnv();
-    if (jenv != nullptr) {
-        if (_assetManager != nullptr) // Just a security to make sure that we don't create too many GlobalRef
-        {
-            jenv->DeleteGlobalRef(_assetManager);
-            _assetManager = nullptr;
-        }
-        if (assetManager != nullptr)
-        {
-            _assetManager = jenv->NewGlobalRef(assetManager);
-        }
-    }
+    return stopBus(AudioBusTable::BUS_MASTER);
 }
 
 /**
- * Factory to create *AudioPlayer and easily managed lifecycle of the objects
+ * Pause all AudioPlayers, the sounds played meanwhile wait for resumeAll
  */
-AudioPlayer *AudioEngine::createPlayerWithPath(const std::string &fileFullPath, const float volume, const bool loop) noexcept
+bool AudioEngine::pauseAll() noexcept
 {
-    AudioPlayer *ret = nullptr;
-    if (initOpenSL() && _assetManager != nullptr)
+    return pauseBus(AudioBusTable::BUS_MASTER);
+}
+
+void AudioEngine::setHeadAtEnd(const int audioId) noexcept
+{
+    const AudioHandleTable::Ref player = _players.acquire(audioId);
+    if (player)
     {
-        ret = new AudioPlayer();
-        const bool init = ret->initWithEngine(_engineEngine, _outputMixObject, getAssetManager(),  ++_audioIds, fileFullPath, volume, loop);
-        if (init)
+        player->setHeadAtEnd(true);
+        if (!player->isLooping() && player->setRetired())
         {
-            std::lock_guard<std::mutex> lock(_playersMutex); // /!\ a thread (audioPlayerGc) in charge of deleting instances of AudioEngine is running
-            _players[_audioIds] = ret;
-            _condition.notify_one(); // to decrease cpu usage of the thread he can be in stasis
-        }
-        else
-        { // If we are not able to create the AudioPlayer we clean the memory
-            delete ret;
-            ret = nullptr;
+            retire(audioId);
         }
     }
-    return ret;
 }
 
 /**
- * Init the OpenSL audio engine and mix to be able to play sounds
+ * The buffer queue of a decoded sample is empty: loop it or retire the player like on HEADATEND
  */
-bool AudioEngine::initOpenSL() noexcept
+void AudioEngine::onBufferQueueEnd(const int audioId, SLAndroidSimpleBufferQueueItf bufferQueue) noexcept
 {
-    if (_engineEngine != nullptr && _outputMixObject != nullptr)
-    {
-        return true;
-    }
-
-    bool error = true;
-
-    // create engine
-    SLEngineOption EngineOption[] = { (SLuint32) SL_ENGINEOPTION_THREADSAFE, (SLuint32) SL_BOOLEAN_TRUE };
-
-    SLresult result = slCreateEngine(&_engineObject, 1, EngineOption, 0, NULL, NULL);
-    if (SL_RESULT_SUCCESS == result)
+    const AudioHandleTable::Ref player = _players.acquire(audioId);
+    if (player && !player->requeue(bufferQueue))
     {
-        // realize the engine
-        result = (*_engineObject)->Realize(_engineObject, SL_BOOLEAN_FALSE);
-        if (SL_RESULT_SUCCESS == result)
-        {
-            // get the engine interface, which is needed in order to create other objects
-            result = (*_engineObject)->GetInterface(_engineObject, SL_IID_ENGINE, &_engineEngine);
-            if (SL_RESULT_SUCCESS == result)
-            {
-                // create output mix
-                const SLInterfaceID outputMixIIDs[] = {};
-                const SLboolean outputMixReqs[] = {};
-                result = (*_engineEngine)->CreateOutputMix(_engineEngine, &_outputMixObject, 0, outputMixIIDs, outputMixReqs);
-                if (SL_RESULT_SUCCESS == result)
-                {
-                    // realize the output mix
-                    result = (*_outputMixObject)->Realize(_outputMixObject, SL_BOOLEAN_FALSE);
-                    if (SL_RESULT_SUCCESS == result)
-                    {
-                        if (!_doneGc)
-                        {
-                            _threadGc = std::thread(&AudioEngine::audioPlayerGc, this, 100);
-
-                            // TODO: Remove this trhead that is only used to rerproduce a bug in OpenSL Destroy Object will be fixed.
-                            _threadTest = std::thread(&AudioEngine::audioPlayerTest, this, 4 * 16);
-                        }
-                        error = false;
-                    }
-                    else
-                    {
-                        LOGEX("Realize _outputMixObject fail");
-                    }
-                }
-                else
-                {
-                    LOGEX("CreateOutputMix _engineEngine fail");
-                }
-            }
-            else
-            {
-                LOGEX("GetInterface _engineObject fail");
-            }
-        }
-        else
+        player->setHeadAtEnd(true);
+        if (player->setRetired())
         {
-            LOGEX("Realize _engineObject fail");
+            retire(audioId);
         }
     }
-    else
-    {
-        LOGEX("slCreateEngine _engineObject fail");
-    }
+}
 
-    if (error) // If there is an error I clean the memory
+/**
+ * First head movement of a player after a play request, from its play callback
+ */
+void AudioEngine::onHeadMoved(const int audioId, SLPlayItf play) noexcept
+{
+    const AudioHandleTable::Ref player = _players.acquire(audioId);
+    if (player)
     {
-        clean();
+        player->onHeadMoved(play);
     }
-    return !error;
 }
 
 /**
- * Thread in charge of deleting *AudioPlayer to keep the memory clean
+ * Lock-free, called from the OpenSL callbacks and the audio callbacks
  */
-void AudioEngine::audioPlayerGc(const int sleep) noexcept
+void AudioEngine::recordLatency(const LatencyStage stage, const int64_t latencyNs) noexcept
 {
-    while (!_stopGc)
-    {
-        size_t playersLength = 0;
-        { // We check if there is an *AudioPlayer that can be destroyed (there is a limit of AudioPlayer that can run at the same time)
-            std::lock_guard<std::mutex> lock(_playersMutex);
-            for (auto it = _players.begin(); it != _players.end();)
-            {
-                if (it->second->isHeadAtEnd() && it->second->isPrefetchedSufficient() && !it->second->isLooping())
-                {
-                    it->second->stop();
-                    const AudioPlayer *tmp = it->second;
-                    it = _players.erase(it);
-                    delete tmp;
-                }
-                else
-                {
-                    ++it;
-                }
-            }
-            playersLength = _players.size();
-        }
-        if (playersLength <= 0) // Put the thread in stasis if there are no sounds playing
-        {
-            std::unique_lock<std::mutex> lock(_pauselMutex);
-            _condition.wait(lock);
-        }
-        std::this_thread::yield();
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleep));
-    }
-    _doneGc = true;
+    _latencies[stage].record(latencyNs);
 }
 
-void AudioEngine::audioPlayerTest(const int sleep) noexcept
+AudioHistogram::Snapshot AudioEngine::getLatencyStats(const LatencyStage stage) const noexcept
 {
-    int audioId = -1;
-    bool leftPlaying = false;
-    AudioPlayer *sound = nullptr;
-    std::string soundPath = "";
+    return _latencies[stage].snapshot();
+}
 
-    while (!_stopGc)
+/**
+ * Start a new measure, e.g. at the beginning of a level
+ */
+void AudioEngine::resetLatencyStats() noexcept
+{
+    for (AudioHistogram &histogram : _latencies)
     {
-        if (audioId != -1)
-        {
-            std::lock_guard<std::mutex> lock(_playersMutex);
-            const auto &it = _players.find(audioId);
-            if (it != _players.end())
-            {
-                it->second->stop();
-                audioId = -1;
-            }
-        }
-
-        if (!leftPlaying)
-        {
-            soundPath = "cse_dialog1.ogg";
-        }
-        else
-        {
-            soundPath = "cse_dialog2.ogg";
-        }
-
-        leftPlaying = !leftPlaying;
-
-        sound = createPlayerWithPath(soundPath, 1.f, true);
-        if (sound != nullptr)
-        {
-            sound->play();
-            audioId = sound->getPlayerId();
-        }
-        std::this_thread::yield();
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleep));
+        histogram.reset();
     }
 }
 
-bool AudioEngine::stop(const int audioId) noexcept
+/**
+ * Whether the sound got a fast track, false until its player is created
+ */
+bool AudioEngine::isFastPath(const int audioId) noexcept
 {
     bool ret = false;
-    std::lock_guard<std::mutex> lock(_playersMutex);
-    const auto &it = _players.find(audioId);
-    if (it != _players.end())
+    const AudioHandleTable::Ref player = _players.acquire(audioId);
+    if (player)
     {
-        ret = it->second->stop();
+        ret = player->isFastPath();
     }
     return ret;
 }
 
-bool AudioEngine::play(const int audioId) noexcept
+SLuint32 AudioEngine::getPrefetchedStatus(const int audioId) noexcept
 {
-    bool ret = false;
-    std::lock_guard<std::mutex> lock(_playersMutex);
-    const auto &it = _players.find(audioId);
-    if (it != _players.end())
+    SLuint32 ret = 0;
+    const AudioHandleTable::Ref player = _players.acquire(audioId);
+    if (player)
     {
-        ret = it->second->play();
+        ret = player->getPrefetchedStatus();
     }
     return ret;
 }
 
-bool AudioEngine::pause(const int audioId) noexcept
+/**
+ * Resume all AudioPlayers but the ones of a bus still paused
+ */
+bool AudioEngine::resumeAll() noexcept
 {
-    bool ret = false;
-    std::lock_guard<std::mutex> lock(_playersMutex);
-    const auto &it = _players.find(audioId);
-    if (it != _players.end())
-    {
-        ret = it->second->pause();
-    }
-    return ret;
+    return resumeBus(AudioBusTable::BUS_MASTER);
 }
 
-bool AudioEngine::resume(const int audioId) noexcept
+/**
+ * Create a user bus under parent, return its id or -1
+ * A name already in use returns its bus
+ */
+int AudioEngine::createBus(const std::string &name, const int parent) noexcept
 {
-    bool ret = false;
-    std::lock_guard<std::mutex> lock(_playersMutex);
-    const auto &it = _players.find(audioId);
-    if (it != _players.end()) {
-        ret = it->second->resume();
-    }
-    return ret;
+    return _buses.create(name, parent);
 }
 
-bool AudioEngine::setParams(const int audioId, const float pitch, const float pan, const float volume) noexcept
+int AudioEngine::findBus(const std::string &name) const noexcept
 {
-    bool ret = false;
-    std::lock_guard<std::mutex> lock(_playersMutex);
-    const auto &it = _players.find(audioId);
-    if (it != _players.end())
-    {
-        ret = it->second->setParams(pitch, pan, volume);
-    }
-    return ret;
+    return _buses.find(name);
 }
 
-bool AudioEngine::setVolume(const int audioId, const float volume) noexcept
+/**
+ * Snapshot of the audioIds of the players attached to the bus or to one of its descendants
+ * The players are then handled one by one through acquire, none is pinned while an other one is changed
+ */
+std::vector<int> AudioEngine::getBusPlayers(const int bus) noexcept
 {
-    bool ret = false;
-    std::lock_guard<std::mutex> lock(_playersMutex);
-    const auto &it = _players.find(audioId);
-    if (it != _players.end()) {
-        ret = it->second->setVolume(volume);
-    }
+    std::vector<int> ret;
+    _players.forEach([this, bus, &ret](const int audioId, AudioPlayer *player)
+    {
+        if (_buses.contains(bus, player->getBus()))
+        {
+            ret.push_back(audioId);
+        }
+    });
     return ret;
 }
 
 /**
- * Stop all AudioPlayers
+ * Change the gain of a bus and apply the new effective gain to the players of its subtree
  */
-bool AudioEngine::stopAll() noexcept
+bool AudioEngine::setBusVolume(const int bus, const float volume) noexcept
 {
+    AUDIO_TRACE_SCOPE("AudioEngine::setBusVolume");
+    if (!_buses.setGain(bus, volume))
+    {
+        return false;
+    }
     bool ret = true;
-    std::lock_guard<std::mutex> lock(_playersMutex);
-    for (const auto &it : _players)
+    for (const int audioId : getBusPlayers(bus))
     {
-        ret &= it.second->stop();
+        const AudioHandleTable::Ref player = _players.acquire(audioId);
+        if (player)
+        {
+            ret &= player->setBusGain(_buses.getEffectiveGain(player->getBus()));
+            ++_paramsWrites;
+        }
     }
     return ret;
 }
 
 /**
- * Pause all AudioPlayers
+ * Pause the playing sounds of a bus and of its descendants, the ones played meanwhile wait for resumeBus
  */
-bool AudioEngine::pauseAll() noexcept
+bool AudioEngine::pauseBus(const int bus) noexcept
 {
+    AUDIO_TRACE_SCOPE("AudioEngine::pauseBus");
+    if (!_buses.setPaused(bus, true))
+    {
+        return false;
+    }
     bool ret = true;
-    std::lock_guard<std::mutex> lock(_playersMutex);
-    for (const auto &it : _players)
+    for (const int audioId : getBusPlayers(bus))
     {
-        ret &= it.second->pause();
+        const AudioHandleTable::Ref player = _players.acquire(audioId);
+        if (player && player->getState() == AudioPlayer::STATE_PLAYING)
+        {
+            ret &= player->pause();
+        }
     }
     return ret;
 }
 
-void AudioEngine::setHeadAtEnd(const int audioId) noexcept
+/**
+ * Resume the paused sounds of a bus, the ones of a descendant bus still paused stay paused
+ */
+bool AudioEngine::resumeBus(const int bus) noexcept
 {
-    std::lock_guard<std::mutex> lock(_playersMutex);
-    const auto &it = _players.find(audioId);
-    if (it != _players.end())
+    AUDIO_TRACE_SCOPE("AudioEngine::resumeBus");
+    if (!_buses.setPaused(bus, false))
     {
-        it->second->setHeadAtEnd(true);
+        return false;
     }
-}
-
-SLuint32 AudioEngine::getPrefetchedStatus(const int audioId) noexcept
-{
-    SLuint32 ret = 0;
-    std::lock_guard<std::mutex> lock(_playersMutex);
-    const auto &it = _players.find(audioId);
-    if (it != _players.end())
+    bool ret = true;
+    for (const int audioId : getBusPlayers(bus))
     {
-        ret = it->second->getPrefetchedStatus();
+        const AudioHandleTable::Ref player = _players.acquire(audioId);
+        if (player && player->getState() == AudioPlayer::STATE_PAUSED && !_buses.isPaused(player->getBus()))
+        {
+            ret &= player->resume();
+        }
     }
     return ret;
 }
 
 /**
- * Resume all AudioPlayers
+ * Stop the sounds of a bus and of its descendants
  */
-bool AudioEngine::resumeAll() noexcept
+bool AudioEngine::stopBus(const int bus) noexcept
 {
+    AUDIO_TRACE_SCOPE("AudioEngine::stopBus");
+    if (!_buses.isValid(bus))
+    {
+        return false;
+    }
     bool ret = true;
-    std::lock_guard<std::mutex> lock(_playersMutex);
-    for (const auto &it : _players)
+    for (const int audioId : getBusPlayers(bus))
     {
-        ret &= it.second->resume();
+        const AudioHandleTable::Ref player = _players.acquire(audioId);
+        if (player)
+        {
+            ret &= player->stop();
+        }
     }
     return ret;
 }
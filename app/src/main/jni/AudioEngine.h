@@ -4,42 +4,124 @@
 #include <SLES/OpenSLES.h>
 #include <SLES/OpenSLES_Android.h>
 #include <string>
-#include <map>
+#include <vector>
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
 #include "AudioPlayer.h"
+#include "AudioHandleTable.h"
+#include "AudioBusTable.h"
+#include "AudioRetireQueue.h"
+#include "AudioPlayerPool.h"
+#include "AudioSampleCache.h"
+#include "AudioAssetCache.h"
+#include "AudioSoundBank.h"
+#include "AudioMixer.h"
+#include "AudioCommand.h"
+#include "AudioCommandQueue.h"
+#include "AudioParamsQueue.h"
+#include "AudioPreloader.h"
+#include "AudioHistogram.h"
+#include "AudioMetrics.h"
+#include "AudioBackend.h"
+#include <memory>
 #include <cstdint>
 #include <jni.h>
 #include <atomic>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <unordered_map>
+#include <algorithm>
 
 extern "C"
 {
     JNIEnv *getJNIEnv();
 
+    void detachJNIEnv();
+
     JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved);
     JNIEXPORT void JNICALL JNI_OnUnload(JavaVM *vm, void *reserved);
 
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_init(JNIEnv *env, jobject thiz, jstring path, jfloat volume, jboolean loop);
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_play(JNIEnv *env, jobject thiz);
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_stop(JNIEnv *env, jobject thiz);
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_pause(JNIEnv *env, jobject thiz);
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_resume(JNIEnv *env, jobject thiz);
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_setParams(JNIEnv *env, jobject thiz, jfloat pitch, jfloat pan, jfloat volume);
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioPlayer_setVolume(JNIEnv *env, jobject thiz, jfloat volume);
-
-    JNIEXPORT void JNICALL Java_com_prettysimple_audio_AudioEngine_setAssetManager(JNIEnv *env, jobject thiz, jobject assetManager);
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioEngine_pauseAll(JNIEnv *env, jobject thiz);
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioEngine_resumeAll(JNIEnv *env, jobject thiz);
-    JNIEXPORT bool JNICALL Java_com_prettysimple_audio_AudioEngine_stopAll(JNIEnv *env, jobject thiz);
 }
 
 namespace audio
 {
     class AudioEngine
     {
+    public:
+        static constexpr size_t DEFAULT_MAX_REAL_VOICES = 24; // Android caps the number of OpenSL players around 32
+        static constexpr size_t DEFAULT_STREAMING_THRESHOLD = 256 * 1024; // compressed bytes
+        static constexpr int COMMAND_WAIT_MS = 100;
+        static constexpr int PRELOAD_TIMEOUT_MS = 2000;
+        static constexpr int PARAMS_TICK_MS = 10; // period of the volume, pan and pitch updates, about an output buffer
+        static constexpr int PARAMS_RAMP_MS = 50; // of a full scale volume change, shorter changes are ramped proportionally
+
+        /**
+         * Latencies of the sounds, each one feeds its AudioHistogram
+         */
+        enum LatencyStage
+        {
+            LATENCY_CREATE = 0, // create request of the caller to the player ready
+            LATENCY_REALIZE, // CreateAudioPlayer and Realize of an OpenSL player
+            LATENCY_PREFETCH, // start of the init of an fd player to its prefetch sufficient
+            LATENCY_START, // play request of the caller to the player playing
+            LATENCY_SOUND, // play request of the caller to the first head movement: the trigger to sound latency
+            LATENCY_COUNT
+        };
+
+        struct VoiceStats
+        {
+            uint64_t real;
+            uint64_t virtuals;
+            uint64_t stolen;
+            uint64_t promoted;
+            uint64_t culled; // virtual one-shots that ended without getting a player back
+        };
+
+        struct StreamingStats
+        {
+            uint64_t underruns;
+            uint64_t underrunFrames;
+            uint64_t refills;
+            uint64_t active;
+        };
+
+        struct CommandStats
+        {
+            uint64_t queued;
+            uint64_t succeeded;
+            uint64_t failed;
+            uint64_t stale; // of the failed ones, for a sound already ended, stopped or never created
+            uint64_t dropped; // queue full or engine destroyed
+            uint64_t calls;
+            uint64_t totalCallerNs; // time spent in the engine by the Java callers
+            uint64_t maxCallerNs;
+            uint64_t totalQueueNs; // from the call to the run of the command
+            uint64_t maxQueueNs;
+        };
+
+        struct ParamsStats
+        {
+            uint64_t writes; // setVolume, setParams and bus volume changes of a sound
+            uint64_t ticks;
+            uint64_t updates; // voices updated by the ticks, a ramp updates its voice on each tick
+        };
+
+        struct SoundBankStats
+        {
+            uint64_t banks;
+            uint64_t sounds;
+            uint64_t bytes; // mapped, the pages are only resident once played
+            uint64_t hits;
+        };
+
+        struct ReclaimStats
+        {
+            uint64_t reclaimed;
+            uint64_t totalLatencyNs; // from the retire (HEADATEND or stop) to the destruction of the player
+            uint64_t maxLatencyNs;
+        };
+
     protected:
         AudioEngine();
 
@@ -56,14 +138,96 @@ namespace audio
     public:
         static AudioEngine *getInstance() noexcept;
 
-        AudioPlayer *createPlayerWithPath(const std::string &fileFullPath, const float volume, const bool loop) noexcept;
+        static void destroy() noexcept;
+
+        AudioPlayer *createPlayerWithPath(const std::string &fileFullPath, const float volume, const bool loop, const int priority, const int bus) noexcept;
+
+        int createPlayerAsync(const std::string &fileFullPath, const float volume, const bool loop, const int priority, const int bus) noexcept;
+
+        bool playOneShot(const std::string &fileFullPath, const float volume, const float pan, const float pitch, const int priority, const int bus) noexcept;
+
+        bool post(const AudioCommand &command) noexcept;
+
+        void setCommandThreadEnabled(const bool enabled) noexcept;
+
+        int preload(const std::vector<std::string> &paths, std::unique_ptr<AudioPreloader::Listener> listener) noexcept;
+
+        bool unload(const std::string &fileFullPath) noexcept;
+
+        CommandStats getCommandStats() const noexcept;
+
+        bool requestParamsUpdate(const int audioId) noexcept;
+
+        ParamsStats getParamsStats() const noexcept;
+
+        bool setBackend(std::unique_ptr<AudioBackend> backend) noexcept;
 
         AAssetManager *getAssetManager() const noexcept;
 
         void setAssetManager(const jobject _assetManager);
 
+        void setOutputConfig(const SLuint32 sampleRate, const size_t framesPerBurst) noexcept;
+
+        SLuint32 getOutputSampleRate() const noexcept;
+
+        size_t getFramesPerBurst() const noexcept;
+
+        bool isFastPath(const int audioId) noexcept;
+
         void setHeadAtEnd(const int audioId) noexcept;
 
+        void onBufferQueueEnd(const int audioId, SLAndroidSimpleBufferQueueItf bufferQueue) noexcept;
+
+        void onHeadMoved(const int audioId, SLPlayItf play) noexcept;
+
+        void recordLatency(const LatencyStage stage, const int64_t latencyNs) noexcept;
+
+        AudioHistogram::Snapshot getLatencyStats(const LatencyStage stage) const noexcept;
+
+        void resetLatencyStats() noexcept;
+
+        void retire(const int audioId) noexcept;
+
+        ReclaimStats getReclaimStats() const noexcept;
+
+        void setMaxRealVoices(const size_t count) noexcept;
+
+        VoiceStats getVoiceStats() const noexcept;
+
+        void setPlayerPoolSize(const size_t size) noexcept;
+
+        AudioPlayerPool::Stats getPlayerPoolStats() const noexcept;
+
+        void setSampleCacheThreshold(const size_t threshold) noexcept;
+
+        void setSampleCacheCapacity(const size_t capacity) noexcept;
+
+        AudioSampleCache::Stats getSampleCacheStats() const noexcept;
+
+        std::shared_ptr<AudioAsset> acquireAsset(const std::string &fileFullPath) noexcept;
+
+        void setAssetCacheCapacity(const size_t capacity) noexcept;
+
+        AudioAssetCache::Stats getAssetCacheStats() const noexcept;
+
+        bool loadSoundBank(const std::string &fileFullPath) noexcept;
+
+        bool unloadSoundBank(const std::string &fileFullPath) noexcept;
+
+        SoundBankStats getSoundBankStats() const noexcept;
+
+        bool setMixerEnabled(const bool enabled) noexcept;
+
+        AudioMixer::Stats getMixerStats() const noexcept;
+
+        void setStreamingThreshold(const size_t threshold) noexcept;
+
+        void setStreamingBuffer(const size_t ringFrames, const size_t lowWatermarkFrames) noexcept;
+
+        StreamingStats getStreamingStats() const noexcept;
+
+        AudioMetrics::Stats getStats() const noexcept;
+
         SLuint32 getPrefetchedStatus(const int audioId) noexcept;
 
         bool stop(const int audioId) noexcept;
@@ -78,7 +242,7 @@ namespace audio
 
         bool setVolume(const int audioId, const float volume) noexcept;
 
-        void destroy() noexcept;
+        int submit(const uint8_t *data, const size_t size) noexcept;
 
         bool stopAll() noexcept;
 
@@ -86,34 +250,157 @@ namespace audio
 
         bool resumeAll() noexcept;
 
+        int createBus(const std::string &name, const int parent) noexcept;
+
+        int findBus(const std::string &name) const noexcept;
+
+        bool setBusVolume(const int bus, const float volume) noexcept;
+
+        bool pauseBus(const int bus) noexcept;
+
+        bool resumeBus(const int bus) noexcept;
+
+        bool stopBus(const int bus) noexcept;
+
     private:
         bool initOpenSL() noexcept;
 
+        int enqueueCreate(AudioCommandQueue::Entry &&entry) noexcept;
+
+        AudioPlayer *createPlayer(const int audioId, const std::string &fileFullPath, const float volume, const bool loop, const int priority, const int bus,
+                                  const float pan = 0.f, const float pitch = 1.f) noexcept;
+
+        std::vector<int> getBusPlayers(const int bus) noexcept;
+
+        bool enqueue(AudioCommandQueue::Entry &&entry) noexcept;
+
+        bool execute(const AudioCommandQueue::Entry &entry) noexcept;
+
+        bool apply(const AudioCommand &command, const int64_t requestedAt) noexcept;
+
+        std::shared_ptr<AudioSample> getSample(const std::string &fileFullPath) noexcept;
+
+        bool preloadPath(const std::string &fileFullPath) noexcept;
+
+        bool unloadPath(const std::string &fileFullPath) noexcept;
+
+        void audioCommandThread() noexcept;
+
+        void updateParams() noexcept;
+
+        void stopCommands() noexcept;
+
+        void notifyCommands() noexcept;
+
+        static void addLatency(std::atomic<uint64_t> &total, std::atomic<uint64_t> &max, const uint64_t latency) noexcept;
+
         void audioPlayerGc(const int sleep) noexcept;
 
-        void audioPlayerTest(const int sleep) noexcept;
+        bool reclaim(const AudioRetireQueue::Entry &entry) noexcept;
+
+        void notifyGc() noexcept;
+
+        bool stealVoice(const int priority, const float audibility, const bool strict) noexcept;
+
+        void updateVoices() noexcept;
+
+        SLmillisecond getKnownDuration(const std::string &fileFullPath) noexcept;
+
+        bool isStreamable(const std::string &fileFullPath) noexcept;
+
+        bool canOpen(const std::string &fileFullPath) noexcept;
+
+        void rememberDuration(const std::string &fileFullPath, const SLmillisecond duration) noexcept;
 
         void clean() noexcept;
 
+        void stopGc() noexcept;
+
     private:
-        int _audioIds;
         static AudioEngine *_instance;
-        std::mutex _playersMutex;
-        std::map<int, AudioPlayer *> _players;
-
+        AudioAssetCache _assetCache; // before the players, their assets count its open fds
+        AudioHandleTable _players;
+        AudioBusTable _buses; // the players only keep the id of their bus
+        AudioPlayerPool _playerPool;
+        AudioSampleCache _sampleCache; // short assets played from memory through a buffer queue
+
+        // Banks of PCM mapped in memory, looked up before the sample cache
+        mutable std::mutex _banksMutex;
+        std::vector<std::pair<std::string, std::shared_ptr<AudioSoundBank>>> _banks;
+        std::atomic<uint64_t> _bankHits;
+
+        std::mutex _openSLMutex; // initOpenSL runs on the command thread and on the callers of setMixerEnabled
+        std::unique_ptr<AudioBackend> _backend; // OpenSL of the device by default, set before the first sound
         SLObjectItf _engineObject;
         SLEngineItf _engineEngine;
         SLObjectItf _outputMixObject;
 
-        jobject _assetManager;
+        // Native output of the device given by the Java AudioManager, 0 while unknown
+        std::atomic<SLuint32> _outputSampleRate;
+        std::atomic<size_t> _framesPerBurst;
 
         std::atomic<bool> _stopGc;
         std::atomic<bool> _doneGc;
         std::thread _threadGc;
-        std::mutex _pauselMutex;
+        std::mutex _gcMutex;
         std::condition_variable _condition;
-
-        std::thread _threadTest;
+        bool _gcPending; // guarded by _gcMutex
+        std::atomic<bool> _sweepRequested; // set when the retire queue overflowed
+        AudioRetireQueue _retired;
+
+        std::atomic<uint64_t> _reclaimed;
+        std::atomic<uint64_t> _reclaimLatencyTotal;
+        std::atomic<uint64_t> _reclaimLatencyMax;
+
+        std::mutex _voicesMutex; // serializes the steal/promote decisions
+        std::atomic<int> _maxRealVoices;
+        std::atomic<int> _realVoices;
+        std::atomic<int> _virtualVoices;
+        std::atomic<uint64_t> _stolen;
+        std::atomic<uint64_t> _promoted;
+        std::atomic<uint64_t> _culled;
+        std::mutex _durationsMutex;
+        std::unordered_map<std::string, SLmillisecond> _durations;
+
+        // Optional software mixer for the decoded samples, created once under _voicesMutex and kept until destruction
+        std::unique_ptr<AudioMixer> _mixer;
+        std::atomic<bool> _mixerEnabled;
+
+        // Assets from this compressed size play as AudioStream, 0 disables streaming
+        std::atomic<size_t> _streamingThreshold;
+        std::atomic<size_t> _streamingRingFrames;
+        std::atomic<size_t> _streamingLowWatermarkFrames;
+        AudioStream::Counters _streamingCounters;
+
+        // Commands of the Java callers, all the OpenSL work they trigger runs on _threadCommands
+        AudioCommandQueue _commands;
+        std::thread _threadCommands;
+        std::mutex _commandsMutex;
+        std::condition_variable _commandsCondition;
+        std::atomic<bool> _commandsWaiting; // the command thread is about to sleep, the producers must notify it
+        std::atomic<bool> _stopCommands;
+        std::atomic<bool> _commandThreadEnabled;
+        std::atomic<uint64_t> _commandsQueued;
+        std::atomic<uint64_t> _commandsSucceeded;
+        std::atomic<uint64_t> _commandsFailed;
+        std::atomic<uint64_t> _commandsStale;
+        std::atomic<uint64_t> _commandsDropped;
+        std::atomic<uint64_t> _callerCalls;
+        std::atomic<uint64_t> _callerLatencyTotal;
+        std::atomic<uint64_t> _callerLatencyMax;
+        std::atomic<uint64_t> _queueLatencyTotal;
+        std::atomic<uint64_t> _queueLatencyMax;
+
+        // Voices whose volume, pan or pitch changed, each one queued once until the next tick of the command thread
+        AudioParamsQueue _paramsPending;
+        std::vector<int> _paramsUpdating; // only touched by the command thread, reserved to AudioParamsQueue::CAPACITY
+        std::atomic<uint64_t> _paramsWrites;
+        std::atomic<uint64_t> _paramsTicks;
+        std::atomic<uint64_t> _paramsUpdates;
+
+        AudioPreloader _preloader;
+
+        AudioHistogram _latencies[LATENCY_COUNT];
     };
 }
 
@@ -0,0 +1,65 @@
+#include "AudioFastPath.h"
+#include "AudioUtils.h"
+
+using namespace audio;
+
+/**
+ * The output rate is only known once the Java side passed it, unknown means not eligible
+ */
+bool AudioFastPath::isEligible(const SLuint32 sampleRate, const SLuint32 nativeSampleRate) noexcept
+{
+    return nativeSampleRate > 0 && sampleRate == nativeSampleRate;
+}
+
+/**
+ * Ask for the low latency mode, between CreateAudioPlayer (with SL_IID_ANDROIDCONFIGURATION) and Realize
+ */
+void AudioFastPath::request(const SLObjectItf &playerObject) noexcept
+{
+#ifdef SL_ANDROID_KEY_PERFORMANCE_MODE
+    SLAndroidConfigurationItf config = nullptr;
+    if (SL_RESULT_SUCCESS == (*playerObject)->GetInterface(playerObject, SL_IID_ANDROIDCONFIGURATION, &config))
+    {
+        const SLuint32 mode = SL_ANDROID_PERFORMANCE_LATENCY;
+        if (SL_RESULT_SUCCESS != (*config)->SetConfiguration(config, SL_ANDROID_KEY_PERFORMANCE_MODE, &mode, sizeof(mode)))
+        {
+            LOGEX("SetConfiguration SL_ANDROID_KEY_PERFORMANCE_MODE fail");
+        }
+    }
+#endif
+}
+
+/**
+ * Whether the realized player got a fast track
+ * Note: The platform downgrades the performance mode it reports when it denies the fast track
+ */
+bool AudioFastPath::isObtained(const SLObjectItf &playerObject, const bool eligible) noexcept
+{
+    bool ret = eligible;
+#ifdef SL_ANDROID_KEY_PERFORMANCE_MODE
+    SLAndroidConfigurationItf config = nullptr;
+    if (eligible && SL_RESULT_SUCCESS == (*playerObject)->GetInterface(playerObject, SL_IID_ANDROIDCONFIGURATION, &config))
+    {
+        SLuint32 mode = 0;
+        SLuint32 size = sizeof(mode);
+        if (SL_RESULT_SUCCESS == (*config)->GetConfiguration(config, SL_ANDROID_KEY_PERFORMANCE_MODE, &size, &mode))
+        {
+            ret = mode == SL_ANDROID_PERFORMANCE_LATENCY;
+        }
+    }
+#endif
+    return ret;
+}
+
+/**
+ * Smallest multiple of the burst holding frames, frames when the burst is unknown
+ */
+size_t AudioFastPath::alignToBurst(const size_t frames, const size_t framesPerBurst) noexcept
+{
+    if (framesPerBurst == 0)
+    {
+        return frames;
+    }
+    const size_t bursts = (frames + framesPerBurst - 1) / framesPerBurst;
+    return (bursts > 0 ? bursts : 1) * framesPerBurst;
+}
@@ -0,0 +1,33 @@
+#ifndef __AudioFastPath__
+#define __AudioFastPath__
+
+#include <SLES/OpenSLES.h>
+#include <SLES/OpenSLES_Android.h>
+#include <cstdint>
+#include <cstddef>
+
+namespace audio
+{
+    /**
+     * Low latency (fast track) negotiation of the PCM buffer queue players
+     * Android grants a fast track to a PCM buffer queue player at the native rate of the output without effect nor playback rate interface
+     * From API 25 the player asks for it through its AndroidConfiguration and the result is read back after Realize,
+     * before that the platform decides alone and the result is the eligibility
+     */
+    class AudioFastPath
+    {
+    public:
+        AudioFastPath() = delete;
+
+    public:
+        static bool isEligible(const SLuint32 sampleRate, const SLuint32 nativeSampleRate) noexcept;
+
+        static void request(const SLObjectItf &playerObject) noexcept;
+
+        static bool isObtained(const SLObjectItf &playerObject, const bool eligible) noexcept;
+
+        static size_t alignToBurst(const size_t frames, const size_t framesPerBurst) noexcept;
+    };
+}
+
+#endif
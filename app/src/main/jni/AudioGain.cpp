@@ -0,0 +1,44 @@
+#include "AudioGain.h"
+#include <cmath>
+
+using namespace audio;
+
+namespace
+{
+    /**
+     * Millibel of the gains of the table, built once when the library is loaded
+     */
+    struct MillibelTable
+    {
+        float levels[AudioGain::TABLE_SIZE];
+
+        MillibelTable() noexcept
+        {
+            levels[0] = (float) SL_MILLIBEL_MIN;
+            for (size_t i = 1; i < AudioGain::TABLE_SIZE; ++i)
+            {
+                const float level = 2000.f * std::log10((float) i / (AudioGain::TABLE_SIZE - 1));
+                levels[i] = level < SL_MILLIBEL_MIN ? (float) SL_MILLIBEL_MIN : level;
+            }
+        }
+    };
+
+    const MillibelTable gMillibels;
+}
+
+SLmillibel AudioGain::toMillibel(const float gain) noexcept
+{
+    if (!(gain > 0.f)) // NaN included
+    {
+        return SL_MILLIBEL_MIN;
+    }
+    if (gain >= 1.f)
+    {
+        return 0;
+    }
+    const float position = gain * (TABLE_SIZE - 1);
+    const size_t index = (size_t) position;
+    const float fraction = position - index;
+    const float level = gMillibels.levels[index] + fraction * (gMillibels.levels[index + 1] - gMillibels.levels[index]);
+    return (SLmillibel) (level - 0.5f); // Rounded to the nearest, the level is never positive
+}
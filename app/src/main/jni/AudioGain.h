@@ -0,0 +1,26 @@
+#ifndef __AudioGain__
+#define __AudioGain__
+
+#include <SLES/OpenSLES.h>
+#include <cstddef>
+
+namespace audio
+{
+    /**
+     * Conversion of a linear gain (0 -> 1) in the millibel level of SetVolumeLevel, read from a table instead of a log10 per call
+     * The table is linearly interpolated, the error stays under 2 mB above -40 dB
+     */
+    class AudioGain
+    {
+    public:
+        static constexpr size_t TABLE_SIZE = 1025; // gains k / (TABLE_SIZE - 1)
+
+    public:
+        AudioGain() = delete;
+
+    public:
+        static SLmillibel toMillibel(const float gain) noexcept;
+    };
+}
+
+#endif
@@ -0,0 +1,236 @@
+#include "AudioHandleTable.h"
+#include <thread>
+
+using namespace audio;
+
+AudioHandleTable::Ref::Ref() noexcept : _slot(nullptr)
+, _player(nullptr)
+{
+}
+
+AudioHandleTable::Ref::Ref(Slot *slot, AudioPlayer *player) noexcept : _slot(slot)
+, _player(player)
+{
+}
+
+AudioHandleTable::Ref::Ref(Ref &&other) noexcept : _slot(other._slot)
+, _player(other._player)
+{
+    other._slot = nullptr;
+    other._player = nullptr;
+}
+
+AudioHandleTable::Ref &AudioHandleTable::Ref::operator=(Ref &&other) & noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        _slot = other._slot;
+        _player = other._player;
+        other._slot = nullptr;
+        other._player = nullptr;
+    }
+    return *this;
+}
+
+AudioHandleTable::Ref::~Ref()
+{
+    reset();
+}
+
+void AudioHandleTable::Ref::reset() noexcept
+{
+    if (_slot != nullptr)
+    {
+        _slot->pins.fetch_sub(1);
+        _slot = nullptr;
+        _player = nullptr;
+    }
+}
+
+AudioHandleTable::Ref::operator bool() const noexcept
+{
+    return _player != nullptr;
+}
+
+AudioPlayer *AudioHandleTable::Ref::operator->() const noexcept
+{
+    return _player;
+}
+
+AudioPlayer *AudioHandleTable::Ref::get() const noexcept
+{
+    return _player;
+}
+
+AudioHandleTable::AudioHandleTable() : _freeHead(0)
+, _used(0)
+, _size(0)
+{
+    for (uint32_t index = 0; index < CAPACITY; ++index)
+    {
+        Slot &slot = _slots[index];
+        slot.generation.store(0, std::memory_order_relaxed);
+        slot.pins.store(0, std::memory_order_relaxed);
+        slot.player.store(nullptr, std::memory_order_relaxed);
+        slot.next.store(index + 2 <= CAPACITY ? index + 2 : 0, std::memory_order_relaxed); // slot 0 is popped first
+        slot.nextGeneration = 1;
+    }
+    _freeHead.store(1, std::memory_order_release);
+}
+
+AudioHandleTable::~AudioHandleTable()
+{
+}
+
+int AudioHandleTable::makeHandle(const uint32_t index, const uint32_t generation) noexcept
+{
+    return (int) ((generation << INDEX_BITS) | index);
+}
+
+/**
+ * Retire the generation of a slot given back to the free list, the handles it issued turn stale, 0 is skipped
+ */
+void AudioHandleTable::bumpGeneration(Slot &slot) noexcept
+{
+    slot.nextGeneration = (slot.nextGeneration + 1) & GENERATION_MASK;
+    if (slot.nextGeneration == 0)
+    {
+        slot.nextGeneration = 1;
+    }
+}
+
+void AudioHandleTable::pushFree(const uint32_t index) noexcept
+{
+    uint64_t head = _freeHead.load(std::memory_order_acquire);
+    uint64_t next;
+    do
+    {
+        _slots[index].next.store((uint32_t) head, std::memory_order_relaxed);
+        next = (((head >> 32) + 1) << 32) | (index + 1);
+    } while (!_freeHead.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_acquire));
+}
+
+bool AudioHandleTable::popFree(uint32_t &index) noexcept
+{
+    uint64_t head = _freeHead.load(std::memory_order_acquire);
+    uint64_t next;
+    do
+    {
+        const uint32_t top = (uint32_t) head;
+        if (top == 0) // The table is full
+        {
+            return false;
+        }
+        index = top - 1;
+        next = (((head >> 32) + 1) << 32) | _slots[index].next.load(std::memory_order_relaxed); // The tag protects us from ABA
+    } while (!_freeHead.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire));
+    return true;
+}
+
+/**
+ * Reserve a slot and return its future handle or -1 if the table is full
+ * The handle can't be acquired until publish() is called
+ */
+int AudioHandleTable::reserve() noexcept
+{
+    uint32_t index = 0;
+    if (!popFree(index))
+    {
+        return -1;
+    }
+
+    uint32_t used = _used.load(std::memory_order_relaxed);
+    while (used < index + 1 && !_used.compare_exchange_weak(used, index + 1, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+
+    return makeHandle(index, _slots[index].nextGeneration);
+}
+
+/**
+ * Make the reserved handle visible to acquire()
+ */
+bool AudioHandleTable::publish(const int handle, AudioPlayer *player) noexcept
+{
+    const uint32_t index = (uint32_t) handle & INDEX_MASK;
+    Slot &slot = _slots[index];
+    if (handle <= 0 || player == nullptr || slot.nextGeneration != ((uint32_t) handle >> INDEX_BITS))
+    {
+        return false;
+    }
+    slot.player.store(player, std::memory_order_relaxed);
+    slot.generation.store(slot.nextGeneration, std::memory_order_release);
+    _size.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * Give back a reserved handle that has never been published, it is never issued again
+ */
+void AudioHandleTable::cancel(const int handle) noexcept
+{
+    const uint32_t index = (uint32_t) handle & INDEX_MASK;
+    Slot &slot = _slots[index];
+    if (handle > 0 && slot.nextGeneration == ((uint32_t) handle >> INDEX_BITS))
+    {
+        bumpGeneration(slot); // The caller may still hold the handle, it must not acquire the next player of the slot
+        pushFree(index);
+    }
+}
+
+/**
+ * Wait-free lookup, a stale handle fails on the generation check without touching the player
+ */
+AudioHandleTable::Ref AudioHandleTable::acquire(const int handle) noexcept
+{
+    if (handle <= 0)
+    {
+        return Ref();
+    }
+    const uint32_t generation = (uint32_t) handle >> INDEX_BITS;
+    Slot &slot = _slots[(uint32_t) handle & INDEX_MASK];
+
+    slot.pins.fetch_add(1); // seq_cst: pairs with the generation store + pins load in remove()
+    if (slot.generation.load() != generation)
+    {
+        slot.pins.fetch_sub(1);
+        return Ref();
+    }
+    return Ref(&slot, slot.player.load(std::memory_order_relaxed));
+}
+
+/**
+ * Unpublish the handle, wait for the readers still pinning it and give the slot back to the free list
+ * Return the AudioPlayer that was stored so the caller can delete it, nullptr if the handle was stale
+ */
+AudioPlayer *AudioHandleTable::remove(const int handle) noexcept
+{
+    if (handle <= 0)
+    {
+        return nullptr;
+    }
+    uint32_t generation = (uint32_t) handle >> INDEX_BITS;
+    const uint32_t index = (uint32_t) handle & INDEX_MASK;
+    Slot &slot = _slots[index];
+
+    if (!slot.generation.compare_exchange_strong(generation, 0)) // Only one thread can win the removal
+    {
+        return nullptr;
+    }
+    while (slot.pins.load() != 0) // Readers only pin for the time of an OpenSL call
+    {
+        std::this_thread::yield();
+    }
+
+    AudioPlayer *player = slot.player.exchange(nullptr, std::memory_order_relaxed);
+    bumpGeneration(slot);
+    _size.fetch_sub(1, std::memory_order_relaxed);
+    pushFree(index);
+    return player;
+}
+
+size_t AudioHandleTable::size() const noexcept
+{
+    return _size.load(std::memory_order_relaxed);
+}
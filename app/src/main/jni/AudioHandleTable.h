@@ -0,0 +1,138 @@
+#ifndef __AudioHandleTable__
+#define __AudioHandleTable__
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace audio
+{
+    class AudioPlayer;
+
+    /**
+     * Fixed capacity table of AudioPlayer* addressed by generation tagged handles
+     * A handle is (generation << INDEX_BITS) | index and always stay positive so it can be stored in AudioPlayer.java
+     * Lookup is wait-free, reserve/release of a slot are lock-free (tagged Treiber stack)
+     */
+    class AudioHandleTable
+    {
+    public:
+        static constexpr uint32_t INDEX_BITS = 12;
+        static constexpr uint32_t CAPACITY = 1u << INDEX_BITS;
+        static constexpr uint32_t INDEX_MASK = CAPACITY - 1;
+        static constexpr uint32_t GENERATION_MASK = (1u << (31 - INDEX_BITS)) - 1;
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint32_t> generation; // 0 while the slot is not published
+            std::atomic<uint32_t> pins;
+            std::atomic<AudioPlayer *> player;
+            std::atomic<uint32_t> next; // free list link (index + 1, 0 is the end of the list)
+            uint32_t nextGeneration; // only touched by the owner of a reserved slot
+        };
+
+    public:
+        /**
+         * Pin on a published slot, the AudioPlayer can't be deleted while a Ref on it is alive
+         */
+        class Ref
+        {
+        public:
+            Ref() noexcept;
+
+            Ref(const Ref &) = delete;
+
+            Ref &operator=(const Ref &) & = delete;
+
+            Ref(Ref &&other) noexcept;
+
+            Ref &operator=(Ref &&other) & noexcept;
+
+            ~Ref();
+
+            explicit operator bool() const noexcept;
+
+            AudioPlayer *operator->() const noexcept;
+
+            AudioPlayer *get() const noexcept;
+
+        private:
+            friend class AudioHandleTable;
+
+            Ref(Slot *slot, AudioPlayer *player) noexcept;
+
+            void reset() noexcept;
+
+        private:
+            Slot *_slot;
+            AudioPlayer *_player;
+        };
+
+    public:
+        AudioHandleTable();
+
+        AudioHandleTable(const AudioHandleTable &) = delete;
+
+        AudioHandleTable &operator=(const AudioHandleTable &) & = delete;
+
+        AudioHandleTable(AudioHandleTable &&) = delete;
+
+        AudioHandleTable &operator=(AudioHandleTable &&) & = delete;
+
+        ~AudioHandleTable();
+
+    public:
+        int reserve() noexcept;
+
+        bool publish(const int handle, AudioPlayer *player) noexcept;
+
+        void cancel(const int handle) noexcept;
+
+        Ref acquire(const int handle) noexcept;
+
+        AudioPlayer *remove(const int handle) noexcept;
+
+        size_t size() const noexcept;
+
+        /**
+         * Call func(handle, AudioPlayer *) for each published slot, each player is pinned during the call
+         * Note: Never call remove() on the visited handle from func, it would wait on its own pin
+         */
+        template<typename Func>
+        void forEach(Func &&func) noexcept
+        {
+            const uint32_t used = _used.load(std::memory_order_acquire);
+            for (uint32_t index = 0; index < used; ++index)
+            {
+                const uint32_t generation = _slots[index].generation.load(std::memory_order_acquire);
+                if (generation != 0)
+                {
+                    const int handle = makeHandle(index, generation);
+                    Ref ref = acquire(handle);
+                    if (ref)
+                    {
+                        func(handle, ref.get());
+                    }
+                }
+            }
+        }
+
+    private:
+        static int makeHandle(const uint32_t index, const uint32_t generation) noexcept;
+
+        static void bumpGeneration(Slot &slot) noexcept;
+
+        void pushFree(const uint32_t index) noexcept;
+
+        bool popFree(uint32_t &index) noexcept;
+
+    private:
+        Slot _slots[CAPACITY];
+        std::atomic<uint64_t> _freeHead; // (tag << 32) | (index + 1)
+        std::atomic<uint32_t> _used; // high water mark of the slots ever reserved
+        std::atomic<uint32_t> _size;
+    };
+}
+
+#endif
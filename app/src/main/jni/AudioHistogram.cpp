@@ -0,0 +1,99 @@
+#include "AudioHistogram.h"
+#include <cmath>
+
+using namespace audio;
+
+AudioHistogram::AudioHistogram() : _maxNs(0)
+{
+    for (std::atomic<uint64_t> &bucket : _buckets)
+    {
+        bucket = 0;
+    }
+}
+
+/**
+ * Index of the bucket of a latency in microseconds, the last bucket takes everything above the range
+ */
+size_t AudioHistogram::bucketOf(const uint64_t us) noexcept
+{
+    if (us < SUB_BUCKETS)
+    {
+        return (size_t) us;
+    }
+    const size_t exponent = (size_t) (63 - __builtin_clzll(us)); // >= 3
+    const size_t sub = (size_t) (us >> (exponent - 3)) & (SUB_BUCKETS - 1);
+    const size_t ret = (exponent - 2) * SUB_BUCKETS + sub;
+    return ret < BUCKETS ? ret : BUCKETS - 1;
+}
+
+uint64_t AudioHistogram::lowerBoundUs(const size_t bucket) noexcept
+{
+    if (bucket < SUB_BUCKETS)
+    {
+        return bucket;
+    }
+    const size_t exponent = bucket / SUB_BUCKETS + 2;
+    return (uint64_t) (SUB_BUCKETS + bucket % SUB_BUCKETS) << (exponent - 3);
+}
+
+void AudioHistogram::record(const int64_t latencyNs) noexcept
+{
+    const uint64_t ns = latencyNs > 0 ? (uint64_t) latencyNs : 0;
+    _buckets[bucketOf(ns / 1000)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t max = _maxNs.load(std::memory_order_relaxed);
+    while (ns > max && !_maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * Upper bound of the bucket holding the given fraction of the samples, capped by the max
+ */
+uint64_t AudioHistogram::percentile(const uint64_t *counts, const uint64_t count, const uint64_t maxNs, const double fraction) noexcept
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    const uint64_t rank = (uint64_t) std::ceil(fraction * count);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            const uint64_t ns = lowerBoundUs(i + 1) * 1000;
+            return ns < maxNs ? ns : maxNs;
+        }
+    }
+    return maxNs;
+}
+
+/**
+ * Copy of the buckets taken without stopping the writers, a sample recorded meanwhile may be missed
+ */
+AudioHistogram::Snapshot AudioHistogram::snapshot() const noexcept
+{
+    uint64_t counts[BUCKETS];
+    Snapshot ret;
+    ret.count = 0;
+    for (size_t i = 0; i < BUCKETS; ++i)
+    {
+        counts[i] = _buckets[i].load(std::memory_order_relaxed);
+        ret.count += counts[i];
+    }
+    ret.maxNs = _maxNs.load(std::memory_order_relaxed);
+    ret.p50Ns = percentile(counts, ret.count, ret.maxNs, 0.50);
+    ret.p95Ns = percentile(counts, ret.count, ret.maxNs, 0.95);
+    ret.p99Ns = percentile(counts, ret.count, ret.maxNs, 0.99);
+    return ret;
+}
+
+void AudioHistogram::reset() noexcept
+{
+    for (std::atomic<uint64_t> &bucket : _buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    _maxNs.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,62 @@
+#ifndef __AudioHistogram__
+#define __AudioHistogram__
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace audio
+{
+    /**
+     * Lock-free histogram of latencies with log2 buckets split in SUB_BUCKETS linear sub-buckets (12.5% of resolution)
+     * record() is a relaxed increment: safe from the OpenSL callbacks, the audio callbacks and any thread
+     */
+    class AudioHistogram
+    {
+    public:
+        static constexpr size_t SUB_BUCKETS = 8;
+        static constexpr size_t BUCKETS = 240; // in microseconds, exact under 8 us and up to ~71 min
+
+        struct Snapshot
+        {
+            uint64_t count;
+            uint64_t p50Ns; // upper bound of the bucket of the percentile
+            uint64_t p95Ns;
+            uint64_t p99Ns;
+            uint64_t maxNs;
+        };
+
+    public:
+        AudioHistogram();
+
+        AudioHistogram(const AudioHistogram &) = delete;
+
+        AudioHistogram &operator=(const AudioHistogram &) & = delete;
+
+        AudioHistogram(AudioHistogram &&) = delete;
+
+        AudioHistogram &operator=(AudioHistogram &&) & = delete;
+
+        ~AudioHistogram() = default;
+
+    public:
+        void record(const int64_t latencyNs) noexcept;
+
+        Snapshot snapshot() const noexcept;
+
+        void reset() noexcept;
+
+    private:
+        static size_t bucketOf(const uint64_t us) noexcept;
+
+        static uint64_t lowerBoundUs(const size_t bucket) noexcept;
+
+        static uint64_t percentile(const uint64_t *counts, const uint64_t count, const uint64_t maxNs, const double fraction) noexcept;
+
+    private:
+        std::atomic<uint64_t> _buckets[BUCKETS];
+        std::atomic<uint64_t> _maxNs;
+    };
+}
+
+#endif
@@ -0,0 +1,1461 @@
+#ifndef __ANDROID__
+
+#include "AudioHostBackend.h"
+#include "AudioUtils.h"
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <cstring>
+#include <cstdio>
+#include <cstdarg>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace audio;
+
+/**
+ * Directory of the assets, an asset is a plain file of it
+ */
+struct AAssetManager
+{
+    std::string root;
+};
+
+struct AAsset
+{
+    std::string path;
+    off64_t length;
+};
+
+namespace
+{
+    // Only the addresses of the interface IDs matter
+    const SLInterfaceID_ gInterfaceIds[9] = {};
+
+    constexpr int MAX_DECODED_BUFFERS_PER_TICK = 32; // a decoder runs faster than real time, not infinitely
+    constexpr SLpermille MIN_RATE = 500;
+    constexpr SLpermille MAX_RATE = 2000;
+}
+
+extern "C"
+{
+    const SLInterfaceID SL_IID_ENGINE = &gInterfaceIds[0];
+    const SLInterfaceID SL_IID_PLAY = &gInterfaceIds[1];
+    const SLInterfaceID SL_IID_SEEK = &gInterfaceIds[2];
+    const SLInterfaceID SL_IID_VOLUME = &gInterfaceIds[3];
+    const SLInterfaceID SL_IID_PREFETCHSTATUS = &gInterfaceIds[4];
+    const SLInterfaceID SL_IID_PLAYBACKRATE = &gInterfaceIds[5];
+    const SLInterfaceID SL_IID_METADATAEXTRACTION = &gInterfaceIds[6];
+    const SLInterfaceID SL_IID_ANDROIDSIMPLEBUFFERQUEUE = &gInterfaceIds[7];
+    const SLInterfaceID SL_IID_ANDROIDCONFIGURATION = &gInterfaceIds[8];
+
+    AAsset *AAssetManager_open(AAssetManager *mgr, const char *filename, int mode)
+    {
+        if (mgr == nullptr || filename == nullptr)
+        {
+            return nullptr;
+        }
+        const std::string path = mgr->root + "/" + filename;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            return nullptr;
+        }
+        return new AAsset{path, (off64_t) info.st_size};
+    }
+
+    int AAsset_openFileDescriptor64(AAsset *asset, off64_t *outStart, off64_t *outLength)
+    {
+        const int fd = open(asset->path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            *outStart = 0;
+            *outLength = asset->length;
+        }
+        return fd;
+    }
+
+    off64_t AAsset_getLength64(AAsset *asset)
+    {
+        return asset->length;
+    }
+
+    void AAsset_close(AAsset *asset)
+    {
+        delete asset;
+    }
+
+    int __android_log_print(int prio, const char *tag, const char *fmt, ...)
+    {
+        va_list args;
+        va_start(args, fmt);
+        fprintf(stderr, "%s: ", tag);
+        const int ret = vfprintf(stderr, fmt, args);
+        fputc('\n', stderr);
+        va_end(args);
+        return ret;
+    }
+}
+
+namespace
+{
+    struct Device;
+    struct Object;
+
+    enum Kind
+    {
+        KIND_ENGINE = 0,
+        KIND_OUTPUT_MIX,
+        KIND_PLAYER
+    };
+
+    // Bits of the interfaces an object exposes, in the order of gInterfaceIds
+    enum Interface
+    {
+        ITF_ENGINE = 1 << 0,
+        ITF_PLAY = 1 << 1,
+        ITF_SEEK = 1 << 2,
+        ITF_VOLUME = 1 << 3,
+        ITF_PREFETCHSTATUS = 1 << 4,
+        ITF_PLAYBACKRATE = 1 << 5,
+        ITF_METADATAEXTRACTION = 1 << 6,
+        ITF_ANDROIDSIMPLEBUFFERQUEUE = 1 << 7,
+        ITF_ANDROIDCONFIGURATION = 1 << 8
+    };
+
+    /**
+     * An OpenSL interface is a pointer on its vtable pointer, the object is found back from it
+     */
+    template<typename Vtable>
+    struct Itf
+    {
+        const Vtable *vtable;
+        Object *owner;
+    };
+
+    template<typename Vtable>
+    Object *ownerOf(const Vtable *const *self) noexcept
+    {
+        return reinterpret_cast<const Itf<Vtable> *>(self)->owner;
+    }
+
+    /**
+     * PCM of an asset: a 16 bits WAV is decoded for real, anything else is silence of the estimated duration
+     */
+    struct Source
+    {
+        bool wav = false;
+        SLuint32 channels = 2;
+        SLuint32 sampleRate = 44100;
+        uint64_t frames = 0;
+        std::vector<int16_t> samples; // only read for the decoders
+    };
+
+    struct Buffer
+    {
+        const void *data;
+        SLuint32 size;
+    };
+
+    struct Pending
+    {
+        int buffers = 0; // completed buffers, one queue callback each
+        SLuint32 playEvents = 0;
+        SLuint32 prefetchEvents = 0;
+    };
+
+    struct Object
+    {
+        Itf<SLObjectItf_> object;
+        Itf<SLEngineItf_> engine;
+        Itf<SLPlayItf_> play;
+        Itf<SLSeekItf_> seek;
+        Itf<SLVolumeItf_> volume;
+        Itf<SLPrefetchStatusItf_> prefetch;
+        Itf<SLPlaybackRateItf_> rate;
+        Itf<SLAndroidSimpleBufferQueueItf_> queue;
+        Itf<SLAndroidConfigurationItf_> config;
+        Itf<SLMetadataExtractionItf_> metadata;
+
+        Device *device = nullptr;
+        Kind kind = KIND_PLAYER;
+        uint32_t interfaces = 0;
+
+        // Guards the state below, never held while a callback runs
+        std::mutex mutex;
+        // Held while the callbacks of the object run, Destroy takes it to wait for them like OpenSL does
+        std::mutex callbackMutex;
+        std::atomic<bool> destroyed{false};
+
+        bool realized = false;
+        bool track = false; // counted in the realized output players
+        bool fromQueue = false; // PCM buffer queue source
+        bool toQueue = false; // decoder: the PCM goes to a buffer queue
+        Source source;
+        SLuint32 numBuffers = 0;
+
+        SLuint32 state = SL_PLAYSTATE_STOPPED;
+        double frames = 0.; // play head in frames of the source
+        double pendingBytes = 0.; // fraction of a frame not consumed yet
+        int64_t startAt = 0; // the head doesn't move before
+        int64_t prefetchAt = 0;
+        bool moving = false;
+        bool loop = false;
+        SLmillisecond marker = SL_TIME_UNKNOWN;
+        SLmillisecond period = 1000;
+        uint64_t lastPeriod = 0;
+
+        SLuint32 playMask = 0;
+        slPlayCallback playCallback = nullptr;
+        void *playContext = nullptr;
+
+        SLuint32 prefetchStatus = SL_PREFETCHSTATUS_UNDERFLOW;
+        SLuint32 prefetchMask = 0;
+        slPrefetchCallback prefetchCallback = nullptr;
+        void *prefetchContext = nullptr;
+
+        std::deque<Buffer> buffers;
+        size_t consumed = 0; // bytes of the front buffer
+        SLuint32 queueIndex = 0;
+        slAndroidSimpleBufferQueueCallback queueCallback = nullptr;
+        void *queueContext = nullptr;
+
+        SLmillibel level = 0;
+        SLboolean stereo = SL_BOOLEAN_FALSE;
+        SLpermille stereoPosition = 0;
+        SLpermille playbackRate = 1000;
+        SLuint32 performanceMode = 0;
+        SLuint32 grantedMode = 0;
+    };
+
+    /**
+     * The engine object and its simulated audio thread
+     */
+    struct Device
+    {
+        AudioHostBackend::Config config;
+        std::shared_ptr<AudioHostBackend::Counters> counters;
+        Object engine;
+        Object *outputMix = nullptr;
+
+        std::mutex mutex; // guards the objects and the random state
+        std::vector<std::shared_ptr<Object>> objects;
+        uint32_t random = 1;
+
+        std::thread thread;
+        std::atomic<bool> exit{false};
+    };
+
+    const SLObjectItf_ *getObjectVtable() noexcept;
+    const SLEngineItf_ *getEngineVtable() noexcept;
+    const SLPlayItf_ *getPlayVtable() noexcept;
+    const SLSeekItf_ *getSeekVtable() noexcept;
+    const SLVolumeItf_ *getVolumeVtable() noexcept;
+    const SLPrefetchStatusItf_ *getPrefetchVtable() noexcept;
+    const SLPlaybackRateItf_ *getRateVtable() noexcept;
+    const SLAndroidSimpleBufferQueueItf_ *getQueueVtable() noexcept;
+    const SLAndroidConfigurationItf_ *getConfigVtable() noexcept;
+    const SLMetadataExtractionItf_ *getMetadataVtable() noexcept;
+
+    void initObject(Object &object, Device *device, const Kind kind, const uint32_t interfaces) noexcept
+    {
+        object.object = {getObjectVtable(), &object};
+        object.engine = {getEngineVtable(), &object};
+        object.play = {getPlayVtable(), &object};
+        object.seek = {getSeekVtable(), &object};
+        object.volume = {getVolumeVtable(), &object};
+        object.prefetch = {getPrefetchVtable(), &object};
+        object.rate = {getRateVtable(), &object};
+        object.queue = {getQueueVtable(), &object};
+        object.config = {getConfigVtable(), &object};
+        object.metadata = {getMetadataVtable(), &object};
+        object.device = device;
+        object.kind = kind;
+        object.interfaces = interfaces;
+    }
+
+    uint32_t interfaceOf(const SLInterfaceID iid) noexcept
+    {
+        for (size_t i = 0; i < sizeof(gInterfaceIds) / sizeof(gInterfaceIds[0]); ++i)
+        {
+            if (iid == &gInterfaceIds[i])
+            {
+                return 1u << i;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Draw an injected failure, xorshift under the lock of the device
+     */
+    bool drawFailure(Device *device, const double rate) noexcept
+    {
+        if (rate <= 0.)
+        {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(device->mutex);
+        uint32_t x = device->random;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        device->random = x;
+        const bool ret = (double) x / 4294967296. < rate;
+        if (ret)
+        {
+            ++device->counters->failed;
+        }
+        return ret;
+    }
+
+    void sleepUs(const int us) noexcept
+    {
+        if (us > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(us));
+        }
+    }
+
+    uint32_t readLe32(const uint8_t *p) noexcept
+    {
+        return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+    }
+
+    uint16_t readLe16(const uint8_t *p) noexcept
+    {
+        return (uint16_t) (p[0] | (p[1] << 8));
+    }
+
+    /**
+     * Read the format of the asset, and its PCM for a decoder
+     */
+    bool readSource(const int fd, const off64_t start, const off64_t length, const bool decode, const uint32_t bitRate, Source &source) noexcept
+    {
+        if (fd < 0 || length <= 0)
+        {
+            return false;
+        }
+        uint8_t header[12];
+        off64_t offset = start + 12;
+        if (length >= 12 && pread64(fd, header, sizeof(header), start) == (ssize_t) sizeof(header)
+            && 0 == memcmp(header, "RIFF", 4) && 0 == memcmp(header + 8, "WAVE", 4))
+        {
+            uint16_t bits = 0;
+            while (offset + 8 <= start + length)
+            {
+                uint8_t chunk[24];
+                if (pread64(fd, chunk, 8, offset) != 8)
+                {
+                    break;
+                }
+                const uint32_t size = readLe32(chunk + 4);
+                if (0 == memcmp(chunk, "fmt ", 4) && size >= 16 && pread64(fd, chunk + 8, 16, offset + 8) == 16)
+                {
+                    source.channels = readLe16(chunk + 10);
+                    source.sampleRate = readLe32(chunk + 12);
+                    bits = readLe16(chunk + 22);
+                }
+                else if (0 == memcmp(chunk, "data", 4) && bits == 16 && source.channels > 0)
+                {
+                    const off64_t available = start + length - (offset + 8);
+                    const size_t bytes = (size_t) (size < available ? size : available);
+                    source.wav = true;
+                    source.frames = bytes / (2 * source.channels);
+                    if (decode)
+                    {
+                        source.samples.resize((size_t) source.frames * source.channels);
+                        if (pread64(fd, source.samples.data(), source.samples.size() * sizeof(int16_t), offset + 8) != (ssize_t) (source.samples.size() * sizeof(int16_t)))
+                        {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                offset += 8 + size + (size & 1);
+            }
+            return false;
+        }
+        source.channels = 2;
+        source.sampleRate = 44100;
+        source.frames = (uint64_t) length * 8 * source.sampleRate / (bitRate > 0 ? bitRate : 128000);
+        return true;
+    }
+
+    SLmillisecond framesToMs(const Object &player, const double frames) noexcept
+    {
+        return player.source.sampleRate > 0 ? (SLmillisecond) (frames * 1000. / player.source.sampleRate) : 0;
+    }
+
+    /**
+     * Play events of a head going from previousMs to the current position, player.mutex must be held
+     */
+    SLuint32 headEvents(Object &player, const SLmillisecond previousMs) noexcept
+    {
+        SLuint32 ret = 0;
+        const SLmillisecond positionMs = framesToMs(player, player.frames);
+        if (!player.moving)
+        {
+            player.moving = true;
+            ret |= SL_PLAYEVENT_HEADMOVING;
+        }
+        if (player.period > 0 && positionMs / player.period != player.lastPeriod)
+        {
+            player.lastPeriod = positionMs / player.period;
+            ret |= SL_PLAYEVENT_HEADATNEWPOS;
+        }
+        if (player.marker != SL_TIME_UNKNOWN && previousMs < player.marker && positionMs >= player.marker)
+        {
+            ret |= SL_PLAYEVENT_HEADATMARKER;
+        }
+        return ret;
+    }
+
+    /**
+     * Move the head of an output player by elapsedNs of real time, player.mutex must be held
+     */
+    void advance(Object &player, const int64_t elapsedNs, Pending &pending) noexcept
+    {
+        const SLmillisecond previousMs = framesToMs(player, player.frames);
+        const double step = (double) elapsedNs * player.source.sampleRate * player.playbackRate / 1000. / 1e9;
+        if (player.fromQueue)
+        {
+            const size_t frameBytes = 2 * player.source.channels;
+            player.pendingBytes += step * frameBytes;
+            size_t bytes = (size_t) player.pendingBytes;
+            player.pendingBytes -= bytes;
+            size_t played = 0;
+            while (bytes > 0 && !player.buffers.empty())
+            {
+                const Buffer &front = player.buffers.front();
+                const size_t taken = std::min(bytes, front.size - player.consumed);
+                player.consumed += taken;
+                played += taken;
+                bytes -= taken;
+                if (player.consumed >= front.size)
+                {
+                    player.buffers.pop_front();
+                    player.consumed = 0;
+                    ++player.queueIndex;
+                    ++pending.buffers;
+                }
+            }
+            if (player.buffers.empty())
+            {
+                player.pendingBytes = 0.; // Starved, the head waits for the next buffer
+            }
+            if (played == 0)
+            {
+                return;
+            }
+            player.frames += (double) played / frameBytes;
+        }
+        else
+        {
+            player.frames += step;
+            const double total = (double) player.source.frames;
+            if (player.frames >= total)
+            {
+                if (player.loop && total > 0.)
+                {
+                    player.frames = std::fmod(player.frames, total);
+                }
+                else
+                {
+                    player.frames = total;
+                    player.state = SL_PLAYSTATE_PAUSED;
+                    pending.playEvents |= SL_PLAYEVENT_HEADATEND;
+                }
+            }
+        }
+        pending.playEvents |= headEvents(player, previousMs);
+    }
+
+    /**
+     * Run the callbacks of the pending events, without player.mutex: they can call the player back
+     */
+    void fire(Object &player, const Pending &pending) noexcept
+    {
+        if (pending.buffers == 0 && pending.playEvents == 0 && pending.prefetchEvents == 0)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(player.callbackMutex);
+        if (player.destroyed)
+        {
+            return;
+        }
+        slAndroidSimpleBufferQueueCallback queueCallback = nullptr;
+        slPlayCallback playCallback = nullptr;
+        slPrefetchCallback prefetchCallback = nullptr;
+        void *queueContext = nullptr, *playContext = nullptr, *prefetchContext = nullptr;
+        SLuint32 playEvents = 0, prefetchEvents = 0;
+        {
+            std::lock_guard<std::mutex> state(player.mutex);
+            queueCallback = player.queueCallback;
+            queueContext = player.queueContext;
+            playCallback = player.playCallback;
+            playContext = player.playContext;
+            playEvents = pending.playEvents & player.playMask;
+            prefetchCallback = player.prefetchCallback;
+            prefetchContext = player.prefetchContext;
+            prefetchEvents = pending.prefetchEvents & player.prefetchMask;
+        }
+        AudioHostBackend::Counters &counters = *player.device->counters;
+        for (int i = 0; i < pending.buffers && queueCallback != nullptr; ++i)
+        {
+            queueCallback(&player.queue.vtable, queueContext);
+            ++counters.callbacks;
+        }
+        if (playEvents != 0 && playCallback != nullptr)
+        {
+            playCallback(&player.play.vtable, playContext, playEvents);
+            ++counters.callbacks;
+        }
+        if (prefetchEvents != 0 && prefetchCallback != nullptr)
+        {
+            prefetchCallback(&player.prefetch.vtable, prefetchContext, prefetchEvents);
+            ++counters.callbacks;
+        }
+    }
+
+    /**
+     * Fill the buffers enqueued on a decoder, one callback each, the decoder callbacks enqueue the next ones
+     */
+    void decode(Object &player) noexcept
+    {
+        for (int i = 0; i < MAX_DECODED_BUFFERS_PER_TICK; ++i)
+        {
+            Pending pending;
+            {
+                std::lock_guard<std::mutex> lock(player.mutex);
+                if (player.destroyed || player.state != SL_PLAYSTATE_PLAYING || player.buffers.empty())
+                {
+                    return;
+                }
+                const Buffer buffer = player.buffers.front();
+                player.buffers.pop_front();
+                ++player.queueIndex;
+                pending.buffers = 1;
+
+                const size_t channels = player.source.channels;
+                const size_t first = (size_t) player.frames * channels;
+                const size_t total = (size_t) player.source.frames * channels;
+                const size_t count = std::min((size_t) buffer.size / sizeof(int16_t), total - std::min(first, total));
+                int16_t *out = static_cast<int16_t *>(const_cast<void *>(buffer.data));
+                if (player.source.wav)
+                {
+                    memcpy(out, player.source.samples.data() + first, count * sizeof(int16_t));
+                }
+                else
+                {
+                    memset(out, 0, count * sizeof(int16_t));
+                }
+                player.frames += (double) count / channels;
+                if (first + count >= total)
+                {
+                    player.state = SL_PLAYSTATE_PAUSED;
+                    pending.playEvents = SL_PLAYEVENT_HEADATEND;
+                }
+            }
+            fire(player, pending);
+            if (pending.playEvents != 0)
+            {
+                return;
+            }
+        }
+    }
+
+    void tick(Object &player, const int64_t now, const int64_t elapsedNs) noexcept
+    {
+        Pending pending;
+        {
+            std::lock_guard<std::mutex> lock(player.mutex);
+            if (player.destroyed || !player.realized)
+            {
+                return;
+            }
+            if (player.prefetchStatus != SL_PREFETCHSTATUS_SUFFICIENTDATA && now >= player.prefetchAt)
+            {
+                player.prefetchStatus = SL_PREFETCHSTATUS_SUFFICIENTDATA;
+                pending.prefetchEvents = SL_PREFETCHEVENT_STATUSCHANGE | SL_PREFETCHEVENT_FILLLEVELCHANGE;
+            }
+            if (!player.toQueue && player.state == SL_PLAYSTATE_PLAYING && now >= player.startAt && player.prefetchStatus == SL_PREFETCHSTATUS_SUFFICIENTDATA)
+            {
+                advance(player, std::min(elapsedNs, now - player.startAt), pending);
+            }
+        }
+        fire(player, pending);
+        if (player.toQueue)
+        {
+            decode(player);
+        }
+    }
+
+    void run(Device *device) noexcept
+    {
+        int64_t last = nowNanos();
+        std::vector<std::shared_ptr<Object>> players;
+        while (!device->exit)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(device->config.tickMs));
+            const int64_t now = nowNanos();
+            {
+                std::lock_guard<std::mutex> lock(device->mutex);
+                players = device->objects;
+            }
+            for (const std::shared_ptr<Object> &player : players)
+            {
+                if (player->kind == KIND_PLAYER)
+                {
+                    tick(*player, now, now - last);
+                }
+            }
+            players.clear(); // The destroyed players are freed here
+            last = now;
+        }
+    }
+
+    // SLObjectItf
+
+    SLresult objectRealize(SLObjectItf self, SLboolean async)
+    {
+        Object *object = ownerOf(self);
+        Device *device = object->device;
+        if (object->kind == KIND_PLAYER)
+        {
+            sleepUs(device->config.realizeLatencyUs);
+            if (drawFailure(device, device->config.realizeFailureRate))
+            {
+                return SL_RESULT_RESOURCE_ERROR;
+            }
+        }
+        std::lock_guard<std::mutex> lock(object->mutex);
+        if (object->realized)
+        {
+            return SL_RESULT_PRECONDITIONS_VIOLATED;
+        }
+        if (object->kind == KIND_ENGINE)
+        {
+            device->thread = std::thread(run, device);
+        }
+        else if (object->kind == KIND_PLAYER && !object->toQueue)
+        {
+            if (++device->counters->tracks > device->config.maxTracks)
+            {
+                --device->counters->tracks;
+                ++device->counters->failed;
+                return SL_RESULT_RESOURCE_ERROR;
+            }
+            object->track = true;
+#ifdef SL_ANDROID_KEY_PERFORMANCE_MODE
+            const bool eligible = object->fromQueue && object->source.sampleRate == device->config.sampleRate && (object->interfaces & ITF_PLAYBACKRATE) == 0;
+            object->grantedMode = object->performanceMode == SL_ANDROID_PERFORMANCE_LATENCY && !eligible ? SL_ANDROID_PERFORMANCE_NONE : object->performanceMode;
+#endif
+        }
+        if (object->kind == KIND_PLAYER)
+        {
+            const bool prefetched = object->fromQueue || object->toQueue;
+            object->prefetchStatus = prefetched ? SL_PREFETCHSTATUS_SUFFICIENTDATA : SL_PREFETCHSTATUS_UNDERFLOW;
+            object->prefetchAt = nowNanos() + (int64_t) device->config.prefetchLatencyMs * 1000000;
+        }
+        object->realized = true;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult objectGetInterface(SLObjectItf self, const SLInterfaceID iid, void *pInterface)
+    {
+        Object *object = ownerOf(self);
+        const uint32_t interface = interfaceOf(iid);
+        std::lock_guard<std::mutex> lock(object->mutex);
+        if (!object->realized)
+        {
+            return SL_RESULT_PRECONDITIONS_VIOLATED;
+        }
+        if ((object->interfaces & interface) == 0)
+        {
+            return SL_RESULT_FEATURE_UNSUPPORTED;
+        }
+        const void *ret = nullptr;
+        switch (interface)
+        {
+            case ITF_ENGINE:
+                ret = &object->engine.vtable;
+                break;
+            case ITF_PLAY:
+                ret = &object->play.vtable;
+                break;
+            case ITF_SEEK:
+                ret = &object->seek.vtable;
+                break;
+            case ITF_VOLUME:
+                ret = &object->volume.vtable;
+                break;
+            case ITF_PREFETCHSTATUS:
+                ret = &object->prefetch.vtable;
+                break;
+            case ITF_PLAYBACKRATE:
+                ret = &object->rate.vtable;
+                break;
+            case ITF_METADATAEXTRACTION:
+                ret = &object->metadata.vtable;
+                break;
+            case ITF_ANDROIDSIMPLEBUFFERQUEUE:
+                ret = &object->queue.vtable;
+                break;
+            case ITF_ANDROIDCONFIGURATION:
+                ret = &object->config.vtable;
+                break;
+            default:
+                return SL_RESULT_FEATURE_UNSUPPORTED;
+        }
+        *static_cast<const void **>(pInterface) = ret;
+        return SL_RESULT_SUCCESS;
+    }
+
+    /**
+     * Wait for the callback in flight like OpenSL, the memory goes with the last tick holding the object
+     */
+    void objectDestroy(SLObjectItf self)
+    {
+        Object *object = ownerOf(self);
+        Device *device = object->device;
+        if (object->kind == KIND_ENGINE)
+        {
+            device->exit = true;
+            if (device->thread.joinable())
+            {
+                device->thread.join();
+            }
+            delete device; // Frees the objects the caller didn't destroy
+            return;
+        }
+        std::shared_ptr<Object> owned;
+        {
+            std::lock_guard<std::mutex> lock(device->mutex);
+            for (auto it = device->objects.begin(); it != device->objects.end(); ++it)
+            {
+                if (it->get() == object)
+                {
+                    owned = std::move(*it);
+                    device->objects.erase(it);
+                    break;
+                }
+            }
+        }
+        object->destroyed = true;
+        {
+            std::lock_guard<std::mutex> lock(object->callbackMutex);
+        }
+        {
+            std::lock_guard<std::mutex> lock(object->mutex); // Nor a decoder still writing in the buffers of the caller
+        }
+        if (object->track)
+        {
+            --device->counters->tracks;
+        }
+        ++device->counters->destroyed;
+    }
+
+    // SLEngineItf
+
+    SLresult engineCreateOutputMix(SLEngineItf self, SLObjectItf *pMix, SLuint32 numInterfaces, const SLInterfaceID *pInterfaceIds, const SLboolean *pInterfaceRequired)
+    {
+        Device *device = ownerOf(self)->device;
+        std::shared_ptr<Object> mix = std::make_shared<Object>();
+        initObject(*mix, device, KIND_OUTPUT_MIX, 0);
+        *pMix = &mix->object.vtable;
+        std::lock_guard<std::mutex> lock(device->mutex);
+        device->outputMix = mix.get();
+        device->objects.push_back(std::move(mix));
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult engineCreateAudioPlayer(SLEngineItf self, SLObjectItf *pPlayer, SLDataSource *pAudioSrc, SLDataSink *pAudioSnk, SLuint32 numInterfaces,
+                                     const SLInterfaceID *pInterfaceIds, const SLboolean *pInterfaceRequired)
+    {
+        Device *device = ownerOf(self)->device;
+        const AudioHostBackend::Config &config = device->config;
+        sleepUs(config.createLatencyUs);
+        if (drawFailure(device, config.createFailureRate))
+        {
+            return SL_RESULT_MEMORY_FAILURE;
+        }
+        if (pAudioSrc == nullptr || pAudioSrc->pLocator == nullptr || pAudioSnk == nullptr || pAudioSnk->pLocator == nullptr)
+        {
+            return SL_RESULT_PARAMETER_INVALID;
+        }
+
+        std::shared_ptr<Object> player = std::make_shared<Object>();
+        uint32_t supported = 0;
+        const SLuint32 sourceType = *static_cast<const SLuint32 *>(pAudioSrc->pLocator);
+        const SLuint32 sinkType = *static_cast<const SLuint32 *>(pAudioSnk->pLocator);
+        if (sourceType == SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE && sinkType == SL_DATALOCATOR_OUTPUTMIX)
+        {
+            const SLDataFormat_PCM *format = static_cast<const SLDataFormat_PCM *>(pAudioSrc->pFormat);
+            if (format == nullptr || format->numChannels == 0 || format->numChannels > 2 || format->samplesPerSec == 0)
+            {
+                return SL_RESULT_CONTENT_UNSUPPORTED;
+            }
+            player->fromQueue = true;
+            player->numBuffers = static_cast<const SLDataLocator_AndroidSimpleBufferQueue *>(pAudioSrc->pLocator)->numBuffers;
+            player->source.channels = format->numChannels;
+            player->source.sampleRate = format->samplesPerSec / 1000;
+            supported = ITF_ANDROIDSIMPLEBUFFERQUEUE | ITF_VOLUME | ITF_PLAYBACKRATE | ITF_ANDROIDCONFIGURATION;
+        }
+        else if (sourceType == SL_DATALOCATOR_ANDROIDFD || sourceType == SL_DATALOCATOR_URI)
+        {
+            player->toQueue = sinkType == SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE;
+            bool found = false;
+            if (sourceType == SL_DATALOCATOR_ANDROIDFD)
+            {
+                const SLDataLocator_AndroidFD *locator = static_cast<const SLDataLocator_AndroidFD *>(pAudioSrc->pLocator);
+                found = readSource(locator->fd, locator->offset, locator->length, player->toQueue, config.compressedBitRate, player->source);
+            }
+            else
+            {
+                const int fd = open((const char *) static_cast<const SLDataLocator_URI *>(pAudioSrc->pLocator)->URI, O_RDONLY | O_CLOEXEC);
+                struct stat info;
+                found = fd >= 0 && fstat(fd, &info) == 0 && readSource(fd, 0, info.st_size, player->toQueue, config.compressedBitRate, player->source);
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+            }
+            if (!found)
+            {
+                return SL_RESULT_CONTENT_NOT_FOUND;
+            }
+            if (player->toQueue)
+            {
+                player->numBuffers = static_cast<const SLDataLocator_AndroidSimpleBufferQueue *>(pAudioSnk->pLocator)->numBuffers;
+                supported = ITF_ANDROIDSIMPLEBUFFERQUEUE | ITF_METADATAEXTRACTION | ITF_PREFETCHSTATUS | ITF_SEEK;
+            }
+            else
+            {
+                supported = ITF_SEEK | ITF_PREFETCHSTATUS | ITF_VOLUME | ITF_PLAYBACKRATE | ITF_METADATAEXTRACTION | ITF_ANDROIDCONFIGURATION;
+            }
+        }
+        else
+        {
+            return SL_RESULT_CONTENT_UNSUPPORTED;
+        }
+
+        uint32_t interfaces = ITF_PLAY;
+        for (SLuint32 i = 0; i < numInterfaces; ++i)
+        {
+            const uint32_t interface = interfaceOf(pInterfaceIds[i]);
+            if ((supported & interface) != 0)
+            {
+                interfaces |= interface;
+            }
+            else if (pInterfaceRequired[i] == SL_BOOLEAN_TRUE)
+            {
+                return SL_RESULT_FEATURE_UNSUPPORTED;
+            }
+        }
+        initObject(*player, device, KIND_PLAYER, interfaces);
+        *pPlayer = &player->object.vtable;
+        ++device->counters->created;
+        std::lock_guard<std::mutex> lock(device->mutex);
+        device->objects.push_back(std::move(player));
+        return SL_RESULT_SUCCESS;
+    }
+
+    // SLPlayItf
+
+    SLresult playSetPlayState(SLPlayItf self, SLuint32 state)
+    {
+        Object *player = ownerOf(self);
+        if (state != SL_PLAYSTATE_STOPPED && state != SL_PLAYSTATE_PAUSED && state != SL_PLAYSTATE_PLAYING)
+        {
+            return SL_RESULT_PARAMETER_INVALID;
+        }
+        std::lock_guard<std::mutex> lock(player->mutex);
+        if (state == SL_PLAYSTATE_PLAYING && player->state != SL_PLAYSTATE_PLAYING)
+        {
+            player->startAt = nowNanos() + (int64_t) player->device->config.startLatencyMs * 1000000;
+            player->moving = false;
+        }
+        else if (state == SL_PLAYSTATE_STOPPED)
+        {
+            player->frames = 0.;
+            player->pendingBytes = 0.;
+            player->lastPeriod = 0;
+        }
+        player->state = state;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult playGetPlayState(SLPlayItf self, SLuint32 *pState)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        *pState = player->state;
+        return SL_RESULT_SUCCESS;
+    }
+
+    /**
+     * Known once prefetched for a fd player, never for a buffer queue player
+     */
+    SLresult playGetDuration(SLPlayItf self, SLmillisecond *pMsec)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        const bool known = !player->fromQueue && player->prefetchStatus == SL_PREFETCHSTATUS_SUFFICIENTDATA;
+        *pMsec = known ? framesToMs(*player, (double) player->source.frames) : SL_TIME_UNKNOWN;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult playGetPosition(SLPlayItf self, SLmillisecond *pMsec)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        *pMsec = framesToMs(*player, player->frames);
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult playRegisterCallback(SLPlayItf self, slPlayCallback callback, void *pContext)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->playCallback = callback;
+        player->playContext = pContext;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult playSetCallbackEventsMask(SLPlayItf self, SLuint32 eventFlags)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->playMask = eventFlags;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult playGetCallbackEventsMask(SLPlayItf self, SLuint32 *pEventFlags)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        *pEventFlags = player->playMask;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult playSetMarkerPosition(SLPlayItf self, SLmillisecond mSec)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->marker = mSec;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult playClearMarkerPosition(SLPlayItf self)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->marker = SL_TIME_UNKNOWN;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult playGetMarkerPosition(SLPlayItf self, SLmillisecond *pMsec)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        *pMsec = player->marker;
+        return player->marker == SL_TIME_UNKNOWN ? SL_RESULT_PRECONDITIONS_VIOLATED : SL_RESULT_SUCCESS;
+    }
+
+    SLresult playSetPositionUpdatePeriod(SLPlayItf self, SLmillisecond mSec)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->period = mSec;
+        player->lastPeriod = mSec > 0 ? framesToMs(*player, player->frames) / mSec : 0;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult playGetPositionUpdatePeriod(SLPlayItf self, SLmillisecond *pMsec)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        *pMsec = player->period;
+        return SL_RESULT_SUCCESS;
+    }
+
+    // SLSeekItf
+
+    SLresult seekSetPosition(SLSeekItf self, SLmillisecond pos, SLuint32 seekMode)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        const double frames = (double) pos * player->source.sampleRate / 1000.;
+        player->frames = std::min(frames, (double) player->source.frames);
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult seekSetLoop(SLSeekItf self, SLboolean loopEnable, SLmillisecond startPos, SLmillisecond endPos)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->loop = loopEnable == SL_BOOLEAN_TRUE;
+        return SL_RESULT_SUCCESS;
+    }
+
+    // SLVolumeItf
+
+    SLresult volumeSetVolumeLevel(SLVolumeItf self, SLmillibel level)
+    {
+        Object *player = ownerOf(self);
+        if (level > 0)
+        {
+            return SL_RESULT_PARAMETER_INVALID;
+        }
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->level = level;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult volumeGetVolumeLevel(SLVolumeItf self, SLmillibel *pLevel)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        *pLevel = player->level;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult volumeEnableStereoPosition(SLVolumeItf self, SLboolean enable)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->stereo = enable;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult volumeSetStereoPosition(SLVolumeItf self, SLpermille stereoPosition)
+    {
+        Object *player = ownerOf(self);
+        if (stereoPosition < -1000 || stereoPosition > 1000)
+        {
+            return SL_RESULT_PARAMETER_INVALID;
+        }
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->stereoPosition = stereoPosition;
+        return SL_RESULT_SUCCESS;
+    }
+
+    // SLPrefetchStatusItf
+
+    SLresult prefetchGetPrefetchStatus(SLPrefetchStatusItf self, SLuint32 *pProp)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        *pProp = player->prefetchStatus;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult prefetchGetFillLevel(SLPrefetchStatusItf self, SLpermille *pLevel)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        *pLevel = player->prefetchStatus == SL_PREFETCHSTATUS_SUFFICIENTDATA ? 1000 : 0;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult prefetchRegisterCallback(SLPrefetchStatusItf self, slPrefetchCallback callback, void *pContext)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->prefetchCallback = callback;
+        player->prefetchContext = pContext;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult prefetchSetCallbackEventsMask(SLPrefetchStatusItf self, SLuint32 eventFlags)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->prefetchMask = eventFlags;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult prefetchSetFillUpdatePeriod(SLPrefetchStatusItf self, SLpermille period)
+    {
+        return period > 0 && period <= 1000 ? SL_RESULT_SUCCESS : SL_RESULT_PARAMETER_INVALID;
+    }
+
+    // SLPlaybackRateItf
+
+    SLresult rateSetRate(SLPlaybackRateItf self, SLpermille rate)
+    {
+        Object *player = ownerOf(self);
+        if (rate < MIN_RATE || rate > MAX_RATE)
+        {
+            return SL_RESULT_PARAMETER_INVALID;
+        }
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->playbackRate = rate;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult rateGetRate(SLPlaybackRateItf self, SLpermille *pRate)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        *pRate = player->playbackRate;
+        return SL_RESULT_SUCCESS;
+    }
+
+    // SLAndroidSimpleBufferQueueItf
+
+    SLresult queueEnqueue(SLAndroidSimpleBufferQueueItf self, const void *pBuffer, SLuint32 size)
+    {
+        Object *player = ownerOf(self);
+        if (pBuffer == nullptr || size == 0)
+        {
+            return SL_RESULT_PARAMETER_INVALID;
+        }
+        std::lock_guard<std::mutex> lock(player->mutex);
+        if (player->buffers.size() >= player->numBuffers)
+        {
+            return SL_RESULT_BUFFER_INSUFFICIENT;
+        }
+        player->buffers.push_back({pBuffer, size});
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult queueClear(SLAndroidSimpleBufferQueueItf self)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->buffers.clear();
+        player->consumed = 0;
+        player->pendingBytes = 0.;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult queueGetState(SLAndroidSimpleBufferQueueItf self, SLAndroidSimpleBufferQueueState *pState)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        pState->count = (SLuint32) player->buffers.size();
+        pState->index = player->queueIndex;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult queueRegisterCallback(SLAndroidSimpleBufferQueueItf self, slAndroidSimpleBufferQueueCallback callback, void *pContext)
+    {
+        Object *player = ownerOf(self);
+        std::lock_guard<std::mutex> lock(player->mutex);
+        player->queueCallback = callback;
+        player->queueContext = pContext;
+        return SL_RESULT_SUCCESS;
+    }
+
+    // SLAndroidConfigurationItf
+
+    SLresult configSetConfiguration(SLAndroidConfigurationItf self, const SLchar *configKey, const void *pConfigValue, SLuint32 valueSize)
+    {
+#ifdef SL_ANDROID_KEY_PERFORMANCE_MODE
+        Object *player = ownerOf(self);
+        if (0 == strcmp((const char *) configKey, (const char *) SL_ANDROID_KEY_PERFORMANCE_MODE) && valueSize == sizeof(SLuint32))
+        {
+            std::lock_guard<std::mutex> lock(player->mutex);
+            if (player->realized)
+            {
+                return SL_RESULT_PRECONDITIONS_VIOLATED;
+            }
+            memcpy(&player->performanceMode, pConfigValue, sizeof(SLuint32));
+        }
+#endif
+        return SL_RESULT_SUCCESS;
+    }
+
+    /**
+     * The performance mode reads back the mode granted at Realize, downgraded without a fast track like Android does
+     */
+    SLresult configGetConfiguration(SLAndroidConfigurationItf self, const SLchar *configKey, SLuint32 *pValueSize, void *pConfigValue)
+    {
+#ifdef SL_ANDROID_KEY_PERFORMANCE_MODE
+        Object *player = ownerOf(self);
+        if (0 == strcmp((const char *) configKey, (const char *) SL_ANDROID_KEY_PERFORMANCE_MODE) && *pValueSize >= sizeof(SLuint32))
+        {
+            std::lock_guard<std::mutex> lock(player->mutex);
+            memcpy(pConfigValue, &player->grantedMode, sizeof(SLuint32));
+            *pValueSize = sizeof(SLuint32);
+            return SL_RESULT_SUCCESS;
+        }
+#endif
+        return SL_RESULT_PARAMETER_INVALID;
+    }
+
+    // SLMetadataExtractionItf: the PCM format keys of the Android decoders
+
+    const char *const METADATA_KEYS[2] = {ANDROID_KEY_PCMFORMAT_NUMCHANNELS, ANDROID_KEY_PCMFORMAT_SAMPLERATE};
+
+    SLresult metadataGetItemCount(SLMetadataExtractionItf self, SLuint32 *pItemCount)
+    {
+        *pItemCount = 2;
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult metadataGetKeySize(SLMetadataExtractionItf self, SLuint32 index, SLuint32 *pKeySize)
+    {
+        if (index >= 2)
+        {
+            return SL_RESULT_PARAMETER_INVALID;
+        }
+        *pKeySize = (SLuint32) (sizeof(SLMetadataInfo) + strlen(METADATA_KEYS[index]));
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult metadataGetKey(SLMetadataExtractionItf self, SLuint32 index, SLuint32 keySize, SLMetadataInfo *pKey)
+    {
+        const size_t length = index < 2 ? strlen(METADATA_KEYS[index]) : 0;
+        if (index >= 2 || keySize < sizeof(SLMetadataInfo) + length)
+        {
+            return SL_RESULT_PARAMETER_INVALID;
+        }
+        pKey->size = (SLuint32) length + 1;
+        pKey->encoding = SL_CHARACTERENCODING_ASCII;
+        memset(pKey->langCountry, 0, sizeof(pKey->langCountry));
+        memcpy(pKey->data, METADATA_KEYS[index], length + 1);
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult metadataGetValueSize(SLMetadataExtractionItf self, SLuint32 index, SLuint32 *pValueSize)
+    {
+        if (index >= 2)
+        {
+            return SL_RESULT_PARAMETER_INVALID;
+        }
+        *pValueSize = (SLuint32) (sizeof(SLMetadataInfo) + sizeof(SLuint32));
+        return SL_RESULT_SUCCESS;
+    }
+
+    SLresult metadataGetValue(SLMetadataExtractionItf self, SLuint32 index, SLuint32 valueSize, SLMetadataInfo *pValue)
+    {
+        Object *player = ownerOf(self);
+        if (index >= 2 || valueSize < sizeof(SLMetadataInfo) + sizeof(SLuint32))
+        {
+            return SL_RESULT_PARAMETER_INVALID;
+        }
+        SLuint32 value = 0;
+        {
+            std::lock_guard<std::mutex> lock(player->mutex);
+            value = index == 0 ? player->source.channels : player->source.sampleRate;
+        }
+        pValue->size = sizeof(SLuint32);
+        pValue->encoding = SL_CHARACTERENCODING_BINARY;
+        memset(pValue->langCountry, 0, sizeof(pValue->langCountry));
+        memcpy(pValue->data, &value, sizeof(value));
+        return SL_RESULT_SUCCESS;
+    }
+
+    // Vtables, filled by name so they don't depend on the order of the members in the headers
+
+    const SLObjectItf_ *getObjectVtable() noexcept
+    {
+        static const SLObjectItf_ vtable = []()
+        {
+            SLObjectItf_ ret;
+            memset(&ret, 0, sizeof(ret));
+            ret.Realize = objectRealize;
+            ret.GetInterface = objectGetInterface;
+            ret.Destroy = objectDestroy;
+            return ret;
+        }();
+        return &vtable;
+    }
+
+    const SLEngineItf_ *getEngineVtable() noexcept
+    {
+        static const SLEngineItf_ vtable = []()
+        {
+            SLEngineItf_ ret;
+            memset(&ret, 0, sizeof(ret));
+            ret.CreateAudioPlayer = engineCreateAudioPlayer;
+            ret.CreateOutputMix = engineCreateOutputMix;
+            return ret;
+        }();
+        return &vtable;
+    }
+
+    const SLPlayItf_ *getPlayVtable() noexcept
+    {
+        static const SLPlayItf_ vtable = []()
+        {
+            SLPlayItf_ ret;
+            memset(&ret, 0, sizeof(ret));
+            ret.SetPlayState = playSetPlayState;
+            ret.GetPlayState = playGetPlayState;
+            ret.GetDuration = playGetDuration;
+            ret.GetPosition = playGetPosition;
+            ret.RegisterCallback = playRegisterCallback;
+            ret.SetCallbackEventsMask = playSetCallbackEventsMask;
+            ret.GetCallbackEventsMask = playGetCallbackEventsMask;
+            ret.SetMarkerPosition = playSetMarkerPosition;
+            ret.ClearMarkerPosition = playClearMarkerPosition;
+            ret.GetMarkerPosition = playGetMarkerPosition;
+            ret.SetPositionUpdatePeriod = playSetPositionUpdatePeriod;
+            ret.GetPositionUpdatePeriod = playGetPositionUpdatePeriod;
+            return ret;
+        }();
+        return &vtable;
+    }
+
+    const SLSeekItf_ *getSeekVtable() noexcept
+    {
+        static const SLSeekItf_ vtable = []()
+        {
+            SLSeekItf_ ret;
+            memset(&ret, 0, sizeof(ret));
+            ret.SetPosition = seekSetPosition;
+            ret.SetLoop = seekSetLoop;
+            return ret;
+        }();
+        return &vtable;
+    }
+
+    const SLVolumeItf_ *getVolumeVtable() noexcept
+    {
+        static const SLVolumeItf_ vtable = []()
+        {
+            SLVolumeItf_ ret;
+            memset(&ret, 0, sizeof(ret));
+            ret.SetVolumeLevel = volumeSetVolumeLevel;
+            ret.GetVolumeLevel = volumeGetVolumeLevel;
+            ret.EnableStereoPosition = volumeEnableStereoPosition;
+            ret.SetStereoPosition = volumeSetStereoPosition;
+            return ret;
+        }();
+        return &vtable;
+    }
+
+    const SLPrefetchStatusItf_ *getPrefetchVtable() noexcept
+    {
+        static const SLPrefetchStatusItf_ vtable = []()
+        {
+            SLPrefetchStatusItf_ ret;
+            memset(&ret, 0, sizeof(ret));
+            ret.GetPrefetchStatus = prefetchGetPrefetchStatus;
+            ret.GetFillLevel = prefetchGetFillLevel;
+            ret.RegisterCallback = prefetchRegisterCallback;
+            ret.SetCallbackEventsMask = prefetchSetCallbackEventsMask;
+            ret.SetFillUpdatePeriod = prefetchSetFillUpdatePeriod;
+            return ret;
+        }();
+        return &vtable;
+    }
+
+    const SLPlaybackRateItf_ *getRateVtable() noexcept
+    {
+        static const SLPlaybackRateItf_ vtable = []()
+        {
+            SLPlaybackRateItf_ ret;
+            memset(&ret, 0, sizeof(ret));
+            ret.SetRate = rateSetRate;
+            ret.GetRate = rateGetRate;
+            return ret;
+        }();
+        return &vtable;
+    }
+
+    const SLAndroidSimpleBufferQueueItf_ *getQueueVtable() noexcept
+    {
+        static const SLAndroidSimpleBufferQueueItf_ vtable = []()
+        {
+            SLAndroidSimpleBufferQueueItf_ ret;
+            memset(&ret, 0, sizeof(ret));
+            ret.Enqueue = queueEnqueue;
+            ret.Clear = queueClear;
+            ret.GetState = queueGetState;
+            ret.RegisterCallback = queueRegisterCallback;
+            return ret;
+        }();
+        return &vtable;
+    }
+
+    const SLAndroidConfigurationItf_ *getConfigVtable() noexcept
+    {
+        static const SLAndroidConfigurationItf_ vtable = []()
+        {
+            SLAndroidConfigurationItf_ ret;
+            memset(&ret, 0, sizeof(ret));
+            ret.SetConfiguration = configSetConfiguration;
+            ret.GetConfiguration = configGetConfiguration;
+            return ret;
+        }();
+        return &vtable;
+    }
+
+    const SLMetadataExtractionItf_ *getMetadataVtable() noexcept
+    {
+        static const SLMetadataExtractionItf_ vtable = []()
+        {
+            SLMetadataExtractionItf_ ret;
+            memset(&ret, 0, sizeof(ret));
+            ret.GetItemCount = metadataGetItemCount;
+            ret.GetKeySize = metadataGetKeySize;
+            ret.GetKey = metadataGetKey;
+            ret.GetValueSize = metadataGetValueSize;
+            ret.GetValue = metadataGetValue;
+            return ret;
+        }();
+        return &vtable;
+    }
+}
+
+AudioHostBackend::AudioHostBackend(const Config &config) : _config(config)
+, _assetManager(new AAssetManager{config.assetsPath})
+, _counters(std::make_shared<Counters>())
+{
+    _counters->created = 0;
+    _counters->destroyed = 0;
+    _counters->failed = 0;
+    _counters->callbacks = 0;
+    _counters->tracks = 0;
+}
+
+AudioHostBackend::~AudioHostBackend()
+{
+    delete _assetManager;
+}
+
+/**
+ * The engine object owns the simulated audio thread, it starts on Realize and stops on Destroy
+ */
+SLresult AudioHostBackend::createEngine(SLObjectItf *engineObject) noexcept
+{
+    Device *device = new Device();
+    device->config = _config;
+    device->counters = _counters;
+    device->random = _config.seed != 0 ? _config.seed : 1;
+    initObject(device->engine, device, KIND_ENGINE, ITF_ENGINE);
+    *engineObject = &device->engine.object.vtable;
+    return SL_RESULT_SUCCESS;
+}
+
+AAssetManager *AudioHostBackend::getAssetManager() const noexcept
+{
+    return _assetManager;
+}
+
+const char *AudioHostBackend::getName() const noexcept
+{
+    return "host";
+}
+
+AudioHostBackend::Stats AudioHostBackend::getStats() const noexcept
+{
+    Stats stats;
+    stats.created = _counters->created.load(std::memory_order_relaxed);
+    stats.destroyed = _counters->destroyed.load(std::memory_order_relaxed);
+    stats.failed = _counters->failed.load(std::memory_order_relaxed);
+    stats.callbacks = _counters->callbacks.load(std::memory_order_relaxed);
+    stats.tracks = (uint64_t) std::max(0, _counters->tracks.load(std::memory_order_relaxed));
+    return stats;
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef __AudioHostBackend__
+#define __AudioHostBackend__
+
+#include "AudioBackend.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace audio
+{
+    /**
+     * Fake OpenSL ES for Linux hosts: the whole engine, its command, GC and stream threads run natively without any device
+     * A simulated audio thread ticks every tickMs: the players consume their buffer queues in real time, move their play head,
+     * prefetch, decode and fire the OpenSL callbacks, with the failures and latencies of the Config
+     * The assets are read from a directory, WAV files decode to their PCM and anything else to silence of a plausible duration
+     * Note: Only the OpenSL methods called by the engine are implemented, and the file compiles to nothing on Android
+     *
+     * Host build from the repository root, the headers SLES/, android/ and jni.h come from the NDK sysroot:
+     *   g++ -std=c++14 -O2 -pthread -idirafter $NDK_SYSROOT/usr/include -D'__INTRODUCED_IN(api)=' $(find app/src/main/jni -name '*.cpp') main.cpp -o host
+     * main.cpp passes an AudioHostBackend to AudioEngine::setBackend() before the first sound
+     */
+    class AudioHostBackend : public AudioBackend
+    {
+    public:
+        struct Config
+        {
+            std::string assetsPath; // directory holding the assets
+            int tickMs = 5; // period of the simulated audio thread
+            int maxTracks = 32; // output players realized at the same time, AudioFlinger denies the next ones
+            uint32_t sampleRate = 48000; // native output rate, a fast track needs its buffer queue at this rate
+            int createLatencyUs = 0; // spent in CreateAudioPlayer
+            int realizeLatencyUs = 0; // spent in Realize
+            int prefetchLatencyMs = 20; // before a fd player gets SL_PREFETCHSTATUS_SUFFICIENTDATA
+            int startLatencyMs = 0; // from SL_PLAYSTATE_PLAYING to the head moving
+            double createFailureRate = 0.; // probability of a CreateAudioPlayer failure
+            double realizeFailureRate = 0.; // probability of a Realize failure
+            uint32_t seed = 1; // of the failures
+            uint32_t compressedBitRate = 128000; // estimates the duration of the assets that aren't WAV
+        };
+
+        struct Stats
+        {
+            uint64_t created;
+            uint64_t destroyed;
+            uint64_t failed; // injected failures and denied tracks
+            uint64_t callbacks;
+            uint64_t tracks; // realized output players
+        };
+
+        struct Counters
+        {
+            std::atomic<uint64_t> created;
+            std::atomic<uint64_t> destroyed;
+            std::atomic<uint64_t> failed;
+            std::atomic<uint64_t> callbacks;
+            std::atomic<int> tracks;
+        };
+
+    public:
+        explicit AudioHostBackend(const Config &config);
+
+        ~AudioHostBackend() override;
+
+    public:
+        SLresult createEngine(SLObjectItf *engineObject) noexcept override;
+
+        AAssetManager *getAssetManager() const noexcept override;
+
+        const char *getName() const noexcept override;
+
+        Stats getStats() const noexcept;
+
+    private:
+        Config _config;
+        AAssetManager *_assetManager;
+        std::shared_ptr<Counters> _counters; // shared with the engine object, it can outlive the backend
+    };
+}
+
+#endif
@@ -0,0 +1,65 @@
+#include "AudioMetrics.h"
+
+using namespace audio;
+
+// Zero initialized as static storage, before any player exists
+std::atomic<uint64_t> AudioMetrics::_counters[COUNTER_COUNT];
+std::atomic<int64_t> AudioMetrics::_gauges[GAUGE_COUNT];
+AudioMetrics::TimerSlot AudioMetrics::_timers[TIMER_COUNT];
+
+void AudioMetrics::addMax(std::atomic<uint64_t> &max, const uint64_t ns) noexcept
+{
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (ns > current && !max.compare_exchange_weak(current, ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * Duration of a section without any lock, e.g. a GC sweep
+ */
+void AudioMetrics::time(const Timer timer, const int64_t ns) noexcept
+{
+#if AUDIO_METRICS
+    const uint64_t value = ns > 0 ? (uint64_t) ns : 0;
+    _timers[timer].count.fetch_add(1, std::memory_order_relaxed);
+    _timers[timer].totalNs.fetch_add(value, std::memory_order_relaxed);
+    addMax(_timers[timer].maxNs, value);
+#endif
+}
+
+/**
+ * Wait of a contended lock, an acquisition without wait is only counted
+ */
+void AudioMetrics::wait(const Timer timer, const int64_t ns) noexcept
+{
+    const uint64_t value = ns > 0 ? (uint64_t) ns : 0;
+    _timers[timer].count.fetch_add(1, std::memory_order_relaxed);
+    _timers[timer].waits.fetch_add(1, std::memory_order_relaxed);
+    _timers[timer].totalNs.fetch_add(value, std::memory_order_relaxed);
+    addMax(_timers[timer].maxNs, value);
+}
+
+/**
+ * Each value is read on its own: the counters updated meanwhile can be a few units apart
+ */
+AudioMetrics::Stats AudioMetrics::getStats() noexcept
+{
+    Stats stats;
+    for (size_t i = 0; i < COUNTER_COUNT; ++i)
+    {
+        stats.counters[i] = _counters[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < GAUGE_COUNT; ++i)
+    {
+        stats.gauges[i] = _gauges[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < TIMER_COUNT; ++i)
+    {
+        stats.timers[i].count = _timers[i].count.load(std::memory_order_relaxed);
+        stats.timers[i].waits = _timers[i].waits.load(std::memory_order_relaxed);
+        stats.timers[i].totalNs = _timers[i].totalNs.load(std::memory_order_relaxed);
+        stats.timers[i].maxNs = _timers[i].maxNs.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
@@ -0,0 +1,168 @@
+#ifndef __AudioMetrics__
+#define __AudioMetrics__
+
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+#include "AudioUtils.h"
+
+// Build with -DAUDIO_METRICS=0 to compile the collection out, getStats() then only reports the polled gauges
+#ifndef AUDIO_METRICS
+#define AUDIO_METRICS 1
+#endif
+
+namespace audio
+{
+    /**
+     * Process wide registry of the engine counters, gauges and timers
+     * Every update is a relaxed atomic operation: safe from the OpenSL callbacks and any thread, nothing allocates nor locks
+     */
+    class AudioMetrics
+    {
+    public:
+        enum Counter
+        {
+            COUNTER_PLAYERS_CREATED = 0,
+            COUNTER_PLAYERS_DESTROYED,
+            COUNTER_CREATE_FAILED, // sounds the engine couldn't create at all
+            COUNTER_FAILED_CREATE_PLAYER, // CreateAudioPlayer
+            COUNTER_FAILED_REALIZE,
+            COUNTER_FAILED_INTERFACE, // GetInterface and the interface setup
+            COUNTER_FAILED_CONFIGURE, // callbacks, loop, first enqueue
+            COUNTER_FAILED_PREFETCH, // prefetch timeout or error
+            COUNTER_STOLEN,
+            COUNTER_RECLAIMED,
+            COUNTER_COUNT
+        };
+
+        enum Gauge
+        {
+            GAUGE_LIVE_PLAYERS = 0, // AudioPlayer instances, the pooled ones included
+            GAUGE_OPEN_FDS, // polled from the AudioAssetCache by getStats()
+            GAUGE_CACHED_BYTES, // polled from the AudioSampleCache by getStats()
+            GAUGE_COUNT
+        };
+
+        enum Timer
+        {
+            TIMER_VOICES_LOCK = 0,
+            TIMER_GC_LOCK,
+            TIMER_COMMANDS_LOCK,
+            TIMER_BANKS_LOCK,
+            TIMER_OPENSL_LOCK,
+            TIMER_GC_SWEEP, // one pass of audioPlayerGc, it has no wait
+            TIMER_COUNT
+        };
+
+        struct TimerStats
+        {
+            uint64_t count;
+            uint64_t waits; // acquisitions that found the mutex locked, only those are timed
+            uint64_t totalNs;
+            uint64_t maxNs;
+        };
+
+        struct Stats
+        {
+            uint64_t counters[COUNTER_COUNT];
+            int64_t gauges[GAUGE_COUNT];
+            TimerStats timers[TIMER_COUNT];
+        };
+
+        /**
+         * std::lock_guard timing the wait on its mutex
+         */
+        class Lock
+        {
+        public:
+            Lock(std::mutex &mutex, const Timer timer) noexcept : _mutex(mutex)
+            {
+                lock(_mutex, timer);
+            }
+
+            Lock(const Lock &) = delete;
+
+            Lock &operator=(const Lock &) & = delete;
+
+            Lock(Lock &&) = delete;
+
+            Lock &operator=(Lock &&) & = delete;
+
+            ~Lock()
+            {
+                _mutex.unlock();
+            }
+
+        private:
+            std::mutex &_mutex;
+        };
+
+    public:
+        AudioMetrics() = delete;
+
+    public:
+        static void count(const Counter counter) noexcept
+        {
+#if AUDIO_METRICS
+            _counters[counter].fetch_add(1, std::memory_order_relaxed);
+#endif
+        }
+
+        static void add(const Gauge gauge, const int64_t delta) noexcept
+        {
+#if AUDIO_METRICS
+            _gauges[gauge].fetch_add(delta, std::memory_order_relaxed);
+#endif
+        }
+
+        static void set(const Gauge gauge, const int64_t value) noexcept
+        {
+            _gauges[gauge].store(value, std::memory_order_relaxed);
+        }
+
+        static void time(const Timer timer, const int64_t ns) noexcept;
+
+        /**
+         * Lock a std::mutex or a deferred std::unique_lock, the clock is only read when the lock is already taken
+         */
+        template<typename Lockable>
+        static void lock(Lockable &lockable, const Timer timer) noexcept
+        {
+#if AUDIO_METRICS
+            if (lockable.try_lock())
+            {
+                _timers[timer].count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            const int64_t start = nowNanos();
+            lockable.lock();
+            wait(timer, nowNanos() - start);
+#else
+            lockable.lock();
+#endif
+        }
+
+        static Stats getStats() noexcept;
+
+    private:
+        struct TimerSlot
+        {
+            std::atomic<uint64_t> count;
+            std::atomic<uint64_t> waits;
+            std::atomic<uint64_t> totalNs;
+            std::atomic<uint64_t> maxNs;
+        };
+
+        static void wait(const Timer timer, const int64_t ns) noexcept;
+
+        static void addMax(std::atomic<uint64_t> &max, const uint64_t ns) noexcept;
+
+    private:
+        static std::atomic<uint64_t> _counters[COUNTER_COUNT];
+        static std::atomic<int64_t> _gauges[GAUGE_COUNT];
+        static TimerSlot _timers[TIMER_COUNT];
+    };
+}
+
+#endif
@@ -0,0 +1,241 @@
+#include "AudioMixKernels.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define AUDIO_MIX_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#define AUDIO_MIX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace audio;
+
+namespace
+{
+    inline int16_t clamp16(const float value) noexcept
+    {
+        if (value >= 32767.f)
+        {
+            return 32767;
+        }
+        if (value <= -32768.f)
+        {
+            return -32768;
+        }
+        return (int16_t) value;
+    }
+
+    /**
+     * Frame index of a tap, -1 outside of a one-shot (silence)
+     */
+    inline long tapIndex(const long index, const size_t inFrames, const bool loop) noexcept
+    {
+        const long frames = (long) inFrames;
+        if (index >= 0 && index < frames)
+        {
+            return index;
+        }
+        if (!loop)
+        {
+            return -1;
+        }
+        const long wrapped = index % frames;
+        return wrapped < 0 ? wrapped + frames : wrapped;
+    }
+}
+
+/**
+ * Accumulate a mono source in both channels of out
+ */
+void AudioMixKernels::mixMono(float *out, const int16_t *in, const size_t frames, const float gainLeft, const float gainRight) noexcept
+{
+    size_t i = 0;
+#if defined(AUDIO_MIX_NEON)
+    const float32x4_t gains = {gainLeft, gainRight, gainLeft, gainRight};
+    for (; i + 4 <= frames; i += 4)
+    {
+        const float32x4_t mono = vcvtq_f32_s32(vmovl_s16(vld1_s16(in + i)));
+        const float32x4x2_t duplicated = vzipq_f32(mono, mono); // [a a b b] [c c d d]
+        float *dst = out + i * 2;
+        vst1q_f32(dst, vmlaq_f32(vld1q_f32(dst), duplicated.val[0], gains));
+        vst1q_f32(dst + 4, vmlaq_f32(vld1q_f32(dst + 4), duplicated.val[1], gains));
+    }
+#elif defined(AUDIO_MIX_SSE2)
+    const __m128 gains = _mm_setr_ps(gainLeft, gainRight, gainLeft, gainRight);
+    for (; i + 4 <= frames; i += 4)
+    {
+        const __m128i samples = _mm_loadl_epi64((const __m128i *) (in + i));
+        const __m128 mono = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16)); // sign extension
+        float *dst = out + i * 2;
+        _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_mul_ps(_mm_unpacklo_ps(mono, mono), gains)));
+        _mm_storeu_ps(dst + 4, _mm_add_ps(_mm_loadu_ps(dst + 4), _mm_mul_ps(_mm_unpackhi_ps(mono, mono), gains)));
+    }
+#endif
+    for (; i < frames; ++i)
+    {
+        out[i * 2] += in[i] * gainLeft;
+        out[i * 2 + 1] += in[i] * gainRight;
+    }
+}
+
+/**
+ * Accumulate an interleaved stereo source in out
+ */
+void AudioMixKernels::mixStereo(float *out, const int16_t *in, const size_t frames, const float gainLeft, const float gainRight) noexcept
+{
+    const size_t samples = frames * 2;
+    size_t i = 0;
+#if defined(AUDIO_MIX_NEON)
+    const float32x4_t gains = {gainLeft, gainRight, gainLeft, gainRight};
+    for (; i + 8 <= samples; i += 8)
+    {
+        const int16x8_t stereo = vld1q_s16(in + i);
+        const float32x4_t low = vcvtq_f32_s32(vmovl_s16(vget_low_s16(stereo)));
+        const float32x4_t high = vcvtq_f32_s32(vmovl_s16(vget_high_s16(stereo)));
+        vst1q_f32(out + i, vmlaq_f32(vld1q_f32(out + i), low, gains));
+        vst1q_f32(out + i + 4, vmlaq_f32(vld1q_f32(out + i + 4), high, gains));
+    }
+#elif defined(AUDIO_MIX_SSE2)
+    const __m128 gains = _mm_setr_ps(gainLeft, gainRight, gainLeft, gainRight);
+    for (; i + 8 <= samples; i += 8)
+    {
+        const __m128i stereo = _mm_loadu_si128((const __m128i *) (in + i));
+        const __m128 low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(stereo, stereo), 16));
+        const __m128 high = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(stereo, stereo), 16));
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(low, gains)));
+        _mm_storeu_ps(out + i + 4, _mm_add_ps(_mm_loadu_ps(out + i + 4), _mm_mul_ps(high, gains)));
+    }
+#endif
+    for (; i < samples; i += 2)
+    {
+        out[i] += in[i] * gainLeft;
+        out[i + 1] += in[i + 1] * gainRight;
+    }
+}
+
+/**
+ * Saturate the accumulator to int16, the values are truncated toward zero on every path
+ */
+void AudioMixKernels::toInt16(int16_t *out, const float *in, const size_t samples) noexcept
+{
+    size_t i = 0;
+#if defined(AUDIO_MIX_NEON)
+    const float32x4_t max = vdupq_n_f32(32767.f);
+    const float32x4_t min = vdupq_n_f32(-32768.f);
+    for (; i + 8 <= samples; i += 8)
+    {
+        const int32x4_t low = vcvtq_s32_f32(vmaxq_f32(vminq_f32(vld1q_f32(in + i), max), min));
+        const int32x4_t high = vcvtq_s32_f32(vmaxq_f32(vminq_f32(vld1q_f32(in + i + 4), max), min));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    }
+#elif defined(AUDIO_MIX_SSE2)
+    const __m128 max = _mm_set1_ps(32767.f);
+    const __m128 min = _mm_set1_ps(-32768.f);
+    for (; i + 8 <= samples; i += 8)
+    {
+        // Clamp first: the conversion of an out of range float gives INT_MIN
+        const __m128i low = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i), max), min));
+        const __m128i high = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i + 4), max), min));
+        _mm_storeu_si128((__m128i *) (out + i), _mm_packs_epi32(low, high));
+    }
+#endif
+    for (; i < samples; ++i)
+    {
+        out[i] = clamp16(in[i]);
+    }
+}
+
+/**
+ * Catmull-Rom interpolation of 4 lanes between x0 and x1, t in [0, 1)
+ */
+void AudioMixKernels::cubic4(const float *xm1, const float *x0, const float *x1, const float *x2, const float *t, float *y) noexcept
+{
+#if defined(AUDIO_MIX_NEON)
+    const float32x4_t vm1 = vld1q_f32(xm1), v0 = vld1q_f32(x0), v1 = vld1q_f32(x1), v2 = vld1q_f32(x2), vt = vld1q_f32(t);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const float32x4_t c = vmulq_f32(vsubq_f32(v1, vm1), half);
+    const float32x4_t d = vsubq_f32(v0, v1);
+    const float32x4_t a = vmlaq_f32(vmulq_f32(vsubq_f32(v2, vm1), half), d, vdupq_n_f32(1.5f));
+    const float32x4_t b = vnegq_f32(vaddq_f32(vaddq_f32(d, c), a));
+    vst1q_f32(y, vmlaq_f32(v0, vmlaq_f32(c, vmlaq_f32(b, a, vt), vt), vt));
+#elif defined(AUDIO_MIX_SSE2)
+    const __m128 vm1 = _mm_loadu_ps(xm1), v0 = _mm_loadu_ps(x0), v1 = _mm_loadu_ps(x1), v2 = _mm_loadu_ps(x2), vt = _mm_loadu_ps(t);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 c = _mm_mul_ps(_mm_sub_ps(v1, vm1), half);
+    const __m128 d = _mm_sub_ps(v0, v1);
+    const __m128 a = _mm_add_ps(_mm_mul_ps(d, _mm_set1_ps(1.5f)), _mm_mul_ps(_mm_sub_ps(v2, vm1), half));
+    const __m128 b = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_add_ps(d, c), a));
+    _mm_storeu_ps(y, _mm_add_ps(v0, _mm_mul_ps(_mm_add_ps(c, _mm_mul_ps(_mm_add_ps(b, _mm_mul_ps(a, vt)), vt)), vt)));
+#else
+    for (size_t i = 0; i < 4; ++i)
+    {
+        const float c = (x1[i] - xm1[i]) * 0.5f;
+        const float d = x0[i] - x1[i];
+        const float a = d * 1.5f + (x2[i] - xm1[i]) * 0.5f;
+        const float b = -(d + c + a);
+        y[i] = x0[i] + ((a * t[i] + b) * t[i] + c) * t[i];
+    }
+#endif
+}
+
+/**
+ * Accumulate the source read at a variable rate with a cubic interpolation, return the new read position (in frames)
+ * The step (source frames per output frame) moves linearly from stepStart to stepEnd so pitch changes don't click
+ * A one-shot reads silence past its end, a loop wraps around
+ */
+double AudioMixKernels::mixResampled(float *out, const int16_t *in, const size_t channels, const size_t inFrames, const bool loop, double position,
+                                     const float stepStart, const float stepEnd, const size_t frames, const float gainLeft, const float gainRight) noexcept
+{
+    const double increment = frames > 0 ? ((double) stepEnd - stepStart) / frames : 0.;
+    double step = stepStart;
+    float taps[4][4];
+    float t[4];
+    float y[2][4];
+    for (size_t i = 0; i < frames; i += 4)
+    {
+        const size_t lanes = frames - i < 4 ? frames - i : 4;
+        for (size_t channel = 0; channel < channels; ++channel)
+        {
+            double lanePosition = position;
+            double laneStep = step;
+            for (size_t lane = 0; lane < 4; ++lane)
+            {
+                const double base = lanePosition < 0. ? 0. : lanePosition;
+                const long index = (long) base;
+                t[lane] = (float) (base - index);
+                for (long k = 0; k < 4; ++k)
+                {
+                    const long tap = tapIndex(index + k - 1, inFrames, loop);
+                    taps[k][lane] = tap < 0 || lane >= lanes ? 0.f : in[tap * channels + channel];
+                }
+                lanePosition += laneStep;
+                laneStep += increment;
+            }
+            cubic4(taps[0], taps[1], taps[2], taps[3], t, y[channel]);
+        }
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            float *dst = out + (i + lane) * 2;
+            dst[0] += y[0][lane] * gainLeft;
+            dst[1] += y[channels - 1][lane] * gainRight;
+            position += step;
+            step += increment;
+        }
+        if (loop && position >= (double) inFrames)
+        {
+            position -= (double) inFrames * (long) (position / inFrames);
+        }
+    }
+    return position;
+}
+
+const char *AudioMixKernels::getName() noexcept
+{
+#if defined(AUDIO_MIX_NEON)
+    return "neon";
+#elif defined(AUDIO_MIX_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,35 @@
+#ifndef __AudioMixKernels__
+#define __AudioMixKernels__
+
+#include <cstdint>
+#include <cstddef>
+
+namespace audio
+{
+    /**
+     * Mixing kernels of the AudioMixer: NEON on ARM, SSE2 on x86 and a scalar fallback
+     * The accumulator is interleaved stereo float in the int16 range
+     */
+    class AudioMixKernels
+    {
+    public:
+        AudioMixKernels() = delete;
+
+    private:
+        static void cubic4(const float *xm1, const float *x0, const float *x1, const float *x2, const float *t, float *y) noexcept;
+
+    public:
+        static void mixMono(float *out, const int16_t *in, const size_t frames, const float gainLeft, const float gainRight) noexcept;
+
+        static void mixStereo(float *out, const int16_t *in, const size_t frames, const float gainLeft, const float gainRight) noexcept;
+
+        static void toInt16(int16_t *out, const float *in, const size_t samples) noexcept;
+
+        static double mixResampled(float *out, const int16_t *in, const size_t channels, const size_t inFrames, const bool loop, double position,
+                                   const float stepStart, const float stepEnd, const size_t frames, const float gainLeft, const float gainRight) noexcept;
+
+        static const char *getName() noexcept;
+    };
+}
+
+#endif
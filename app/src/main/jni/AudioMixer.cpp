@@ -0,0 +1,379 @@
+#include "AudioMixer.h"
+#include "AudioMixKernels.h"
+#include "AudioEngine.h"
+#include "AudioFastPath.h"
+#include "AudioMetrics.h"
+#include "AudioTrace.h"
+#include "AudioUtils.h"
+#include <thread>
+#include <algorithm>
+
+using namespace audio;
+
+AudioMixer::AudioMixer() : _playerObject(nullptr)
+, _playerPlay(nullptr)
+, _bufferQueue(nullptr)
+, _sampleRate(DEFAULT_SAMPLE_RATE)
+, _bufferFrames(DEFAULT_BUFFER_FRAMES)
+, _queueNs(0)
+, _isFastPath(false)
+, _next(0)
+, _renderSequence(0)
+, _renders(0)
+, _playing(0)
+, _renderTotal(0)
+, _renderMax(0)
+{
+    for (Voice &voice : _voices)
+    {
+        voice.state = VOICE_FREE;
+        voice.gainLeft = 0.f;
+        voice.gainRight = 0.f;
+        voice.pitch = 1.f;
+        voice.loop = false;
+        voice.playRequestedAt = 0;
+        voice.position = 0.;
+        voice.step = 1.f;
+        voice.audioId = -1;
+    }
+}
+
+AudioMixer::~AudioMixer()
+{
+    destroyObjects();
+}
+
+/**
+ * Destroy the output player, Destroy waits for the callback in progress
+ */
+void AudioMixer::destroyObjects() noexcept
+{
+    if (_playerObject != nullptr)
+    {
+        (*_playerObject)->Destroy(_playerObject);
+        _playerObject = nullptr;
+    }
+    _playerPlay = nullptr;
+    _bufferQueue = nullptr;
+}
+
+/**
+ * Create the stereo 16 bits output player and start it with silence
+ * At the output rate with buffers of whole bursts it asks for a fast track
+ */
+bool AudioMixer::init(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, const SLuint32 sampleRate, const size_t bufferFrames) noexcept
+{
+    if (engineEngine == nullptr || outputMixObject == nullptr || _playerObject != nullptr || sampleRate == 0 || bufferFrames == 0)
+    {
+        return false;
+    }
+    _sampleRate = sampleRate;
+    _bufferFrames = bufferFrames;
+    _queueNs = (int64_t) ((uint64_t) (BUFFER_COUNT - 1) * bufferFrames * 1000000000ULL / sampleRate);
+    _buffers.assign(BUFFER_COUNT * bufferFrames * 2, 0);
+    _accumulator.assign(bufferFrames * 2, 0.f);
+
+    SLDataLocator_AndroidSimpleBufferQueue loc_bq = {SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, (SLuint32) BUFFER_COUNT};
+    SLDataFormat_PCM format_pcm = {SL_DATAFORMAT_PCM, 2, sampleRate * 1000, SL_PCMSAMPLEFORMAT_FIXED_16, SL_PCMSAMPLEFORMAT_FIXED_16,
+                                   SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT, SL_BYTEORDER_LITTLEENDIAN};
+    SLDataSource audioSrc = {&loc_bq, &format_pcm};
+
+    SLDataLocator_OutputMix loc_outmix = {SL_DATALOCATOR_OUTPUTMIX, outputMixObject};
+    SLDataSink audioSnk = {&loc_outmix, NULL};
+
+    const size_t framesPerBurst = AudioEngine::getInstance()->getFramesPerBurst();
+    const bool fastPath = AudioFastPath::isEligible(sampleRate, AudioEngine::getInstance()->getOutputSampleRate())
+                          && AudioFastPath::alignToBurst(bufferFrames, framesPerBurst) == bufferFrames;
+    const SLInterfaceID ids[2] = {SL_IID_ANDROIDSIMPLEBUFFERQUEUE, SL_IID_ANDROIDCONFIGURATION};
+    const SLboolean req[2] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_FALSE};
+    SLresult result = (*engineEngine)->CreateAudioPlayer(engineEngine, &_playerObject, &audioSrc, &audioSnk, 2, ids, req);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("CreateAudioPlayer _playerObject fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_CREATE_PLAYER);
+        _playerObject = nullptr;
+        return false;
+    }
+    if (fastPath)
+    {
+        AudioFastPath::request(_playerObject);
+    }
+    result = (*_playerObject)->Realize(_playerObject, SL_BOOLEAN_FALSE);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("Realize _playerObject fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_REALIZE);
+        destroyObjects();
+        return false;
+    }
+    _isFastPath = AudioFastPath::isObtained(_playerObject, fastPath);
+    if (SL_RESULT_SUCCESS != (*_playerObject)->GetInterface(_playerObject, SL_IID_PLAY, &_playerPlay)
+        || SL_RESULT_SUCCESS != (*_playerObject)->GetInterface(_playerObject, SL_IID_ANDROIDSIMPLEBUFFERQUEUE, &_bufferQueue))
+    {
+        LOGEX("GetInterface _playerObject fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_INTERFACE);
+        destroyObjects();
+        return false;
+    }
+    result = (*_bufferQueue)->RegisterCallback(_bufferQueue, AudioMixer::bufferQueueCallback, this);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("RegisterCallback _bufferQueue fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_CONFIGURE);
+        destroyObjects();
+        return false;
+    }
+    for (size_t i = 0; i < BUFFER_COUNT && SL_RESULT_SUCCESS == result; ++i)
+    {
+        result = (*_bufferQueue)->Enqueue(_bufferQueue, &_buffers[i * _bufferFrames * 2], (SLuint32) (_bufferFrames * 2 * sizeof(int16_t)));
+    }
+    if (SL_RESULT_SUCCESS == result)
+    {
+        result = (*_playerPlay)->SetPlayState(_playerPlay, SL_PLAYSTATE_PLAYING);
+    }
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("Enqueue _bufferQueue fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_CONFIGURE);
+        destroyObjects();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Any mono or stereo sample can be mixed, its rate is converted while mixing
+ */
+bool AudioMixer::accepts(const AudioSample &sample) const noexcept
+{
+    return _playerObject != nullptr && sample.sampleRate > 0 && (sample.channels == 1 || sample.channels == 2) && sample.getFrames() > 0;
+}
+
+/**
+ * Claim a free voice for the sample, return its index or -1 if all the voices are busy
+ * The voice stays silent until play()
+ */
+int AudioMixer::addVoice(const int audioId, const std::shared_ptr<AudioSample> &sample, const float volume, const float pan, const bool loop) noexcept
+{
+    if (sample == nullptr || !accepts(*sample))
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < MAX_VOICES; ++i)
+    {
+        Voice &voice = _voices[i];
+        int expected = VOICE_FREE;
+        if (voice.state.compare_exchange_strong(expected, VOICE_IDLE))
+        {
+            voice.sample = sample;
+            voice.position = 0.;
+            voice.pitch = 1.f;
+            voice.step = (float) sample->sampleRate / _sampleRate;
+            voice.audioId = audioId;
+            voice.loop = loop;
+            voice.playRequestedAt = 0;
+            setGain((int) i, volume, pan);
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * requestedAt is the time of the play request of the caller, 0 on resume: the first render of the voice measures the latency
+ */
+bool AudioMixer::play(const int voice, const int64_t requestedAt) noexcept
+{
+    if (requestedAt != 0)
+    {
+        _voices[voice].playRequestedAt = requestedAt; // Before the state: the render sees it with the voice playing
+    }
+    int expected = VOICE_IDLE;
+    if (_voices[voice].state.compare_exchange_strong(expected, VOICE_PLAYING))
+    {
+        return true;
+    }
+    expected = VOICE_PAUSED;
+    return _voices[voice].state.compare_exchange_strong(expected, VOICE_PLAYING) || expected == VOICE_PLAYING;
+}
+
+bool AudioMixer::pause(const int voice) noexcept
+{
+    int expected = VOICE_PLAYING;
+    return _voices[voice].state.compare_exchange_strong(expected, VOICE_PAUSED) || expected == VOICE_PAUSED;
+}
+
+/**
+ * Silence the voice, it keeps its sample until releaseVoice()
+ */
+bool AudioMixer::stop(const int voice) noexcept
+{
+    _voices[voice].loop = false;
+    return _voices[voice].state.exchange(VOICE_ENDED) != VOICE_FREE;
+}
+
+/**
+ * Volume (0 -> 1) and balance (-1 left -> 1 right) like the stereo position of an OpenSL player
+ */
+void AudioMixer::setGain(const int voice, const float volume, const float pan) noexcept
+{
+    const float gain = volume < 0.f ? 0.f : (volume > 1.f ? 1.f : volume);
+    const float balance = pan < -1.f ? -1.f : (pan > 1.f ? 1.f : pan);
+    _voices[voice].gainLeft = gain * (balance > 0.f ? 1.f - balance : 1.f);
+    _voices[voice].gainRight = gain * (balance < 0.f ? 1.f + balance : 1.f);
+}
+
+/**
+ * Playback rate of the voice (1 = original pitch), the callback ramps to it over one buffer
+ */
+void AudioMixer::setPitch(const int voice, const float pitch) noexcept
+{
+    _voices[voice].pitch = pitch < MIN_PITCH ? MIN_PITCH : (pitch > MAX_PITCH ? MAX_PITCH : pitch);
+}
+
+/**
+ * Give the voice back, waits for the render reading it to complete so the sample can be released
+ */
+void AudioMixer::releaseVoice(const int voice) noexcept
+{
+    _voices[voice].state = VOICE_ENDED;
+    const uint64_t sequence = _renderSequence.load();
+    if ((sequence & 1) != 0)
+    {
+        while (_renderSequence.load() == sequence)
+        {
+            std::this_thread::yield();
+        }
+    }
+    _voices[voice].sample.reset();
+    _voices[voice].audioId = -1;
+    _voices[voice].state = VOICE_FREE;
+}
+
+SLuint32 AudioMixer::getSampleRate() const noexcept
+{
+    return _sampleRate;
+}
+
+/**
+ * Whether the output player got a fast track, all the mixed voices share it
+ */
+bool AudioMixer::isFastPath() const noexcept
+{
+    return _isFastPath;
+}
+
+AudioMixer::Stats AudioMixer::getStats() const noexcept
+{
+    Stats stats;
+    stats.renders = _renders.load(std::memory_order_relaxed);
+    stats.voices = _playing.load(std::memory_order_relaxed);
+    stats.totalRenderNs = _renderTotal.load(std::memory_order_relaxed);
+    stats.maxRenderNs = _renderMax.load(std::memory_order_relaxed);
+    return stats;
+}
+
+/**
+ * Mix all the playing voices in buffer, called from the OpenSL callback
+ */
+void AudioMixer::render(int16_t *buffer) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioMixer::render");
+    const int64_t start = nowNanos();
+    int ended[MAX_VOICES];
+    size_t endedCount = 0;
+    uint64_t playing = 0;
+
+    _renderSequence.fetch_add(1); // odd: releaseVoice() waits
+    std::fill(_accumulator.begin(), _accumulator.end(), 0.f);
+    for (Voice &voice : _voices)
+    {
+        if (voice.state.load() != VOICE_PLAYING)
+        {
+            continue;
+        }
+        ++playing;
+        if (voice.playRequestedAt.load(std::memory_order_relaxed) != 0)
+        {
+            const int64_t requestedAt = voice.playRequestedAt.exchange(0);
+            if (requestedAt != 0)
+            {
+                AudioEngine::getInstance()->recordLatency(AudioEngine::LATENCY_SOUND, start + _queueNs - requestedAt);
+            }
+        }
+        const AudioSample &sample = *voice.sample;
+        const size_t frames = sample.getFrames();
+        const float gainLeft = voice.gainLeft.load(std::memory_order_relaxed);
+        const float gainRight = voice.gainRight.load(std::memory_order_relaxed);
+        const bool loop = voice.loop.load(std::memory_order_relaxed);
+        const float step = voice.pitch.load(std::memory_order_relaxed) * sample.sampleRate / _sampleRate;
+        bool end = false;
+        size_t cursor = (size_t) voice.position;
+        if (step == 1.f && voice.step == 1.f && voice.position == (double) cursor) // Same rate and no pitch: plain copy
+        {
+            size_t offset = 0;
+            while (offset < _bufferFrames && !end)
+            {
+                const size_t count = std::min(_bufferFrames - offset, frames - cursor);
+                const int16_t *in = sample.getData() + cursor * sample.channels;
+                if (sample.channels == 1)
+                {
+                    AudioMixKernels::mixMono(&_accumulator[offset * 2], in, count, gainLeft, gainRight);
+                }
+                else
+                {
+                    AudioMixKernels::mixStereo(&_accumulator[offset * 2], in, count, gainLeft, gainRight);
+                }
+                offset += count;
+                cursor += count;
+                if (cursor >= frames)
+                {
+                    end = !loop;
+                    cursor = 0;
+                }
+            }
+            voice.position = (double) cursor;
+        }
+        else
+        {
+            voice.position = AudioMixKernels::mixResampled(_accumulator.data(), sample.getData(), sample.channels, frames, loop, voice.position,
+                                                            voice.step, step, _bufferFrames, gainLeft, gainRight);
+            voice.step = step;
+            end = !loop && voice.position >= (double) frames;
+        }
+        if (end)
+        {
+            int expected = VOICE_PLAYING;
+            if (voice.state.compare_exchange_strong(expected, VOICE_ENDED))
+            {
+                ended[endedCount++] = voice.audioId;
+            }
+        }
+    }
+    AudioMixKernels::toInt16(buffer, _accumulator.data(), _bufferFrames * 2);
+    _renderSequence.fetch_add(1);
+
+    AudioEngine *engine = AudioEngine::getInstance();
+    for (size_t i = 0; i < endedCount; ++i) // Same path as the HEADATEND of a player
+    {
+        engine->setHeadAtEnd(ended[i]);
+    }
+
+    const uint64_t duration = (uint64_t) (nowNanos() - start);
+    _renders.fetch_add(1, std::memory_order_relaxed);
+    _playing.store(playing, std::memory_order_relaxed);
+    _renderTotal.fetch_add(duration, std::memory_order_relaxed);
+    if (duration > _renderMax.load(std::memory_order_relaxed))
+    {
+        _renderMax.store(duration, std::memory_order_relaxed); // Only the callback writes it
+    }
+}
+
+void AudioMixer::bufferQueueCallback(SLAndroidSimpleBufferQueueItf caller, void *context) noexcept
+{
+    AudioMixer *mixer = static_cast<AudioMixer *>(context);
+    int16_t *buffer = &mixer->_buffers[mixer->_next * mixer->_bufferFrames * 2];
+    mixer->_next = (mixer->_next + 1) % BUFFER_COUNT;
+    mixer->render(buffer);
+    (*caller)->Enqueue(caller, buffer, (SLuint32) (mixer->_bufferFrames * 2 * sizeof(int16_t)));
+}
@@ -0,0 +1,132 @@
+#ifndef __AudioMixer__
+#define __AudioMixer__
+
+#include <SLES/OpenSLES.h>
+#include <SLES/OpenSLES_Android.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "AudioSample.h"
+
+namespace audio
+{
+    /**
+     * Software mixer: a single OpenSL buffer queue player fed with the sum of up to MAX_VOICES decoded samples
+     * Samples at another rate or with a pitch are resampled with a cubic interpolation
+     * The callback doesn't lock nor allocate, the voices are fixed slots driven through atomics
+     */
+    class AudioMixer
+    {
+    public:
+        static constexpr size_t MAX_VOICES = 64;
+        static constexpr SLuint32 DEFAULT_SAMPLE_RATE = 44100;
+        static constexpr size_t DEFAULT_BUFFER_FRAMES = 512;
+        static constexpr size_t BUFFER_COUNT = 2;
+        static constexpr float MIN_PITCH = 0.5f;
+        static constexpr float MAX_PITCH = 2.f;
+
+        struct Stats
+        {
+            uint64_t renders;
+            uint64_t voices; // playing right now
+            uint64_t totalRenderNs;
+            uint64_t maxRenderNs;
+        };
+
+    private:
+        enum VoiceState
+        {
+            VOICE_FREE = 0,
+            VOICE_IDLE,
+            VOICE_PLAYING,
+            VOICE_PAUSED,
+            VOICE_ENDED
+        };
+
+        struct Voice
+        {
+            std::atomic<int> state;
+            std::atomic<float> gainLeft;
+            std::atomic<float> gainRight;
+            std::atomic<float> pitch;
+            std::atomic<bool> loop;
+            std::atomic<int64_t> playRequestedAt; // play request waiting for its first render, 0 if none
+            std::shared_ptr<AudioSample> sample; // written only while the voice is not mixed
+            double position; // in source frames, owned by the callback while playing
+            float step; // source frames read per output frame during the last render
+            int audioId;
+        };
+
+    public:
+        AudioMixer();
+
+        AudioMixer(const AudioMixer &) = delete;
+
+        AudioMixer &operator=(const AudioMixer &) & = delete;
+
+        AudioMixer(AudioMixer &&) = delete;
+
+        AudioMixer &operator=(AudioMixer &&) & = delete;
+
+        ~AudioMixer();
+
+    public:
+        bool init(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, const SLuint32 sampleRate, const size_t bufferFrames) noexcept;
+
+        bool accepts(const AudioSample &sample) const noexcept;
+
+        int addVoice(const int audioId, const std::shared_ptr<AudioSample> &sample, const float volume, const float pan, const bool loop) noexcept;
+
+        bool play(const int voice, const int64_t requestedAt) noexcept;
+
+        bool pause(const int voice) noexcept;
+
+        bool stop(const int voice) noexcept;
+
+        void setGain(const int voice, const float volume, const float pan) noexcept;
+
+        void setPitch(const int voice, const float pitch) noexcept;
+
+        void releaseVoice(const int voice) noexcept;
+
+        SLuint32 getSampleRate() const noexcept;
+
+        bool isFastPath() const noexcept;
+
+        Stats getStats() const noexcept;
+
+    private:
+        void render(int16_t *buffer) noexcept;
+
+        void destroyObjects() noexcept;
+
+        static void bufferQueueCallback(SLAndroidSimpleBufferQueueItf caller, void *context) noexcept;
+
+    private:
+        SLObjectItf _playerObject;
+        SLPlayItf _playerPlay;
+        SLAndroidSimpleBufferQueueItf _bufferQueue;
+
+        SLuint32 _sampleRate;
+        size_t _bufferFrames;
+        int64_t _queueNs; // from the render of a buffer to its playback, the buffers queued before it
+        std::atomic<bool> _isFastPath;
+        std::vector<int16_t> _buffers; // BUFFER_COUNT stereo buffers enqueued in turn
+        size_t _next;
+        std::vector<float> _accumulator;
+
+        Voice _voices[MAX_VOICES];
+
+        // Incremented before and after each render: odd while the callback reads the voices
+        std::atomic<uint64_t> _renderSequence;
+
+        std::atomic<uint64_t> _renders;
+        std::atomic<uint64_t> _playing;
+        std::atomic<uint64_t> _renderTotal;
+        std::atomic<uint64_t> _renderMax;
+    };
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifdef __ANDROID__
+
+#include "AudioOpenSLBackend.h"
+#include "AudioEngine.h"
+#include "AudioUtils.h"
+#include <android/asset_manager_jni.h>
+
+using namespace audio;
+
+AudioOpenSLBackend::AudioOpenSLBackend() : _assetManager(nullptr)
+{
+}
+
+AudioOpenSLBackend::~AudioOpenSLBackend()
+{
+    JNIEnv *jenv = getJNIEnv(); // Delete the GlobalRef on AssetManager to be GC
+    if (jenv != nullptr && _assetManager != nullptr)
+    {
+        jenv->DeleteGlobalRef(_assetManager);
+        _assetManager = nullptr;
+    }
+}
+
+SLresult AudioOpenSLBackend::createEngine(SLObjectItf *engineObject) noexcept
+{
+    SLEngineOption EngineOption[] = { (SLuint32) SL_ENGINEOPTION_THREADSAFE, (SLuint32) SL_BOOLEAN_TRUE };
+    return slCreateEngine(engineObject, 1, EngineOption, 0, NULL, NULL);
+}
+
+/**
+ * Return the AAssetMaanger from the jobect stored as GlobalRef
+ */
+AAssetManager *AudioOpenSLBackend::getAssetManager() const noexcept
+{
+    JNIEnv *jenv = getJNIEnv();
+    AAssetManager *ret = nullptr;
+    if (_assetManager != nullptr && jenv != nullptr)
+    {
+        ret = AAssetManager_fromJava(jenv, _assetManager);
+    }
+    return ret;
+}
+
+/**
+ * Store AssetManager jobject as GlobalRef
+ */
+void AudioOpenSLBackend::setAssetManager(const jobject assetManager) noexcept
+{
+    JNIEnv *jenv = getJNIEnv();
+    if (jenv != nullptr) {
+        if (_assetManager != nullptr) // Just a security to make sure that we don't create too many GlobalRef
+        {
+            jenv->DeleteGlobalRef(_assetManager);
+            _assetManager = nullptr;
+        }
+        if (assetManager != nullptr)
+        {
+            _assetManager = jenv->NewGlobalRef(assetManager);
+        }
+    }
+}
+
+const char *AudioOpenSLBackend::getName() const noexcept
+{
+    return "opensl";
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef __AudioOpenSLBackend__
+#define __AudioOpenSLBackend__
+
+#include "AudioBackend.h"
+
+namespace audio
+{
+    /**
+     * The OpenSL ES of the device, the assets are read from the APK through the Java AssetManager
+     */
+    class AudioOpenSLBackend : public AudioBackend
+    {
+    public:
+        AudioOpenSLBackend();
+
+        ~AudioOpenSLBackend() override;
+
+    public:
+        SLresult createEngine(SLObjectItf *engineObject) noexcept override;
+
+        AAssetManager *getAssetManager() const noexcept override;
+
+        void setAssetManager(const jobject assetManager) noexcept override;
+
+        const char *getName() const noexcept override;
+
+    private:
+        jobject _assetManager; // GlobalRef
+    };
+}
+
+#endif
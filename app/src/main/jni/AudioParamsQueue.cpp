@@ -0,0 +1,78 @@
+#include "AudioParamsQueue.h"
+
+using namespace audio;
+
+AudioParamsQueue::AudioParamsQueue() : _tail(0)
+, _size(0)
+, _head(0)
+{
+    for (uint32_t i = 0; i < CAPACITY; ++i)
+    {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+AudioParamsQueue::~AudioParamsQueue()
+{
+}
+
+/**
+ * Enqueue the audioId of a voice written since the last tick, return false if the queue is full
+ * wasEmpty is true if the queue had nothing pending before this push
+ */
+bool AudioParamsQueue::push(const int audioId, bool &wasEmpty) noexcept
+{
+    wasEmpty = _size.fetch_add(1) == 0; // seq_cst: pairs with the fence of the command thread before it sleeps
+    uint32_t position = _tail.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell &cell = _cells[position & (CAPACITY - 1)];
+        const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const int32_t diff = (int32_t) (sequence - position);
+        if (diff == 0)
+        {
+            if (_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                cell.audioId = audioId;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) // The command thread didn't free this cell yet
+        {
+            _size.fetch_sub(1);
+            wasEmpty = false;
+            return false;
+        }
+        else
+        {
+            position = _tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Dequeue the oldest audioId, must only be called by the command thread
+ */
+bool AudioParamsQueue::pop(int &audioId) noexcept
+{
+    Cell &cell = _cells[_head & (CAPACITY - 1)];
+    const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != _head + 1)
+    {
+        return false;
+    }
+    audioId = cell.audioId;
+    cell.sequence.store(_head + CAPACITY, std::memory_order_release);
+    ++_head;
+    _size.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * False as soon as a push has started, its audioId may not be readable by pop() yet
+ */
+bool AudioParamsQueue::empty() const noexcept
+{
+    return _size.load() == 0;
+}
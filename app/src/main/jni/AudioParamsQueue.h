@@ -0,0 +1,56 @@
+#ifndef __AudioParamsQueue__
+#define __AudioParamsQueue__
+
+#include <atomic>
+#include <cstdint>
+#include "AudioHandleTable.h"
+
+namespace audio
+{
+    /**
+     * Bounded lock-free multi-producer single-consumer queue of the audioIds waiting for the engine params tick
+     * Producers are the threads writing a volume, pan or pitch, the consumer is the command thread
+     * push() never allocates nor locks: a fade written on every frame of a game thread stays wait-free on its side
+     * It tells the producer that made the queue non-empty, the only one that has to wake the command thread up
+     */
+    class AudioParamsQueue
+    {
+    public:
+        static constexpr uint32_t CAPACITY = 2 * AudioHandleTable::CAPACITY; // A live voice is queued once, the stale ones until the next tick
+
+    private:
+        struct Cell
+        {
+            std::atomic<uint32_t> sequence;
+            int audioId;
+        };
+
+    public:
+        AudioParamsQueue();
+
+        AudioParamsQueue(const AudioParamsQueue &) = delete;
+
+        AudioParamsQueue &operator=(const AudioParamsQueue &) & = delete;
+
+        AudioParamsQueue(AudioParamsQueue &&) = delete;
+
+        AudioParamsQueue &operator=(AudioParamsQueue &&) & = delete;
+
+        ~AudioParamsQueue();
+
+    public:
+        bool push(const int audioId, bool &wasEmpty) noexcept;
+
+        bool pop(int &audioId) noexcept;
+
+        bool empty() const noexcept;
+
+    private:
+        Cell _cells[CAPACITY];
+        std::atomic<uint32_t> _tail; // next position written by the producers
+        std::atomic<uint32_t> _size; // counted before the cell is written, a push in progress keeps the queue non-empty
+        uint32_t _head; // next position read by the command thread
+    };
+}
+
+#endif
@@ -1,131 +1,358 @@
 #include "AudioPlayer.h"
-#include <unistd.h>
 #include "AudioUtils.h"
 #include <complex>
+#include <thread>
 #include "AudioEngine.h"
+#include "AudioFastPath.h"
+#include "AudioGain.h"
+#include "AudioMetrics.h"
+#include "AudioTrace.h"
 
 using namespace audio;
 
+namespace
+{
+    inline float clampPitch(const float pitch) noexcept
+    {
+        return pitch < AudioMixer::MIN_PITCH ? AudioMixer::MIN_PITCH : (pitch > AudioMixer::MAX_PITCH ? AudioMixer::MAX_PITCH : pitch);
+    }
+
+    // The other failures come from the platform: out of players, memory or resources
+    inline bool isSourceError(const SLresult result) noexcept
+    {
+        return result == SL_RESULT_CONTENT_CORRUPTED || result == SL_RESULT_CONTENT_UNSUPPORTED || result == SL_RESULT_CONTENT_NOT_FOUND;
+    }
+}
+
 AudioPlayer::AudioPlayer() : _fdPlayerObject(nullptr)
 , _fdPlayerPlay(nullptr)
 , _fdPlayerSeek(nullptr)
 , _fdPlayerVolume(nullptr)
 ,  _fdPlayerPrefetchedStatus(nullptr)
+, _bufferQueue(nullptr)
+, _fdPlayerPlaybackRate(nullptr)
+, _queueOffset(0)
+, _mixer(nullptr)
+, _mixerVoice(-1)
 , _isHeadAtEnd(false)
 , _isPrefetchedSufficientData(false)
+, _isRetired(false)
+, _isVirtual(false)
+, _isFastPath(false)
+, _isUnplayable(false)
+, _promoteAt(0)
+, _state(STATE_IDLE)
 , _loop(false)
 , _audioId(-1)
-, _assetFd(-1)
+, _priority(0)
+, _createdAt(0)
 , _volume(1.f)
-, _javaAudioPlayerObj(nullptr)
+, _pan(0.f)
+, _pitch(1.f)
+, _bus(0)
+, _busGain(1.f)
+, _paramsDirty(false)
+, _outputGain(1.f)
+, _outputPan(0.f)
+, _outputPitch(1.f)
+, _outputLevel(SL_MILLIBEL_MAX)
+, _isStereoPosition(false)
+, _position(0)
+, _playingSince(0)
+, _duration(SL_TIME_UNKNOWN)
+, _playRequestedAt(0)
+, _soundRequestedAt(0)
+, _soundStartPosition(0)
 {
+    AudioMetrics::count(AudioMetrics::COUNTER_PLAYERS_CREATED);
+    AudioMetrics::add(AudioMetrics::GAUGE_LIVE_PLAYERS, 1);
 }
 
 AudioPlayer::~AudioPlayer()
+{
+    destroyObjects();
+
+    _isPrefetchedSufficientData = false;
+    _isHeadAtEnd = false;
+
+    _loop = false;
+    _audioId = -1;
+
+    AudioMetrics::count(AudioMetrics::COUNTER_PLAYERS_DESTROYED);
+    AudioMetrics::add(AudioMetrics::GAUGE_LIVE_PLAYERS, -1);
+}
+
+/**
+ * Destroy the OpenSL player and release the asset, the voice itself stays valid
+ */
+void AudioPlayer::destroyObjects() noexcept
 {
     if (_fdPlayerObject != nullptr)
     {
         (*_fdPlayerObject)->Destroy(_fdPlayerObject);
-        _fdPlayerPlay = nullptr;
-        _fdPlayerSeek = nullptr;
-        _fdPlayerVolume = nullptr;
-        _fdPlayerPrefetchedStatus = nullptr;
+        _fdPlayerObject = nullptr;
     }
+    _fdPlayerPlay = nullptr;
+    _fdPlayerSeek = nullptr;
+    _fdPlayerVolume = nullptr;
+    _fdPlayerPrefetchedStatus = nullptr;
+    _bufferQueue = nullptr;
+    _fdPlayerPlaybackRate = nullptr;
+    _outputLevel = SL_MILLIBEL_MAX;
+    _outputPan = 0.f;
+    _outputPitch = 1.f;
+    _isStereoPosition = false;
 
-    if (_assetFd > 0)
+    _stream.reset(); // Joins the decoder thread
+    _isFastPath = false;
+
+    if (_mixer != nullptr)
     {
-        close(_assetFd);
-        _assetFd = -1;
+        _mixer->releaseVoice(_mixerVoice);
+        _mixer = nullptr;
+        _mixerVoice = -1;
     }
 
-    _isPrefetchedSufficientData = false;
-    _isHeadAtEnd = false;
+    _asset = nullptr; // After the player that reads it
+}
 
-    _loop = false;
-    _audioId = -1;
+/**
+ * Set pitch, pan and gain to the sound, the output follows them from the next engine tick
+ */
+bool AudioPlayer::setParams(const float pitch, const float pan, const float volume) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::setParams");
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const float rate = clampPitch(pitch);
+        if (_isVirtual && _state == STATE_PLAYING && rate != _pitch) // The virtual clock runs at the pitch
+        {
+            _position = getVirtualPosition();
+            _playingSince = nowNanos();
+        }
+        _volume = volume < 0.f ? 0.f : (volume > 1.f ? 1.f : volume);
+        _pan = pan < -1.f ? -1.f : (pan > 1.f ? 1.f : pan);
+        _pitch = rate;
+    }
+    return requestUpdate();
+}
+
+/**
+ * Set volume of the sound (0% -> 100%), the output follows it from the next engine tick
+ */
+bool AudioPlayer::setVolume(const float volume) noexcept
+{
+    _volume = volume < 0.f ? 0.f : (volume > 1.f ? 1.f : volume);
+    return requestUpdate();
+}
+
+/**
+ * Attach a player being created to its bus, before the init that applies the volume
+ */
+void AudioPlayer::setBus(const int bus, const float gain) noexcept
+{
+    _bus = bus;
+    _busGain = gain;
+}
+
+/**
+ * Pan and pitch of a player being created, applied by the init with the volume instead of being ramped from the center
+ */
+void AudioPlayer::setStartParams(const float pan, const float pitch) noexcept
+{
+    _pan = pan < -1.f ? -1.f : (pan > 1.f ? 1.f : pan);
+    _pitch = clampPitch(pitch);
+}
+
+/**
+ * New effective gain of the bus on top of the volume of the sound, ramped like a volume change
+ */
+bool AudioPlayer::setBusGain(const float gain) noexcept
+{
+    _busGain = gain;
+    return requestUpdate();
+}
+
+const int AudioPlayer::getBus() const noexcept
+{
+    return _bus;
+}
+
+/**
+ * Queue the voice for the next engine tick, only once whatever the number of writes before the tick
+ * Lock-free but for the wake-up of the sleeping command thread by the first queued voice, _mutex must not be held
+ */
+bool AudioPlayer::requestUpdate() noexcept
+{
+    if (_paramsDirty.exchange(true))
+    {
+        return true; // Already queued, the tick reads the latest values
+    }
+    if (!AudioEngine::getInstance()->requestParamsUpdate(_audioId))
+    {
+        _paramsDirty = false; // Not queued, the next write tries again
+        return false;
+    }
+    return true;
+}
 
-    JNIEnv *jenv = getJNIEnv();
-    if (jenv != nullptr)
+/**
+ * Move the output one step toward the latest volume, pan and pitch, run by the engine tick
+ * step is the largest change of the gain in a tick (the pan moves twice as much over its range), it avoids the zipper noise of a jump
+ * Return true while the output hasn't reached the values yet: requestUpdate() again for the next tick
+ */
+bool AudioPlayer::updateParams(const float step) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::updateParams");
+    std::lock_guard<std::mutex> lock(_mutex);
+    _paramsDirty = false; // Cleared before the values are read: a later write queues the voice again
+    const float gain = _volume * _busGain;
+    const float pan = _pan;
+    const float pitch = _pitch;
+    if (_isVirtual) // Nothing is heard, devirtualize applies the values at once
+    {
+        _outputGain = gain;
+        _outputPan = pan;
+        return false;
+    }
+    const float nextGain = std::fabs(gain - _outputGain) <= step ? gain : _outputGain + (gain > _outputGain ? step : -step);
+    const float nextPan = std::fabs(pan - _outputPan) <= 2.f * step ? pan : _outputPan + (pan > _outputPan ? 2.f * step : -2.f * step);
+    if (_mixer != nullptr)
+    {
+        _mixer->setGain(_mixerVoice, nextGain, nextPan);
+        if (pitch != _outputPitch)
+        {
+            _mixer->setPitch(_mixerVoice, pitch); // The mixer ramps the rate over a buffer itself
+            _outputPitch = pitch;
+        }
+    }
+    else if (_stream != nullptr)
+    {
+        _stream->setParams(nextGain, nextPan, pitch);
+        _outputPitch = pitch;
+    }
+    else
     {
-        if (_javaAudioPlayerObj != nullptr)
+        if (!applyGain(nextGain) || !applyPan(nextPan))
+        {
+            return false; // Given up until the next write
+        }
+        if (pitch != _outputPitch)
         {
-            jenv->DeleteGlobalRef(_javaAudioPlayerObj);
-            _javaAudioPlayerObj = nullptr;
+            applyPitch(pitch); // Without playback rate the sound keeps its original pitch
         }
     }
+    _outputGain = nextGain;
+    _outputPan = nextPan;
+    return nextGain != gain || nextPan != pan;
 }
 
 /**
- * Set pitch, pan and gain to the sound
+ * Convert the effective gain in millibel and apply it on the OpenSL player, _mutex must be held
+ * The call is skipped when the level doesn't change, e.g. for the last steps of a slow fade
  */
-bool AudioPlayer::setParams(const float pitch, const float pan, const float volume) noexcept
+bool AudioPlayer::applyGain(const float gain) noexcept
 {
     bool ret = false;
     if (_fdPlayerVolume != nullptr)
     {
-        if (!setVolume(volume))
-        {
-            LOGEX("SetVolumeLevel _fdPlayerVolume fail");
-            return false;
-        }
-        SLresult result = (*_fdPlayerVolume)->EnableStereoPosition(_fdPlayerVolume, SL_BOOLEAN_TRUE);
-        if (SL_RESULT_SUCCESS != result)
+        const SLmillibel level = AudioGain::toMillibel(gain);
+        if (level == _outputLevel)
         {
-            LOGEX("EnableStereoPosition _fdPlayerVolume fail");
-            return false;
+            ret = true;
         }
-        result = (*_fdPlayerVolume)->SetStereoPosition(_fdPlayerVolume, (SLpermille) pan * 1000);
-        if (SL_RESULT_SUCCESS != result)
+        else if (SL_RESULT_SUCCESS != (*_fdPlayerVolume)->SetVolumeLevel(_fdPlayerVolume, level))
         {
-            LOGEX("SetStereoPosition _fdPlayerVolume fail");
-            return false;
+            LOGEX("SetVolumeLevel _fdPlayerVolume fail");
         }
         else
         {
-            _volume = volume;
+            _outputLevel = level;
             ret = true;
         }
+        if (ret)
+        {
+            _outputGain = gain;
+        }
     }
 
     return ret;
 }
 
 /**
- * Set volume of the sound (0% -> 100%)
+ * Apply the stereo position (-1 left -> 1 right) on the OpenSL player, _mutex must be held
+ * The stereo position is only enabled once, by the first pan away from the center
  */
-bool AudioPlayer::setVolume(const float volume) noexcept
+bool AudioPlayer::applyPan(const float pan) noexcept
 {
     bool ret = false;
     if (_fdPlayerVolume != nullptr)
     {
-        float vol = volume;
-        if (volume > 1.0f)
-        {
-            vol = 1.0f;
-        }
-        else if (volume < 0.0f)
+        const SLpermille position = (SLpermille) (pan * 1000);
+        if (position == (SLpermille) (_outputPan * 1000))
         {
-            vol = 0.0f;
+            _outputPan = pan;
+            return true;
         }
-
-        int dbVolume = 2000 * std::log10(vol);
-        if (dbVolume < SL_MILLIBEL_MIN)
+        SLresult result = SL_RESULT_SUCCESS;
+        if (!_isStereoPosition)
         {
-            dbVolume = SL_MILLIBEL_MIN;
+            result = (*_fdPlayerVolume)->EnableStereoPosition(_fdPlayerVolume, SL_BOOLEAN_TRUE);
+            if (SL_RESULT_SUCCESS != result)
+            {
+                LOGEX("EnableStereoPosition _fdPlayerVolume fail");
+                return false;
+            }
+            _isStereoPosition = true;
         }
-
-        SLresult result = (*_fdPlayerVolume)->SetVolumeLevel(_fdPlayerVolume, (SLpermille) dbVolume);
+        result = (*_fdPlayerVolume)->SetStereoPosition(_fdPlayerVolume, position);
         if (SL_RESULT_SUCCESS != result)
         {
-            LOGEX("SetVolumeLevel _fdPlayerVolume fail");
+            LOGEX("SetStereoPosition _fdPlayerVolume fail");
         }
         else
         {
+            _outputPan = pan;
             ret = true;
-            _volume = vol;
         }
     }
+    return ret;
+}
+
+/**
+ * Fetch the optional playback rate interface, pitch is only supported when the device exposes it, _mutex must be held
+ */
+void AudioPlayer::getPlaybackRateInterface() noexcept
+{
+    if (SL_RESULT_SUCCESS != (*_fdPlayerObject)->GetInterface(_fdPlayerObject, SL_IID_PLAYBACKRATE, &_fdPlayerPlaybackRate))
+    {
+        _fdPlayerPlaybackRate = nullptr;
+    }
+}
 
+/**
+ * Change the playback rate (1 = original pitch) of the OpenSL player, _mutex must be held
+ * Return false if the pitch can't be applied because the player has no playback rate
+ */
+bool AudioPlayer::applyPitch(const float pitch) noexcept
+{
+    const float rate = clampPitch(pitch);
+    if (_fdPlayerPlaybackRate == nullptr) // _pitch stays as requested, a later player of the voice may have a playback rate
+    {
+        _outputPitch = 1.f;
+        return rate == 1.f;
+    }
+    bool ret = false;
+    SLresult result = (*_fdPlayerPlaybackRate)->SetRate(_fdPlayerPlaybackRate, (SLpermille) (rate * 1000));
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("SetRate _fdPlayerPlaybackRate fail");
+    }
+    else
+    {
+        _outputPitch = rate;
+        ret = true;
+    }
     return ret;
 }
 
@@ -134,6 +361,24 @@ bool AudioPlayer::setVolume(const float volume) noexcept
  */
 bool AudioPlayer::pause() noexcept
 {
+    AUDIO_TRACE_SCOPE("AudioPlayer::pause");
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_isVirtual)
+    {
+        _position = getVirtualPosition();
+        _state = STATE_PAUSED;
+        return true;
+    }
+    if (_mixer != nullptr || _stream != nullptr)
+    {
+        const bool ret = _mixer != nullptr ? _mixer->pause(_mixerVoice) : _stream->pause();
+        if (ret)
+        {
+            _state = STATE_PAUSED;
+        }
+        return ret;
+    }
+
     bool ret = false;
     if (_fdPlayerPlay != nullptr)
     {
@@ -144,41 +389,55 @@ bool AudioPlayer::pause() noexcept
         }
         else
         {
+            _state = STATE_PAUSED;
             ret = true;
         }
     }
     return ret;
 }
 
+/**
+ * Time of the play request of the caller, the next play() measures its latency from it
+ */
+void AudioPlayer::markPlayRequested(const int64_t requestedAt) noexcept
+{
+    _playRequestedAt = requestedAt;
+}
+
 /**
  * Play sound
  */
 bool AudioPlayer::play() noexcept
 {
-    bool ret = false;
-    if (_fdPlayerPlay != nullptr)
+    AUDIO_TRACE_SCOPE("AudioPlayer::play");
+    std::lock_guard<std::mutex> lock(_mutex);
+    const int64_t requestedAt = _playRequestedAt.exchange(0); // 0 for a resume
+    if (_isVirtual)
     {
-        SLresult result = (*_fdPlayerPlay)->SetPlayState(_fdPlayerPlay, SL_PLAYSTATE_PLAYING);
-        if (SL_RESULT_SUCCESS != result)
+        if (_state != STATE_PLAYING)
         {
-            LOGEX("SetPlayState _fdPlayerPlay fail");
+            _playingSince = nowNanos();
+            _state = STATE_PLAYING;
         }
-        else
+        return true;
+    }
+    if (_mixer != nullptr || _stream != nullptr)
+    {
+        const bool ret = _mixer != nullptr ? _mixer->play(_mixerVoice, requestedAt) : _stream->play(requestedAt);
+        if (ret)
         {
-            ret = true;
+            _state = STATE_PLAYING;
         }
+        return ret;
     }
-    return ret;
-}
 
-/**
- * Resume sound
- */
-bool AudioPlayer::resume() noexcept
-{
     bool ret = false;
     if (_fdPlayerPlay != nullptr)
     {
+        if (requestedAt != 0)
+        {
+            waitHeadMoved(requestedAt);
+        }
         SLresult result = (*_fdPlayerPlay)->SetPlayState(_fdPlayerPlay, SL_PLAYSTATE_PLAYING);
         if (SL_RESULT_SUCCESS != result)
         {
@@ -186,19 +445,76 @@ bool AudioPlayer::resume() noexcept
         }
         else
         {
+            _state = STATE_PLAYING;
             ret = true;
         }
     }
     return ret;
 }
 
+/**
+ * Ask the play interface for the position updates until the head moves, _mutex must be held
+ * Android doesn't report SL_PLAYEVENT_HEADMOVING on every version, the first new position gives the start instead
+ */
+void AudioPlayer::waitHeadMoved(const int64_t requestedAt) noexcept
+{
+    SLmillisecond position = 0;
+    SLuint32 mask = 0;
+    if (SL_RESULT_SUCCESS != (*_fdPlayerPlay)->GetPosition(_fdPlayerPlay, &position)
+        || SL_RESULT_SUCCESS != (*_fdPlayerPlay)->GetCallbackEventsMask(_fdPlayerPlay, &mask))
+    {
+        return;
+    }
+    _soundStartPosition = position;
+    _soundRequestedAt = requestedAt;
+    if (SL_RESULT_SUCCESS != (*_fdPlayerPlay)->SetPositionUpdatePeriod(_fdPlayerPlay, POSITION_UPDATE_MS)
+        || SL_RESULT_SUCCESS != (*_fdPlayerPlay)->SetCallbackEventsMask(_fdPlayerPlay, mask | SL_PLAYEVENT_HEADATNEWPOS | SL_PLAYEVENT_HEADMOVING))
+    {
+        LOGEX("SetCallbackEventsMask _fdPlayerPlay fail");
+        _soundRequestedAt = 0;
+    }
+}
+
+/**
+ * First head movement after a play request, from the play callback: no lock, Destroy waits for this callback
+ * The sound started when the head was at the position of the request, the position events are dropped until the next request
+ */
+void AudioPlayer::onHeadMoved(SLPlayItf caller) noexcept
+{
+    const int64_t now = nowNanos();
+    const int64_t requestedAt = _soundRequestedAt.exchange(0);
+    SLuint32 mask = 0;
+    if (SL_RESULT_SUCCESS == (*caller)->GetCallbackEventsMask(caller, &mask))
+    {
+        (*caller)->SetCallbackEventsMask(caller, mask & ~(SL_PLAYEVENT_HEADATNEWPOS | SL_PLAYEVENT_HEADMOVING));
+    }
+    SLmillisecond position = 0;
+    if (requestedAt != 0 && SL_RESULT_SUCCESS == (*caller)->GetPosition(caller, &position))
+    {
+        const SLmillisecond start = _soundStartPosition;
+        const SLmillisecond played = position >= start ? position - start : position; // A loop may have wrapped
+        AudioEngine::getInstance()->recordLatency(AudioEngine::LATENCY_SOUND, now - (int64_t) played * 1000000 - requestedAt);
+    }
+}
+
+/**
+ * Resume sound
+ */
+bool AudioPlayer::resume() noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::resume");
+    return play();
+}
+
 /**
  * Stop sound meaning it will be destroyed
  */
 bool AudioPlayer::stop() noexcept
 {
-    bool ret = false;
-    if (_fdPlayerPlay != nullptr)
+    AUDIO_TRACE_SCOPE("AudioPlayer::stop");
+    std::lock_guard<std::mutex> lock(_mutex);
+    bool ret = _isVirtual || (_mixer != nullptr && _mixer->stop(_mixerVoice)) || (_stream != nullptr && _stream->stop());
+    if (!ret && _fdPlayerPlay != nullptr)
     {
         SLresult result = (*_fdPlayerPlay)->SetPlayState(_fdPlayerPlay, SL_PLAYSTATE_STOPPED);
         if (SL_RESULT_SUCCESS != result)
@@ -207,21 +523,19 @@ bool AudioPlayer::stop() noexcept
         }
         else
         {
-            if (_javaAudioPlayerObj != nullptr) // Set the audioId of the member AudioPlayer.java if set
-            {
-                JNIEnv *jenv = getJNIEnv();
-                if (jenv != nullptr)
-                {
-                    jclass audioPlayerClass = jenv->GetObjectClass(_javaAudioPlayerObj);
-                    jfieldID audioIdField = jenv->GetFieldID(audioPlayerClass, "_audioId", "I");
-                    jenv->SetIntField(_javaAudioPlayerObj, audioIdField, (jint) -1);
-                }
-            }
-            _isHeadAtEnd = true; // Boolean used to force the GC Thread to delete the player
-            _loop = false;
             ret = true;
         }
     }
+    if (ret)
+    {
+        _state = STATE_STOPPED;
+        _isHeadAtEnd = true;
+        _loop = false;
+        if (setRetired()) // Hand the player to the GC Thread so it is deleted right away
+        {
+            AudioEngine::getInstance()->retire(_audioId);
+        }
+    }
     return ret;
 }
 
@@ -234,6 +548,19 @@ void AudioPlayer::setHeadAtEnd(const bool isHeadAtEnd) noexcept
     _isHeadAtEnd = isHeadAtEnd;
 }
 
+/**
+ * Flag the player as retired, return true only for the first call so it is queued once
+ */
+bool AudioPlayer::setRetired() noexcept
+{
+    return !_isRetired.exchange(true);
+}
+
+const bool AudioPlayer::isRetired() const noexcept
+{
+    return _isRetired;
+}
+
 /**
  * Check if we reach the end of the sound or stoped the sound
  */
@@ -253,18 +580,20 @@ const bool AudioPlayer::isPrefetchedSufficient() const noexcept
 
 /**
  * Get the OpenSL prefeteched status and set the flag if we prefetched enough data
+ * Note: Called from the OpenSL callback, it must not wait on _mutex that is held while the player is destroyed
  */
 SLuint32 AudioPlayer::getPrefetchedStatus() noexcept
 {
     SLuint32 status = 0;
-    if (_fdPlayerPrefetchedStatus != nullptr)
+    std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+    if (lock.owns_lock() && _fdPlayerPrefetchedStatus != nullptr)
     {
         SLresult result = (*_fdPlayerPrefetchedStatus)->GetPrefetchStatus(_fdPlayerPrefetchedStatus, &status);
         if (SL_RESULT_SUCCESS == result)
         {
-            if (status == SL_PREFETCHSTATUS_SUFFICIENTDATA)
+            if (status == SL_PREFETCHSTATUS_SUFFICIENTDATA && !_isPrefetchedSufficientData.exchange(true))
             {
-                _isPrefetchedSufficientData = true;
+                AudioEngine::getInstance()->recordLatency(AudioEngine::LATENCY_PREFETCH, nowNanos() - _createdAt);
             }
         }
         else
@@ -280,80 +609,320 @@ SLuint32 AudioPlayer::getPrefetchedStatus() noexcept
  * Init hte OpenSL Object required to be able to play the sound
  * Note: We need OpenSL Engine, Mix Obj and AssetManager to be able to init the sound
  */
-bool AudioPlayer::initWithEngine(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager, const int audioId, const std::string &fileFullPath, const float volume, const bool loop) noexcept
+bool AudioPlayer::initWithEngine(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager, const int audioId, const std::string &fileFullPath, const std::shared_ptr<AudioSample> &sample, const float volume, const bool loop, const int priority) noexcept
 {
-    bool ret = false;
-    bool fileFound = false;
-
-    if (engineEngine == nullptr || outputMixObject == nullptr || assetManager == nullptr)
+    AUDIO_TRACE_SCOPE("AudioPlayer::initWithEngine");
+    std::lock_guard<std::mutex> lock(_mutex);
+    _path = fileFullPath;
+    _sample = sample;
+    _volume = volume;
+    _loop = loop;
+    _priority = priority;
+    _createdAt = nowNanos();
+    if (!realize(engineEngine, outputMixObject, assetManager))
     {
         return false;
     }
+    return configure(audioId);
+}
 
-    SLDataSource audioSrc;
-
-    SLDataLocator_AndroidFD loc_fd;
-    SLDataLocator_URI loc_uri;
-
-    SLDataFormat_MIME format_mime = {SL_DATAFORMAT_MIME, NULL, SL_CONTAINERTYPE_UNSPECIFIED};
-    audioSrc.pFormat = &format_mime;
+/**
+ * Init a voice that has no OpenSL player yet, the engine gives it one with devirtualize() when it matters enough
+ * Note: duration is the length of the source if known (SL_TIME_UNKNOWN otherwise)
+ */
+bool AudioPlayer::initVirtual(const int audioId, const std::string &fileFullPath, const std::shared_ptr<AudioSample> &sample, const float volume, const bool loop, const int priority, const SLmillisecond duration) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::initVirtual");
+    std::lock_guard<std::mutex> lock(_mutex);
+    _path = fileFullPath;
+    _sample = sample;
+    _volume = volume;
+    _loop = loop;
+    _priority = priority;
+    _createdAt = nowNanos();
+    _duration = duration;
+    _position = 0;
+    _audioId = audioId;
+    _isVirtual = true;
+    return true;
+}
 
-    if (fileFullPath[0] != '/')
+/**
+ * Init a voice of the software mixer, fails if all the voices of the mixer are busy
+ */
+bool AudioPlayer::initMixed(AudioMixer *mixer, const int audioId, const std::string &fileFullPath, const std::shared_ptr<AudioSample> &sample, const float volume, const bool loop, const int priority) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::initMixed");
+    std::lock_guard<std::mutex> lock(_mutex);
+    _path = fileFullPath;
+    _sample = sample;
+    _volume = volume;
+    _loop = loop;
+    _priority = priority;
+    _createdAt = nowNanos();
+    _mixerVoice = mixer->addVoice(audioId, sample, volume * _busGain, _pan, loop);
+    if (_mixerVoice < 0)
     {
-        std::string relativePath = "";
-
-        const size_t position = fileFullPath.find("assets/");
-        if (0 == position)
-        {
-            // "assets/" is at the beginning of the path and we don't want it
-            const std::string assetsPath = "assets/";
-            relativePath += fileFullPath.substr(assetsPath.length());
-        }
-        else
-        {
-            relativePath += fileFullPath;
-        }
-
-        AAsset *asset = AAssetManager_open(assetManager, relativePath.c_str(), AASSET_MODE_UNKNOWN);
-
-        // open asset as file descriptor
-        off64_t start = 0, length = 0;
-        _assetFd = AAsset_openFileDescriptor64(asset, &start, &length);
-        AAsset_close(asset);
-        if (_assetFd > 0)
-        {
-            // configure audio source
-            loc_fd.locatorType = SL_DATALOCATOR_ANDROIDFD;
-            loc_fd.fd = _assetFd;
-            loc_fd.offset = start;
-            loc_fd.length = length;
+        return false;
+    }
+    if (_pitch != 1.f)
+    {
+        mixer->setPitch(_mixerVoice, _pitch);
+    }
+    _mixer = mixer;
+    _outputGain = volume * _busGain;
+    _outputPan = _pan;
+    _outputPitch = _pitch;
+    _audioId = audioId;
+    _isFastPath = mixer->isFastPath();
+    _isPrefetchedSufficientData = true; // The whole sound is already in memory
+    return true;
+}
 
-            audioSrc.pLocator = &loc_fd;
+/**
+ * Init a streaming voice on the fd of the asset, the AudioStream decodes it progressively
+ */
+bool AudioPlayer::initStreamed(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager, const int audioId, const std::string &fileFullPath,
+                               const float volume, const bool loop, const int priority, const size_t ringFrames, const size_t lowWatermarkFrames, AudioStream::Counters *counters) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::initStreamed");
+    std::lock_guard<std::mutex> lock(_mutex);
+    _path = fileFullPath;
+    _volume = volume;
+    _loop = loop;
+    _priority = priority;
+    _createdAt = nowNanos();
 
-            fileFound = true;
-        }
-    }
-    else
+    const std::shared_ptr<AudioAsset> asset = AudioEngine::getInstance()->acquireAsset(fileFullPath);
+    if (asset == nullptr)
     {
-        loc_uri.locatorType = SL_DATALOCATOR_URI;
-        loc_uri.URI = (SLchar *) fileFullPath.c_str();
-        audioSrc.pLocator = &loc_uri;
-        fileFound = true;
+        return false;
     }
 
-    if (fileFound)
+    _stream.reset(new AudioStream());
+    if (!_stream->init(engineEngine, outputMixObject, asset, audioId, loop, ringFrames, lowWatermarkFrames, counters, &_isFastPath))
     {
-        // configure audio sink
-        SLDataLocator_OutputMix loc_outmix = {SL_DATALOCATOR_OUTPUTMIX, outputMixObject};
-        SLDataSink audioSnk = {&loc_outmix, NULL};
+        _stream.reset();
+        return false;
+    }
+    _stream->setParams(_volume * _busGain, _pan, _pitch);
+    _outputGain = _volume * _busGain;
+    _outputPan = _pan;
+    _outputPitch = _pitch;
+    _audioId = audioId;
+    _isPrefetchedSufficientData = true;
+    return true;
+}
 
-        // create audio player
-        const SLInterfaceID ids[3] = {SL_IID_SEEK, SL_IID_PREFETCHSTATUS, SL_IID_VOLUME};
-        const SLboolean req[3] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE};
-        SLresult result = (*engineEngine)->CreateAudioPlayer(engineEngine, &_fdPlayerObject, &audioSrc, &audioSnk, 3, ids, req);
+/**
+ * Create and realize the OpenSL player of the source and fetch its interfaces, _mutex must be held
+ * A decoded sample plays through a buffer queue, anything else streams from its fd or URI
+ */
+bool AudioPlayer::realize(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::realize");
+    const int64_t start = nowNanos();
+    _isUnplayable = false;
+    const bool ret = _sample != nullptr ? realizeBufferQueue(engineEngine, outputMixObject) : realizeFd(engineEngine, outputMixObject, assetManager);
+    if (ret)
+    {
+        AudioEngine::getInstance()->recordLatency(AudioEngine::LATENCY_REALIZE, nowNanos() - start);
+    }
+    return ret;
+}
+
+/**
+ * Create a PCM buffer queue player matching the format of the sample, _mutex must be held
+ * A sample at the output rate asks for a fast track, it has no playback rate interface then: the platform denies the fast track to players having one
+ */
+bool AudioPlayer::realizeBufferQueue(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject) noexcept
+{
+    if (engineEngine == nullptr || outputMixObject == nullptr)
+    {
+        return false;
+    }
+
+    SLDataLocator_AndroidSimpleBufferQueue loc_bq = {SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, 2};
+    SLDataFormat_PCM format_pcm = {SL_DATAFORMAT_PCM, _sample->channels, _sample->sampleRate * 1000, SL_PCMSAMPLEFORMAT_FIXED_16, SL_PCMSAMPLEFORMAT_FIXED_16,
+                                   _sample->channels == 1 ? SL_SPEAKER_FRONT_CENTER : SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT, SL_BYTEORDER_LITTLEENDIAN};
+    SLDataSource audioSrc = {&loc_bq, &format_pcm};
+
+    // configure audio sink
+    SLDataLocator_OutputMix loc_outmix = {SL_DATALOCATOR_OUTPUTMIX, outputMixObject};
+    SLDataSink audioSnk = {&loc_outmix, NULL};
+
+    // create audio player
+    const bool fastPath = AudioFastPath::isEligible(_sample->sampleRate, AudioEngine::getInstance()->getOutputSampleRate());
+    const SLInterfaceID ids[4] = {SL_IID_ANDROIDSIMPLEBUFFERQUEUE, SL_IID_VOLUME, SL_IID_ANDROIDCONFIGURATION, SL_IID_PLAYBACKRATE};
+    const SLboolean req[4] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE, SL_BOOLEAN_FALSE, SL_BOOLEAN_FALSE};
+    SLresult result = (*engineEngine)->CreateAudioPlayer(engineEngine, &_fdPlayerObject, &audioSrc, &audioSnk, fastPath ? 3 : 4, ids, req);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("CreateAudioPlayer _fdPlayerObject fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_CREATE_PLAYER);
+        _isUnplayable = isSourceError(result);
+        _fdPlayerObject = nullptr;
+        return false;
+    }
+    if (fastPath)
+    {
+        AudioFastPath::request(_fdPlayerObject);
+    }
+    // realize the player
+    result = (*_fdPlayerObject)->Realize(_fdPlayerObject, SL_BOOLEAN_FALSE);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("Realize _fdPlayerObject fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_REALIZE);
+        _isUnplayable = isSourceError(result);
+        destroyObjects();
+        return false;
+    }
+    // get the play interface
+    result = (*_fdPlayerObject)->GetInterface(_fdPlayerObject, SL_IID_PLAY, &_fdPlayerPlay);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("GetInterface _fdPlayerPlay fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_INTERFACE);
+        destroyObjects();
+        return false;
+    }
+    // get the buffer queue interface
+    result = (*_fdPlayerObject)->GetInterface(_fdPlayerObject, SL_IID_ANDROIDSIMPLEBUFFERQUEUE, &_bufferQueue);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("GetInterface _bufferQueue fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_INTERFACE);
+        destroyObjects();
+        return false;
+    }
+    // get the volume interface
+    result = (*_fdPlayerObject)->GetInterface(_fdPlayerObject, SL_IID_VOLUME, &_fdPlayerVolume);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("GetInterface _fdPlayerVolume fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_INTERFACE);
+        destroyObjects();
+        return false;
+    }
+    getPlaybackRateInterface();
+    _isFastPath = AudioFastPath::isObtained(_fdPlayerObject, fastPath);
+    _isPrefetchedSufficientData = true; // The whole sound is already in memory
+    return true;
+}
+
+/**
+ * Enqueue the sample from offset (ms) to its end, _mutex must be held
+ */
+bool AudioPlayer::enqueue(const SLmillisecond offset) noexcept
+{
+    const size_t frames = _sample->getFrames();
+    size_t first = (size_t) ((uint64_t) offset * _sample->sampleRate / 1000);
+    if (first >= frames)
+    {
+        first = 0;
+    }
+    SLresult result = (*_bufferQueue)->Clear(_bufferQueue);
+    if (SL_RESULT_SUCCESS == result)
+    {
+        result = (*_bufferQueue)->Enqueue(_bufferQueue, _sample->getData() + first * _sample->channels, (SLuint32) ((frames - first) * _sample->channels * sizeof(int16_t)));
+    }
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("Enqueue _bufferQueue fail");
+        return false;
+    }
+    _queueOffset = first == 0 ? 0 : offset;
+    return true;
+}
+
+/**
+ * The sample has been fully played: enqueue it again if the voice loops
+ * Note: Called from the OpenSL callback with the queue of the callback, it doesn't take _mutex
+ */
+bool AudioPlayer::requeue(SLAndroidSimpleBufferQueueItf bufferQueue) noexcept
+{
+    const std::shared_ptr<AudioSample> sample = _sample;
+    if (!_loop || sample == nullptr)
+    {
+        return false;
+    }
+    SLresult result = (*bufferQueue)->Enqueue(bufferQueue, sample->getData(), (SLuint32) sample->getBytes());
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("Enqueue bufferQueue fail");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Create the OpenSL player reading the compressed asset from its fd, _mutex must be held
+ */
+bool AudioPlayer::realizeFd(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager) noexcept
+{
+    bool ret = false;
+    bool fileFound = false;
+
+    if (engineEngine == nullptr || outputMixObject == nullptr || assetManager == nullptr)
+    {
+        return false;
+    }
+
+    SLDataSource audioSrc;
+
+    SLDataLocator_AndroidFD loc_fd;
+    SLDataLocator_URI loc_uri;
+
+    SLDataFormat_MIME format_mime = {SL_DATAFORMAT_MIME, NULL, SL_CONTAINERTYPE_UNSPECIFIED};
+    audioSrc.pFormat = &format_mime;
+
+    if (_path[0] != '/')
+    {
+        // the fd of the asset is shared with the other players of the path
+        _asset = AudioEngine::getInstance()->acquireAsset(_path);
+        if (_asset != nullptr)
+        {
+            // configure audio source
+            loc_fd.locatorType = SL_DATALOCATOR_ANDROIDFD;
+            loc_fd.fd = _asset->fd;
+            loc_fd.offset = _asset->start;
+            loc_fd.length = _asset->length;
+
+            audioSrc.pLocator = &loc_fd;
+
+            fileFound = true;
+        }
+        else
+        {
+            _isUnplayable = true; // The asset is missing or compressed in the APK
+        }
+    }
+    else
+    {
+        loc_uri.locatorType = SL_DATALOCATOR_URI;
+        loc_uri.URI = (SLchar *) _path.c_str();
+        audioSrc.pLocator = &loc_uri;
+        fileFound = true;
+    }
+
+    if (fileFound)
+    {
+        // configure audio sink
+        SLDataLocator_OutputMix loc_outmix = {SL_DATALOCATOR_OUTPUTMIX, outputMixObject};
+        SLDataSink audioSnk = {&loc_outmix, NULL};
+
+        // create audio player
+        const SLInterfaceID ids[4] = {SL_IID_SEEK, SL_IID_PREFETCHSTATUS, SL_IID_VOLUME, SL_IID_PLAYBACKRATE};
+        const SLboolean req[4] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE, SL_BOOLEAN_FALSE}; // The playback rate is optional
+        SLresult result = (*engineEngine)->CreateAudioPlayer(engineEngine, &_fdPlayerObject, &audioSrc, &audioSnk, 4, ids, req);
         if (SL_RESULT_SUCCESS != result)
         {
             LOGEX("CreateAudioPlayer _fdPlayerObject fail");
+            AudioMetrics::count(AudioMetrics::COUNTER_FAILED_CREATE_PLAYER);
+            _isUnplayable = isSourceError(result);
+            _fdPlayerObject = nullptr;
+            destroyObjects();
             return false;
         }
         // realize the player
@@ -361,6 +930,9 @@ bool AudioPlayer::initWithEngine(const SLEngineItf &engineEngine, const SLObject
         if (SL_RESULT_SUCCESS != result)
         {
             LOGEX("Realize _fdPlayerObject fail");
+            AudioMetrics::count(AudioMetrics::COUNTER_FAILED_REALIZE);
+            _isUnplayable = isSourceError(result);
+            destroyObjects();
             return false;
         }
         // get the play interface
@@ -368,24 +940,24 @@ bool AudioPlayer::initWithEngine(const SLEngineItf &engineEngine, const SLObject
         if (SL_RESULT_SUCCESS != result)
         {
             LOGEX("GetInterface _prefetchedStatus fail");
+            AudioMetrics::count(AudioMetrics::COUNTER_FAILED_INTERFACE);
+            destroyObjects();
             return false;
         }
         result = (*_fdPlayerPrefetchedStatus)->SetCallbackEventsMask(_fdPlayerPrefetchedStatus, SL_PREFETCHEVENT_FILLLEVELCHANGE);
         if (SL_RESULT_SUCCESS != result)
         {
             LOGEX("SetCallbackEventsMask _prefetchedStatus fail");
+            AudioMetrics::count(AudioMetrics::COUNTER_FAILED_INTERFACE);
+            destroyObjects();
             return false;
         }
         result = (*_fdPlayerPrefetchedStatus)->SetFillUpdatePeriod(_fdPlayerPrefetchedStatus, 10);
         if (SL_RESULT_SUCCESS != result)
         {
             LOGEX("SetFillUpdatePeriod _prefetchedStatus fail");
-            return false;
-        }
-        result = (*_fdPlayerPrefetchedStatus)->RegisterCallback(_fdPlayerPrefetchedStatus, AudioPlayer::prefetchEventCallback, (void *) (intptr_t) audioId);
-        if (SL_RESULT_SUCCESS != result)
-        {
-            LOGEX("RegisterCallback _prefetchedStatus fail");
+            AudioMetrics::count(AudioMetrics::COUNTER_FAILED_INTERFACE);
+            destroyObjects();
             return false;
         }
         // get the play interface
@@ -393,18 +965,16 @@ bool AudioPlayer::initWithEngine(const SLEngineItf &engineEngine, const SLObject
         if (SL_RESULT_SUCCESS != result)
         {
             LOGEX("GetInterface _fdPlayerPlay fail");
+            AudioMetrics::count(AudioMetrics::COUNTER_FAILED_INTERFACE);
+            destroyObjects();
             return false;
         }
         result = (*_fdPlayerPlay)->SetCallbackEventsMask(_fdPlayerPlay, SL_PLAYEVENT_HEADATEND);
         if (SL_RESULT_SUCCESS != result)
         {
             LOGEX("SetCallbackEventsMask _fdPlayerPlay fail");
-            return false;
-        }
-        result = (*_fdPlayerPlay)->RegisterCallback(_fdPlayerPlay, AudioPlayer::playEventCallback, (void *) (intptr_t) audioId);
-        if (SL_RESULT_SUCCESS != result)
-        {
-            LOGEX("RegisterCallback _fdPlayerPlay fail");
+            AudioMetrics::count(AudioMetrics::COUNTER_FAILED_INTERFACE);
+            destroyObjects();
             return false;
         }
         // get the seek interface
@@ -412,6 +982,8 @@ bool AudioPlayer::initWithEngine(const SLEngineItf &engineEngine, const SLObject
         if (SL_RESULT_SUCCESS != result)
         {
             LOGEX("GetInterface _fdPlayerSeek fail");
+            AudioMetrics::count(AudioMetrics::COUNTER_FAILED_INTERFACE);
+            destroyObjects();
             return false;
         }
         // get the volume interface
@@ -419,41 +991,347 @@ bool AudioPlayer::initWithEngine(const SLEngineItf &engineEngine, const SLObject
         if (SL_RESULT_SUCCESS != result)
         {
             LOGEX("GetInterface _fdPlayerVolume fail");
+            AudioMetrics::count(AudioMetrics::COUNTER_FAILED_INTERFACE);
+            destroyObjects();
             return false;
         }
-        _loop = loop;
-        if (loop)
+        getPlaybackRateInterface();
+        ret = true;
+    }
+
+    return ret;
+}
+
+/**
+ * Bind the realized player to an audioId: the callbacks context, the loop, the volume and the pan, _mutex must be held
+ */
+bool AudioPlayer::configure(const int audioId) noexcept
+{
+    if (_bufferQueue != nullptr)
+    {
+        SLresult result = (*_bufferQueue)->RegisterCallback(_bufferQueue, AudioPlayer::bufferQueueCallback, (void *) (intptr_t) audioId);
+        if (SL_RESULT_SUCCESS != result)
         {
-            result = (*_fdPlayerSeek)->SetLoop(_fdPlayerSeek, SL_BOOLEAN_TRUE, 0, SL_TIME_UNKNOWN);
-            if (SL_RESULT_SUCCESS != result)
-            {
-                LOGEX("SetLoop _fdPlayerSeek fail");
-                return false;
-            }
+            LOGEX("RegisterCallback _bufferQueue fail");
+            AudioMetrics::count(AudioMetrics::COUNTER_FAILED_CONFIGURE);
+            return false;
+        }
+        result = (*_fdPlayerPlay)->RegisterCallback(_fdPlayerPlay, AudioPlayer::playEventCallback, (void *) (intptr_t) audioId); // Only the position events
+        if (SL_RESULT_SUCCESS != result)
+        {
+            LOGEX("RegisterCallback _fdPlayerPlay fail");
+            AudioMetrics::count(AudioMetrics::COUNTER_FAILED_CONFIGURE);
+            return false;
+        }
+        if (!enqueue(_position) || !applyGain(_volume * _busGain) || (_pan != 0.f && !applyPan(_pan)))
+        {
+            return false;
         }
+        if (_pitch != 1.f)
+        {
+            applyPitch(_pitch);
+        }
+        _audioId = audioId;
+        return true;
+    }
+
+    SLresult result = (*_fdPlayerPrefetchedStatus)->RegisterCallback(_fdPlayerPrefetchedStatus, AudioPlayer::prefetchEventCallback, (void *) (intptr_t) audioId);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("RegisterCallback _prefetchedStatus fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_CONFIGURE);
+        return false;
+    }
+    result = (*_fdPlayerPlay)->RegisterCallback(_fdPlayerPlay, AudioPlayer::playEventCallback, (void *) (intptr_t) audioId);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("RegisterCallback _fdPlayerPlay fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_CONFIGURE);
+        return false;
+    }
+
+    result = (*_fdPlayerSeek)->SetLoop(_fdPlayerSeek, _loop ? SL_BOOLEAN_TRUE : SL_BOOLEAN_FALSE, 0, SL_TIME_UNKNOWN);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("SetLoop _fdPlayerSeek fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_CONFIGURE);
+        return false;
+    }
+
+    if (!applyGain(_volume * _busGain) || (_pan != 0.f && !applyPan(_pan)))
+    {
+        return false;
+    }
+    if (_pitch != 1.f)
+    {
+        applyPitch(_pitch);
+    }
+
+    _audioId = audioId;
+    return true;
+}
+
+/**
+ * Give the OpenSL player back to the platform and keep tracking the play head with a clock
+ */
+bool AudioPlayer::virtualize() noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::virtualize");
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_isVirtual || _fdPlayerPlay == nullptr)
+    {
+        return false;
+    }
 
-        int dbVolume = 2000 * std::log10(volume);
-        if (dbVolume < SL_MILLIBEL_MIN)
+    SLmillisecond position = 0;
+    if (SL_RESULT_SUCCESS != (*_fdPlayerPlay)->GetPosition(_fdPlayerPlay, &position))
+    {
+        LOGEX("GetPosition _fdPlayerPlay fail");
+        position = 0;
+    }
+    if (_bufferQueue != nullptr) // The position of a buffer queue starts where the sample has been enqueued from
+    {
+        position += _queueOffset;
+    }
+    SLmillisecond duration = SL_TIME_UNKNOWN;
+    if (SL_RESULT_SUCCESS == (*_fdPlayerPlay)->GetDuration(_fdPlayerPlay, &duration) && duration != SL_TIME_UNKNOWN)
+    {
+        _duration = duration;
+    }
+
+    destroyObjects();
+    _position = position;
+    _playingSince = nowNanos();
+    _isPrefetchedSufficientData = false;
+    _isVirtual = true;
+    return true;
+}
+
+/**
+ * Give a player back to a virtual voice and resume it where its clock is
+ */
+bool AudioPlayer::devirtualize(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::devirtualize");
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_isVirtual)
+    {
+        return false;
+    }
+
+    SLmillisecond position = getVirtualPosition();
+    const SLmillisecond duration = _duration;
+    if (_loop && duration != SL_TIME_UNKNOWN && duration > 0)
+    {
+        position %= duration;
+    }
+
+    if (!realize(engineEngine, outputMixObject, assetManager))
+    {
+        if (_isUnplayable)
+        {
+            _promoteAt = nowNanos() + PROMOTE_BACKOFF_MS * 1000000;
+        }
+        return false;
+    }
+    _position = position; // A buffer queue is enqueued from there
+    if (!configure(_audioId))
+    {
+        destroyObjects();
+        return false;
+    }
+    if (position > 0 && _fdPlayerSeek != nullptr && SL_RESULT_SUCCESS != (*_fdPlayerSeek)->SetPosition(_fdPlayerSeek, position, SL_SEEKMODE_ACCURATE))
+    {
+        LOGEX("SetPosition _fdPlayerSeek fail");
+    }
+
+    SLresult result = SL_RESULT_SUCCESS;
+    if (_state == STATE_PLAYING)
+    {
+        result = (*_fdPlayerPlay)->SetPlayState(_fdPlayerPlay, SL_PLAYSTATE_PLAYING);
+    }
+    else if (_state == STATE_PAUSED)
+    {
+        result = (*_fdPlayerPlay)->SetPlayState(_fdPlayerPlay, SL_PLAYSTATE_PAUSED);
+    }
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("SetPlayState _fdPlayerPlay fail");
+        destroyObjects();
+        return false;
+    }
+
+    _position = position;
+    _isVirtual = false;
+    return true;
+}
+
+/**
+ * Play head of a virtual voice, _mutex must be held
+ */
+SLmillisecond AudioPlayer::getVirtualPosition() const noexcept
+{
+    SLmillisecond position = _position;
+    if (_state == STATE_PLAYING)
+    {
+        position += (SLmillisecond) ((nowNanos() - _playingSince) * _pitch / 1000000);
+    }
+    return position;
+}
+
+/**
+ * Check if a virtual one-shot would have reached its end
+ * Note: A virtual voice whose length is unknown (never realized) is considered finished
+ */
+bool AudioPlayer::isVirtualFinished() noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_isVirtual || _loop || _state == STATE_PAUSED)
+    {
+        return false;
+    }
+    const SLmillisecond duration = _duration;
+    return duration == SL_TIME_UNKNOWN || getVirtualPosition() >= duration;
+}
+
+/**
+ * Length of the source in ms or SL_TIME_UNKNOWN
+ */
+SLmillisecond AudioPlayer::getDuration() noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_sample != nullptr)
+    {
+        return _sample->getDurationMs();
+    }
+    if (_duration == SL_TIME_UNKNOWN && _fdPlayerPlay != nullptr)
+    {
+        SLmillisecond duration = SL_TIME_UNKNOWN;
+        if (SL_RESULT_SUCCESS == (*_fdPlayerPlay)->GetDuration(_fdPlayerPlay, &duration))
+        {
+            _duration = duration;
+        }
+    }
+    return _duration;
+}
+
+/**
+ * Bring a finished player back to its initial state so the AudioPlayerPool can hand it out again
+ * Note: SL_PLAYSTATE_STOPPED rewinds the play head to the beginning of the source
+ */
+bool AudioPlayer::reset() noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::reset");
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_fdPlayerPlay == nullptr || (_fdPlayerSeek == nullptr && _bufferQueue == nullptr))
+    {
+        return false;
+    }
+    SLresult result = (*_fdPlayerPlay)->SetPlayState(_fdPlayerPlay, SL_PLAYSTATE_STOPPED);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("SetPlayState _fdPlayerPlay fail");
+        return false;
+    }
+    if (_bufferQueue != nullptr)
+    {
+        result = (*_bufferQueue)->Clear(_bufferQueue);
+        if (SL_RESULT_SUCCESS != result)
         {
-            dbVolume = SL_MILLIBEL_MIN;
+            LOGEX("Clear _bufferQueue fail");
+            return false;
         }
-        result = (*_fdPlayerVolume)->SetVolumeLevel(_fdPlayerVolume, (SLpermille) dbVolume);
+    }
+    else
+    {
+        result = (*_fdPlayerSeek)->SetLoop(_fdPlayerSeek, SL_BOOLEAN_FALSE, 0, SL_TIME_UNKNOWN);
         if (SL_RESULT_SUCCESS != result)
         {
-            LOGEX("SetVolumeLevel _fdPlayerVolume fail");
+            LOGEX("SetLoop _fdPlayerSeek fail");
             return false;
         }
-        _volume = volume;
+    }
+    if (_outputPan != 0.f && !applyPan(0.f))
+    {
+        return false;
+    }
+    if (_outputPitch != 1.f && !applyPitch(1.f))
+    {
+        return false;
+    }
+    _pan = 0.f;
+    _pitch = 1.f;
+    _paramsDirty = false; // A pending tick of the previous sound must not hide the writes of the next one
+    _state = STATE_IDLE;
+    _loop = false;
+    _audioId = -1;
+    return true;
+}
 
-        _audioId = audioId;
-        ret = true;
+/**
+ * Realize the fd player of a source without any audioId and wait for OpenSL to prefetch it, then it can go to the AudioPlayerPool
+ * The play head stays at the beginning of the source in SL_PLAYSTATE_PAUSED, the status is polled as no callback is registered yet
+ */
+bool AudioPlayer::prefetch(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager, const std::string &fileFullPath, const int timeoutMs) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::prefetch");
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _path = fileFullPath;
+        _sample = nullptr;
+        if (!realizeFd(engineEngine, outputMixObject, assetManager))
+        {
+            return false;
+        }
+        SLresult result = (*_fdPlayerPlay)->SetPlayState(_fdPlayerPlay, SL_PLAYSTATE_PAUSED);
+        if (SL_RESULT_SUCCESS != result)
+        {
+            LOGEX("SetPlayState _fdPlayerPlay fail");
+            return false;
+        }
+    }
+    const int64_t deadline = nowNanos() + (int64_t) timeoutMs * 1000000;
+    while (getPrefetchedStatus() != SL_PREFETCHSTATUS_SUFFICIENTDATA)
+    {
+        if (nowNanos() > deadline)
+        {
+            LOGEX("prefetch timeout");
+            AudioMetrics::count(AudioMetrics::COUNTER_FAILED_PREFETCH);
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
     }
+    return true;
+}
 
-    return ret;
+/**
+ * Hand a pooled player out with a new audioId
+ * A buffer queue player can play any sample of the same PCM format, a fd player only its own source
+ */
+bool AudioPlayer::reuse(const int audioId, const std::string &fileFullPath, const std::shared_ptr<AudioSample> &sample, const float volume, const bool loop, const int priority) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::reuse");
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (makePoolKey(fileFullPath, sample) != makePoolKey(_path, _sample))
+    {
+        return false;
+    }
+    _path = fileFullPath;
+    _sample = sample;
+    _position = 0;
+    _state = STATE_IDLE;
+    _isHeadAtEnd = false;
+    _isRetired = false;
+    _volume = volume;
+    _loop = loop;
+    _priority = priority;
+    _createdAt = nowNanos();
+    return configure(audioId);
 }
 
 void AudioPlayer::prefetchEventCallback(SLPrefetchStatusItf caller, void *context, SLuint32 prefetchEvent) noexcept
 {
+    AUDIO_TRACE_SCOPE("AudioPlayer::prefetchEventCallback");
     if ((prefetchEvent & SL_PREFETCHEVENT_FILLLEVELCHANGE) == SL_PREFETCHEVENT_FILLLEVELCHANGE)
     {
         int audioId = (int) (intptr_t) context;
@@ -462,16 +1340,51 @@ void AudioPlayer::prefetchEventCallback(SLPrefetchStatusItf caller, void *contex
     }
 }
 
+void AudioPlayer::bufferQueueCallback(SLAndroidSimpleBufferQueueItf caller, void *context) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioPlayer::bufferQueueCallback");
+    int audioId = (int) (intptr_t) context;
+    AudioEngine *engine = AudioEngine::getInstance();
+    engine->onBufferQueueEnd(audioId, caller);
+}
+
 void AudioPlayer::playEventCallback(SLPlayItf caller, void *context, SLuint32 playEvent) noexcept
 {
+    AUDIO_TRACE_SCOPE("AudioPlayer::playEventCallback");
+    int audioId = (int) (intptr_t) context;
+    AudioEngine *engine = AudioEngine::getInstance();
+    if ((playEvent & (SL_PLAYEVENT_HEADATNEWPOS | SL_PLAYEVENT_HEADMOVING)) != 0)
+    {
+        engine->onHeadMoved(audioId, caller);
+    }
     if ((playEvent & SL_PLAYEVENT_HEADATEND) == SL_PLAYEVENT_HEADATEND)
     {
-        int audioId = (int) (intptr_t) context;
-        AudioEngine *engine = AudioEngine::getInstance();
         engine->setHeadAtEnd(audioId);
     }
 }
 
+const std::string &AudioPlayer::getPath() const noexcept
+{
+    return _path;
+}
+
+/**
+ * Key of the AudioPlayerPool: the PCM format for a buffer queue player, the source path otherwise
+ */
+std::string AudioPlayer::makePoolKey(const std::string &fileFullPath, const std::shared_ptr<AudioSample> &sample) noexcept
+{
+    if (sample != nullptr)
+    {
+        return "pcm:" + std::to_string(sample->channels) + ":" + std::to_string(sample->sampleRate);
+    }
+    return fileFullPath;
+}
+
+std::string AudioPlayer::getPoolKey() const noexcept
+{
+    return makePoolKey(_path, _sample);
+}
+
 const int AudioPlayer::getPlayerId() const noexcept
 {
     return _audioId;
@@ -482,19 +1395,66 @@ const bool AudioPlayer::isLooping() const noexcept
     return _loop;
 }
 
-void AudioPlayer::setJavaAudioPlayerObj(const jobject obj) noexcept
+const AudioPlayer::State AudioPlayer::getState() const noexcept
 {
-    JNIEnv *jenv = getJNIEnv();
-    if (jenv != nullptr)
-    {
-        if (_javaAudioPlayerObj != nullptr)
-        {
-            jenv->DeleteGlobalRef(_javaAudioPlayerObj);
-            _javaAudioPlayerObj = nullptr;
-        }
-        if (obj != nullptr)
-        {
-            _javaAudioPlayerObj = jenv->NewGlobalRef(obj);
-        }
-    }
+    return (State) _state.load();
+}
+
+const int AudioPlayer::getPriority() const noexcept
+{
+    return _priority;
+}
+
+/**
+ * How loud the voice is, used to pick the voice to steal between voices of the same priority
+ * Note: A fully panned voice is only heard on one side, a voice of a ducked bus is quieter
+ */
+const float AudioPlayer::getAudibility() const noexcept
+{
+    const float pan = _pan;
+    return _volume * _busGain * (1.f - 0.5f * (pan < 0.f ? -pan : pan));
+}
+
+const int64_t AudioPlayer::getCreatedAt() const noexcept
+{
+    return _createdAt;
+}
+
+/**
+ * True if the voice is rendered by the AudioMixer instead of its own OpenSL player
+ */
+const bool AudioPlayer::isMixed() const noexcept
+{
+    return _mixerVoice >= 0;
+}
+
+const bool AudioPlayer::isStreamed() const noexcept
+{
+    return _stream != nullptr;
+}
+
+const bool AudioPlayer::isFastPath() const noexcept
+{
+    return _isFastPath;
+}
+
+const bool AudioPlayer::isVirtual() const noexcept
+{
+    return _isVirtual;
+}
+
+/**
+ * True if the last realize failed because of the source, another try fails the same way
+ */
+const bool AudioPlayer::isUnplayable() const noexcept
+{
+    return _isUnplayable;
+}
+
+/**
+ * False while a virtual voice backs off after its source failed to realize
+ */
+const bool AudioPlayer::isPromotable(const int64_t now) const noexcept
+{
+    return now >= _promoteAt;
 }
@@ -8,21 +8,39 @@
 #include <string>
 #include <cstdint>
 #include <jni.h>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include "AudioSample.h"
+#include "AudioMixer.h"
+#include "AudioStream.h"
 
 namespace audio
 {
     class AudioPlayer
     {
+    public:
+        enum State
+        {
+            STATE_IDLE = 0,
+            STATE_PLAYING,
+            STATE_PAUSED,
+            STATE_STOPPED
+        };
+
+        static constexpr SLmillisecond POSITION_UPDATE_MS = 10; // while waiting for the first head movement after a play request
+        static constexpr int64_t PROMOTE_BACKOFF_MS = 1000; // a virtual voice whose source failed to realize waits that long before the next promotion
+
     public:
         AudioPlayer();
 
-        AudioPlayer(const AudioPlayer &) = default;
+        AudioPlayer(const AudioPlayer &) = delete;
 
-        AudioPlayer &operator=(const AudioPlayer &) & = default;
+        AudioPlayer &operator=(const AudioPlayer &) & = delete;
 
-        AudioPlayer(AudioPlayer &&) = default;
+        AudioPlayer(AudioPlayer &&) = delete;
 
-        AudioPlayer &operator=(AudioPlayer &&) & = default;
+        AudioPlayer &operator=(AudioPlayer &&) & = delete;
 
         virtual ~AudioPlayer();
 
@@ -31,6 +49,20 @@ namespace audio
 
         bool setVolume(const float volume) noexcept;
 
+        void setBus(const int bus, const float gain) noexcept;
+
+        void setStartParams(const float pan, const float pitch) noexcept;
+
+        bool setBusGain(const float gain) noexcept;
+
+        const int getBus() const noexcept;
+
+        bool requestUpdate() noexcept;
+
+        bool updateParams(const float step) noexcept;
+
+        void markPlayRequested(const int64_t requestedAt) noexcept;
+
         bool play() noexcept;
 
         bool pause() noexcept;
@@ -43,40 +75,169 @@ namespace audio
 
         const bool isHeadAtEnd() const noexcept;
 
+        bool setRetired() noexcept;
+
+        const bool isRetired() const noexcept;
+
         SLuint32 getPrefetchedStatus() noexcept;
 
+        void onHeadMoved(SLPlayItf caller) noexcept;
+
         const bool isPrefetchedSufficient() const noexcept;
 
         const bool isLooping() const noexcept;
 
+        const State getState() const noexcept;
+
         const int getPlayerId() const noexcept;
 
-        void setJavaAudioPlayerObj(const jobject obj) noexcept;
+        const std::string &getPath() const noexcept;
+
+        std::string getPoolKey() const noexcept;
+
+        static std::string makePoolKey(const std::string &fileFullPath, const std::shared_ptr<AudioSample> &sample) noexcept;
+
+        const int getPriority() const noexcept;
+
+        const float getAudibility() const noexcept;
+
+        const int64_t getCreatedAt() const noexcept;
+
+        const bool isVirtual() const noexcept;
+
+        const bool isMixed() const noexcept;
+
+        const bool isStreamed() const noexcept;
+
+        const bool isFastPath() const noexcept;
+
+        const bool isUnplayable() const noexcept;
+
+        const bool isPromotable(const int64_t now) const noexcept;
+
+        bool isVirtualFinished() noexcept;
+
+        SLmillisecond getDuration() noexcept;
 
-        bool initWithEngine(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager, const int audioId, const std::string &fileFullPath, const float volume, const bool loop) noexcept;
+        bool initWithEngine(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager, const int audioId, const std::string &fileFullPath, const std::shared_ptr<AudioSample> &sample, const float volume, const bool loop, const int priority) noexcept;
+
+        bool initVirtual(const int audioId, const std::string &fileFullPath, const std::shared_ptr<AudioSample> &sample, const float volume, const bool loop, const int priority, const SLmillisecond duration) noexcept;
+
+        bool initMixed(AudioMixer *mixer, const int audioId, const std::string &fileFullPath, const std::shared_ptr<AudioSample> &sample, const float volume, const bool loop, const int priority) noexcept;
+
+        bool initStreamed(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager, const int audioId, const std::string &fileFullPath,
+                          const float volume, const bool loop, const int priority, const size_t ringFrames, const size_t lowWatermarkFrames, AudioStream::Counters *counters) noexcept;
+
+        bool virtualize() noexcept;
+
+        bool devirtualize(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager) noexcept;
+
+        bool reset() noexcept;
+
+        bool prefetch(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager, const std::string &fileFullPath, const int timeoutMs) noexcept;
+
+        bool reuse(const int audioId, const std::string &fileFullPath, const std::shared_ptr<AudioSample> &sample, const float volume, const bool loop, const int priority) noexcept;
+
+        bool requeue(SLAndroidSimpleBufferQueueItf bufferQueue) noexcept;
 
     private:
+        bool realize(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager) noexcept;
+
+        bool realizeFd(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, AAssetManager *assetManager) noexcept;
+
+        bool realizeBufferQueue(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject) noexcept;
+
+        bool enqueue(const SLmillisecond offset) noexcept;
+
+        void destroyObjects() noexcept;
+
+        bool configure(const int audioId) noexcept;
+
+        bool applyGain(const float gain) noexcept;
+
+        bool applyPan(const float pan) noexcept;
+
+        bool applyPitch(const float pitch) noexcept;
+
+        void getPlaybackRateInterface() noexcept;
+
+        void waitHeadMoved(const int64_t requestedAt) noexcept;
+
+        SLmillisecond getVirtualPosition() const noexcept;
+
         static void prefetchEventCallback(SLPrefetchStatusItf caller, void *context, SLuint32 prefetchEvent) noexcept;
 
         static void playEventCallback(SLPlayItf caller, void *context, SLuint32 playEvent) noexcept;
 
+        static void bufferQueueCallback(SLAndroidSimpleBufferQueueItf caller, void *context) noexcept;
+
     private:
+        // Guards the OpenSL interfaces: a voice can be virtualized by the engine while a caller uses it
+        std::mutex _mutex;
+
         SLObjectItf _fdPlayerObject;
         SLPlayItf _fdPlayerPlay;
         SLSeekItf _fdPlayerSeek;
         SLVolumeItf _fdPlayerVolume;
         SLPrefetchStatusItf _fdPlayerPrefetchedStatus;
-
-        bool _isHeadAtEnd;
-        bool _isPrefetchedSufficientData;
-
-        bool _loop;
+        SLAndroidSimpleBufferQueueItf _bufferQueue; // Only for decoded samples, the fd players have no queue
+        SLPlaybackRateItf _fdPlayerPlaybackRate; // Optional, nullptr if the device doesn't support it
+
+        // Decoded PCM shared with the AudioSampleCache, enqueued without any copy
+        std::shared_ptr<AudioSample> _sample;
+        SLmillisecond _queueOffset; // where the sample has been enqueued from
+
+        // Voice of the software mixer, the player has no OpenSL object in this case
+        AudioMixer *_mixer;
+        int _mixerVoice;
+
+        // Descriptor of the asset shared with the other players of the path through the AudioAssetCache
+        std::shared_ptr<AudioAsset> _asset;
+
+        // Streaming voice of a long track, it owns its decoder thread and output player
+        std::unique_ptr<AudioStream> _stream;
+
+        // Flags are shared between the callers, the OpenSL callbacks and the GC thread without any lock
+        std::atomic<bool> _isHeadAtEnd;
+        std::atomic<bool> _isPrefetchedSufficientData;
+        std::atomic<bool> _isRetired; // true once pushed in the retire queue of the AudioEngine
+        std::atomic<bool> _isVirtual; // true while the voice is tracked without any OpenSL player
+        std::atomic<bool> _isFastPath; // true while the voice plays through a fast track, written by the stream thread for a stream
+        std::atomic<bool> _isUnplayable; // true if the last realize failed on the source (missing, corrupted or unsupported), not on the platform
+        std::atomic<int64_t> _promoteAt; // nowNanos() before which the engine doesn't try to promote the virtual voice again
+        std::atomic<int> _state;
+
+        std::atomic<bool> _loop;
         int _audioId;
-        int _assetFd;
-        float _volume;
-
-        jobject _javaAudioPlayerObj;
+        int _priority;
+        int64_t _createdAt;
+        std::string _path;
+        std::atomic<float> _volume;
+        std::atomic<float> _pan;
+        std::atomic<float> _pitch;
+
+        // Mix bus given at the creation, its effective gain scales _volume on the output
+        std::atomic<int> _bus;
+        std::atomic<float> _busGain;
+
+        // The setters above only write the latest values, the engine tick ramps the output toward them
+        std::atomic<bool> _paramsDirty; // queued for the next tick
+        float _outputGain; // guarded by _mutex like the rest of the output state
+        float _outputPan;
+        float _outputPitch;
+        SLmillibel _outputLevel; // last SetVolumeLevel, SL_MILLIBEL_MAX while unknown
+        bool _isStereoPosition;
+
+        // Virtual playback clock, guarded by _mutex
+        SLmillisecond _position; // play head when the voice was last virtualized, paused or realized
+        int64_t _playingSince; // nowNanos() when the virtual voice started playing
+        std::atomic<SLmillisecond> _duration;
+
+        // Latency timestamps (nowNanos()), _createdAt is the start of the init
+        std::atomic<int64_t> _playRequestedAt; // play request of the caller, consumed by play()
+        std::atomic<int64_t> _soundRequestedAt; // play request waiting for the first head movement, 0 if none
+        std::atomic<SLmillisecond> _soundStartPosition; // play head when the wait started
     };
 }
 
-#endif
\ No newline at end of file
+#endif
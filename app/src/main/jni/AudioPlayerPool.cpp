@@ -0,0 +1,164 @@
+#include "AudioPlayerPool.h"
+#include "AudioPlayer.h"
+
+using namespace audio;
+
+AudioPlayerPool::AudioPlayerPool() : _capacity(DEFAULT_CAPACITY)
+, _hits(0)
+, _misses(0)
+, _evictions(0)
+{
+}
+
+AudioPlayerPool::~AudioPlayerPool()
+{
+    clear();
+}
+
+/**
+ * Return an idle player realized for this key or nullptr if there is none
+ */
+AudioPlayer *AudioPlayerPool::acquire(const std::string &key) noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto it = _idle.rbegin(); it != _idle.rend(); ++it) // The most recent one is the most likely to be still cached by the platform
+    {
+        if (it->key == key)
+        {
+            AudioPlayer *ret = it->player;
+            _idle.erase(std::next(it).base());
+            ++_hits;
+            return ret;
+        }
+    }
+    ++_misses;
+    return nullptr;
+}
+
+/**
+ * Give back a player that has been reset, the oldest idle player is destroyed if the pool is full
+ */
+void AudioPlayerPool::release(const std::string &key, AudioPlayer *player) noexcept
+{
+    std::vector<AudioPlayer *> evicted;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_capacity == 0)
+        {
+            evicted.push_back(player);
+        }
+        else
+        {
+            while (_idle.size() >= _capacity)
+            {
+                evicted.push_back(_idle.front().player);
+                _idle.pop_front();
+                ++_evictions;
+            }
+            _idle.push_back({key, player});
+        }
+    }
+    for (AudioPlayer *tmp : evicted) // Destroy the OpenSL objects outside of the lock
+    {
+        delete tmp;
+    }
+}
+
+/**
+ * Change the number of idle players kept warm, extra players are destroyed
+ */
+void AudioPlayerPool::setCapacity(const size_t capacity) noexcept
+{
+    std::vector<AudioPlayer *> evicted;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _capacity = capacity;
+        while (_idle.size() > _capacity)
+        {
+            evicted.push_back(_idle.front().player);
+            _idle.pop_front();
+            ++_evictions;
+        }
+    }
+    for (AudioPlayer *tmp : evicted)
+    {
+        delete tmp;
+    }
+}
+
+size_t AudioPlayerPool::getCapacity() const noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capacity;
+}
+
+/**
+ * Destroy the oldest idle player to give an OpenSL player object back to the platform
+ */
+bool AudioPlayerPool::evictOldest() noexcept
+{
+    AudioPlayer *evicted = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_idle.empty())
+        {
+            evicted = _idle.front().player;
+            _idle.pop_front();
+            ++_evictions;
+        }
+    }
+    delete evicted;
+    return evicted != nullptr;
+}
+
+/**
+ * Destroy the idle players of a key, return how many were destroyed
+ */
+size_t AudioPlayerPool::erase(const std::string &key) noexcept
+{
+    std::vector<AudioPlayer *> erased;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto it = _idle.begin(); it != _idle.end();)
+        {
+            if (it->key == key)
+            {
+                erased.push_back(it->player);
+                it = _idle.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    for (AudioPlayer *tmp : erased)
+    {
+        delete tmp;
+    }
+    return erased.size();
+}
+
+void AudioPlayerPool::clear() noexcept
+{
+    std::deque<Entry> idle;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        idle.swap(_idle);
+    }
+    for (const Entry &entry : idle)
+    {
+        delete entry.player;
+    }
+}
+
+AudioPlayerPool::Stats AudioPlayerPool::getStats() const noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Stats stats;
+    stats.hits = _hits;
+    stats.misses = _misses;
+    stats.evictions = _evictions;
+    stats.idle = _idle.size();
+    return stats;
+}
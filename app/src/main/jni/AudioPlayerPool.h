@@ -0,0 +1,80 @@
+#ifndef __AudioPlayerPool__
+#define __AudioPlayerPool__
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+namespace audio
+{
+    class AudioPlayer;
+
+    /**
+     * Keep realized AudioPlayers warm once they finished playing so the next play of the same source skips CreateAudioPlayer/Realize
+     * An OpenSL player is bound to its data source, so the key is the source path
+     */
+    class AudioPlayerPool
+    {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 8;
+
+        struct Stats
+        {
+            uint64_t hits;
+            uint64_t misses;
+            uint64_t evictions;
+            size_t idle;
+        };
+
+    private:
+        struct Entry
+        {
+            std::string key;
+            AudioPlayer *player;
+        };
+
+    public:
+        AudioPlayerPool();
+
+        AudioPlayerPool(const AudioPlayerPool &) = delete;
+
+        AudioPlayerPool &operator=(const AudioPlayerPool &) & = delete;
+
+        AudioPlayerPool(AudioPlayerPool &&) = delete;
+
+        AudioPlayerPool &operator=(AudioPlayerPool &&) & = delete;
+
+        ~AudioPlayerPool();
+
+    public:
+        AudioPlayer *acquire(const std::string &key) noexcept;
+
+        void release(const std::string &key, AudioPlayer *player) noexcept;
+
+        void setCapacity(const size_t capacity) noexcept;
+
+        size_t getCapacity() const noexcept;
+
+        bool evictOldest() noexcept;
+
+        size_t erase(const std::string &key) noexcept;
+
+        void clear() noexcept;
+
+        Stats getStats() const noexcept;
+
+    private:
+        mutable std::mutex _mutex;
+        std::deque<Entry> _idle; // the oldest released player is at the front
+        size_t _capacity;
+
+        uint64_t _hits;
+        uint64_t _misses;
+        uint64_t _evictions;
+    };
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include "AudioPreloader.h"
+#include "AudioEngine.h"
+#include <utility>
+
+using namespace audio;
+
+AudioPreloader::AudioPreloader(std::function<bool(const std::string &)> load) : _load(std::move(load))
+, _stop(false)
+, _nextBatchId(1)
+{
+}
+
+AudioPreloader::~AudioPreloader()
+{
+    stop();
+}
+
+/**
+ * Queue a batch of paths, return its id
+ * An empty batch is reported as loaded right away on the caller thread
+ */
+int AudioPreloader::preload(const std::vector<std::string> &paths, std::unique_ptr<Listener> listener) noexcept
+{
+    const int ret = _nextBatchId++;
+    if (paths.empty())
+    {
+        if (listener != nullptr)
+        {
+            listener->onBatchLoaded(ret, 0, 0);
+        }
+        return ret;
+    }
+
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+    batch->id = ret;
+    batch->listener = std::move(listener);
+    batch->pending = paths.size();
+    batch->loaded = 0;
+    batch->failed = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stop)
+        {
+            return -1;
+        }
+        for (const std::string &path : paths)
+        {
+            _jobs.push_back({batch, path});
+        }
+        while (_threads.size() < THREAD_COUNT)
+        {
+            _threads.emplace_back(&AudioPreloader::run, this);
+        }
+    }
+    _condition.notify_all();
+    return ret;
+}
+
+/**
+ * Join the preload threads, the batches not done yet are dropped without any notification
+ */
+void AudioPreloader::stop() noexcept
+{
+    std::vector<std::thread> threads;
+    std::deque<Job> jobs;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+        threads.swap(_threads);
+        jobs.swap(_jobs);
+    }
+    _condition.notify_all();
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+/**
+ * Preload thread: load the paths in the order they were queued
+ */
+void AudioPreloader::run() noexcept
+{
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+            if (_stop)
+            {
+                break;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        const bool loaded = _load(job.path);
+        Batch &batch = *job.batch;
+        if (loaded)
+        {
+            ++batch.loaded;
+        }
+        else
+        {
+            ++batch.failed;
+        }
+        if (batch.listener != nullptr)
+        {
+            batch.listener->onPathLoaded(batch.id, job.path, loaded);
+        }
+        if (--batch.pending == 0 && batch.listener != nullptr) // Every onPathLoaded of the batch happened before
+        {
+            batch.listener->onBatchLoaded(batch.id, batch.loaded, batch.failed);
+        }
+    }
+    detachJNIEnv(); // The listeners attached the thread to the JavaVM
+}
@@ -0,0 +1,90 @@
+#ifndef __AudioPreloader__
+#define __AudioPreloader__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+namespace audio
+{
+    /**
+     * Background threads warming batches of paths before their first play
+     * Each path is loaded by the function given to the constructor, the listener of its batch hears about the path then about the batch
+     */
+    class AudioPreloader
+    {
+    public:
+        static constexpr size_t THREAD_COUNT = 2;
+
+        /**
+         * Called from the preload threads, onPathLoaded can run on several threads at once
+         * onBatchLoaded is the last call, the listener is deleted right after it
+         */
+        class Listener
+        {
+        public:
+            virtual ~Listener()
+            {
+            }
+
+            virtual void onPathLoaded(const int batchId, const std::string &fileFullPath, const bool loaded) noexcept = 0;
+
+            virtual void onBatchLoaded(const int batchId, const int loaded, const int failed) noexcept = 0;
+        };
+
+    private:
+        struct Batch
+        {
+            int id;
+            std::unique_ptr<Listener> listener;
+            std::atomic<size_t> pending;
+            std::atomic<int> loaded;
+            std::atomic<int> failed;
+        };
+
+        struct Job
+        {
+            std::shared_ptr<Batch> batch;
+            std::string path;
+        };
+
+    public:
+        explicit AudioPreloader(std::function<bool(const std::string &)> load);
+
+        AudioPreloader(const AudioPreloader &) = delete;
+
+        AudioPreloader &operator=(const AudioPreloader &) & = delete;
+
+        AudioPreloader(AudioPreloader &&) = delete;
+
+        AudioPreloader &operator=(AudioPreloader &&) & = delete;
+
+        ~AudioPreloader();
+
+    public:
+        int preload(const std::vector<std::string> &paths, std::unique_ptr<Listener> listener) noexcept;
+
+        void stop() noexcept;
+
+    private:
+        void run() noexcept;
+
+    private:
+        std::function<bool(const std::string &)> _load;
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        std::deque<Job> _jobs; // guarded by _mutex
+        std::vector<std::thread> _threads; // started by the first batch
+        bool _stop; // guarded by _mutex
+        std::atomic<int> _nextBatchId;
+    };
+}
+
+#endif
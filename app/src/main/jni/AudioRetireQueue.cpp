@@ -0,0 +1,70 @@
+#include "AudioRetireQueue.h"
+
+using namespace audio;
+
+AudioRetireQueue::AudioRetireQueue() : _tail(0)
+, _head(0)
+{
+    for (uint32_t i = 0; i < CAPACITY; ++i)
+    {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+AudioRetireQueue::~AudioRetireQueue()
+{
+}
+
+/**
+ * Enqueue a finished audioId, return false if the queue is full
+ */
+bool AudioRetireQueue::push(const int audioId, const int64_t retiredAt) noexcept
+{
+    uint32_t position = _tail.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell &cell = _cells[position & (CAPACITY - 1)];
+        const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const int32_t diff = (int32_t) (sequence - position);
+        if (diff == 0)
+        {
+            if (_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                cell.entry.audioId = audioId;
+                cell.entry.retiredAt = retiredAt;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) // The consumer didn't free this cell yet
+        {
+            return false;
+        }
+        else
+        {
+            position = _tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Dequeue the oldest finished audioId, must only be called by the reclaim thread
+ */
+bool AudioRetireQueue::pop(Entry &entry) noexcept
+{
+    Cell &cell = _cells[_head & (CAPACITY - 1)];
+    const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != _head + 1)
+    {
+        return false;
+    }
+    entry = cell.entry;
+    cell.sequence.store(_head + CAPACITY, std::memory_order_release);
+    ++_head;
+    return true;
+}
+
+bool AudioRetireQueue::empty() const noexcept
+{
+    return _cells[_head & (CAPACITY - 1)].sequence.load(std::memory_order_acquire) != _head + 1;
+}
@@ -0,0 +1,59 @@
+#ifndef __AudioRetireQueue__
+#define __AudioRetireQueue__
+
+#include <atomic>
+#include <cstdint>
+
+namespace audio
+{
+    /**
+     * Bounded lock-free multi-producer single-consumer queue of finished audioIds
+     * Producers are the OpenSL callbacks and the callers of AudioPlayer::stop, the consumer is the reclaim thread
+     * push() never allocates so it is safe to call from an OpenSL callback
+     */
+    class AudioRetireQueue
+    {
+    public:
+        static constexpr uint32_t CAPACITY = 8192; // Must be a power of 2
+
+        struct Entry
+        {
+            int audioId;
+            int64_t retiredAt; // steady_clock in nanoseconds
+        };
+
+    private:
+        struct Cell
+        {
+            std::atomic<uint32_t> sequence;
+            Entry entry;
+        };
+
+    public:
+        AudioRetireQueue();
+
+        AudioRetireQueue(const AudioRetireQueue &) = delete;
+
+        AudioRetireQueue &operator=(const AudioRetireQueue &) & = delete;
+
+        AudioRetireQueue(AudioRetireQueue &&) = delete;
+
+        AudioRetireQueue &operator=(AudioRetireQueue &&) & = delete;
+
+        ~AudioRetireQueue();
+
+    public:
+        bool push(const int audioId, const int64_t retiredAt) noexcept;
+
+        bool pop(Entry &entry) noexcept;
+
+        bool empty() const noexcept;
+
+    private:
+        Cell _cells[CAPACITY];
+        std::atomic<uint32_t> _tail; // next position written by the producers
+        uint32_t _head; // next position read by the single consumer
+    };
+}
+
+#endif
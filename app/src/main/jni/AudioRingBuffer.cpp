@@ -0,0 +1,74 @@
+#include "AudioRingBuffer.h"
+#include <cstring>
+
+using namespace audio;
+
+AudioRingBuffer::AudioRingBuffer() : _capacity(0)
+, _written(0)
+, _read(0)
+{
+}
+
+AudioRingBuffer::~AudioRingBuffer()
+{
+}
+
+/**
+ * Allocate capacity samples and empty the ring, neither the producer nor the consumer may run
+ */
+void AudioRingBuffer::reset(const size_t capacity)
+{
+    _data.assign(capacity, 0);
+    _capacity = capacity;
+    _written.store(0, std::memory_order_relaxed);
+    _read.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * Producer side: copy up to count samples, return the number of samples written
+ */
+size_t AudioRingBuffer::write(const int16_t *data, const size_t count) noexcept
+{
+    const uint64_t written = _written.load(std::memory_order_relaxed);
+    const uint64_t read = _read.load(std::memory_order_acquire);
+    const size_t free = _capacity - (size_t) (written - read);
+    const size_t n = count < free ? count : free;
+    const size_t offset = (size_t) (written % _capacity);
+    const size_t first = n < _capacity - offset ? n : _capacity - offset;
+    memcpy(&_data[offset], data, first * sizeof(int16_t));
+    memcpy(&_data[0], data + first, (n - first) * sizeof(int16_t));
+    _written.store(written + n, std::memory_order_release);
+    return n;
+}
+
+/**
+ * Consumer side: copy up to count samples, return the number of samples read
+ */
+size_t AudioRingBuffer::read(int16_t *data, const size_t count) noexcept
+{
+    const uint64_t read = _read.load(std::memory_order_relaxed);
+    const uint64_t written = _written.load(std::memory_order_acquire);
+    const size_t used = (size_t) (written - read);
+    const size_t n = count < used ? count : used;
+    const size_t offset = (size_t) (read % _capacity);
+    const size_t first = n < _capacity - offset ? n : _capacity - offset;
+    memcpy(data, &_data[offset], first * sizeof(int16_t));
+    memcpy(data + first, &_data[0], (n - first) * sizeof(int16_t));
+    _read.store(read + n, std::memory_order_release);
+    return n;
+}
+
+size_t AudioRingBuffer::available() const noexcept
+{
+    return (size_t) (_written.load(std::memory_order_acquire) - _read.load(std::memory_order_acquire));
+}
+
+size_t AudioRingBuffer::space() const noexcept
+{
+    return _capacity - available();
+}
+
+size_t AudioRingBuffer::getCapacity() const noexcept
+{
+    return _capacity;
+}
@@ -0,0 +1,56 @@
+#ifndef __AudioRingBuffer__
+#define __AudioRingBuffer__
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace audio
+{
+    /**
+     * Lock-free single-producer single-consumer ring of PCM samples
+     * The producer is the decoder of an AudioStream, the consumer its OpenSL buffer queue callback
+     * write() and read() never allocate nor block
+     */
+    class AudioRingBuffer
+    {
+    public:
+        AudioRingBuffer();
+
+        AudioRingBuffer(const AudioRingBuffer &) = delete;
+
+        AudioRingBuffer &operator=(const AudioRingBuffer &) & = delete;
+
+        AudioRingBuffer(AudioRingBuffer &&) = delete;
+
+        AudioRingBuffer &operator=(AudioRingBuffer &&) & = delete;
+
+        ~AudioRingBuffer();
+
+    public:
+        void reset(const size_t capacity);
+
+        size_t write(const int16_t *data, const size_t count) noexcept;
+
+        size_t read(int16_t *data, const size_t count) noexcept;
+
+        size_t available() const noexcept;
+
+        size_t space() const noexcept;
+
+        size_t getCapacity() const noexcept;
+
+    private:
+        std::vector<int16_t> _data;
+        size_t _capacity;
+
+        // Total of samples written and read, padded apart as each one is written by a single thread
+        // Note: no alignas, the heap of C++14 doesn't honor extended alignments
+        std::atomic<uint64_t> _written;
+        char _padding[64 - sizeof(std::atomic<uint64_t>)];
+        std::atomic<uint64_t> _read;
+    };
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef __AudioSample__
+#define __AudioSample__
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace audio
+{
+    /**
+     * Decoded sound shared by all the players of the same asset
+     * The PCM is interleaved signed 16 bits, it's never modified once decoded so players can enqueue it without copy
+     * A sample of a sound bank owns no PCM: it points into the mapping of the bank and keeps the bank alive
+     */
+    struct AudioSample
+    {
+        std::vector<int16_t> pcm;
+        uint32_t channels;
+        uint32_t sampleRate; // in Hz
+
+        const int16_t *view = nullptr; // PCM of a sound bank, pcm is empty in this case
+        size_t viewSamples = 0;
+        std::shared_ptr<const void> owner; // the sound bank of the view
+
+        const int16_t *getData() const noexcept
+        {
+            return view != nullptr ? view : pcm.data();
+        }
+
+        size_t getSamples() const noexcept
+        {
+            return view != nullptr ? viewSamples : pcm.size();
+        }
+
+        size_t getFrames() const noexcept
+        {
+            return channels > 0 ? getSamples() / channels : 0;
+        }
+
+        size_t getBytes() const noexcept
+        {
+            return getSamples() * sizeof(int16_t);
+        }
+
+        uint32_t getDurationMs() const noexcept
+        {
+            return sampleRate > 0 ? (uint32_t) ((uint64_t) getFrames() * 1000 / sampleRate) : 0;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,176 @@
+#include "AudioSampleCache.h"
+#include "AudioDecoder.h"
+#include "AudioUtils.h"
+#include <unistd.h>
+
+using namespace audio;
+
+AudioSampleCache::AudioSampleCache() : _threshold(DEFAULT_THRESHOLD)
+, _capacity(DEFAULT_CAPACITY)
+, _sampleRate(0)
+, _bytes(0)
+, _clock(0)
+, _hits(0)
+, _misses(0)
+, _evictions(0)
+{
+}
+
+AudioSampleCache::~AudioSampleCache()
+{
+    clear();
+}
+
+/**
+ * Return the decoded asset, decoding it on the first call
+ * Return nullptr if the asset must be streamed: absolute path, bigger than the threshold or not decodable
+ */
+std::shared_ptr<AudioSample> AudioSampleCache::get(const std::string &fileFullPath, const SLEngineItf &engineEngine, AAssetManager *assetManager) noexcept
+{
+    if (fileFullPath.empty() || fileFullPath[0] == '/' || assetManager == nullptr)
+    {
+        return nullptr;
+    }
+
+    size_t threshold = 0;
+    SLuint32 sampleRate = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto &it = _samples.find(fileFullPath);
+        if (it != _samples.end())
+        {
+            it->second.lastUse = ++_clock;
+            ++_hits;
+            return it->second.sample;
+        }
+        if (_streamed.count(fileFullPath) > 0)
+        {
+            return nullptr;
+        }
+        ++_misses;
+        threshold = _threshold;
+        sampleRate = _sampleRate;
+    }
+
+    // Decode outside of the lock, it takes a few ms
+    std::shared_ptr<AudioSample> sample;
+    AAsset *asset = AAssetManager_open(assetManager, assetRelativePath(fileFullPath).c_str(), AASSET_MODE_UNKNOWN);
+    if (asset != nullptr)
+    {
+        if ((size_t) AAsset_getLength64(asset) <= threshold)
+        {
+            off64_t start = 0, length = 0;
+            const int fd = AAsset_openFileDescriptor64(asset, &start, &length);
+            if (fd > 0)
+            {
+                sample = AudioDecoder::decode(engineEngine, fd, start, length);
+                close(fd);
+                sample = AudioDecoder::resample(sample, sampleRate);
+            }
+        }
+        AAsset_close(asset);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (sample == nullptr)
+    {
+        _streamed.insert(fileFullPath);
+        return nullptr;
+    }
+    const auto &it = _samples.find(fileFullPath);
+    if (it != _samples.end()) // Decoded by another thread in the meantime
+    {
+        return it->second.sample;
+    }
+    _samples[fileFullPath] = {sample, ++_clock};
+    _bytes += sample->getBytes();
+    evict();
+    return sample;
+}
+
+/**
+ * Drop the least recently used samples until the cache fits its capacity, _mutex must be held
+ * Note: A sample still enqueued by a player stays alive until the player releases it
+ */
+void AudioSampleCache::evict() noexcept
+{
+    while (_bytes > _capacity && _samples.size() > 1)
+    {
+        auto oldest = _samples.begin();
+        for (auto it = _samples.begin(); it != _samples.end(); ++it)
+        {
+            if (it->second.lastUse < oldest->second.lastUse)
+            {
+                oldest = it;
+            }
+        }
+        _bytes -= oldest->second.sample->getBytes();
+        _samples.erase(oldest);
+        ++_evictions;
+    }
+}
+
+/**
+ * Assets with a compressed size bigger than the threshold are streamed from their fd instead of decoded
+ */
+void AudioSampleCache::setThreshold(const size_t threshold) noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _threshold = threshold;
+    _streamed.clear();
+}
+
+void AudioSampleCache::setCapacity(const size_t capacity) noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _capacity = capacity;
+    evict();
+}
+
+/**
+ * Decode the next samples at the output rate, their players can get a fast track
+ * Note: The samples already decoded keep their rate
+ */
+void AudioSampleCache::setSampleRate(const SLuint32 sampleRate) noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _sampleRate = sampleRate;
+}
+
+/**
+ * Forget an asset, return false if it wasn't decoded
+ * Note: A sample still enqueued by a player stays alive until the player releases it
+ */
+bool AudioSampleCache::remove(const std::string &fileFullPath) noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _streamed.erase(fileFullPath);
+    const auto &it = _samples.find(fileFullPath);
+    if (it == _samples.end())
+    {
+        return false;
+    }
+    _bytes -= it->second.sample->getBytes();
+    _samples.erase(it);
+    return true;
+}
+
+void AudioSampleCache::clear() noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _samples.clear();
+    _streamed.clear();
+    _bytes = 0;
+}
+
+AudioSampleCache::Stats AudioSampleCache::getStats() const noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Stats stats;
+    stats.hits = _hits;
+    stats.misses = _misses;
+    stats.evictions = _evictions;
+    stats.bytes = _bytes;
+    stats.samples = _samples.size();
+    return stats;
+}
@@ -0,0 +1,90 @@
+#ifndef __AudioSampleCache__
+#define __AudioSampleCache__
+
+#include <SLES/OpenSLES.h>
+#include <android/asset_manager.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+#include "AudioSample.h"
+
+namespace audio
+{
+    /**
+     * Path keyed cache of decoded short assets
+     * Assets bigger than the threshold (compressed size) keep streaming from their fd
+     */
+    class AudioSampleCache
+    {
+    public:
+        static constexpr size_t DEFAULT_THRESHOLD = 64 * 1024;
+        static constexpr size_t DEFAULT_CAPACITY = 8 * 1024 * 1024; // decoded bytes
+
+        struct Stats
+        {
+            uint64_t hits;
+            uint64_t misses;
+            uint64_t evictions;
+            size_t bytes;
+            size_t samples;
+        };
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr<AudioSample> sample;
+            uint64_t lastUse;
+        };
+
+    public:
+        AudioSampleCache();
+
+        AudioSampleCache(const AudioSampleCache &) = delete;
+
+        AudioSampleCache &operator=(const AudioSampleCache &) & = delete;
+
+        AudioSampleCache(AudioSampleCache &&) = delete;
+
+        AudioSampleCache &operator=(AudioSampleCache &&) & = delete;
+
+        ~AudioSampleCache();
+
+    public:
+        std::shared_ptr<AudioSample> get(const std::string &fileFullPath, const SLEngineItf &engineEngine, AAssetManager *assetManager) noexcept;
+
+        void setThreshold(const size_t threshold) noexcept;
+
+        void setCapacity(const size_t capacity) noexcept;
+
+        void setSampleRate(const SLuint32 sampleRate) noexcept;
+
+        bool remove(const std::string &fileFullPath) noexcept;
+
+        void clear() noexcept;
+
+        Stats getStats() const noexcept;
+
+    private:
+        void evict() noexcept;
+
+    private:
+        mutable std::mutex _mutex;
+        std::unordered_map<std::string, Entry> _samples;
+        std::unordered_set<std::string> _streamed; // assets too big or that failed to decode
+        size_t _threshold;
+        size_t _capacity;
+        SLuint32 _sampleRate; // rate of the decoded samples, 0 keeps the rate of the source
+        size_t _bytes;
+        uint64_t _clock;
+
+        uint64_t _hits;
+        uint64_t _misses;
+        uint64_t _evictions;
+    };
+}
+
+#endif
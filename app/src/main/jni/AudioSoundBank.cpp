@@ -0,0 +1,102 @@
+#include "AudioSoundBank.h"
+#include "AudioUtils.h"
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace audio;
+
+AudioSoundBank::AudioSoundBank(void *mapping, const size_t mappingLength, const uint8_t *data, const size_t length) noexcept : _mapping(mapping)
+, _mappingLength(mappingLength)
+, _data(data)
+, _length(length)
+, _header(reinterpret_cast<const Header *>(data))
+, _index(reinterpret_cast<const Entry *>(data + reinterpret_cast<const Header *>(data)->indexOffset))
+{
+}
+
+AudioSoundBank::~AudioSoundBank()
+{
+    munmap(_mapping, _mappingLength);
+}
+
+/**
+ * Map the bank stored at [start, start + length) of the fd, return nullptr if it's not a valid bank
+ * Only the header is read: the cost doesn't depend on the number of sounds, the fd can be closed afterwards
+ */
+std::shared_ptr<AudioSoundBank> AudioSoundBank::map(const int fd, const off64_t start, const off64_t length) noexcept
+{
+    if (fd <= 0 || start < 0 || length < (off64_t) sizeof(Header))
+    {
+        return nullptr;
+    }
+    const off64_t page = sysconf(_SC_PAGESIZE);
+    const off64_t base = start - start % page; // mmap only takes page aligned offsets
+    const size_t mappingLength = (size_t) (start - base + length);
+    void *mapping = mmap(nullptr, mappingLength, PROT_READ, MAP_PRIVATE, fd, (off_t) base);
+    if (mapping == MAP_FAILED)
+    {
+        LOGEX("mmap fail");
+        return nullptr;
+    }
+
+    const uint8_t *data = static_cast<const uint8_t *>(mapping) + (start - base);
+    const Header *header = reinterpret_cast<const Header *>(data);
+    const uint64_t indexBytes = (uint64_t) header->slots * sizeof(Entry);
+    if (header->magic != MAGIC || header->version != VERSION
+        || header->slots == 0 || (header->slots & (header->slots - 1)) != 0 || header->count >= header->slots
+        || header->indexOffset % sizeof(uint64_t) != 0 || header->indexOffset < sizeof(Header)
+        || header->indexOffset + indexBytes > (uint64_t) length)
+    {
+        LOGEX("AudioSoundBank header fail");
+        munmap(mapping, mappingLength);
+        return nullptr;
+    }
+    return std::shared_ptr<AudioSoundBank>(new AudioSoundBank(mapping, mappingLength, data, (size_t) length));
+}
+
+/**
+ * Return a sample viewing the PCM of the sound in the mapping, nullptr if the bank doesn't have it
+ * The entry is checked against the bank here rather than when mapping, so mapping never walks the index
+ */
+std::shared_ptr<AudioSample> AudioSoundBank::find(const std::string &fileFullPath) noexcept
+{
+    const uint64_t key = hash(assetRelativePath(fileFullPath));
+    const uint32_t mask = _header->slots - 1;
+    for (uint32_t i = 0, slot = (uint32_t) key & mask; i < _header->slots; ++i, slot = (slot + 1) & mask)
+    {
+        const Entry &entry = _index[slot];
+        if (entry.hash == 0)
+        {
+            break;
+        }
+        if (entry.hash != key)
+        {
+            continue;
+        }
+        const uint64_t bytes = (uint64_t) entry.frames * entry.channels * sizeof(int16_t);
+        if (entry.channels == 0 || entry.channels > 2 || entry.sampleRate == 0 || entry.frames == 0
+            || entry.offset % sizeof(int16_t) != 0 || entry.offset + bytes > _length)
+        {
+            LOGEX("AudioSoundBank entry fail");
+            return nullptr;
+        }
+        std::shared_ptr<AudioSample> ret = std::make_shared<AudioSample>();
+        ret->channels = entry.channels;
+        ret->sampleRate = entry.sampleRate;
+        ret->view = reinterpret_cast<const int16_t *>(_data + entry.offset);
+        ret->viewSamples = (size_t) entry.frames * entry.channels;
+        ret->owner = shared_from_this(); // The mapping lives as long as a player holds the sample
+        return ret;
+    }
+    return nullptr;
+}
+
+size_t AudioSoundBank::getCount() const noexcept
+{
+    return _header->count;
+}
+
+size_t AudioSoundBank::getBytes() const noexcept
+{
+    return _length;
+}
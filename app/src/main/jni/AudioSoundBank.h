@@ -0,0 +1,97 @@
+#ifndef __AudioSoundBank__
+#define __AudioSoundBank__
+
+#include <sys/types.h>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "AudioSample.h"
+
+namespace audio
+{
+    /**
+     * Read-only bank of PCM sounds mapped in memory with a single mmap, its samples are views on the mapping
+     * Layout, little endian:
+     * - Header at offset 0
+     * - Open addressing table of Header::slots Entry at Header::indexOffset, an empty slot has a hash of 0
+     * - Interleaved signed 16 bits PCM of each entry at Entry::offset, aligned on 16 bytes
+     * A sound is found in O(1) from the hash of its asset relative path (linear probing from hash & (slots - 1))
+     * Note: The bank must be stored uncompressed in the APK to be opened as fd
+     */
+    class AudioSoundBank : public std::enable_shared_from_this<AudioSoundBank>
+    {
+    public:
+        static constexpr uint32_t MAGIC = 0x4b4e4241; // "ABNK"
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint32_t DATA_ALIGNMENT = 16;
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t slots; // power of 2, at least twice the number of sounds
+            uint32_t count;
+            uint64_t indexOffset;
+            uint64_t reserved;
+        };
+
+        struct Entry
+        {
+            uint64_t hash;
+            uint64_t offset; // from the beginning of the bank
+            uint32_t frames;
+            uint32_t sampleRate;
+            uint32_t channels;
+            uint32_t reserved;
+        };
+
+    public:
+        AudioSoundBank(const AudioSoundBank &) = delete;
+
+        AudioSoundBank &operator=(const AudioSoundBank &) & = delete;
+
+        AudioSoundBank(AudioSoundBank &&) = delete;
+
+        AudioSoundBank &operator=(AudioSoundBank &&) & = delete;
+
+        ~AudioSoundBank();
+
+    public:
+        static std::shared_ptr<AudioSoundBank> map(const int fd, const off64_t start, const off64_t length) noexcept;
+
+        /**
+         * 64 bits FNV-1a of the asset relative path, 0 is reserved for the empty slots
+         * Inline so the asset conditioner writes the same keys without the Android sources
+         */
+        static uint64_t hash(const std::string &name) noexcept
+        {
+            uint64_t ret = 14695981039346656037ULL;
+            for (const char c : name)
+            {
+                ret ^= (uint8_t) c;
+                ret *= 1099511628211ULL;
+            }
+            return ret != 0 ? ret : 1;
+        }
+
+        std::shared_ptr<AudioSample> find(const std::string &fileFullPath) noexcept;
+
+        size_t getCount() const noexcept;
+
+        size_t getBytes() const noexcept;
+
+    private:
+        AudioSoundBank(void *mapping, const size_t mappingLength, const uint8_t *data, const size_t length) noexcept;
+
+    private:
+        void *_mapping; // page aligned, the bank starts at _data
+        size_t _mappingLength;
+        const uint8_t *_data;
+        size_t _length;
+        const Header *_header;
+        const Entry *_index;
+    };
+}
+
+#endif
@@ -0,0 +1,499 @@
+#include "AudioStream.h"
+#include "AudioDecoder.h"
+#include "AudioEngine.h"
+#include "AudioFastPath.h"
+#include "AudioGain.h"
+#include "AudioMetrics.h"
+#include "AudioTrace.h"
+#include "AudioUtils.h"
+#include <cstring>
+#include <cmath>
+
+using namespace audio;
+
+AudioStream::AudioStream() : _engineEngine(nullptr)
+, _outputMixObject(nullptr)
+, _audioId(-1)
+, _loop(false)
+, _counters(nullptr)
+, _fastPath(nullptr)
+, _decoderObject(nullptr)
+, _decoderPlay(nullptr)
+, _decoderQueue(nullptr)
+, _decoderMetadata(nullptr)
+, _decoderStalled(false)
+, _decoderEnded(false)
+, _lowWatermarkFrames(DEFAULT_LOW_WATERMARK_FRAMES)
+, _outputObject(nullptr)
+, _outputPlay(nullptr)
+, _outputQueue(nullptr)
+, _outputVolume(nullptr)
+, _outputPlaybackRate(nullptr)
+, _channels(0)
+, _bufferFrames(BUFFER_FRAMES)
+, _bufferNs(0)
+, _next(0)
+, _finished(false)
+, _ended(false)
+, _request(REQUEST_IDLE)
+, _playRequestedAt(0)
+, _volume(1.f)
+, _pan(0.f)
+, _pitch(1.f)
+, _refill(false)
+, _exit(false)
+{
+}
+
+AudioStream::~AudioStream()
+{
+    _exit = true;
+    wake();
+    if (_thread.joinable())
+    {
+        _thread.join(); // The thread destroys the decoder and the output before leaving
+    }
+}
+
+/**
+ * Hold the asset and start the decoder thread, the output is created once the ring is primed
+ * Note: ringFrames and lowWatermarkFrames are in frames, the ring is sized for stereo
+ */
+bool AudioStream::init(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, const std::shared_ptr<AudioAsset> &asset, const int audioId,
+                       const bool loop, const size_t ringFrames, const size_t lowWatermarkFrames, Counters *counters, std::atomic<bool> *fastPath)
+{
+    if (engineEngine == nullptr || outputMixObject == nullptr || asset == nullptr || counters == nullptr || fastPath == nullptr)
+    {
+        return false;
+    }
+    _asset = asset;
+    _engineEngine = engineEngine;
+    _outputMixObject = outputMixObject;
+    _audioId = audioId;
+    _loop = loop;
+    _counters = counters;
+    _fastPath = fastPath;
+
+    const size_t frames = ringFrames < DECODE_SAMPLES * 2 ? DECODE_SAMPLES * 2 : ringFrames; // at least 2 decoder buffers in mono
+    _ring.reset(frames * 2);
+    _lowWatermarkFrames = lowWatermarkFrames < frames ? lowWatermarkFrames : frames / 2;
+
+    ++_counters->active;
+    _thread = std::thread(&AudioStream::run, this);
+    return true;
+}
+
+/**
+ * Decoder thread: prime the ring, open the output, then restart the decoder each time the ring drains under the low watermark
+ */
+void AudioStream::run() noexcept
+{
+    bool ready = openDecoder();
+    if (ready)
+    {
+        const int64_t deadline = nowNanos() + (int64_t) PREROLL_TIMEOUT_MS * 1000000;
+        std::unique_lock<std::mutex> lock(_threadMutex);
+        while (!_exit && !_decoderStalled && !_decoderEnded && nowNanos() < deadline)
+        {
+            _condition.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+    if (ready && !_exit)
+    {
+        // The decoder outputs the format of the source, it's known once the first buffer is decoded
+        const SLuint32 channels = AudioDecoder::getMetadataValue(_decoderMetadata, ANDROID_KEY_PCMFORMAT_NUMCHANNELS);
+        const SLuint32 sampleRate = AudioDecoder::getMetadataValue(_decoderMetadata, ANDROID_KEY_PCMFORMAT_SAMPLERATE);
+        ready = channels > 0 && channels <= 2 && sampleRate > 0 && openOutput(channels, sampleRate);
+        if (!ready)
+        {
+            LOGEX("openOutput fail");
+        }
+    }
+    if (!ready && !_exit && !_ended.exchange(true)) // Let the engine reclaim the voice
+    {
+        AudioEngine::getInstance()->setHeadAtEnd(_audioId);
+    }
+
+    while (ready && !_exit)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_threadMutex);
+            // The callbacks notify without the lock, the timeout bounds a lost wake up
+            _condition.wait_for(lock, std::chrono::milliseconds(20), [this]()
+            {
+                return _exit || _refill || (_decoderEnded && !_finished);
+            });
+        }
+        if (_decoderEnded && !_finished)
+        {
+            if (_loop && !_exit)
+            {
+                closeDecoder();
+                _finished = !openDecoder();
+            }
+            else
+            {
+                _finished = true;
+            }
+        }
+        if (_refill.exchange(false) && _decoderStalled.exchange(false))
+        {
+            memset(_decodeBuffer, 0, sizeof(_decodeBuffer));
+            if (SL_RESULT_SUCCESS != (*_decoderQueue)->Enqueue(_decoderQueue, _decodeBuffer, sizeof(_decodeBuffer)))
+            {
+                LOGEX("Enqueue _decoderQueue fail");
+                _finished = true;
+            }
+            _counters->refills.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    closeDecoder();
+    closeOutput();
+    --_counters->active;
+}
+
+/**
+ * Create the decoder on the fd and start it with an empty buffer
+ */
+bool AudioStream::openDecoder() noexcept
+{
+    SLDataLocator_AndroidFD loc_fd = {SL_DATALOCATOR_ANDROIDFD, _asset->fd, _asset->start, _asset->length};
+    SLDataFormat_MIME format_mime = {SL_DATAFORMAT_MIME, NULL, SL_CONTAINERTYPE_UNSPECIFIED};
+    SLDataSource audioSrc = {&loc_fd, &format_mime};
+
+    SLDataLocator_AndroidSimpleBufferQueue loc_bq = {SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, 1};
+    SLDataFormat_PCM format_pcm = {SL_DATAFORMAT_PCM, 2, SL_SAMPLINGRATE_44_1, SL_PCMSAMPLEFORMAT_FIXED_16, SL_PCMSAMPLEFORMAT_FIXED_16, SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT, SL_BYTEORDER_LITTLEENDIAN};
+    SLDataSink audioSnk = {&loc_bq, &format_pcm};
+
+    const SLInterfaceID ids[2] = {SL_IID_ANDROIDSIMPLEBUFFERQUEUE, SL_IID_METADATAEXTRACTION};
+    const SLboolean req[2] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE};
+    SLresult result = (*_engineEngine)->CreateAudioPlayer(_engineEngine, &_decoderObject, &audioSrc, &audioSnk, 2, ids, req);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("CreateAudioPlayer _decoderObject fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_CREATE_PLAYER);
+        _decoderObject = nullptr;
+        return false;
+    }
+    _decoderStalled = false;
+    _decoderEnded = false;
+    if (SL_RESULT_SUCCESS != (*_decoderObject)->Realize(_decoderObject, SL_BOOLEAN_FALSE)
+        || SL_RESULT_SUCCESS != (*_decoderObject)->GetInterface(_decoderObject, SL_IID_PLAY, &_decoderPlay)
+        || SL_RESULT_SUCCESS != (*_decoderObject)->GetInterface(_decoderObject, SL_IID_ANDROIDSIMPLEBUFFERQUEUE, &_decoderQueue)
+        || SL_RESULT_SUCCESS != (*_decoderObject)->GetInterface(_decoderObject, SL_IID_METADATAEXTRACTION, &_decoderMetadata)
+        || SL_RESULT_SUCCESS != (*_decoderQueue)->RegisterCallback(_decoderQueue, AudioStream::decoderBufferCallback, this)
+        || SL_RESULT_SUCCESS != (*_decoderPlay)->SetCallbackEventsMask(_decoderPlay, SL_PLAYEVENT_HEADATEND)
+        || SL_RESULT_SUCCESS != (*_decoderPlay)->RegisterCallback(_decoderPlay, AudioStream::decoderPlayCallback, this))
+    {
+        LOGEX("Realize _decoderObject fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_REALIZE);
+        closeDecoder();
+        return false;
+    }
+    memset(_decodeBuffer, 0, sizeof(_decodeBuffer));
+    if (_ring.space() < DECODE_SAMPLES) // Looping with a full ring: the buffer is enqueued by the next refill
+    {
+        _decoderStalled = true;
+    }
+    else
+    {
+        result = (*_decoderQueue)->Enqueue(_decoderQueue, _decodeBuffer, sizeof(_decodeBuffer));
+    }
+    if (SL_RESULT_SUCCESS != result || SL_RESULT_SUCCESS != (*_decoderPlay)->SetPlayState(_decoderPlay, SL_PLAYSTATE_PLAYING))
+    {
+        LOGEX("Enqueue _decoderQueue fail");
+        closeDecoder();
+        return false;
+    }
+    return true;
+}
+
+void AudioStream::closeDecoder() noexcept
+{
+    if (_decoderObject != nullptr)
+    {
+        (*_decoderObject)->Destroy(_decoderObject);
+        _decoderObject = nullptr;
+    }
+    _decoderPlay = nullptr;
+    _decoderQueue = nullptr;
+    _decoderMetadata = nullptr;
+}
+
+/**
+ * Create the buffer queue player in the format of the source, prime it from the ring and apply the requested state
+ */
+bool AudioStream::openOutput(const SLuint32 channels, const SLuint32 sampleRate) noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    SLDataLocator_AndroidSimpleBufferQueue loc_bq = {SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, (SLuint32) OUTPUT_BUFFERS};
+    SLDataFormat_PCM format_pcm = {SL_DATAFORMAT_PCM, channels, sampleRate * 1000, SL_PCMSAMPLEFORMAT_FIXED_16, SL_PCMSAMPLEFORMAT_FIXED_16,
+                                   channels == 1 ? SL_SPEAKER_FRONT_CENTER : SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT, SL_BYTEORDER_LITTLEENDIAN};
+    SLDataSource audioSrc = {&loc_bq, &format_pcm};
+
+    SLDataLocator_OutputMix loc_outmix = {SL_DATALOCATOR_OUTPUTMIX, _outputMixObject};
+    SLDataSink audioSnk = {&loc_outmix, NULL};
+
+    // A track at the output rate asks for a fast track, without playback rate then like the decoded samples
+    const bool fastPath = AudioFastPath::isEligible(sampleRate, AudioEngine::getInstance()->getOutputSampleRate());
+    const SLInterfaceID ids[4] = {SL_IID_ANDROIDSIMPLEBUFFERQUEUE, SL_IID_VOLUME, SL_IID_ANDROIDCONFIGURATION, SL_IID_PLAYBACKRATE};
+    const SLboolean req[4] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE, SL_BOOLEAN_FALSE, SL_BOOLEAN_FALSE};
+    SLresult result = (*_engineEngine)->CreateAudioPlayer(_engineEngine, &_outputObject, &audioSrc, &audioSnk, fastPath ? 3 : 4, ids, req);
+    if (SL_RESULT_SUCCESS != result)
+    {
+        LOGEX("CreateAudioPlayer _outputObject fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_CREATE_PLAYER);
+        _outputObject = nullptr;
+        return false;
+    }
+    if (fastPath)
+    {
+        AudioFastPath::request(_outputObject);
+    }
+    _channels = channels;
+    _bufferFrames = AudioFastPath::alignToBurst(BUFFER_FRAMES, AudioEngine::getInstance()->getFramesPerBurst());
+    _bufferNs = (int64_t) ((uint64_t) _bufferFrames * 1000000000ULL / sampleRate);
+    _outputBuffers.assign(OUTPUT_BUFFERS * _bufferFrames * channels, 0);
+    _next = 0;
+    if (SL_RESULT_SUCCESS != (*_outputObject)->Realize(_outputObject, SL_BOOLEAN_FALSE)
+        || SL_RESULT_SUCCESS != (*_outputObject)->GetInterface(_outputObject, SL_IID_PLAY, &_outputPlay)
+        || SL_RESULT_SUCCESS != (*_outputObject)->GetInterface(_outputObject, SL_IID_ANDROIDSIMPLEBUFFERQUEUE, &_outputQueue)
+        || SL_RESULT_SUCCESS != (*_outputObject)->GetInterface(_outputObject, SL_IID_VOLUME, &_outputVolume)
+        || SL_RESULT_SUCCESS != (*_outputQueue)->RegisterCallback(_outputQueue, AudioStream::outputCallback, this))
+    {
+        LOGEX("Realize _outputObject fail");
+        AudioMetrics::count(AudioMetrics::COUNTER_FAILED_REALIZE);
+        (*_outputObject)->Destroy(_outputObject);
+        _outputObject = nullptr;
+        _outputPlay = nullptr;
+        _outputQueue = nullptr;
+        _outputVolume = nullptr;
+        return false;
+    }
+    *_fastPath = AudioFastPath::isObtained(_outputObject, fastPath);
+    if (SL_RESULT_SUCCESS != (*_outputObject)->GetInterface(_outputObject, SL_IID_PLAYBACKRATE, &_outputPlaybackRate))
+    {
+        _outputPlaybackRate = nullptr;
+    }
+    for (size_t i = 0; i < OUTPUT_BUFFERS; ++i)
+    {
+        fill(_outputQueue);
+    }
+    applyParams();
+    return applyState();
+}
+
+void AudioStream::closeOutput() noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_outputObject != nullptr)
+    {
+        (*_outputObject)->Destroy(_outputObject); // The callback doesn't take _mutex, Destroy can wait for it
+        _outputObject = nullptr;
+    }
+    *_fastPath = false;
+    _outputPlay = nullptr;
+    _outputQueue = nullptr;
+    _outputVolume = nullptr;
+    _outputPlaybackRate = nullptr;
+}
+
+/**
+ * Apply volume, pan and pitch on the output, _mutex must be held
+ */
+bool AudioStream::applyParams() noexcept
+{
+    if (_outputVolume == nullptr)
+    {
+        return true; // Applied once the output is created
+    }
+    bool ret = SL_RESULT_SUCCESS == (*_outputVolume)->SetVolumeLevel(_outputVolume, AudioGain::toMillibel(_volume))
+               && SL_RESULT_SUCCESS == (*_outputVolume)->EnableStereoPosition(_outputVolume, SL_BOOLEAN_TRUE)
+               && SL_RESULT_SUCCESS == (*_outputVolume)->SetStereoPosition(_outputVolume, (SLpermille) (_pan * 1000));
+    if (!ret)
+    {
+        LOGEX("SetVolumeLevel _outputVolume fail");
+    }
+    if (_outputPlaybackRate != nullptr)
+    {
+        if (SL_RESULT_SUCCESS != (*_outputPlaybackRate)->SetRate(_outputPlaybackRate, (SLpermille) (_pitch * 1000)))
+        {
+            LOGEX("SetRate _outputPlaybackRate fail");
+            ret = false;
+        }
+    }
+    else if (_pitch != 1.f)
+    {
+        ret = false;
+    }
+    return ret;
+}
+
+/**
+ * Apply the requested play state on the output, _mutex must be held
+ */
+bool AudioStream::applyState() noexcept
+{
+    if (_outputPlay == nullptr)
+    {
+        return true; // Applied once the output is created
+    }
+    SLuint32 state = 0;
+    switch (_request)
+    {
+        case REQUEST_PLAYING:
+            state = SL_PLAYSTATE_PLAYING;
+            break;
+        case REQUEST_PAUSED:
+            state = SL_PLAYSTATE_PAUSED;
+            break;
+        case REQUEST_STOPPED:
+            state = SL_PLAYSTATE_STOPPED;
+            break;
+        default:
+            return true;
+    }
+    if (SL_RESULT_SUCCESS != (*_outputPlay)->SetPlayState(_outputPlay, state))
+    {
+        LOGEX("SetPlayState _outputPlay fail");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * requestedAt is the time of the play request of the caller, 0 on resume: the output measures the latency to its first buffer played
+ */
+bool AudioStream::play(const int64_t requestedAt) noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (requestedAt != 0)
+    {
+        _playRequestedAt = requestedAt;
+    }
+    _request = REQUEST_PLAYING;
+    return applyState();
+}
+
+bool AudioStream::pause() noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _request = REQUEST_PAUSED;
+    return applyState();
+}
+
+/**
+ * Stop the output and let the decoder thread release the OpenSL objects
+ */
+bool AudioStream::stop() noexcept
+{
+    bool ret = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _request = REQUEST_STOPPED;
+        _loop = false;
+        ret = applyState();
+    }
+    _ended = true; // The engine already knows, the callback must not report the end
+    _exit = true;
+    wake();
+    return ret;
+}
+
+bool AudioStream::setParams(const float volume, const float pan, const float pitch) noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _volume = volume;
+    _pan = pan;
+    _pitch = pitch;
+    return applyParams();
+}
+
+/**
+ * Wake the decoder thread up without taking its lock so it's safe from the OpenSL callbacks
+ */
+void AudioStream::wake() noexcept
+{
+    _condition.notify_one();
+}
+
+/**
+ * Enqueue the next output buffer from the ring, silence fills an underrun
+ * Return false once the stream ended, nothing is enqueued then
+ */
+bool AudioStream::fill(SLAndroidSimpleBufferQueueItf bufferQueue) noexcept
+{
+    int16_t *buffer = &_outputBuffers[_next * _bufferFrames * _channels];
+    const size_t samples = _bufferFrames * _channels;
+    const size_t n = _ring.read(buffer, samples);
+    if (n < samples)
+    {
+        if (n == 0 && _finished)
+        {
+            if (!_ended.exchange(true)) // Same path as the HEADATEND of a player
+            {
+                AudioEngine::getInstance()->setHeadAtEnd(_audioId);
+            }
+            return false;
+        }
+        memset(buffer + n, 0, (samples - n) * sizeof(int16_t));
+        if (!_finished)
+        {
+            _counters->underruns.fetch_add(1, std::memory_order_relaxed);
+            _counters->underrunFrames.fetch_add((samples - n) / _channels, std::memory_order_relaxed);
+        }
+    }
+    if (_ring.available() <= _lowWatermarkFrames * _channels && _decoderStalled)
+    {
+        _refill = true;
+        wake();
+    }
+    _next = (_next + 1) % OUTPUT_BUFFERS;
+    return SL_RESULT_SUCCESS == (*bufferQueue)->Enqueue(bufferQueue, buffer, (SLuint32) (samples * sizeof(int16_t)));
+}
+
+/**
+ * A decoder buffer is full: push it in the ring and decode the next one while the ring has room
+ */
+void AudioStream::decoderBufferCallback(SLAndroidSimpleBufferQueueItf caller, void *context) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioStream::decoderBufferCallback");
+    AudioStream *stream = static_cast<AudioStream *>(context);
+    stream->_ring.write(stream->_decodeBuffer, DECODE_SAMPLES); // There is room, the buffer is only enqueued then
+    if (stream->_ring.space() >= DECODE_SAMPLES)
+    {
+        memset(stream->_decodeBuffer, 0, sizeof(stream->_decodeBuffer)); // The last buffer is only partially filled
+        (*caller)->Enqueue(caller, stream->_decodeBuffer, sizeof(stream->_decodeBuffer));
+    }
+    else
+    {
+        stream->_decoderStalled = true;
+        stream->wake();
+    }
+}
+
+void AudioStream::decoderPlayCallback(SLPlayItf caller, void *context, SLuint32 playEvent) noexcept
+{
+    if ((playEvent & SL_PLAYEVENT_HEADATEND) == SL_PLAYEVENT_HEADATEND)
+    {
+        AudioStream *stream = static_cast<AudioStream *>(context);
+        stream->_decoderEnded = true;
+        stream->wake();
+    }
+}
+
+void AudioStream::outputCallback(SLAndroidSimpleBufferQueueItf caller, void *context) noexcept
+{
+    AUDIO_TRACE_SCOPE("AudioStream::outputCallback");
+    AudioStream *stream = static_cast<AudioStream *>(context);
+    if (stream->_playRequestedAt.load(std::memory_order_relaxed) != 0) // A buffer was played, it started one buffer ago
+    {
+        const int64_t requestedAt = stream->_playRequestedAt.exchange(0);
+        if (requestedAt != 0)
+        {
+            AudioEngine::getInstance()->recordLatency(AudioEngine::LATENCY_SOUND, nowNanos() - stream->_bufferNs - requestedAt);
+        }
+    }
+    stream->fill(caller);
+}
@@ -0,0 +1,154 @@
+#ifndef __AudioStream__
+#define __AudioStream__
+
+#include <SLES/OpenSLES.h>
+#include <SLES/OpenSLES_Android.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <sys/types.h>
+#include <memory>
+#include "AudioRingBuffer.h"
+#include "AudioAssetCache.h"
+
+namespace audio
+{
+    /**
+     * Streaming voice for long tracks: a decoder thread fills a lock-free ring, a buffer queue player drains it
+     * The buffer queue callback never locks nor allocates, it only wakes the decoder thread up under the low watermark
+     */
+    class AudioStream
+    {
+    public:
+        static constexpr size_t DEFAULT_RING_FRAMES = 32768;
+        static constexpr size_t DEFAULT_LOW_WATERMARK_FRAMES = 8192;
+        static constexpr size_t BUFFER_FRAMES = 1024; // frames of an output buffer, rounded up to whole bursts of the output
+        static constexpr size_t DECODE_SAMPLES = 2048; // samples of a decoder buffer, whole frames in mono and stereo
+        static constexpr size_t OUTPUT_BUFFERS = 2;
+        static constexpr int PREROLL_TIMEOUT_MS = 2000;
+
+        /**
+         * Shared by all the streams of the engine
+         */
+        struct Counters
+        {
+            std::atomic<uint64_t> underruns; // output buffers that found the ring short
+            std::atomic<uint64_t> underrunFrames; // silent frames inserted
+            std::atomic<uint64_t> refills; // decoder restarts under the low watermark
+            std::atomic<int> active;
+        };
+
+    private:
+        enum Request
+        {
+            REQUEST_IDLE = 0,
+            REQUEST_PLAYING,
+            REQUEST_PAUSED,
+            REQUEST_STOPPED
+        };
+
+    public:
+        AudioStream();
+
+        AudioStream(const AudioStream &) = delete;
+
+        AudioStream &operator=(const AudioStream &) & = delete;
+
+        AudioStream(AudioStream &&) = delete;
+
+        AudioStream &operator=(AudioStream &&) & = delete;
+
+        ~AudioStream();
+
+    public:
+        bool init(const SLEngineItf &engineEngine, const SLObjectItf &outputMixObject, const std::shared_ptr<AudioAsset> &asset, const int audioId,
+                  const bool loop, const size_t ringFrames, const size_t lowWatermarkFrames, Counters *counters, std::atomic<bool> *fastPath);
+
+        bool play(const int64_t requestedAt) noexcept;
+
+        bool pause() noexcept;
+
+        bool stop() noexcept;
+
+        bool setParams(const float volume, const float pan, const float pitch) noexcept;
+
+    private:
+        void run() noexcept;
+
+        bool openDecoder() noexcept;
+
+        void closeDecoder() noexcept;
+
+        bool openOutput(const SLuint32 channels, const SLuint32 sampleRate) noexcept;
+
+        void closeOutput() noexcept;
+
+        bool applyParams() noexcept;
+
+        bool applyState() noexcept;
+
+        bool fill(SLAndroidSimpleBufferQueueItf bufferQueue) noexcept;
+
+        void wake() noexcept;
+
+        static void decoderBufferCallback(SLAndroidSimpleBufferQueueItf caller, void *context) noexcept;
+
+        static void decoderPlayCallback(SLPlayItf caller, void *context, SLuint32 playEvent) noexcept;
+
+        static void outputCallback(SLAndroidSimpleBufferQueueItf caller, void *context) noexcept;
+
+    private:
+        SLEngineItf _engineEngine;
+        SLObjectItf _outputMixObject;
+        std::shared_ptr<AudioAsset> _asset; // its fd stays open until the stream is destroyed
+        int _audioId;
+        std::atomic<bool> _loop;
+        Counters *_counters;
+        std::atomic<bool> *_fastPath; // flag of the player, set once the output is realized
+
+        // Decoder, driven by the decoder thread and its own callbacks
+        SLObjectItf _decoderObject;
+        SLPlayItf _decoderPlay;
+        SLAndroidSimpleBufferQueueItf _decoderQueue;
+        SLMetadataExtractionItf _decoderMetadata;
+        int16_t _decodeBuffer[DECODE_SAMPLES];
+        std::atomic<bool> _decoderStalled; // the ring was full: the decoder buffer waits for the thread to enqueue it again
+        std::atomic<bool> _decoderEnded;
+
+        AudioRingBuffer _ring;
+        size_t _lowWatermarkFrames;
+
+        // Output, its interfaces are guarded by _mutex except in the callback
+        std::mutex _mutex;
+        SLObjectItf _outputObject;
+        SLPlayItf _outputPlay;
+        SLAndroidSimpleBufferQueueItf _outputQueue;
+        SLVolumeItf _outputVolume;
+        SLPlaybackRateItf _outputPlaybackRate;
+        SLuint32 _channels;
+        size_t _bufferFrames;
+        int64_t _bufferNs; // duration of an output buffer
+        std::vector<int16_t> _outputBuffers;
+        size_t _next;
+        std::atomic<bool> _finished; // the last sample has been decoded, the output ends when the ring is empty
+        std::atomic<bool> _ended;
+
+        std::atomic<int> _request;
+        std::atomic<int64_t> _playRequestedAt; // play request waiting for its first buffer played, 0 if none
+        std::atomic<float> _volume;
+        std::atomic<float> _pan;
+        std::atomic<float> _pitch;
+
+        std::thread _thread;
+        std::mutex _threadMutex;
+        std::condition_variable _condition;
+        std::atomic<bool> _refill;
+        std::atomic<bool> _exit;
+    };
+}
+
+#endif
@@ -0,0 +1,215 @@
+#include "AudioTrace.h"
+#include "AudioUtils.h"
+#if AUDIO_TRACE
+#ifdef __ANDROID__
+#include <dlfcn.h>
+#else
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+using namespace audio;
+
+namespace
+{
+#if AUDIO_TRACE && defined(__ANDROID__)
+    struct ATrace
+    {
+        bool (*isEnabled)();
+        void (*beginSection)(const char *);
+        void (*endSection)();
+    };
+
+    ATrace loadATrace() noexcept
+    {
+        ATrace ret = {nullptr, nullptr, nullptr};
+        void *handle = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+        if (handle != nullptr)
+        {
+            ret.isEnabled = (bool (*)()) dlsym(handle, "ATrace_isEnabled");
+            ret.beginSection = (void (*)(const char *)) dlsym(handle, "ATrace_beginSection");
+            ret.endSection = (void (*)()) dlsym(handle, "ATrace_endSection");
+            if (ret.isEnabled == nullptr || ret.beginSection == nullptr || ret.endSection == nullptr) // Before API 23
+            {
+                ret = {nullptr, nullptr, nullptr};
+            }
+        }
+        return ret;
+    }
+
+    const ATrace &getATrace() noexcept
+    {
+        static const ATrace atrace = loadATrace();
+        return atrace;
+    }
+#elif AUDIO_TRACE
+    struct Event
+    {
+        const char *name;
+        int64_t start;
+        int64_t duration;
+    };
+
+    /**
+     * Only its thread writes, the exporter reads the events published by count
+     */
+    struct ThreadBuffer
+    {
+        std::atomic<size_t> count;
+        long tid;
+        Event events[AudioTrace::EVENTS_PER_THREAD];
+    };
+
+    std::mutex &getBuffersMutex() noexcept
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    std::vector<ThreadBuffer *> &getBuffers() noexcept
+    {
+        static std::vector<ThreadBuffer *> buffers;
+        return buffers;
+    }
+
+    std::atomic<uint64_t> gDropped(0);
+
+    /**
+     * The buffer is registered on the first span of the thread and never freed: it can be exported after the thread ended
+     */
+    ThreadBuffer *getThreadBuffer() noexcept
+    {
+        static thread_local ThreadBuffer *buffer = nullptr;
+        if (buffer == nullptr)
+        {
+            buffer = new ThreadBuffer();
+            buffer->count = 0;
+            buffer->tid = (long) syscall(SYS_gettid);
+            std::lock_guard<std::mutex> lock(getBuffersMutex());
+            getBuffers().push_back(buffer);
+        }
+        return buffer;
+    }
+#endif
+}
+
+AudioTrace::Scope::Scope(const char *name) noexcept : _name(name)
+, _start(begin(name))
+{
+}
+
+AudioTrace::Scope::~Scope()
+{
+    if (_start != 0)
+    {
+        end(_name, _start);
+    }
+}
+
+/**
+ * On a device, true while systrace or Perfetto records the app
+ */
+bool AudioTrace::isEnabled() noexcept
+{
+#if AUDIO_TRACE && defined(__ANDROID__)
+    const ATrace &atrace = getATrace();
+    return atrace.isEnabled != nullptr && atrace.isEnabled();
+#elif AUDIO_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Start of a span, return 0 if it isn't recorded
+ */
+int64_t AudioTrace::begin(const char *name) noexcept
+{
+#if AUDIO_TRACE && defined(__ANDROID__)
+    if (!isEnabled())
+    {
+        return 0;
+    }
+    getATrace().beginSection(name);
+    return 1;
+#elif AUDIO_TRACE
+    return nowNanos();
+#else
+    return 0;
+#endif
+}
+
+void AudioTrace::end(const char *name, const int64_t start) noexcept
+{
+#if AUDIO_TRACE && defined(__ANDROID__)
+    getATrace().endSection();
+#elif AUDIO_TRACE
+    const int64_t now = nowNanos();
+    ThreadBuffer *buffer = getThreadBuffer();
+    const size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= EVENTS_PER_THREAD)
+    {
+        gDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[index] = {name, start, now - start};
+    buffer->count.store(index + 1, std::memory_order_release);
+#endif
+}
+
+/**
+ * Spans lost because the buffer of their thread was full
+ */
+uint64_t AudioTrace::getDropped() noexcept
+{
+#if AUDIO_TRACE && !defined(__ANDROID__)
+    return gDropped.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Write the spans of all the threads as a Chrome trace_event JSON file, to open in chrome://tracing or Perfetto
+ * Return false on a device (the spans went to ATrace), when tracing is compiled out or if the file can't be written
+ */
+bool AudioTrace::writeChromeTrace(const char *path) noexcept
+{
+#if AUDIO_TRACE && !defined(__ANDROID__)
+    std::vector<ThreadBuffer *> buffers;
+    {
+        std::lock_guard<std::mutex> lock(getBuffersMutex());
+        buffers = getBuffers();
+    }
+    FILE *file = fopen(path, "w");
+    if (file == nullptr)
+    {
+        LOGEX("fopen trace fail");
+        return false;
+    }
+    const int pid = (int) getpid();
+    bool first = true;
+    fprintf(file, "{\"traceEvents\":[");
+    for (const ThreadBuffer *buffer : buffers)
+    {
+        const size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Event &event = buffer->events[i];
+            fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"audio\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%ld}", first ? "" : ",",
+                    event.name, event.start / 1000.0, event.duration / 1000.0, pid, buffer->tid);
+            first = false;
+        }
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return fclose(file) == 0;
+#else
+    return false;
+#endif
+}
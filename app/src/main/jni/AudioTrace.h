@@ -0,0 +1,75 @@
+#ifndef __AudioTrace__
+#define __AudioTrace__
+
+#include <cstdint>
+#include <cstddef>
+
+// Build with -DAUDIO_TRACE=0 to compile the spans out, the default follows NDEBUG so release builds pay nothing
+#ifndef AUDIO_TRACE
+#ifdef NDEBUG
+#define AUDIO_TRACE 0
+#else
+#define AUDIO_TRACE 1
+#endif
+#endif
+
+#define AUDIO_TRACE_CONCAT2(a, b) a##b
+#define AUDIO_TRACE_CONCAT(a, b) AUDIO_TRACE_CONCAT2(a, b)
+
+#if AUDIO_TRACE
+#define AUDIO_TRACE_SCOPE(name) audio::AudioTrace::Scope AUDIO_TRACE_CONCAT(_traceScope, __LINE__)(name)
+#else
+#define AUDIO_TRACE_SCOPE(name) ((void) 0)
+#endif
+
+namespace audio
+{
+    /**
+     * Scoped trace spans of the engine
+     * On a device a span is an ATrace section, visible in systrace and Perfetto, resolved at runtime as ATrace only exists from API 23
+     * On the host a span is recorded in a fixed buffer of its thread without any lock and writeChromeTrace() exports them all
+     * Note: The names must be string literals, the host buffers keep the pointers
+     */
+    class AudioTrace
+    {
+    public:
+        static constexpr size_t EVENTS_PER_THREAD = 16384; // the spans of a full buffer are dropped
+
+        class Scope
+        {
+        public:
+            explicit Scope(const char *name) noexcept;
+
+            Scope(const Scope &) = delete;
+
+            Scope &operator=(const Scope &) & = delete;
+
+            Scope(Scope &&) = delete;
+
+            Scope &operator=(Scope &&) & = delete;
+
+            ~Scope();
+
+        private:
+            const char *_name;
+            int64_t _start; // 0 if the span isn't recorded
+        };
+
+    public:
+        AudioTrace() = delete;
+
+    public:
+        static bool isEnabled() noexcept;
+
+        static bool writeChromeTrace(const char *path) noexcept;
+
+        static uint64_t getDropped() noexcept;
+
+    private:
+        static int64_t begin(const char *name) noexcept;
+
+        static void end(const char *name, const int64_t start) noexcept;
+    };
+}
+
+#endif
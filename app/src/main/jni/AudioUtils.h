@@ -2,11 +2,38 @@
 #define __AudioUtils__
 
 #include <android/log.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
 
 #define  LOG_TAG    "libaudio"
 #define  LOGD(...)  __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 #define  LOGEX(msg) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "fun:%s,line:%d,msg:%s", __func__, __LINE__, #msg)
 
+namespace audio
+{
+    /**
+     * Monotonic timestamp in nanoseconds used by the engine statistics
+     */
+    inline int64_t nowNanos() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * Path of a sound relative to the assets directory, "assets/" at the beginning of the path is dropped
+     */
+    inline std::string assetRelativePath(const std::string &fileFullPath)
+    {
+        const std::string assetsPath = "assets/";
+        if (0 == fileFullPath.compare(0, assetsPath.length(), assetsPath))
+        {
+            return fileFullPath.substr(assetsPath.length());
+        }
+        return fileFullPath;
+    }
+}
+
 #endif
 
 
@@ -0,0 +1,416 @@
+/**
+ * Offline conditioning of the sound assets, run on the build host before packaging the APK
+ *
+ * Build: c++ -std=c++14 -O2 -pthread -I../../app/src/main/jni *.cpp -lvorbisfile -lvorbis -logg -o assetconditioner
+ * Usage: assetconditioner [options] <assets dir> <output dir>
+ *
+ * The short clips are decoded, resampled to the device rate, trimmed, normalized and written as 16 bits PCM:
+ * in a sound bank for AudioEngine.loadSoundBank (the default) or as one WAVE per clip.
+ * The long tracks and the clips the engine can't play from memory are copied untouched, they keep streaming compressed.
+ */
+#include "ClipReader.h"
+#include "ClipWriter.h"
+#include "ClipProcessing.h"
+#include "Resampler.h"
+#include "AudioSoundBank.h"
+#include <sys/stat.h>
+#include <dirent.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace audio;
+
+namespace
+{
+    struct Options
+    {
+        std::string input;
+        std::string output;
+        uint32_t rate = 48000;
+        bool bank = true;
+        std::string bankName = "sounds.bank";
+        double maxClipSeconds = 10.0;
+        bool trim = true;
+        float trimDb = -60.0f;
+        bool normalize = true;
+        float peakDb = -1.0f;
+        unsigned jobs = 0;
+    };
+
+    enum Action
+    {
+        ACTION_FAILED = 0,
+        ACTION_BANK,
+        ACTION_WAV,
+        ACTION_COPY
+    };
+
+    struct Result
+    {
+        std::string name; // relative to the input directory
+        Action action = ACTION_FAILED;
+        std::string error;
+        uint32_t inputRate = 0;
+        uint32_t outputRate = 0;
+        uint32_t channels = 0;
+        double inputSeconds = 0.0;
+        double outputSeconds = 0.0;
+        size_t trimmedFrames = 0;
+        float gain = 1.0f;
+        double decodeMs = 0.0;
+        double resampleMs = 0.0;
+        double processMs = 0.0;
+        double writeMs = 0.0;
+        double totalMs = 0.0;
+        ClipWriter::BankEntry entry; // moved into the bank once all the workers are done
+    };
+
+    double elapsedMs(const std::chrono::steady_clock::time_point &since) noexcept
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    }
+
+    void listFiles(const std::string &root, const std::string &relative, std::vector<std::string> &names) noexcept
+    {
+        DIR *dir = opendir((root + "/" + relative).c_str());
+        if (dir == nullptr)
+        {
+            return;
+        }
+        while (const dirent *item = readdir(dir))
+        {
+            if (item->d_name[0] == '.')
+            {
+                continue;
+            }
+            const std::string name = relative.empty() ? item->d_name : relative + "/" + item->d_name;
+            struct stat info;
+            if (stat((root + "/" + name).c_str(), &info) != 0)
+            {
+                continue;
+            }
+            if (S_ISDIR(info.st_mode))
+            {
+                listFiles(root, name, names);
+            }
+            else if (ClipReader::isSupported(name))
+            {
+                names.push_back(name);
+            }
+        }
+        closedir(dir);
+    }
+
+    bool makeParentDirectories(const std::string &path) noexcept
+    {
+        for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1))
+        {
+            if (mkdir(path.substr(0, slash).c_str(), 0755) != 0 && errno != EEXIST)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool copyFile(const std::string &from, const std::string &to) noexcept
+    {
+        FILE *in = fopen(from.c_str(), "rb");
+        if (in == nullptr)
+        {
+            return false;
+        }
+        FILE *out = fopen(to.c_str(), "wb");
+        bool ret = out != nullptr;
+        char buffer[64 * 1024];
+        size_t size = 0;
+        while (ret && (size = fread(buffer, 1, sizeof(buffer), in)) > 0)
+        {
+            ret = fwrite(buffer, 1, size, out) == size;
+        }
+        fclose(in);
+        if (out != nullptr)
+        {
+            ret = fclose(out) == 0 && ret;
+        }
+        return ret;
+    }
+
+    std::string withExtension(const std::string &name, const char *extension) noexcept
+    {
+        const size_t dot = name.rfind('.');
+        const size_t slash = name.rfind('/');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        {
+            return name + extension;
+        }
+        return name.substr(0, dot) + extension;
+    }
+
+    /**
+     * Condition one source, run by the workers
+     */
+    void condition(const Options &options, Result &result) noexcept
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const std::string source = options.input + "/" + result.name;
+        AudioClipInfo info;
+        if (!ClipReader::readInfo(source, info))
+        {
+            result.error = "unreadable";
+            return;
+        }
+        result.inputRate = info.sampleRate;
+        result.outputRate = info.sampleRate;
+        result.channels = info.channels;
+        result.inputSeconds = info.getDurationSeconds();
+        result.outputSeconds = result.inputSeconds;
+
+        if (info.getDurationSeconds() > options.maxClipSeconds || info.channels == 0 || info.channels > 2)
+        {
+            const std::string destination = options.output + "/" + result.name;
+            auto stepStart = std::chrono::steady_clock::now();
+            if (!makeParentDirectories(destination) || !copyFile(source, destination))
+            {
+                result.error = "can't copy to " + destination;
+                return;
+            }
+            result.writeMs = elapsedMs(stepStart);
+            result.action = ACTION_COPY;
+            result.totalMs = elapsedMs(start);
+            return;
+        }
+
+        AudioClip clip;
+        auto stepStart = std::chrono::steady_clock::now();
+        if (!ClipReader::read(source, clip) || clip.getFrames() == 0)
+        {
+            result.error = "decode failed";
+            return;
+        }
+        result.decodeMs = elapsedMs(stepStart);
+
+        stepStart = std::chrono::steady_clock::now();
+        Resampler resampler(clip.sampleRate, options.rate);
+        resampler.process(clip);
+        result.outputRate = clip.sampleRate;
+        result.resampleMs = elapsedMs(stepStart);
+
+        stepStart = std::chrono::steady_clock::now();
+        if (options.trim)
+        {
+            result.trimmedFrames = ClipProcessing::trimSilence(clip, options.trimDb);
+        }
+        if (options.normalize)
+        {
+            result.gain = ClipProcessing::normalizePeak(clip, options.peakDb);
+        }
+        std::vector<int16_t> pcm = ClipProcessing::toPcm16(clip, AudioSoundBank::hash(result.name));
+        result.outputSeconds = clip.getDurationSeconds();
+        result.processMs = elapsedMs(stepStart);
+
+        if (options.bank)
+        {
+            result.entry.name = result.name;
+            result.entry.pcm = std::move(pcm);
+            result.entry.channels = clip.channels;
+            result.entry.sampleRate = clip.sampleRate;
+            result.action = ACTION_BANK;
+        }
+        else
+        {
+            stepStart = std::chrono::steady_clock::now();
+            const std::string destination = options.output + "/" + withExtension(result.name, ".wav");
+            if (!makeParentDirectories(destination) || !ClipWriter::writeWav(destination, pcm, clip.channels, clip.sampleRate))
+            {
+                result.error = "can't write " + destination;
+                return;
+            }
+            result.writeMs = elapsedMs(stepStart);
+            result.action = ACTION_WAV;
+        }
+        result.totalMs = elapsedMs(start);
+    }
+
+    void usage() noexcept
+    {
+        fprintf(stderr,
+                "usage: assetconditioner [options] <assets dir> <output dir>\n"
+                "  --rate <44100|48000>      device output rate (48000)\n"
+                "  --format <bank|wav>       output of the short clips (bank)\n"
+                "  --bank <name>             name of the sound bank in the output dir (sounds.bank)\n"
+                "  --max-clip-seconds <s>    longer sources are copied compressed (10)\n"
+                "  --trim-db <dB>            silence threshold of the trim (-60)\n"
+                "  --no-trim\n"
+                "  --peak-db <dB>            peak of the normalized clips (-1)\n"
+                "  --no-normalize\n"
+                "  --jobs <n>                worker threads (number of cores)\n");
+    }
+
+    bool parseOptions(const int argc, char **argv, Options &options) noexcept
+    {
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--rate" && hasValue)
+            {
+                options.rate = (uint32_t) strtoul(argv[++i], nullptr, 10);
+            }
+            else if (arg == "--format" && hasValue)
+            {
+                const std::string format = argv[++i];
+                if (format != "bank" && format != "wav")
+                {
+                    return false;
+                }
+                options.bank = format == "bank";
+            }
+            else if (arg == "--bank" && hasValue)
+            {
+                options.bankName = argv[++i];
+            }
+            else if (arg == "--max-clip-seconds" && hasValue)
+            {
+                options.maxClipSeconds = strtod(argv[++i], nullptr);
+            }
+            else if (arg == "--trim-db" && hasValue)
+            {
+                options.trimDb = strtof(argv[++i], nullptr);
+            }
+            else if (arg == "--no-trim")
+            {
+                options.trim = false;
+            }
+            else if (arg == "--peak-db" && hasValue)
+            {
+                options.peakDb = strtof(argv[++i], nullptr);
+            }
+            else if (arg == "--no-normalize")
+            {
+                options.normalize = false;
+            }
+            else if (arg == "--jobs" && hasValue)
+            {
+                options.jobs = (unsigned) strtoul(argv[++i], nullptr, 10);
+            }
+            else if (!arg.empty() && arg[0] != '-')
+            {
+                positional.push_back(arg);
+            }
+            else
+            {
+                return false;
+            }
+        }
+        if (positional.size() != 2 || (options.rate != 44100 && options.rate != 48000))
+        {
+            return false;
+        }
+        options.input = positional[0];
+        options.output = positional[1];
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage();
+        return 2;
+    }
+    if (options.jobs == 0)
+    {
+        options.jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    mkdir(options.output.c_str(), 0755);
+
+    std::vector<std::string> names;
+    listFiles(options.input, "", names);
+    std::sort(names.begin(), names.end());
+    std::vector<Result> results(names.size());
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        results[i].name = names[i];
+    }
+
+    // Workers take the next source until none is left, the longest files don't serialize the others
+    const auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    const unsigned jobs = std::min<unsigned>(options.jobs, (unsigned) std::max<size_t>(1, names.size()));
+    for (unsigned i = 0; i < jobs; ++i)
+    {
+        workers.emplace_back([&options, &results, &next]()
+        {
+            for (size_t index = next++; index < results.size(); index = next++)
+            {
+                condition(options, results[index]);
+            }
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    int ret = 0;
+    double bankMs = 0.0;
+    size_t bankBytes = 0;
+    if (options.bank)
+    {
+        const auto bankStart = std::chrono::steady_clock::now();
+        std::vector<ClipWriter::BankEntry> entries;
+        for (Result &result : results)
+        {
+            if (result.action == ACTION_BANK)
+            {
+                bankBytes += result.entry.pcm.size() * sizeof(int16_t);
+                entries.push_back(std::move(result.entry));
+            }
+        }
+        std::string error;
+        const std::string path = options.output + "/" + options.bankName;
+        if (!entries.empty() && !ClipWriter::writeSoundBank(path, entries, error))
+        {
+            fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+            ret = 1;
+        }
+        bankMs = elapsedMs(bankStart);
+    }
+    const double wallMs = elapsedMs(start);
+
+    // One tab separated line per file, then the totals
+    static const char *const ACTIONS[] = {"failed", "bank", "wav", "copy"};
+    printf("file\taction\trate\tchannels\tseconds\ttrimmed_frames\tgain\tdecode_ms\tresample_ms\tprocess_ms\twrite_ms\ttotal_ms\n");
+    double cpuMs = 0.0;
+    for (const Result &result : results)
+    {
+        printf("%s\t%s\t%u->%u\t%u\t%.3f->%.3f\t%zu\t%.3f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\n",
+               result.name.c_str(), ACTIONS[result.action], result.inputRate, result.outputRate, result.channels,
+               result.inputSeconds, result.outputSeconds, result.trimmedFrames, result.gain,
+               result.decodeMs, result.resampleMs, result.processMs, result.writeMs, result.totalMs);
+        if (result.action == ACTION_FAILED)
+        {
+            fprintf(stderr, "%s: %s\n", result.name.c_str(), result.error.c_str());
+            ret = 1;
+        }
+        cpuMs += result.totalMs;
+    }
+    printf("# files %zu, jobs %u, wall %.2f ms, sum of files %.2f ms, bank %zu bytes of PCM written in %.2f ms\n",
+           results.size(), jobs, wallMs, cpuMs, bankBytes, bankMs);
+    return ret;
+}
@@ -0,0 +1,47 @@
+#ifndef __AudioClip__
+#define __AudioClip__
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace audio
+{
+    /**
+     * Sound being conditioned, interleaved float samples in [-1, 1]
+     */
+    struct AudioClip
+    {
+        std::vector<float> samples;
+        uint32_t channels = 0;
+        uint32_t sampleRate = 0; // in Hz
+
+        size_t getFrames() const noexcept
+        {
+            return channels > 0 ? samples.size() / channels : 0;
+        }
+
+        double getDurationSeconds() const noexcept
+        {
+            return sampleRate > 0 ? (double) getFrames() / sampleRate : 0.0;
+        }
+    };
+
+    /**
+     * Format of a source read from its header only, used to leave the long tracks untouched without decoding them
+     */
+    struct AudioClipInfo
+    {
+        uint32_t channels = 0;
+        uint32_t sampleRate = 0;
+        uint64_t frames = 0;
+
+        double getDurationSeconds() const noexcept
+        {
+            return sampleRate > 0 ? (double) frames / sampleRate : 0.0;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,96 @@
+#include "ClipProcessing.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace audio;
+
+float ClipProcessing::dbToGain(const float db) noexcept
+{
+    return std::pow(10.0f, db / 20.0f);
+}
+
+/**
+ * Drop the leading and trailing frames of which all the channels are under the threshold, return the dropped frames
+ * An all silent clip keeps a single frame so it stays playable
+ */
+size_t ClipProcessing::trimSilence(AudioClip &clip, const float thresholdDb) noexcept
+{
+    const size_t frames = clip.getFrames();
+    const size_t channels = clip.channels;
+    const float threshold = dbToGain(thresholdDb);
+    auto isAudible = [&clip, channels, threshold](const size_t frame)
+    {
+        for (size_t c = 0; c < channels; ++c)
+        {
+            if (std::fabs(clip.samples[frame * channels + c]) > threshold)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+    size_t first = 0;
+    while (first < frames && !isAudible(first))
+    {
+        ++first;
+    }
+    size_t last = frames;
+    while (last > first && !isAudible(last - 1))
+    {
+        --last;
+    }
+    if (first == last)
+    {
+        last = std::min(frames, first + 1);
+        first = last > 0 ? last - 1 : 0;
+    }
+    clip.samples.erase(clip.samples.begin() + (last * channels), clip.samples.end());
+    clip.samples.erase(clip.samples.begin(), clip.samples.begin() + (first * channels));
+    return frames - (last - first);
+}
+
+/**
+ * Scale the clip so its peak reaches the target, return the applied gain (1 for a silent clip)
+ */
+float ClipProcessing::normalizePeak(AudioClip &clip, const float targetDb) noexcept
+{
+    float peak = 0.0f;
+    for (const float sample : clip.samples)
+    {
+        peak = std::max(peak, std::fabs(sample));
+    }
+    if (peak <= 0.0f)
+    {
+        return 1.0f;
+    }
+    const float gain = dbToGain(targetDb) / peak;
+    for (float &sample : clip.samples)
+    {
+        sample *= gain;
+    }
+    return gain;
+}
+
+/**
+ * Quantize to signed 16 bits with a triangular dither
+ * The dither is seeded by the caller so a build writes the same bytes for the same sources
+ */
+std::vector<int16_t> ClipProcessing::toPcm16(const AudioClip &clip, const uint64_t seed) noexcept
+{
+    std::vector<int16_t> ret(clip.samples.size());
+    uint64_t state = seed | 1;
+    auto next = [&state]()
+    {
+        state ^= state << 13; // xorshift64
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (float) (state >> 40) / (float) (1 << 24); // [0, 1)
+    };
+    for (size_t i = 0; i < ret.size(); ++i)
+    {
+        const float dither = next() - next(); // (-1, 1) LSB
+        const float value = std::round(clip.samples[i] * 32767.0f + dither);
+        ret[i] = (int16_t) std::max(-32768.0f, std::min(32767.0f, value));
+    }
+    return ret;
+}
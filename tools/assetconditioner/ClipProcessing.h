@@ -0,0 +1,29 @@
+#ifndef __ClipProcessing__
+#define __ClipProcessing__
+
+#include <vector>
+#include <cstdint>
+#include "AudioClip.h"
+
+namespace audio
+{
+    /**
+     * In place steps of the conditioning, they run after the resampling
+     */
+    class ClipProcessing
+    {
+    public:
+        ClipProcessing() = delete;
+
+    public:
+        static size_t trimSilence(AudioClip &clip, const float thresholdDb) noexcept;
+
+        static float normalizePeak(AudioClip &clip, const float targetDb) noexcept;
+
+        static std::vector<int16_t> toPcm16(const AudioClip &clip, const uint64_t seed) noexcept;
+
+        static float dbToGain(const float db) noexcept;
+    };
+}
+
+#endif
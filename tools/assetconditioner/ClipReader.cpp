@@ -0,0 +1,225 @@
+#include "ClipReader.h"
+#include <vorbis/vorbisfile.h>
+#include <cstdio>
+#include <cstring>
+
+using namespace audio;
+
+namespace
+{
+    bool hasExtension(const std::string &path, const char *extension) noexcept
+    {
+        const size_t length = strlen(extension);
+        if (path.size() < length)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < length; ++i)
+        {
+            char c = path[path.size() - length + i];
+            if (c >= 'A' && c <= 'Z')
+            {
+                c = (char) (c - 'A' + 'a');
+            }
+            if (c != extension[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint32_t readLE(const uint8_t *data, const size_t bytes) noexcept
+    {
+        uint32_t ret = 0;
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            ret |= (uint32_t) data[i] << (8 * i);
+        }
+        return ret;
+    }
+}
+
+bool ClipReader::isSupported(const std::string &path) noexcept
+{
+    return hasExtension(path, ".ogg") || hasExtension(path, ".wav");
+}
+
+bool ClipReader::readInfo(const std::string &path, AudioClipInfo &info) noexcept
+{
+    if (hasExtension(path, ".ogg"))
+    {
+        return readVorbisInfo(path, info);
+    }
+    return readWav(path, info, nullptr);
+}
+
+/**
+ * Decode a whole source, return false if it's not valid or has a format the engine can't play (more than 2 channels)
+ */
+bool ClipReader::read(const std::string &path, AudioClip &clip) noexcept
+{
+    if (hasExtension(path, ".ogg"))
+    {
+        return readVorbis(path, clip);
+    }
+    AudioClipInfo info;
+    return readWav(path, info, &clip);
+}
+
+bool ClipReader::readVorbisInfo(const std::string &path, AudioClipInfo &info) noexcept
+{
+    bool ret = false;
+    OggVorbis_File file;
+    if (ov_fopen(path.c_str(), &file) == 0)
+    {
+        const vorbis_info *vorbisInfo = ov_info(&file, -1);
+        const ogg_int64_t frames = ov_pcm_total(&file, -1);
+        if (vorbisInfo != nullptr && frames >= 0)
+        {
+            info.channels = (uint32_t) vorbisInfo->channels;
+            info.sampleRate = (uint32_t) vorbisInfo->rate;
+            info.frames = (uint64_t) frames;
+            ret = true;
+        }
+        ov_clear(&file);
+    }
+    return ret;
+}
+
+/**
+ * Note: A chained stream must keep the same format in all its links
+ */
+bool ClipReader::readVorbis(const std::string &path, AudioClip &clip) noexcept
+{
+    OggVorbis_File file;
+    if (ov_fopen(path.c_str(), &file) != 0)
+    {
+        return false;
+    }
+    bool ret = false;
+    const vorbis_info *vorbisInfo = ov_info(&file, -1);
+    if (vorbisInfo != nullptr && vorbisInfo->channels >= 1 && vorbisInfo->channels <= 2)
+    {
+        clip.channels = (uint32_t) vorbisInfo->channels;
+        clip.sampleRate = (uint32_t) vorbisInfo->rate;
+        clip.samples.clear();
+        const ogg_int64_t total = ov_pcm_total(&file, -1);
+        if (total > 0)
+        {
+            clip.samples.reserve((size_t) total * clip.channels);
+        }
+        ret = true;
+        int bitstream = 0;
+        for (;;)
+        {
+            float **pcm = nullptr;
+            const long frames = ov_read_float(&file, &pcm, 4096, &bitstream);
+            if (frames == 0)
+            {
+                break;
+            }
+            const vorbis_info *linkInfo = ov_info(&file, bitstream);
+            if (frames < 0 || linkInfo == nullptr || (uint32_t) linkInfo->channels != clip.channels || (uint32_t) linkInfo->rate != clip.sampleRate)
+            {
+                ret = false;
+                break;
+            }
+            for (long i = 0; i < frames; ++i)
+            {
+                for (uint32_t c = 0; c < clip.channels; ++c)
+                {
+                    clip.samples.push_back(pcm[c][i]);
+                }
+            }
+        }
+    }
+    ov_clear(&file);
+    return ret;
+}
+
+/**
+ * Parse a RIFF WAVE, only the header when clip is nullptr
+ */
+bool ClipReader::readWav(const std::string &path, AudioClipInfo &info, AudioClip *clip) noexcept
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    bool ret = false;
+    uint8_t header[12];
+    uint32_t format = 0, bits = 0;
+    bool hasFormat = false;
+    if (fread(header, 1, sizeof(header), file) == sizeof(header) && memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVE", 4) == 0)
+    {
+        uint8_t chunk[8];
+        while (fread(chunk, 1, sizeof(chunk), file) == sizeof(chunk))
+        {
+            const uint32_t size = readLE(chunk + 4, 4);
+            if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+            {
+                uint8_t fmt[16];
+                if (fread(fmt, 1, sizeof(fmt), file) != sizeof(fmt))
+                {
+                    break;
+                }
+                format = readLE(fmt, 2);
+                info.channels = readLE(fmt + 2, 2);
+                info.sampleRate = readLE(fmt + 4, 4);
+                bits = readLE(fmt + 14, 2);
+                hasFormat = true;
+                fseek(file, (long) (size - sizeof(fmt) + (size & 1)), SEEK_CUR);
+            }
+            else if (memcmp(chunk, "data", 4) == 0)
+            {
+                const bool isPcm16 = (format == 1 || format == 0xfffe) && bits == 16;
+                const bool isFloat = (format == 3 || format == 0xfffe) && bits == 32;
+                if (!hasFormat || info.channels == 0 || (!isPcm16 && !isFloat))
+                {
+                    break;
+                }
+                const uint32_t frameBytes = info.channels * bits / 8;
+                info.frames = size / frameBytes;
+                if (clip == nullptr)
+                {
+                    ret = true;
+                    break;
+                }
+                if (info.channels > 2)
+                {
+                    break;
+                }
+                std::vector<uint8_t> data((size_t) info.frames * frameBytes);
+                if (fread(data.data(), 1, data.size(), file) != data.size())
+                {
+                    break;
+                }
+                clip->channels = info.channels;
+                clip->sampleRate = info.sampleRate;
+                clip->samples.resize((size_t) info.frames * info.channels);
+                for (size_t i = 0; i < clip->samples.size(); ++i)
+                {
+                    if (isPcm16)
+                    {
+                        clip->samples[i] = (float) (int16_t) readLE(data.data() + i * 2, 2) / 32768.0f;
+                    }
+                    else
+                    {
+                        const uint32_t value = readLE(data.data() + i * 4, 4);
+                        memcpy(&clip->samples[i], &value, sizeof(float));
+                    }
+                }
+                ret = true;
+                break;
+            }
+            else
+            {
+                fseek(file, (long) (size + (size & 1)), SEEK_CUR); // Chunks are padded to an even size
+            }
+        }
+    }
+    fclose(file);
+    return ret;
+}
@@ -0,0 +1,33 @@
+#ifndef __ClipReader__
+#define __ClipReader__
+
+#include <string>
+#include "AudioClip.h"
+
+namespace audio
+{
+    /**
+     * Decoder of the source assets: Ogg Vorbis through libvorbisfile, RIFF WAVE 16 bits PCM or 32 bits float
+     */
+    class ClipReader
+    {
+    public:
+        ClipReader() = delete;
+
+    public:
+        static bool isSupported(const std::string &path) noexcept;
+
+        static bool readInfo(const std::string &path, AudioClipInfo &info) noexcept;
+
+        static bool read(const std::string &path, AudioClip &clip) noexcept;
+
+    private:
+        static bool readVorbisInfo(const std::string &path, AudioClipInfo &info) noexcept;
+
+        static bool readVorbis(const std::string &path, AudioClip &clip) noexcept;
+
+        static bool readWav(const std::string &path, AudioClipInfo &info, AudioClip *clip) noexcept;
+    };
+}
+
+#endif
@@ -0,0 +1,121 @@
+#include "ClipWriter.h"
+#include "AudioSoundBank.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace audio;
+
+namespace
+{
+    void writeLE(std::vector<uint8_t> &out, const uint32_t value, const size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            out.push_back((uint8_t) (value >> (8 * i)));
+        }
+    }
+
+    bool writeFile(const std::string &path, const std::vector<uint8_t> &data) noexcept
+    {
+        FILE *file = fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        const bool ret = fwrite(data.data(), 1, data.size(), file) == data.size();
+        return fclose(file) == 0 && ret;
+    }
+}
+
+/**
+ * Write the entries sorted by name so the same sources give the same bank
+ * Fails on a hash collision between two names: the runtime lookup compares the hashes only
+ */
+bool ClipWriter::writeSoundBank(const std::string &path, std::vector<BankEntry> &entries, std::string &error) noexcept
+{
+    std::sort(entries.begin(), entries.end(), [](const BankEntry &a, const BankEntry &b)
+    {
+        return a.name < b.name;
+    });
+    uint32_t slots = 1;
+    while (slots < 2 * entries.size()) // At most half full, the probes stay short
+    {
+        slots <<= 1;
+    }
+    std::vector<AudioSoundBank::Entry> index(slots);
+    memset(index.data(), 0, index.size() * sizeof(AudioSoundBank::Entry));
+
+    const uint64_t indexOffset = sizeof(AudioSoundBank::Header);
+    uint64_t offset = indexOffset + (uint64_t) slots * sizeof(AudioSoundBank::Entry);
+    for (const BankEntry &entry : entries)
+    {
+        offset = (offset + AudioSoundBank::DATA_ALIGNMENT - 1) / AudioSoundBank::DATA_ALIGNMENT * AudioSoundBank::DATA_ALIGNMENT;
+        const uint64_t hash = AudioSoundBank::hash(entry.name);
+        uint32_t slot = (uint32_t) hash & (slots - 1);
+        while (index[slot].hash != 0)
+        {
+            if (index[slot].hash == hash)
+            {
+                error = "hash collision on " + entry.name;
+                return false;
+            }
+            slot = (slot + 1) & (slots - 1);
+        }
+        AudioSoundBank::Entry &indexEntry = index[slot];
+        indexEntry.hash = hash;
+        indexEntry.offset = offset;
+        indexEntry.frames = (uint32_t) (entry.pcm.size() / entry.channels);
+        indexEntry.sampleRate = entry.sampleRate;
+        indexEntry.channels = entry.channels;
+        offset += entry.pcm.size() * sizeof(int16_t);
+    }
+
+    AudioSoundBank::Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = AudioSoundBank::MAGIC;
+    header.version = AudioSoundBank::VERSION;
+    header.slots = slots;
+    header.count = (uint32_t) entries.size();
+    header.indexOffset = indexOffset;
+
+    std::vector<uint8_t> data;
+    data.reserve((size_t) offset);
+    data.insert(data.end(), (const uint8_t *) &header, (const uint8_t *) &header + sizeof(header));
+    data.insert(data.end(), (const uint8_t *) index.data(), (const uint8_t *) (index.data() + index.size()));
+    for (const BankEntry &entry : entries) // Same order as the offsets above
+    {
+        data.resize((data.size() + AudioSoundBank::DATA_ALIGNMENT - 1) / AudioSoundBank::DATA_ALIGNMENT * AudioSoundBank::DATA_ALIGNMENT, 0);
+        data.insert(data.end(), (const uint8_t *) entry.pcm.data(), (const uint8_t *) (entry.pcm.data() + entry.pcm.size()));
+    }
+    if (!writeFile(path, data))
+    {
+        error = "can't write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool ClipWriter::writeWav(const std::string &path, const std::vector<int16_t> &pcm, const uint32_t channels, const uint32_t sampleRate) noexcept
+{
+    const uint32_t dataBytes = (uint32_t) (pcm.size() * sizeof(int16_t));
+    std::vector<uint8_t> data;
+    data.reserve(44 + dataBytes);
+    data.insert(data.end(), {'R', 'I', 'F', 'F'});
+    writeLE(data, 36 + dataBytes, 4);
+    data.insert(data.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    writeLE(data, 16, 4);
+    writeLE(data, 1, 2); // PCM
+    writeLE(data, channels, 2);
+    writeLE(data, sampleRate, 4);
+    writeLE(data, sampleRate * channels * 2, 4);
+    writeLE(data, channels * 2, 2);
+    writeLE(data, 16, 2);
+    data.insert(data.end(), {'d', 'a', 't', 'a'});
+    writeLE(data, dataBytes, 4);
+    for (const int16_t sample : pcm)
+    {
+        writeLE(data, (uint16_t) sample, 2);
+    }
+    return writeFile(path, data);
+}
@@ -0,0 +1,35 @@
+#ifndef __ClipWriter__
+#define __ClipWriter__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace audio
+{
+    /**
+     * Outputs of the conditioner: the sound bank mapped by AudioSoundBank, or a 16 bits WAVE per clip
+     * Note: The bank is written in the byte order of the host, little endian like the devices
+     */
+    class ClipWriter
+    {
+    public:
+        struct BankEntry
+        {
+            std::string name; // asset relative path the game plays, the key of the bank
+            std::vector<int16_t> pcm;
+            uint32_t channels;
+            uint32_t sampleRate;
+        };
+
+    public:
+        ClipWriter() = delete;
+
+    public:
+        static bool writeSoundBank(const std::string &path, std::vector<BankEntry> &entries, std::string &error) noexcept;
+
+        static bool writeWav(const std::string &path, const std::vector<int16_t> &pcm, const uint32_t channels, const uint32_t sampleRate) noexcept;
+    };
+}
+
+#endif
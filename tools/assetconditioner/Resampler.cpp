@@ -0,0 +1,146 @@
+#include "Resampler.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace audio;
+
+namespace
+{
+    uint32_t gcd(uint32_t a, uint32_t b) noexcept
+    {
+        while (b != 0)
+        {
+            const uint32_t t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+}
+
+Resampler::Resampler(const uint32_t inputRate, const uint32_t outputRate) noexcept : _inputRate(inputRate)
+, _outputRate(outputRate)
+, _up(1)
+, _down(1)
+, _cutoff(1.0)
+, _halfTaps(HALF_ZERO_CROSSINGS)
+{
+    if (inputRate == 0 || outputRate == 0 || inputRate == outputRate)
+    {
+        return;
+    }
+    const uint32_t divisor = gcd(inputRate, outputRate);
+    _up = outputRate / divisor;
+    _down = inputRate / divisor;
+    const double scale = std::min(1.0, (double) outputRate / inputRate); // downsampling narrows the band
+    _cutoff = scale * ROLLOFF;
+    _halfTaps = (int) std::ceil(HALF_ZERO_CROSSINGS / scale);
+    if (_up <= MAX_PHASES)
+    {
+        const size_t taps = (size_t) (2 * _halfTaps);
+        _phases.resize(_up * taps);
+        for (uint32_t phase = 0; phase < _up; ++phase)
+        {
+            computePhase(phase, &_phases[phase * taps]);
+        }
+    }
+}
+
+/**
+ * Zeroth order modified Bessel function of the first kind, for the Kaiser window
+ */
+double Resampler::besselI0(const double x) noexcept
+{
+    double ret = 1.0, term = 1.0;
+    for (int k = 1; k < 64 && term > ret * 1e-12; ++k)
+    {
+        const double factor = x / (2.0 * k);
+        term *= factor * factor;
+        ret += term;
+    }
+    return ret;
+}
+
+/**
+ * Coefficients of the input samples around an output position phase / L after an input sample
+ * coefficients[j] weights the input sample (i - _halfTaps + 1 + j), each phase sums to 1 to keep the DC gain flat
+ */
+void Resampler::computePhase(const uint32_t phase, float *coefficients) const noexcept
+{
+    const double fraction = (double) phase / _up;
+    const double halfWidth = _halfTaps;
+    const double norm = besselI0(KAISER_BETA);
+    const int taps = 2 * _halfTaps;
+    double sum = 0.0;
+    std::vector<double> values((size_t) taps);
+    for (int j = 0; j < taps; ++j)
+    {
+        const double distance = fraction + _halfTaps - 1 - j; // from the output position to the input sample
+        double value = 0.0;
+        const double ratio = distance / halfWidth;
+        if (ratio > -1.0 && ratio < 1.0)
+        {
+            const double x = M_PI * _cutoff * distance;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(x) / x;
+            value = _cutoff * sinc * besselI0(KAISER_BETA * std::sqrt(1.0 - ratio * ratio)) / norm;
+        }
+        values[(size_t) j] = value;
+        sum += value;
+    }
+    for (int j = 0; j < taps; ++j)
+    {
+        coefficients[j] = (float) (sum != 0.0 ? values[(size_t) j] / sum : 0.0);
+    }
+}
+
+/**
+ * Resample the clip in place to the output rate, the samples outside of the clip are silence
+ */
+void Resampler::process(AudioClip &clip) const noexcept
+{
+    if (clip.sampleRate != _inputRate || _up == _down)
+    {
+        return;
+    }
+    const size_t channels = clip.channels;
+    const size_t inputFrames = clip.getFrames();
+    const size_t outputFrames = (size_t) (((uint64_t) inputFrames * _up + _down - 1) / _down);
+    const int taps = 2 * _halfTaps;
+    std::vector<float> output(outputFrames * channels);
+    std::vector<float> scratch;
+    if (_phases.empty())
+    {
+        scratch.resize((size_t) taps);
+    }
+    for (size_t n = 0; n < outputFrames; ++n)
+    {
+        const uint64_t position = (uint64_t) n * _down;
+        const int64_t index = (int64_t) (position / _up);
+        const uint32_t phase = (uint32_t) (position % _up);
+        const float *coefficients = nullptr;
+        if (_phases.empty())
+        {
+            computePhase(phase, scratch.data());
+            coefficients = scratch.data();
+        }
+        else
+        {
+            coefficients = &_phases[(size_t) phase * taps];
+        }
+        const int64_t first = index - _halfTaps + 1;
+        const int begin = (int) std::max<int64_t>(0, -first);
+        const int end = (int) std::min<int64_t>(taps, (int64_t) inputFrames - first);
+        for (size_t c = 0; c < channels; ++c)
+        {
+            float sum = 0.0f;
+            const float *input = &clip.samples[c];
+            for (int j = begin; j < end; ++j)
+            {
+                sum += coefficients[j] * input[(size_t) (first + j) * channels];
+            }
+            output[n * channels + c] = sum;
+        }
+    }
+    clip.samples.swap(output);
+    clip.sampleRate = _outputRate;
+}
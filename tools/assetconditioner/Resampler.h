@@ -0,0 +1,56 @@
+#ifndef __Resampler__
+#define __Resampler__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "AudioClip.h"
+
+namespace audio
+{
+    /**
+     * Polyphase windowed sinc resampler for a fixed ratio outputRate / inputRate = L / M
+     * The filter has one phase per output position between two input samples (L phases), precomputed once
+     * Kaiser window (beta 8.6, ~-90 dB stopband) over HALF_ZERO_CROSSINGS on each side, the cutoff follows the lower rate
+     */
+    class Resampler
+    {
+    public:
+        static constexpr int HALF_ZERO_CROSSINGS = 32;
+        static constexpr double KAISER_BETA = 8.6;
+        static constexpr double ROLLOFF = 0.95; // passband edge relative to the lower Nyquist
+        static constexpr uint32_t MAX_PHASES = 2048; // above it the phases are computed per sample
+
+    public:
+        Resampler(const uint32_t inputRate, const uint32_t outputRate) noexcept;
+
+        Resampler(const Resampler &) = delete;
+
+        Resampler &operator=(const Resampler &) & = delete;
+
+        Resampler(Resampler &&) = delete;
+
+        Resampler &operator=(Resampler &&) & = delete;
+
+        ~Resampler() = default;
+
+    public:
+        void process(AudioClip &clip) const noexcept;
+
+    private:
+        void computePhase(const uint32_t phase, float *coefficients) const noexcept;
+
+        static double besselI0(const double x) noexcept;
+
+    private:
+        uint32_t _inputRate;
+        uint32_t _outputRate;
+        uint32_t _up; // L
+        uint32_t _down; // M
+        double _cutoff; // in cycles per input sample, times 2
+        int _halfTaps; // input samples on each side of the output position
+        std::vector<float> _phases; // _up rows of 2 * _halfTaps coefficients, empty above MAX_PHASES
+    };
+}
+
+#endif
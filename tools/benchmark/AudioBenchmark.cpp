@@ -0,0 +1,870 @@
+/**
+ * Microbenchmarks of the engine hot paths, run on the build host against AudioHostBackend
+ *
+ * Build: ./gradlew :app:benchmark, or from the repository root with the SLES/, android/ and jni.h headers of the NDK sysroot:
+ *   c++ -std=c++14 -O2 -DNDEBUG -pthread -idirafter $NDK_SYSROOT/usr/include -D'__INTRODUCED_IN(api)=' -Iapp/src/main/jni -Itools/benchmark \
+ *       $(find app/src/main/jni tools/benchmark -name '*.cpp') -o audiobenchmark
+ * Usage: audiobenchmark [options]
+ *
+ * Every scene is measured with 1, 32, 256 and 1024 live voices and the shared paths with 1 to 8 contending threads.
+ * One tab separated line per result goes to stdout, --json writes them all with the context of the build to compare builds.
+ */
+#include "Benchmark.h"
+#include "AudioEngine.h"
+#include "AudioGain.h"
+#include "AudioHostBackend.h"
+#include "AudioHandleTable.h"
+#include "AudioMixKernels.h"
+#include "AudioMetrics.h"
+#include "AudioPlayer.h"
+#include "AudioTrace.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace audio;
+
+namespace
+{
+    const int VOICES[] = {1, 32, 256, 1024};
+    const int THREADS[] = {1, 2, 4, 8};
+    const float PITCHES[] = {0.5f, 0.75f, 1.f, 1.25f, 1.5f, 2.f};
+
+    constexpr uint32_t SAMPLE_RATE = 48000;
+    constexpr size_t BURST_FRAMES = 192; // 4 ms at 48 kHz, the burst of a fast track
+    constexpr int COMMANDS_PER_FRAME = 100;
+    constexpr int TRIGGERS_PER_BURST = 16; // a volley of shots in one frame
+    constexpr int RECLAIM_TIMEOUT_MS = 5000;
+
+    const char *const LOOP_ASSET = "loop.wav"; // decoded once, the voices play it from memory
+    const char *const SHOT_ASSET = "shot.wav";
+    const char *const FD_ASSET = "music.ogg"; // above the sample cache threshold, played from its fd
+
+    struct Options
+    {
+        int minTimeMs = 200;
+        std::string filter;
+        std::string json;
+        std::string assets; // generated in a temporary directory if empty
+        int createLatencyUs = 0;
+        int realizeLatencyUs = 0;
+    };
+
+    /**
+     * xorshift, each thread draws its own voices
+     */
+    uint32_t nextRandom(uint32_t &state) noexcept
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    bool writeWav(const std::string &path, const uint32_t channels, const uint32_t frames, const float frequency) noexcept
+    {
+        std::vector<int16_t> pcm(frames * channels);
+        for (uint32_t i = 0; i < frames; ++i)
+        {
+            const int16_t value = (int16_t) (16000.0 * std::sin(2.0 * M_PI * frequency * i / SAMPLE_RATE));
+            for (uint32_t channel = 0; channel < channels; ++channel)
+            {
+                pcm[i * channels + channel] = value;
+            }
+        }
+        const uint32_t dataSize = (uint32_t) (pcm.size() * sizeof(int16_t));
+        const uint32_t byteRate = SAMPLE_RATE * channels * 2;
+        const uint16_t blockAlign = (uint16_t) (channels * 2);
+        const uint16_t format = 1, bits = 16, channelCount = (uint16_t) channels;
+        const uint32_t riffSize = 36 + dataSize, fmtSize = 16, rate = SAMPLE_RATE;
+        FILE *out = fopen(path.c_str(), "wb");
+        if (out == nullptr)
+        {
+            return false;
+        }
+        fwrite("RIFF", 1, 4, out);
+        fwrite(&riffSize, 4, 1, out);
+        fwrite("WAVEfmt ", 1, 8, out);
+        fwrite(&fmtSize, 4, 1, out);
+        fwrite(&format, 2, 1, out);
+        fwrite(&channelCount, 2, 1, out);
+        fwrite(&rate, 4, 1, out);
+        fwrite(&byteRate, 4, 1, out);
+        fwrite(&blockAlign, 2, 1, out);
+        fwrite(&bits, 2, 1, out);
+        fwrite("data", 1, 4, out);
+        fwrite(&dataSize, 4, 1, out);
+        fwrite(pcm.data(), 1, dataSize, out);
+        return fclose(out) == 0;
+    }
+
+    bool writeAssets(const std::string &directory) noexcept
+    {
+        bool ret = writeWav(directory + "/" + LOOP_ASSET, 1, SAMPLE_RATE / 4, 440.f) && writeWav(directory + "/" + SHOT_ASSET, 1, SAMPLE_RATE / 20, 880.f);
+        // Any content that isn't a WAV plays as silence of the duration of its size at 128 kbps
+        FILE *out = fopen((directory + "/" + FD_ASSET).c_str(), "wb");
+        if (ret && out != nullptr)
+        {
+            std::vector<uint8_t> bytes(128 * 1024, 0x55);
+            ret = fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size();
+        }
+        return out != nullptr && fclose(out) == 0 && ret;
+    }
+
+    /**
+     * Wait for the command thread to run every command queued so far
+     */
+    void drainCommands(AudioEngine *engine) noexcept
+    {
+        const int64_t deadline = nowNanos() + (int64_t) RECLAIM_TIMEOUT_MS * 1000000;
+        AudioEngine::CommandStats stats = engine->getCommandStats();
+        while (stats.succeeded + stats.failed < stats.queued && nowNanos() < deadline)
+        {
+            std::this_thread::yield();
+            stats = engine->getCommandStats();
+        }
+    }
+
+    /**
+     * Live looped voices of a scene
+     */
+    class Scene
+    {
+    public:
+        explicit Scene(AudioEngine *engine) noexcept : _engine(engine)
+        {
+        }
+
+        /**
+         * Start or stop voices until count are playing and wait for the GC to reclaim the stopped ones
+         */
+        bool resize(const size_t count) noexcept
+        {
+            if (_voices.size() > count)
+            {
+                while (_voices.size() > count)
+                {
+                    _engine->stop(_voices.back());
+                    _voices.pop_back();
+                }
+                waitReclaimed();
+            }
+            while (_voices.size() < count)
+            {
+                AudioPlayer *player = _engine->createPlayerWithPath(LOOP_ASSET, 0.5f, true, 0, AudioBusTable::BUS_MUSIC);
+                if (player == nullptr || !player->play())
+                {
+                    return false;
+                }
+                _voices.push_back(player->getPlayerId());
+            }
+            return true;
+        }
+
+        bool waitReclaimed() const noexcept
+        {
+            const int64_t deadline = nowNanos() + (int64_t) RECLAIM_TIMEOUT_MS * 1000000;
+            while (nowNanos() < deadline)
+            {
+                const AudioEngine::VoiceStats stats = _engine->getVoiceStats();
+                if (stats.real + stats.virtuals <= _voices.size())
+                {
+                    return true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            fprintf(stderr, "the GC didn't reclaim the stopped voices\n");
+            return false;
+        }
+
+        /**
+         * The voices were stopped by the engine itself, e.g. by stopAll
+         */
+        void forget() noexcept
+        {
+            _voices.clear();
+        }
+
+        const std::vector<int> &getVoices() const noexcept
+        {
+            return _voices;
+        }
+
+    private:
+        AudioEngine *_engine;
+        std::vector<int> _voices;
+    };
+
+    /**
+     * createPlayerWithPath of a one-shot that is stopped right away, the GC reclaims it meanwhile
+     */
+    void benchCreatePlayer(Benchmark &benchmark, AudioEngine *engine, Scene &scene) noexcept
+    {
+        static const char *const VARIANTS[][2] = {{"sample", SHOT_ASSET}, {"fd", FD_ASSET}};
+        for (const int voices : VOICES)
+        {
+            if (!scene.resize(voices))
+            {
+                return;
+            }
+            for (const auto &variant : VARIANTS)
+            {
+                for (const int threads : THREADS)
+                {
+                    const char *path = variant[1];
+                    Benchmark::Result &result = benchmark.run("engine.create_player", variant[0], voices, threads, [engine, path](const int)
+                    {
+                        AudioPlayer *player = engine->createPlayerWithPath(path, 1.f, false, 0, AudioBusTable::BUS_SFX);
+                        if (player == nullptr || !player->stop())
+                        {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(1)); // Out of handles or tracks until the GC catches up
+                            return 0;
+                        }
+                        return 1;
+                    });
+                    benchmark.print(result, stdout);
+                    scene.waitReclaimed();
+                }
+            }
+        }
+    }
+
+    /**
+     * Handle lookups of random live voices, the std::map under _playersMutex of the first versions
+     */
+    void benchLookup(Benchmark &benchmark) noexcept
+    {
+        constexpr int LOOKUPS = 256;
+        std::unique_ptr<AudioHandleTable> table(new AudioHandleTable());
+        std::vector<int> handles;
+        for (const int voices : VOICES)
+        {
+            while (handles.size() < (size_t) voices)
+            {
+                const int handle = table->reserve();
+                table->publish(handle, reinterpret_cast<AudioPlayer *>(&handles)); // never dereferenced by the table
+                handles.push_back(handle);
+            }
+            for (const int threads : THREADS)
+            {
+                std::vector<uint32_t> seeds(threads);
+                for (int i = 0; i < threads; ++i)
+                {
+                    seeds[i] = 0x9e3779b9u * (i + 1);
+                }
+                Benchmark::Result &result = benchmark.run("engine.lookup", "", voices, threads, [&table, &handles, &seeds](const int thread)
+                {
+                    size_t found = 0;
+                    for (int i = 0; i < LOOKUPS; ++i)
+                    {
+                        const AudioHandleTable::Ref ref = table->acquire(handles[nextRandom(seeds[thread]) % handles.size()]);
+                        found += ref ? 1 : 0;
+                    }
+                    return found;
+                });
+                benchmark.print(result, stdout);
+            }
+        }
+    }
+
+    /**
+     * AudioEngine::setVolume of random live voices: lookup and write of the latest value, the OpenSL call is left to the engine tick
+     * voice_updates is the share of the writes that reached an OpenSL player, the rest was coalesced
+     */
+    void benchSetVolume(Benchmark &benchmark, AudioEngine *engine, Scene &scene) noexcept
+    {
+        constexpr int CALLS = 16;
+        for (const int voices : VOICES)
+        {
+            if (!scene.resize(voices))
+            {
+                return;
+            }
+            const std::vector<int> &handles = scene.getVoices();
+            for (const int threads : THREADS)
+            {
+                std::vector<uint32_t> seeds(threads);
+                for (int i = 0; i < threads; ++i)
+                {
+                    seeds[i] = 0x85ebca6bu * (i + 1);
+                }
+                const AudioEngine::ParamsStats before = engine->getParamsStats();
+                Benchmark::Result &result = benchmark.run("player.set_volume", "", voices, threads, [engine, &handles, &seeds](const int thread)
+                {
+                    size_t applied = 0;
+                    for (int i = 0; i < CALLS; ++i)
+                    {
+                        const uint32_t random = nextRandom(seeds[thread]);
+                        applied += engine->setVolume(handles[random % handles.size()], 0.25f + (random & 0xff) / 512.f) ? 1 : 0;
+                    }
+                    return applied;
+                });
+                std::this_thread::sleep_for(std::chrono::milliseconds(AudioEngine::PARAMS_RAMP_MS + AudioEngine::PARAMS_TICK_MS)); // The ramps end
+                const AudioEngine::ParamsStats after = engine->getParamsStats();
+                result.metrics.push_back({"voice_updates", (double) (after.updates - before.updates) / std::max<uint64_t>(1, after.writes - before.writes)});
+                benchmark.print(result, stdout);
+            }
+        }
+
+        // The conversion alone: the log10 of the first versions against the table of AudioPlayer::applyGain
+        std::vector<float> volumes(256);
+        for (size_t i = 0; i < volumes.size(); ++i)
+        {
+            volumes[i] = (i + 1) / (float) volumes.size();
+        }
+        volatile int sink = 0;
+        Benchmark::Result &result = benchmark.run("player.millibel", "log10", 0, 1, [&volumes, &sink](const int)
+        {
+            int sum = 0;
+            for (const float volume : volumes)
+            {
+                sum += (int) (2000 * std::log10(volume));
+            }
+            sink = sink + sum;
+            return volumes.size();
+        });
+        benchmark.print(result, stdout);
+        Benchmark::Result &table = benchmark.run("player.millibel", "table", 0, 1, [&volumes, &sink](const int)
+        {
+            int sum = 0;
+            for (const float volume : volumes)
+            {
+                sum += AudioGain::toMillibel(volume);
+            }
+            sink = sink + sum;
+            return volumes.size();
+        });
+        benchmark.print(table, stdout);
+    }
+
+    /**
+     * pauseAll and resumeAll in turn, a duck of the music bus of the scene and its restore, then stopAll of a scene created again before each call
+     */
+    void benchAll(Benchmark &benchmark, AudioEngine *engine, Scene &scene) noexcept
+    {
+        for (const int voices : VOICES)
+        {
+            if (!scene.resize(voices))
+            {
+                return;
+            }
+            bool paused = false;
+            Benchmark::Result &result = benchmark.run("engine.pause_resume_all", "", voices, 1, [engine, &paused](const int)
+            {
+                paused = !paused;
+                return (paused ? engine->pauseAll() : engine->resumeAll()) ? 1 : 0;
+            });
+            if (paused)
+            {
+                engine->resumeAll();
+            }
+            benchmark.print(result, stdout);
+        }
+
+        for (const int voices : VOICES)
+        {
+            if (!scene.resize(voices))
+            {
+                return;
+            }
+            bool ducked = false;
+            Benchmark::Result &result = benchmark.run("engine.bus_volume", "", voices, 1, [engine, &ducked](const int)
+            {
+                ducked = !ducked;
+                return engine->setBusVolume(AudioBusTable::BUS_MUSIC, ducked ? 0.3f : 1.f) ? 1 : 0;
+            });
+            engine->setBusVolume(AudioBusTable::BUS_MUSIC, 1.f);
+            benchmark.print(result, stdout);
+        }
+
+        for (const int voices : VOICES)
+        {
+            Benchmark::Samples samples;
+            const int64_t deadline = benchmark.getDeadline();
+            do
+            {
+                if (!scene.resize(voices))
+                {
+                    return;
+                }
+                const int64_t start = nowNanos();
+                const bool stopped = engine->stopAll();
+                const int64_t ns = nowNanos() - start;
+                if (stopped)
+                {
+                    samples.record(ns, 1);
+                }
+                else
+                {
+                    samples.fail();
+                }
+                scene.forget();
+                scene.waitReclaimed();
+            } while (nowNanos() < deadline);
+            benchmark.print(benchmark.add("engine.stop_all", "", voices, 1, samples), stdout);
+        }
+    }
+
+    /**
+     * Duration of the audioPlayerGc sweeps while every voice is virtual: the GC tracks them all on each pass
+     */
+    void benchGcSweep(Benchmark &benchmark, AudioEngine *engine, Scene &scene) noexcept
+    {
+        constexpr int SWEEP_TIME_MS = 1000; // the GC passes every 100 ms
+        if (!scene.resize(0))
+        {
+            return;
+        }
+        engine->setMaxRealVoices(0);
+        for (const int voices : VOICES)
+        {
+            if (!scene.resize(voices))
+            {
+                break;
+            }
+            const AudioMetrics::TimerStats before = engine->getStats().timers[AudioMetrics::TIMER_GC_SWEEP];
+            Benchmark::Samples samples;
+            const int64_t deadline = benchmark.getDeadline(SWEEP_TIME_MS);
+            while (nowNanos() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            const AudioMetrics::TimerStats after = engine->getStats().timers[AudioMetrics::TIMER_GC_SWEEP];
+            const uint64_t sweeps = after.count - before.count;
+            if (sweeps > 0)
+            {
+                samples.record((int64_t) (after.totalNs - before.totalNs), sweeps);
+            }
+            // Only the mean is known: the registry times the sweeps together and keeps its max since the start
+            Benchmark::Result &result = benchmark.add("engine.gc_sweep", "virtual", voices, 1, samples);
+            result.p50Ns = result.p99Ns = result.maxNs = 0.0;
+            result.metrics.push_back({"sweeps", (double) sweeps});
+            benchmark.print(result, stdout);
+        }
+        scene.resize(0);
+        engine->setMaxRealVoices(AudioHandleTable::CAPACITY);
+    }
+
+    /**
+     * Software mix of every voice into one burst, then its int16 conversion: the cost per voice per buffer
+     */
+    void benchMix(Benchmark &benchmark) noexcept
+    {
+        std::vector<int16_t> pcm(SAMPLE_RATE * 2);
+        for (size_t i = 0; i < pcm.size(); ++i)
+        {
+            pcm[i] = (int16_t) (12000.0 * std::sin(i * 0.05));
+        }
+        std::vector<float> mix(BURST_FRAMES * 2);
+        std::vector<int16_t> out(BURST_FRAMES * 2);
+        for (const int channels : {1, 2})
+        {
+            for (const int voices : VOICES)
+            {
+                size_t offset = 0;
+                Benchmark::Result &result = benchmark.run("mixer.mix", channels == 1 ? "mono" : "stereo", voices, 1, [&, channels, voices](const int)
+                {
+                    std::fill(mix.begin(), mix.end(), 0.f);
+                    for (int voice = 0; voice < voices; ++voice)
+                    {
+                        const int16_t *in = pcm.data() + ((offset + voice * 37) % (SAMPLE_RATE - BURST_FRAMES)) * channels;
+                        if (channels == 1)
+                        {
+                            AudioMixKernels::mixMono(mix.data(), in, BURST_FRAMES, 0.1f, 0.2f);
+                        }
+                        else
+                        {
+                            AudioMixKernels::mixStereo(mix.data(), in, BURST_FRAMES, 0.1f, 0.2f);
+                        }
+                    }
+                    AudioMixKernels::toInt16(out.data(), mix.data(), mix.size());
+                    offset += BURST_FRAMES;
+                    return (size_t) voices;
+                });
+                result.metrics.push_back({"frames", (double) BURST_FRAMES});
+                benchmark.print(result, stdout);
+            }
+        }
+    }
+
+    /**
+     * Signal to noise ratio of a resampled sine against the exact sine at the same positions
+     */
+    double measureSnr(const float pitch, const double frequency) noexcept
+    {
+        constexpr size_t FRAMES = 8192;
+        std::vector<int16_t> in(SAMPLE_RATE); // whole periods of the tone so that the loop is seamless
+        for (size_t i = 0; i < in.size(); ++i)
+        {
+            in[i] = (int16_t) std::lrint(16000.0 * std::sin(2.0 * M_PI * frequency * i / SAMPLE_RATE));
+        }
+        std::vector<float> out(FRAMES * 2, 0.f);
+        const double start = 1000.25;
+        AudioMixKernels::mixResampled(out.data(), in.data(), 1, in.size(), true, start, pitch, pitch, FRAMES, 1.f, 1.f);
+        double signal = 0.0, noise = 0.0;
+        for (size_t i = 0; i < FRAMES; ++i)
+        {
+            const double expected = 16000.0 * std::sin(2.0 * M_PI * frequency * (start + i * (double) pitch) / SAMPLE_RATE);
+            const double error = out[i * 2] - expected;
+            signal += expected * expected;
+            noise += error * error;
+        }
+        return noise > 0.0 ? 10.0 * std::log10(signal / noise) : 200.0;
+    }
+
+    /**
+     * Variable rate resampling of a decoded voice across the pitch range, CPU per output frame and quality
+     */
+    void benchResampler(Benchmark &benchmark) noexcept
+    {
+        std::vector<int16_t> pcm(SAMPLE_RATE);
+        for (size_t i = 0; i < pcm.size(); ++i)
+        {
+            pcm[i] = (int16_t) (12000.0 * std::sin(2.0 * M_PI * 440.0 * i / SAMPLE_RATE));
+        }
+        std::vector<float> mix(BURST_FRAMES * 2);
+        for (const float pitch : PITCHES)
+        {
+            char variant[16];
+            snprintf(variant, sizeof(variant), "pitch=%.2f", pitch);
+            double position = 0.0;
+            Benchmark::Result &result = benchmark.run("resampler.pitch", variant, 1, 1, [&, pitch](const int)
+            {
+                position = AudioMixKernels::mixResampled(mix.data(), pcm.data(), 1, pcm.size(), true, position, pitch, pitch, BURST_FRAMES, 0.5f, 0.5f);
+                return BURST_FRAMES;
+            });
+            result.metrics.push_back({"snr_db_1k", measureSnr(pitch, 1000.0)});
+            result.metrics.push_back({"snr_db_8k", measureSnr(pitch, 8000.0)});
+            benchmark.print(result, stdout);
+        }
+    }
+
+    /**
+     * A frame of 100 volume changes: 100 posted commands, as the JNI calls of AudioPlayer.java do, against one submitted batch
+     * Only the caller side is timed, the command thread drains the frame before the next one
+     */
+    void benchCommands(Benchmark &benchmark, AudioEngine *engine, Scene &scene) noexcept
+    {
+        if (!scene.resize(COMMANDS_PER_FRAME))
+        {
+            return;
+        }
+        const std::vector<int> &handles = scene.getVoices();
+        std::vector<uint8_t> batch;
+        for (int i = 0; i < COMMANDS_PER_FRAME; ++i)
+        {
+            const int32_t header[2] = {AudioCommand::TYPE_SET_VOLUME, handles[i]};
+            const float volume = 0.5f;
+            const uint8_t *bytes = reinterpret_cast<const uint8_t *>(header);
+            batch.insert(batch.end(), bytes, bytes + sizeof(header));
+            bytes = reinterpret_cast<const uint8_t *>(&volume);
+            batch.insert(batch.end(), bytes, bytes + sizeof(volume));
+        }
+        for (const bool batched : {false, true})
+        {
+            Benchmark::Samples samples;
+            const int64_t deadline = benchmark.getDeadline();
+            const AudioEngine::CommandStats before = engine->getCommandStats();
+            const AudioEngine::ParamsStats paramsBefore = engine->getParamsStats();
+            int64_t appliedNs = 0;
+            while (nowNanos() < deadline)
+            {
+                const int64_t start = nowNanos();
+                int queued = 0;
+                if (batched)
+                {
+                    queued = engine->submit(batch.data(), batch.size());
+                }
+                else
+                {
+                    for (int i = 0; i < COMMANDS_PER_FRAME; ++i)
+                    {
+                        queued += engine->post(AudioCommand::make(AudioCommand::TYPE_SET_VOLUME, handles[i], 0.5f)) ? 1 : 0;
+                    }
+                }
+                const int64_t ns = nowNanos() - start;
+                drainCommands(engine);
+                appliedNs += nowNanos() - start;
+                if (queued == COMMANDS_PER_FRAME)
+                {
+                    samples.record(ns, 1);
+                }
+                else
+                {
+                    samples.fail();
+                }
+            }
+            const AudioEngine::CommandStats after = engine->getCommandStats();
+            const AudioEngine::ParamsStats paramsAfter = engine->getParamsStats();
+            Benchmark::Result &result = benchmark.add("command.frame_x100", batched ? "submit" : "post", COMMANDS_PER_FRAME, 1, samples);
+            const uint64_t frames = std::max<uint64_t>(1, result.operations + result.failures);
+            result.metrics.push_back({"applied_ns", (double) appliedNs / frames});
+            result.metrics.push_back({"voice_updates", (double) (paramsAfter.updates - paramsBefore.updates) / frames});
+            result.metrics.push_back({"dropped", (double) (after.dropped - before.dropped)});
+            benchmark.print(result, stdout);
+        }
+    }
+
+    /**
+     * Caller side of a sound creation: createPlayerWithPath on the caller thread against createPlayerAsync on the command thread
+     * One sound per millisecond, a busy game scene, so that the command thread keeps up
+     */
+    void benchCreateCaller(Benchmark &benchmark, AudioEngine *engine, Scene &scene) noexcept
+    {
+        if (!scene.resize(32))
+        {
+            return;
+        }
+        for (const bool async : {false, true})
+        {
+            Benchmark::Samples samples;
+            const int64_t deadline = benchmark.getDeadline();
+            while (nowNanos() < deadline)
+            {
+                const int64_t start = nowNanos();
+                int audioId = -1;
+                if (async)
+                {
+                    audioId = engine->createPlayerAsync(SHOT_ASSET, 1.f, false, 0, AudioBusTable::BUS_SFX);
+                }
+                else
+                {
+                    AudioPlayer *player = engine->createPlayerWithPath(SHOT_ASSET, 1.f, false, 0, AudioBusTable::BUS_SFX);
+                    audioId = player != nullptr ? player->getPlayerId() : -1;
+                }
+                const int64_t ns = nowNanos() - start;
+                if (audioId > 0)
+                {
+                    samples.record(ns, 1);
+                    engine->post(AudioCommand::make(AudioCommand::TYPE_STOP, audioId));
+                }
+                else
+                {
+                    samples.fail();
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            benchmark.print(benchmark.add("command.create_caller", async ? "async" : "sync", 32, 1, samples), stdout);
+            scene.waitReclaimed();
+        }
+    }
+
+    /**
+     * Bursts of short sounds as a game fires them: createPlayerAsync then a play, like AudioPlayer.java, against a single playOneShot
+     * ops_per_sec is the rate of the callers, triggers_per_sec the rate at which the command thread got them playing
+     */
+    void benchTriggers(Benchmark &benchmark, AudioEngine *engine, Scene &scene) noexcept
+    {
+        if (!scene.resize(32))
+        {
+            return;
+        }
+        for (const bool oneShot : {false, true})
+        {
+            Benchmark::Samples samples;
+            const int64_t deadline = benchmark.getDeadline();
+            const AudioEngine::CommandStats before = engine->getCommandStats();
+            int64_t appliedNs = 0;
+            uint64_t triggers = 0;
+            do
+            {
+                const int64_t start = nowNanos();
+                int triggered = 0;
+                for (int i = 0; i < TRIGGERS_PER_BURST; ++i)
+                {
+                    if (oneShot)
+                    {
+                        triggered += engine->playOneShot(SHOT_ASSET, 1.f, (i & 1) != 0 ? -0.5f : 0.5f, 1.f, 0, AudioBusTable::BUS_SFX) ? 1 : 0;
+                    }
+                    else
+                    {
+                        const int audioId = engine->createPlayerAsync(SHOT_ASSET, 1.f, false, 0, AudioBusTable::BUS_SFX);
+                        triggered += audioId > 0 && engine->post(AudioCommand::make(AudioCommand::TYPE_PLAY, audioId)) ? 1 : 0;
+                    }
+                }
+                const int64_t ns = nowNanos() - start;
+                drainCommands(engine);
+                appliedNs += nowNanos() - start;
+                triggers += triggered;
+                if (triggered == TRIGGERS_PER_BURST)
+                {
+                    samples.record(ns, TRIGGERS_PER_BURST);
+                }
+                else
+                {
+                    samples.fail();
+                }
+                engine->stopBus(AudioBusTable::BUS_SFX); // Only the bus reaches the one-shots before their end
+                scene.waitReclaimed();
+            } while (nowNanos() < deadline);
+            const AudioEngine::CommandStats after = engine->getCommandStats();
+            Benchmark::Result &result = benchmark.add("command.trigger", oneShot ? "one_shot" : "player", 32, 1, samples);
+            result.metrics.push_back({"triggers_per_sec", appliedNs > 0 ? triggers * 1e9 / appliedNs : 0.0});
+            result.metrics.push_back({"commands_per_trigger", (double) (after.queued - before.queued) / std::max<uint64_t>(1, triggers)});
+            benchmark.print(result, stdout);
+        }
+    }
+
+    void usage() noexcept
+    {
+        fprintf(stderr,
+                "usage: audiobenchmark [options]\n"
+                "  --filter <text>             only the benchmarks whose name contains the text\n"
+                "  --min-time <ms>             of each measure (200)\n"
+                "  --json <path>               write the results and the build context as JSON\n"
+                "  --assets <dir>              directory of generated assets (a temporary directory)\n"
+                "  --create-latency-us <us>    simulated cost of CreateAudioPlayer (0)\n"
+                "  --realize-latency-us <us>   simulated cost of Realize (0)\n");
+    }
+
+    bool parseOptions(const int argc, char **argv, Options &options) noexcept
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--filter" && hasValue)
+            {
+                options.filter = argv[++i];
+            }
+            else if (arg == "--min-time" && hasValue)
+            {
+                options.minTimeMs = atoi(argv[++i]);
+            }
+            else if (arg == "--json" && hasValue)
+            {
+                options.json = argv[++i];
+            }
+            else if (arg == "--assets" && hasValue)
+            {
+                options.assets = argv[++i];
+            }
+            else if (arg == "--create-latency-us" && hasValue)
+            {
+                options.createLatencyUs = atoi(argv[++i]);
+            }
+            else if (arg == "--realize-latency-us" && hasValue)
+            {
+                options.realizeLatencyUs = atoi(argv[++i]);
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return options.minTimeMs > 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage();
+        return 2;
+    }
+    if (options.assets.empty())
+    {
+        char directory[] = "/tmp/audiobenchmarkXXXXXX";
+        if (mkdtemp(directory) == nullptr)
+        {
+            perror("mkdtemp");
+            return 1;
+        }
+        options.assets = directory;
+    }
+    mkdir(options.assets.c_str(), 0755);
+    if (!writeAssets(options.assets))
+    {
+        fprintf(stderr, "can't write the assets in %s\n", options.assets.c_str());
+        return 1;
+    }
+
+    AudioHostBackend::Config config;
+    config.assetsPath = options.assets;
+    config.maxTracks = AudioHandleTable::CAPACITY; // the engine budget is the one measured, not AudioFlinger's
+    config.createLatencyUs = options.createLatencyUs;
+    config.realizeLatencyUs = options.realizeLatencyUs;
+    config.sampleRate = SAMPLE_RATE;
+    AudioEngine *engine = AudioEngine::getInstance();
+    if (!engine->setBackend(std::unique_ptr<AudioBackend>(new AudioHostBackend(config))))
+    {
+        fprintf(stderr, "setBackend fail\n");
+        return 1;
+    }
+    engine->setMaxRealVoices(AudioHandleTable::CAPACITY);
+    engine->setPlayerPoolSize(0); // every creation realizes its player
+    engine->setOutputConfig(SAMPLE_RATE, BURST_FRAMES);
+
+    Benchmark benchmark(options.minTimeMs, options.filter);
+    Scene scene(engine);
+    printf("name\tvariant\tvoices\tthreads\toperations\tfailures\tns_per_op\tops_per_sec\tp50_ns\tp99_ns\tmax_ns\tmetrics\n");
+    if (benchmark.isSelected("engine.create_player"))
+    {
+        benchCreatePlayer(benchmark, engine, scene);
+    }
+    if (benchmark.isSelected("engine.lookup"))
+    {
+        benchLookup(benchmark);
+    }
+    if (benchmark.isSelected("player.set_volume") || benchmark.isSelected("player.millibel"))
+    {
+        benchSetVolume(benchmark, engine, scene);
+    }
+    if (benchmark.isSelected("engine.pause_resume_all") || benchmark.isSelected("engine.bus_volume") || benchmark.isSelected("engine.stop_all"))
+    {
+        benchAll(benchmark, engine, scene);
+    }
+    if (benchmark.isSelected("engine.gc_sweep"))
+    {
+        benchGcSweep(benchmark, engine, scene);
+    }
+    if (benchmark.isSelected("mixer.mix"))
+    {
+        benchMix(benchmark);
+    }
+    if (benchmark.isSelected("resampler.pitch"))
+    {
+        benchResampler(benchmark);
+    }
+    if (benchmark.isSelected("command.frame_x100"))
+    {
+        benchCommands(benchmark, engine, scene);
+    }
+    if (benchmark.isSelected("command.create_caller"))
+    {
+        benchCreateCaller(benchmark, engine, scene);
+    }
+    if (benchmark.isSelected("command.trigger"))
+    {
+        benchTriggers(benchmark, engine, scene);
+    }
+
+    int ret = 0;
+    if (!options.json.empty())
+    {
+        std::vector<std::pair<std::string, std::string>> context;
+        context.push_back({"compiler", __VERSION__});
+        context.push_back({"kernels", AudioMixKernels::getName()});
+        context.push_back({"metrics", AUDIO_METRICS ? "on" : "off"});
+        context.push_back({"trace", AudioTrace::isEnabled() ? "on" : "off"});
+        context.push_back({"cores", std::to_string(std::thread::hardware_concurrency())});
+        context.push_back({"min_time_ms", std::to_string(options.minTimeMs)});
+        if (!benchmark.writeJson(options.json, context))
+        {
+            fprintf(stderr, "can't write %s\n", options.json.c_str());
+            ret = 1;
+        }
+    }
+    scene.resize(0);
+    AudioEngine::destroy();
+    return ret;
+}
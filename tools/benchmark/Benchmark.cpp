@@ -0,0 +1,161 @@
+#include "Benchmark.h"
+#include <algorithm>
+
+using namespace audio;
+
+namespace
+{
+    double percentile(std::vector<double> &values, const double fraction) noexcept
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        const size_t index = std::min(values.size() - 1, (size_t) (fraction * values.size()));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    void writeJsonString(FILE *out, const std::string &value) noexcept
+    {
+        fputc('"', out);
+        for (const char c : value)
+        {
+            if (c == '"' || c == '\\')
+            {
+                fputc('\\', out);
+            }
+            fputc(c, out);
+        }
+        fputc('"', out);
+    }
+}
+
+Benchmark::Samples::Samples() noexcept : _operations(0)
+, _failures(0)
+, _busyNs(0)
+, _start(nowNanos())
+{
+}
+
+void Benchmark::Samples::record(const int64_t ns, const uint64_t operations) noexcept
+{
+    if (_nsPerOperation.size() < MAX_SAMPLES)
+    {
+        _nsPerOperation.push_back((double) ns / operations);
+    }
+    _operations += operations;
+    _busyNs += ns;
+}
+
+void Benchmark::Samples::fail() noexcept
+{
+    ++_failures;
+}
+
+Benchmark::Benchmark(const int minTimeMs, const std::string &filter) noexcept : _minTimeMs(minTimeMs)
+, _filter(filter)
+{
+}
+
+/**
+ * A benchmark runs if its name contains the filter
+ */
+bool Benchmark::isSelected(const std::string &name) const noexcept
+{
+    return _filter.empty() || name.find(_filter) != std::string::npos;
+}
+
+/**
+ * End of a loop timed by the benchmark itself, never shorter than the minimum time of the run
+ */
+int64_t Benchmark::getDeadline(const int minTimeMs) const noexcept
+{
+    return nowNanos() + (int64_t) std::max(minTimeMs, _minTimeMs) * 1000000;
+}
+
+Benchmark::Result &Benchmark::add(const std::string &name, const std::string &variant, const int voices, const int threads, Samples &samples) noexcept
+{
+    const int64_t wallNs = nowNanos() - samples._start;
+    Result result;
+    result.name = name;
+    result.variant = variant;
+    result.voices = voices;
+    result.threads = threads;
+    result.operations = samples._operations;
+    result.failures = samples._failures;
+    if (samples._operations > 0)
+    {
+        result.nsPerOperation = (double) samples._busyNs / samples._operations;
+    }
+    if (wallNs > 0)
+    {
+        result.operationsPerSecond = samples._operations * 1e9 / wallNs;
+    }
+    result.p50Ns = percentile(samples._nsPerOperation, 0.50);
+    result.p99Ns = percentile(samples._nsPerOperation, 0.99);
+    if (!samples._nsPerOperation.empty())
+    {
+        result.maxNs = *std::max_element(samples._nsPerOperation.begin(), samples._nsPerOperation.end());
+    }
+    _results.push_back(std::move(result));
+    return _results.back();
+}
+
+/**
+ * One tab separated line per result, the extra metrics go last as name=value
+ */
+void Benchmark::print(const Result &result, FILE *out) const noexcept
+{
+    fprintf(out, "%s\t%s\t%d\t%d\t%llu\t%llu\t%.2f\t%.0f\t%.2f\t%.2f\t%.2f\t", result.name.c_str(), result.variant.empty() ? "-" : result.variant.c_str(),
+            result.voices, result.threads, (unsigned long long) result.operations, (unsigned long long) result.failures,
+            result.nsPerOperation, result.operationsPerSecond, result.p50Ns, result.p99Ns, result.maxNs);
+    for (size_t i = 0; i < result.metrics.size(); ++i)
+    {
+        fprintf(out, "%s%s=%.3f", i > 0 ? "," : "", result.metrics[i].first.c_str(), result.metrics[i].second);
+    }
+    fputc('\n', out);
+    fflush(out);
+}
+
+/**
+ * The context describes the build so that the results of two builds can be compared
+ */
+bool Benchmark::writeJson(const std::string &path, const std::vector<std::pair<std::string, std::string>> &context) const noexcept
+{
+    FILE *out = fopen(path.c_str(), "w");
+    if (out == nullptr)
+    {
+        return false;
+    }
+    fprintf(out, "{\n  \"context\": {");
+    for (size_t i = 0; i < context.size(); ++i)
+    {
+        fprintf(out, "%s\n    ", i > 0 ? "," : "");
+        writeJsonString(out, context[i].first);
+        fprintf(out, ": ");
+        writeJsonString(out, context[i].second);
+    }
+    fprintf(out, "\n  },\n  \"results\": [");
+    for (size_t i = 0; i < _results.size(); ++i)
+    {
+        const Result &result = _results[i];
+        fprintf(out, "%s\n    {\"name\": ", i > 0 ? "," : "");
+        writeJsonString(out, result.name);
+        fprintf(out, ", \"variant\": ");
+        writeJsonString(out, result.variant);
+        fprintf(out, ", \"voices\": %d, \"threads\": %d, \"operations\": %llu, \"failures\": %llu, \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f, "
+                     "\"p50_ns\": %.3f, \"p99_ns\": %.3f, \"max_ns\": %.3f",
+                result.voices, result.threads, (unsigned long long) result.operations, (unsigned long long) result.failures,
+                result.nsPerOperation, result.operationsPerSecond, result.p50Ns, result.p99Ns, result.maxNs);
+        for (const std::pair<std::string, double> &metric : result.metrics)
+        {
+            fprintf(out, ", ");
+            writeJsonString(out, metric.first);
+            fprintf(out, ": %.3f", metric.second);
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+    return fclose(out) == 0;
+}
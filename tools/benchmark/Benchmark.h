@@ -0,0 +1,151 @@
+#ifndef __Benchmark__
+#define __Benchmark__
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include "AudioUtils.h"
+
+namespace audio
+{
+    /**
+     * Timed loops of the host benchmarks and their results
+     * run() calls an operation from every thread until the minimum time is spent, each call is timed on its own:
+     * the percentiles are per operation of a call, an operation returning many cheap operations amortizes the clock
+     */
+    class Benchmark
+    {
+    public:
+        struct Result
+        {
+            std::string name;
+            std::string variant; // e.g. the pitch ratio, empty if none
+            int voices = 0;
+            int threads = 1;
+            uint64_t operations = 0;
+            uint64_t failures = 0; // calls that returned no operation
+            double nsPerOperation = 0.0; // busy time of the threads per operation
+            double operationsPerSecond = 0.0; // all the threads together
+            double p50Ns = 0.0;
+            double p99Ns = 0.0;
+            double maxNs = 0.0;
+            std::vector<std::pair<std::string, double>> metrics; // extra values of a benchmark
+        };
+
+        /**
+         * Durations of a loop timed by the benchmark itself, e.g. when each call needs an untimed setup
+         */
+        class Samples
+        {
+        public:
+            Samples() noexcept;
+
+            void record(const int64_t ns, const uint64_t operations) noexcept;
+
+            void fail() noexcept;
+
+        private:
+            friend class Benchmark;
+
+            std::vector<double> _nsPerOperation;
+            uint64_t _operations;
+            uint64_t _failures;
+            int64_t _busyNs;
+            int64_t _start;
+        };
+
+    public:
+        Benchmark(const int minTimeMs, const std::string &filter) noexcept;
+
+        Benchmark(const Benchmark &) = delete;
+
+        Benchmark &operator=(const Benchmark &) & = delete;
+
+        Benchmark(Benchmark &&) = delete;
+
+        Benchmark &operator=(Benchmark &&) & = delete;
+
+        ~Benchmark() = default;
+
+    public:
+        bool isSelected(const std::string &name) const noexcept;
+
+        int64_t getDeadline(const int minTimeMs = 0) const noexcept;
+
+        /**
+         * operation(thread) runs some operations and returns how many, 0 if it failed
+         */
+        template<typename Operation>
+        Result &run(const std::string &name, const std::string &variant, const int voices, const int threads, Operation &&operation) noexcept
+        {
+            std::vector<Samples> samples(threads);
+            std::atomic<int> ready(0);
+            std::atomic<bool> stop(false);
+            std::vector<std::thread> workers;
+            for (int thread = 0; thread < threads; ++thread)
+            {
+                workers.emplace_back([&samples, &ready, &stop, &operation, thread]()
+                {
+                    Samples &own = samples[thread];
+                    own._nsPerOperation.reserve(MAX_SAMPLES);
+                    ++ready;
+                    while (!stop.load(std::memory_order_relaxed))
+                    {
+                        const int64_t start = nowNanos();
+                        const size_t count = operation(thread);
+                        const int64_t ns = nowNanos() - start;
+                        if (count > 0)
+                        {
+                            own.record(ns, count);
+                        }
+                        else
+                        {
+                            own.fail();
+                        }
+                    }
+                });
+            }
+            while (ready.load() < threads)
+            {
+                std::this_thread::yield();
+            }
+            const int64_t start = nowNanos();
+            std::this_thread::sleep_for(std::chrono::milliseconds(_minTimeMs));
+            stop = true;
+            for (std::thread &worker : workers)
+            {
+                worker.join();
+            }
+            Samples merged;
+            merged._start = start;
+            for (Samples &own : samples)
+            {
+                merged._nsPerOperation.insert(merged._nsPerOperation.end(), own._nsPerOperation.begin(), own._nsPerOperation.end());
+                merged._operations += own._operations;
+                merged._failures += own._failures;
+                merged._busyNs += own._busyNs;
+            }
+            return add(name, variant, voices, threads, merged);
+        }
+
+        Result &add(const std::string &name, const std::string &variant, const int voices, const int threads, Samples &samples) noexcept;
+
+        void print(const Result &result, FILE *out) const noexcept;
+
+        bool writeJson(const std::string &path, const std::vector<std::pair<std::string, std::string>> &context) const noexcept;
+
+    private:
+        static constexpr size_t MAX_SAMPLES = 1 << 20; // per thread, the percentiles of a longer run are those of its start
+
+        int _minTimeMs;
+        std::string _filter;
+        std::deque<Result> _results; // a Result returned by run() or add() stays valid
+    };
+}
+
+#endif
@@ -0,0 +1,708 @@
+/**
+ * Scenario driven stress harness of the engine, run on the build host against AudioHostBackend, never part of the shipped library
+ *
+ * Build: ./gradlew :app:stress, or from the repository root with the SLES/, android/ and jni.h headers of the NDK sysroot:
+ *   c++ -std=c++14 -O2 -pthread -idirafter $NDK_SYSROOT/usr/include -D'__INTRODUCED_IN(api)=' -Iapp/src/main/jni -Itools/stress \
+ *       $(find app/src/main/jni tools/stress -name '*.cpp') -o audiostress
+ * Usage: audiostress [options] <scenario>...
+ *
+ * Each scenario gets a fresh engine: its trigger threads create, play, stop and change the volume of sounds at their rates while
+ * a storm thread pauses, resumes and stops everything and preloads batches. Once the load stops the harness waits for the GC and
+ * checks that no player, fd or preload listener outlived its sounds: on a device a leaked listener is a leaked GlobalRef.
+ * Before the scenarios the "handles" check makes sure that a handle given back to the AudioHandleTable is never issued again.
+ * The report goes to stdout as "scenario key value" tab separated lines, the exit code is 1 if a scenario or a check failed.
+ */
+#include "StressScenario.h"
+#include "AudioEngine.h"
+#include "AudioHandleTable.h"
+#include "AudioHistogram.h"
+#include "AudioHostBackend.h"
+#include "AudioMetrics.h"
+#include "AudioPlayer.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace audio;
+
+namespace
+{
+    constexpr int SETTLE_TIMEOUT_MS = 5000;
+
+    const char *const LATENCY_NAMES[AudioEngine::LATENCY_COUNT] = {"create", "realize", "prefetch", "start", "sound"};
+
+    struct Options
+    {
+        std::string assets; // generated in a temporary directory if empty
+        int durationMs = 0; // overrides the scenarios, e.g. for a soak
+        std::vector<std::string> scenarios;
+    };
+
+    /**
+     * Counters of a run, shared by its threads
+     */
+    struct Run
+    {
+        std::atomic<uint64_t> triggers{0};
+        std::atomic<uint64_t> createFailures{0};
+        std::atomic<uint64_t> playFailures{0};
+        std::atomic<uint64_t> volumes{0};
+        std::atomic<uint64_t> pauseResumes{0};
+        std::atomic<uint64_t> stopAlls{0};
+        std::atomic<uint64_t> preloads{0};
+        std::atomic<uint64_t> busChanges{0};
+        AudioHistogram callerLatency; // of the create and play calls of a trigger
+    };
+
+    std::atomic<int> gListeners(0);
+
+    /**
+     * Stands for AudioPreloadListener.java: the JNI listener holds a GlobalRef until the engine deletes it
+     */
+    class CountingListener : public AudioPreloader::Listener
+    {
+    public:
+        CountingListener() noexcept
+        {
+            ++gListeners;
+        }
+
+        ~CountingListener() override
+        {
+            --gListeners;
+        }
+
+        void onPathLoaded(const int, const std::string &, const bool) noexcept override
+        {
+        }
+
+        void onBatchLoaded(const int, const int, const int) noexcept override
+        {
+        }
+    };
+
+    struct Voice
+    {
+        int audioId;
+        int64_t stopAt; // 0 if the voice ends by itself
+    };
+
+    /**
+     * xorshift, each thread draws its own sounds from the seed of the scenario
+     */
+    uint32_t nextRandom(uint32_t &state) noexcept
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    bool draw(uint32_t &state, const double ratio) noexcept
+    {
+        return (nextRandom(state) & 0xffffff) < ratio * 0x1000000;
+    }
+
+    int64_t periodOf(const double rate) noexcept
+    {
+        return rate > 0.0 ? (int64_t) (1e9 / rate) : 0;
+    }
+
+    /**
+     * Next time of an event at a period, never for a period of 0
+     * An overloaded host lowers the rate, it doesn't burst to catch up
+     */
+    int64_t nextOf(const int64_t time, const int64_t period, const int64_t now) noexcept
+    {
+        return period > 0 ? std::max(time + period, now - period) : INT64_MAX;
+    }
+
+    /**
+     * Generate an asset that the assets directory doesn't have, a real asset with the same name is played as is
+     */
+    bool writeAsset(const std::string &directory, const StressScenario::Asset &asset, const AudioHostBackend::Config &config) noexcept
+    {
+        const std::string path = directory + "/" + asset.path;
+        if (access(path.c_str(), R_OK) == 0)
+        {
+            return true;
+        }
+        FILE *out = fopen(path.c_str(), "wb");
+        if (out == nullptr)
+        {
+            return false;
+        }
+        bool ret = false;
+        const size_t dot = asset.path.find_last_of('.');
+        if (dot != std::string::npos && asset.path.substr(dot) == ".wav")
+        {
+            const uint32_t frames = (uint32_t) (asset.seconds * config.sampleRate);
+            std::vector<int16_t> pcm(frames);
+            for (uint32_t i = 0; i < frames; ++i)
+            {
+                pcm[i] = (int16_t) (12000.0 * std::sin(2.0 * M_PI * 440.0 * i / config.sampleRate));
+            }
+            const uint32_t dataSize = frames * 2, riffSize = 36 + dataSize, fmtSize = 16, rate = config.sampleRate, byteRate = rate * 2;
+            const uint16_t format = 1, channels = 1, blockAlign = 2, bits = 16;
+            fwrite("RIFF", 1, 4, out);
+            fwrite(&riffSize, 4, 1, out);
+            fwrite("WAVEfmt ", 1, 8, out);
+            fwrite(&fmtSize, 4, 1, out);
+            fwrite(&format, 2, 1, out);
+            fwrite(&channels, 2, 1, out);
+            fwrite(&rate, 4, 1, out);
+            fwrite(&byteRate, 4, 1, out);
+            fwrite(&blockAlign, 2, 1, out);
+            fwrite(&bits, 2, 1, out);
+            fwrite("data", 1, 4, out);
+            fwrite(&dataSize, 4, 1, out);
+            ret = fwrite(pcm.data(), 1, dataSize, out) == dataSize;
+        }
+        else
+        {
+            // Any content that isn't a WAV plays as silence of the duration of its size at the compressed bit rate
+            std::vector<uint8_t> bytes((size_t) (asset.seconds * config.compressedBitRate / 8), 0x55);
+            ret = fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size();
+        }
+        return fclose(out) == 0 && ret;
+    }
+
+    int countOpenFds() noexcept
+    {
+        int ret = -1; // the fd of the listing itself
+        DIR *directory = opendir("/proc/self/fd");
+        if (directory == nullptr)
+        {
+            return 0;
+        }
+        while (readdir(directory) != nullptr)
+        {
+            ++ret;
+        }
+        closedir(directory);
+        return ret - 2; // . and ..
+    }
+
+    /**
+     * Start a sound of the scenario as AudioPlayer.java does, inline when the scenario turns the command thread off
+     */
+    int trigger(AudioEngine *engine, const StressScenario &scenario, Run &run, uint32_t &state, const size_t index) noexcept
+    {
+        const std::string &path = scenario.assets[index % scenario.assets.size()].path;
+        const bool loop = draw(state, scenario.loopRatio);
+        const int priority = scenario.maxPriority > 0 ? (int) (nextRandom(state) % (scenario.maxPriority + 1)) : 0;
+        const int64_t start = nowNanos();
+        const int bus = AudioBusTable::BUS_MUSIC + (int) (index % (AudioBusTable::BUILTIN_COUNT - AudioBusTable::BUS_MUSIC));
+        const int audioId = engine->createPlayerAsync(path, 1.f, loop, priority, bus);
+        if (audioId <= 0)
+        {
+            ++run.createFailures;
+        }
+        else if (!engine->post(AudioCommand::make(AudioCommand::TYPE_PLAY, audioId)))
+        {
+            ++run.playFailures;
+        }
+        run.callerLatency.record(nowNanos() - start);
+        ++run.triggers;
+        return audioId;
+    }
+
+    /**
+     * Queued behind the creation of the sound like the calls of AudioPlayer.java, it fails once the sound ended or was stolen
+     */
+    void stop(AudioEngine *engine, const int audioId) noexcept
+    {
+        engine->post(AudioCommand::make(AudioCommand::TYPE_STOP, audioId));
+    }
+
+    /**
+     * A game thread: sounds at the trigger rate, at most maxVoices of its own, and volume changes of the live ones
+     */
+    void triggerThread(AudioEngine *engine, const StressScenario &scenario, Run &run, const int thread, const int64_t deadline) noexcept
+    {
+        uint32_t state = scenario.backend.seed * 2654435761u + 0x9e3779b9u * (thread + 1);
+        const int64_t triggerPeriod = periodOf(scenario.triggerRate);
+        const int64_t volumePeriod = periodOf(scenario.volumeRate);
+        const int64_t start = nowNanos();
+        int64_t nextTrigger = triggerPeriod > 0 ? start : INT64_MAX;
+        int64_t nextVolume = volumePeriod > 0 ? start : INT64_MAX;
+        size_t cycle = (size_t) thread;
+        std::deque<Voice> voices;
+        while (true)
+        {
+            int64_t now = nowNanos();
+            if (now >= deadline)
+            {
+                break;
+            }
+            while (!voices.empty() && voices.front().stopAt != 0 && voices.front().stopAt <= now)
+            {
+                stop(engine, voices.front().audioId);
+                voices.pop_front();
+            }
+            if (now >= nextTrigger)
+            {
+                if (voices.size() >= scenario.maxVoices)
+                {
+                    stop(engine, voices.front().audioId);
+                    voices.pop_front();
+                }
+                const size_t index = scenario.cycleAssets ? cycle++ : nextRandom(state);
+                const int audioId = trigger(engine, scenario, run, state, index);
+                if (audioId > 0)
+                {
+                    voices.push_back({audioId, scenario.lifetimeMs > 0 ? now + (int64_t) scenario.lifetimeMs * 1000000 : 0});
+                }
+                nextTrigger = nextOf(nextTrigger, triggerPeriod, now);
+            }
+            if (now >= nextVolume)
+            {
+                if (!voices.empty())
+                {
+                    const uint32_t random = nextRandom(state);
+                    engine->post(AudioCommand::make(AudioCommand::TYPE_SET_VOLUME, voices[random % voices.size()].audioId, 0.25f + (random >> 24) / 340.f));
+                    ++run.volumes;
+                }
+                nextVolume = nextOf(nextVolume, volumePeriod, now);
+            }
+            int64_t wake = std::min(std::min(nextTrigger, nextVolume), deadline);
+            for (const Voice &voice : voices)
+            {
+                if (voice.stopAt != 0)
+                {
+                    wake = std::min(wake, voice.stopAt);
+                    break; // the lifetime is the same for all, the first voice stops first
+                }
+            }
+            now = nowNanos();
+            if (wake > now)
+            {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(wake - now));
+            }
+        }
+        for (const Voice &voice : voices)
+        {
+            stop(engine, voice.audioId);
+        }
+    }
+
+    /**
+     * Posted like the bus calls of AudioEngine.java: a duck of the bus restored or a pause of the bus resumed pauseMs later
+     */
+    void changeBus(AudioEngine *engine, const int bus, const bool duck, const bool undo) noexcept
+    {
+        if (duck)
+        {
+            engine->post(AudioCommand::make(AudioCommand::TYPE_SET_BUS_VOLUME, bus, undo ? 1.f : 0.3f));
+        }
+        else
+        {
+            engine->post(AudioCommand::make(undo ? AudioCommand::TYPE_RESUME_BUS : AudioCommand::TYPE_PAUSE_BUS, bus));
+        }
+    }
+
+    /**
+     * The engine wide calls: pause/resume storms of a game going to the background, stopAll of a scene change, preloads of a level
+     * and the bus changes of a dialog ducking the music or of a menu pausing the effects
+     */
+    void stormThread(AudioEngine *engine, const StressScenario &scenario, Run &run, const int64_t deadline) noexcept
+    {
+        uint32_t state = scenario.backend.seed * 2654435761u + 0x85ebca6bu;
+        const int64_t pausePeriod = periodOf(scenario.pauseResumeRate);
+        const int64_t stopAllPeriod = periodOf(scenario.stopAllRate);
+        const int64_t preloadPeriod = periodOf(scenario.preloadRate);
+        const int64_t busPeriod = periodOf(scenario.busRate);
+        const int64_t start = nowNanos();
+        int64_t nextPause = nextOf(start, pausePeriod, start);
+        int64_t nextStopAll = nextOf(start, stopAllPeriod, start);
+        int64_t nextPreload = nextOf(start, preloadPeriod, start);
+        int64_t nextBus = nextOf(start, busPeriod, start);
+        int64_t resumeAt = INT64_MAX;
+        int64_t busUndoAt = INT64_MAX;
+        int bus = AudioBusTable::BUS_MUSIC;
+        bool duck = false;
+        std::vector<std::string> paths;
+        for (const StressScenario::Asset &asset : scenario.assets)
+        {
+            paths.push_back(asset.path);
+        }
+        while (true)
+        {
+            int64_t now = nowNanos();
+            if (now >= resumeAt)
+            {
+                engine->resumeAll();
+                resumeAt = INT64_MAX;
+                ++run.pauseResumes;
+            }
+            if (now >= busUndoAt)
+            {
+                changeBus(engine, bus, duck, true);
+                busUndoAt = INT64_MAX;
+            }
+            if (now >= deadline)
+            {
+                break;
+            }
+            if (now >= nextPause)
+            {
+                if (resumeAt == INT64_MAX)
+                {
+                    engine->pauseAll();
+                    resumeAt = now + (int64_t) scenario.pauseMs * 1000000;
+                }
+                nextPause = nextOf(nextPause, pausePeriod, now);
+            }
+            if (now >= nextStopAll)
+            {
+                engine->stopAll();
+                ++run.stopAlls;
+                nextStopAll = nextOf(nextStopAll, stopAllPeriod, now);
+            }
+            if (now >= nextPreload)
+            {
+                if (engine->preload(paths, std::unique_ptr<AudioPreloader::Listener>(new CountingListener())) > 0)
+                {
+                    ++run.preloads;
+                }
+                nextPreload = nextOf(nextPreload, preloadPeriod, now);
+            }
+            if (now >= nextBus)
+            {
+                if (busUndoAt == INT64_MAX)
+                {
+                    const uint32_t random = nextRandom(state);
+                    bus = AudioBusTable::BUS_MUSIC + (int) (random % (AudioBusTable::BUILTIN_COUNT - AudioBusTable::BUS_MUSIC));
+                    duck = (random >> 16) % 2 == 0;
+                    changeBus(engine, bus, duck, false);
+                    busUndoAt = now + (int64_t) scenario.pauseMs * 1000000;
+                    ++run.busChanges;
+                }
+                nextBus = nextOf(nextBus, busPeriod, now);
+            }
+            const int64_t wake = std::min(std::min(std::min(nextPause, resumeAt), std::min(nextStopAll, nextPreload)), std::min(std::min(nextBus, busUndoAt), deadline));
+            now = nowNanos();
+            if (wake > now)
+            {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(wake - now));
+            }
+        }
+    }
+
+    /**
+     * Wait until the condition holds, false after SETTLE_TIMEOUT_MS
+     */
+    template<typename Condition>
+    bool waitFor(Condition &&condition) noexcept
+    {
+        const int64_t deadline = nowNanos() + (int64_t) SETTLE_TIMEOUT_MS * 1000000;
+        while (!condition())
+        {
+            if (nowNanos() >= deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return true;
+    }
+
+    /**
+     * Stop what the load left and wait for the engine to be idle: the command thread drained, the preloads finished
+     * and every player reclaimed by the GC, only the idle players of the pool and the mixer remain
+     * The queued creations run before the stopAll, they would play forever otherwise
+     */
+    bool settle(AudioEngine *engine, const AudioHostBackend *backend, const int64_t expectedPlayers) noexcept
+    {
+        const bool drained = waitFor([engine]()
+        {
+            const AudioEngine::CommandStats commands = engine->getCommandStats();
+            return commands.succeeded + commands.failed >= commands.queued && gListeners.load() == 0;
+        });
+        engine->stopAll();
+        return waitFor([engine, backend, expectedPlayers]()
+        {
+            const AudioEngine::VoiceStats voices = engine->getVoiceStats();
+            const AudioHostBackend::Stats stats = backend->getStats();
+            const int64_t players = (int64_t) (stats.created - stats.destroyed) - (int64_t) engine->getPlayerPoolStats().idle;
+            return voices.real + voices.virtuals == 0 && players <= expectedPlayers;
+        }) && drained;
+    }
+
+    void report(const std::string &scenario, const char *key, const double value) noexcept
+    {
+        printf("%s\t%s\t%.3f\n", scenario.c_str(), key, value);
+    }
+
+    void reportLatency(const std::string &scenario, const std::string &name, const AudioHistogram::Snapshot &snapshot) noexcept
+    {
+        if (snapshot.count == 0)
+        {
+            return;
+        }
+        report(scenario, (name + "_p50_us").c_str(), snapshot.p50Ns / 1e3);
+        report(scenario, (name + "_p95_us").c_str(), snapshot.p95Ns / 1e3);
+        report(scenario, (name + "_p99_us").c_str(), snapshot.p99Ns / 1e3);
+        report(scenario, (name + "_max_us").c_str(), snapshot.maxNs / 1e3);
+    }
+
+    /**
+     * Give back every handle of a table with cancel() then with remove() and reserve them all again
+     * A reissued handle would let the caller still holding it reach the next player of its slot
+     */
+    bool checkHandles() noexcept
+    {
+        std::unique_ptr<AudioHandleTable> table(new AudioHandleTable());
+        AudioPlayer player; // Only stored, the table never calls it
+        std::unordered_set<int> released;
+        std::vector<int> handles;
+        uint64_t reissued = 0, staleAcquires = 0;
+        const auto reserveAll = [&](const bool publish)
+        {
+            handles.clear();
+            for (int handle = table->reserve(); handle > 0 && handles.size() <= AudioHandleTable::CAPACITY; handle = table->reserve()) // A slot pushed twice loops the free list
+            {
+                reissued += released.count(handle);
+                handles.push_back(handle);
+                if (publish)
+                {
+                    table->publish(handle, &player);
+                }
+            }
+            for (const int handle : released)
+            {
+                staleAcquires += table->acquire(handle) ? 1 : 0;
+            }
+        };
+
+        reserveAll(false);
+        for (const int handle : handles)
+        {
+            table->cancel(handle);
+            table->cancel(handle); // Ignored, the slot must not be pushed twice on the free list
+            released.insert(handle);
+        }
+        reserveAll(true);
+        for (const int handle : handles)
+        {
+            table->remove(handle);
+            released.insert(handle);
+        }
+        reserveAll(true);
+
+        report("handles", "reserved", (double) handles.size());
+        report("handles", "reissued", (double) reissued);
+        report("handles", "stale_acquires", (double) staleAcquires);
+        const bool ret = handles.size() == AudioHandleTable::CAPACITY && reissued == 0 && staleAcquires == 0;
+        printf("handles\tresult\t%s\n", ret ? "PASS" : "FAIL");
+        fflush(stdout);
+        return ret;
+    }
+
+    /**
+     * Run one scenario on a fresh engine and report it, return false if it leaked or failed too often
+     */
+    bool runScenario(const StressScenario &scenario, const std::string &assets) noexcept
+    {
+        AudioHostBackend::Config config = scenario.backend;
+        config.assetsPath = assets;
+        for (const StressScenario::Asset &asset : scenario.assets)
+        {
+            if (!writeAsset(assets, asset, config))
+            {
+                fprintf(stderr, "can't write %s in %s\n", asset.path.c_str(), assets.c_str());
+                return false;
+            }
+        }
+
+        const int fds = countOpenFds();
+        AudioHostBackend *backend = new AudioHostBackend(config);
+        AudioEngine *engine = AudioEngine::getInstance();
+        if (!engine->setBackend(std::unique_ptr<AudioBackend>(backend)))
+        {
+            fprintf(stderr, "setBackend fail\n");
+            return false;
+        }
+        engine->setOutputConfig(config.sampleRate, AudioMixer::DEFAULT_BUFFER_FRAMES);
+        engine->setMaxRealVoices(scenario.maxRealVoices);
+        engine->setPlayerPoolSize(scenario.playerPoolSize);
+        engine->setCommandThreadEnabled(scenario.commandThread);
+        const bool mixer = scenario.mixer && engine->setMixerEnabled(true);
+
+        Run run;
+        const AudioEngine::CommandStats commandsBefore = engine->getCommandStats();
+        const uint64_t createFailedBefore = AudioMetrics::getStats().counters[AudioMetrics::COUNTER_CREATE_FAILED]; // The counters outlive the engine
+        const int64_t start = nowNanos();
+        const int64_t deadline = start + (int64_t) scenario.durationMs * 1000000;
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < scenario.threads; ++thread)
+        {
+            threads.emplace_back(triggerThread, engine, std::cref(scenario), std::ref(run), thread, deadline);
+        }
+        threads.emplace_back(stormThread, engine, std::cref(scenario), std::ref(run), deadline);
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        const double seconds = (nowNanos() - start) / 1e9;
+
+        const bool settled = settle(engine, backend, mixer ? 1 : 0);
+        engine->setPlayerPoolSize(0);
+        waitFor([engine, fds]()
+        {
+            engine->setAssetCacheCapacity(0); // The cache only drops the descriptors that no player holds anymore
+            return countOpenFds() <= fds;
+        });
+        const AudioHostBackend::Stats backendStats = backend->getStats();
+        const AudioEngine::VoiceStats voices = engine->getVoiceStats();
+        const AudioEngine::CommandStats commands = engine->getCommandStats();
+        const AudioEngine::ParamsStats params = engine->getParamsStats();
+        const AudioEngine::ReclaimStats reclaim = engine->getReclaimStats();
+        const int64_t leakedPlayers = (int64_t) (backendStats.created - backendStats.destroyed) - (mixer ? 1 : 0);
+        const int leakedFds = countOpenFds() - fds;
+        const int leakedListeners = gListeners.load();
+
+        const std::string &name = scenario.name;
+        const uint64_t triggers = run.triggers.load();
+        const uint64_t commandsFailed = commands.failed - commandsBefore.failed;
+        const uint64_t commandsStale = commands.stale - commandsBefore.stale;
+        const uint64_t createFailed = AudioMetrics::getStats().counters[AudioMetrics::COUNTER_CREATE_FAILED] - createFailedBefore;
+        // The caller rejections and the commands the engine failed on a live sound or a creation, each failed creation once
+        // The stale ones target sounds that already ended: a game stops and fades its sounds without tracking their end
+        const uint64_t failures = run.createFailures + run.playFailures + commandsFailed - commandsStale;
+        const double failureRate = triggers > 0 ? (double) failures / triggers : 0.0;
+        report(name, "seconds", seconds);
+        report(name, "triggers", (double) triggers);
+        report(name, "triggers_per_sec", triggers / seconds);
+        report(name, "create_failures", (double) run.createFailures);
+        report(name, "play_failures", (double) run.playFailures);
+        report(name, "engine_create_failures", (double) createFailed);
+        report(name, "failure_rate", failureRate);
+        report(name, "volumes", (double) run.volumes);
+        report(name, "param_writes", (double) params.writes);
+        report(name, "param_updates", (double) params.updates);
+        report(name, "pause_resumes", (double) run.pauseResumes);
+        report(name, "stop_alls", (double) run.stopAlls);
+        report(name, "preloads", (double) run.preloads);
+        report(name, "bus_changes", (double) run.busChanges);
+        report(name, "commands_queued", (double) commands.queued);
+        report(name, "commands_failed", (double) commandsFailed);
+        report(name, "commands_stale", (double) commandsStale);
+        report(name, "commands_dropped", (double) commands.dropped);
+        report(name, "voices_stolen", (double) voices.stolen);
+        report(name, "voices_culled", (double) voices.culled);
+        report(name, "players_created", (double) backendStats.created);
+        report(name, "players_failed", (double) backendStats.failed);
+        report(name, "callbacks", (double) backendStats.callbacks);
+        report(name, "reclaimed", (double) reclaim.reclaimed);
+        report(name, "reclaim_mean_us", reclaim.reclaimed > 0 ? reclaim.totalLatencyNs / 1e3 / reclaim.reclaimed : 0.0);
+        report(name, "reclaim_max_us", reclaim.maxLatencyNs / 1e3);
+        reportLatency(name, "caller", run.callerLatency.snapshot());
+        for (int stage = 0; stage < AudioEngine::LATENCY_COUNT; ++stage)
+        {
+            reportLatency(name, LATENCY_NAMES[stage], engine->getLatencyStats((AudioEngine::LatencyStage) stage));
+        }
+        report(name, "live_voices", (double) (voices.real + voices.virtuals));
+        report(name, "leaked_players", (double) leakedPlayers);
+        report(name, "leaked_fds", (double) leakedFds);
+        report(name, "leaked_listeners", (double) leakedListeners);
+
+        const bool ret = settled && leakedPlayers == 0 && leakedFds == 0 && leakedListeners == 0 && failureRate <= scenario.maxFailureRate;
+        printf("%s\tresult\t%s\n", name.c_str(), ret ? "PASS" : "FAIL");
+        fflush(stdout);
+        AudioEngine::destroy();
+        return ret;
+    }
+
+    void usage() noexcept
+    {
+        fprintf(stderr,
+                "usage: audiostress [options] <scenario>...\n"
+                "  --assets <dir>         directory of the assets, the missing ones are generated (a temporary directory)\n"
+                "  --duration-ms <ms>     of every scenario instead of its own, e.g. for a soak\n");
+    }
+
+    bool parseOptions(const int argc, char **argv, Options &options) noexcept
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--assets" && hasValue)
+            {
+                options.assets = argv[++i];
+            }
+            else if (arg == "--duration-ms" && hasValue)
+            {
+                options.durationMs = atoi(argv[++i]);
+                if (options.durationMs <= 0)
+                {
+                    return false;
+                }
+            }
+            else if (arg.compare(0, 2, "--") == 0)
+            {
+                return false;
+            }
+            else
+            {
+                options.scenarios.push_back(arg);
+            }
+        }
+        return !options.scenarios.empty();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage();
+        return 2;
+    }
+    std::vector<StressScenario> scenarios(options.scenarios.size());
+    for (size_t i = 0; i < scenarios.size(); ++i)
+    {
+        if (!scenarios[i].load(options.scenarios[i]))
+        {
+            return 2;
+        }
+        if (options.durationMs > 0)
+        {
+            scenarios[i].durationMs = options.durationMs;
+        }
+    }
+    if (options.assets.empty())
+    {
+        char directory[] = "/tmp/audiostressXXXXXX";
+        if (mkdtemp(directory) == nullptr)
+        {
+            perror("mkdtemp");
+            return 1;
+        }
+        options.assets = directory;
+    }
+    mkdir(options.assets.c_str(), 0755);
+
+    int ret = checkHandles() ? 0 : 1;
+    for (const StressScenario &scenario : scenarios)
+    {
+        if (!runScenario(scenario, options.assets))
+        {
+            ret = 1;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,236 @@
+#include "StressScenario.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace audio;
+
+namespace
+{
+    std::string trim(const std::string &value) noexcept
+    {
+        const size_t first = value.find_first_not_of(" \t\r");
+        if (first == std::string::npos)
+        {
+            return "";
+        }
+        return value.substr(first, value.find_last_not_of(" \t\r") - first + 1);
+    }
+
+    bool parseDouble(const std::string &value, double &out) noexcept
+    {
+        char *end = nullptr;
+        out = strtod(value.c_str(), &end);
+        return end != value.c_str() && *end == '\0' && out >= 0.0;
+    }
+
+    bool parseInt(const std::string &value, int &out) noexcept
+    {
+        char *end = nullptr;
+        const long parsed = strtol(value.c_str(), &end, 10);
+        out = (int) parsed;
+        return end != value.c_str() && *end == '\0' && parsed >= 0;
+    }
+
+    bool parseSize(const std::string &value, size_t &out) noexcept
+    {
+        int parsed = 0;
+        const bool ret = parseInt(value, parsed);
+        out = (size_t) parsed;
+        return ret;
+    }
+
+    bool parseBool(const std::string &value, bool &out) noexcept
+    {
+        out = value == "on" || value == "true";
+        return out || value == "off" || value == "false";
+    }
+
+    bool parseRatio(const std::string &value, double &out) noexcept
+    {
+        return parseDouble(value, out) && out <= 1.0;
+    }
+}
+
+/**
+ * Fill the scenario from a file, the keys it doesn't set keep their defaults
+ * Report the first bad line on stderr and return false
+ */
+bool StressScenario::load(const std::string &path) noexcept
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        fprintf(stderr, "%s: can't open\n", path.c_str());
+        return false;
+    }
+    const size_t slash = path.find_last_of('/');
+    name = path.substr(slash == std::string::npos ? 0 : slash + 1);
+    name = name.substr(0, name.find('.'));
+
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line))
+    {
+        ++number;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
+        {
+            continue;
+        }
+        const size_t equal = line.find('=');
+        if (equal == std::string::npos)
+        {
+            fprintf(stderr, "%s:%d: expected key = value\n", path.c_str(), number);
+            return false;
+        }
+        const std::string key = trim(line.substr(0, equal));
+        const std::string value = trim(line.substr(equal + 1));
+        bool valid = false;
+        if (key == "name")
+        {
+            name = value;
+            valid = !value.empty();
+        }
+        else if (key == "duration_ms")
+        {
+            valid = parseInt(value, durationMs) && durationMs > 0;
+        }
+        else if (key == "threads")
+        {
+            valid = parseInt(value, threads) && threads > 0;
+        }
+        else if (key == "trigger_rate")
+        {
+            valid = parseDouble(value, triggerRate);
+        }
+        else if (key == "max_voices")
+        {
+            valid = parseSize(value, maxVoices) && maxVoices > 0;
+        }
+        else if (key == "lifetime_ms")
+        {
+            valid = parseInt(value, lifetimeMs);
+        }
+        else if (key == "loop_ratio")
+        {
+            valid = parseRatio(value, loopRatio);
+        }
+        else if (key == "max_priority")
+        {
+            valid = parseInt(value, maxPriority);
+        }
+        else if (key == "pick")
+        {
+            cycleAssets = value == "cycle";
+            valid = cycleAssets || value == "random";
+        }
+        else if (key == "volume_rate")
+        {
+            valid = parseDouble(value, volumeRate);
+        }
+        else if (key == "pause_resume_rate")
+        {
+            valid = parseDouble(value, pauseResumeRate);
+        }
+        else if (key == "pause_ms")
+        {
+            valid = parseInt(value, pauseMs);
+        }
+        else if (key == "stop_all_rate")
+        {
+            valid = parseDouble(value, stopAllRate);
+        }
+        else if (key == "preload_rate")
+        {
+            valid = parseDouble(value, preloadRate);
+        }
+        else if (key == "bus_rate")
+        {
+            valid = parseDouble(value, busRate);
+        }
+        else if (key == "max_real_voices")
+        {
+            valid = parseSize(value, maxRealVoices);
+        }
+        else if (key == "player_pool_size")
+        {
+            valid = parseSize(value, playerPoolSize);
+        }
+        else if (key == "command_thread")
+        {
+            valid = parseBool(value, commandThread);
+        }
+        else if (key == "mixer")
+        {
+            valid = parseBool(value, mixer);
+        }
+        else if (key == "max_failure_rate")
+        {
+            valid = parseRatio(value, maxFailureRate);
+        }
+        else if (key == "tick_ms")
+        {
+            valid = parseInt(value, backend.tickMs) && backend.tickMs > 0;
+        }
+        else if (key == "max_tracks")
+        {
+            valid = parseInt(value, backend.maxTracks);
+        }
+        else if (key == "create_latency_us")
+        {
+            valid = parseInt(value, backend.createLatencyUs);
+        }
+        else if (key == "realize_latency_us")
+        {
+            valid = parseInt(value, backend.realizeLatencyUs);
+        }
+        else if (key == "prefetch_latency_ms")
+        {
+            valid = parseInt(value, backend.prefetchLatencyMs);
+        }
+        else if (key == "start_latency_ms")
+        {
+            valid = parseInt(value, backend.startLatencyMs);
+        }
+        else if (key == "create_failure_rate")
+        {
+            valid = parseRatio(value, backend.createFailureRate);
+        }
+        else if (key == "realize_failure_rate")
+        {
+            valid = parseRatio(value, backend.realizeFailureRate);
+        }
+        else if (key == "seed")
+        {
+            int seed = 0;
+            valid = parseInt(value, seed) && seed > 0;
+            backend.seed = (uint32_t) seed;
+        }
+        else if (key == "asset")
+        {
+            // asset = <path> <seconds>
+            std::istringstream fields(value);
+            Asset asset;
+            valid = (bool) (fields >> asset.path >> asset.seconds) && asset.seconds > 0.0;
+            assets.push_back(asset);
+        }
+        else
+        {
+            fprintf(stderr, "%s:%d: unknown key %s\n", path.c_str(), number, key.c_str());
+            return false;
+        }
+        if (!valid)
+        {
+            fprintf(stderr, "%s:%d: bad value for %s\n", path.c_str(), number, key.c_str());
+            return false;
+        }
+    }
+    if (assets.empty())
+    {
+        fprintf(stderr, "%s: no asset\n", path.c_str());
+        return false;
+    }
+    return true;
+}
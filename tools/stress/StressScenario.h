@@ -0,0 +1,53 @@
+#ifndef __StressScenario__
+#define __StressScenario__
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "AudioEngine.h"
+#include "AudioHostBackend.h"
+#include "AudioPlayerPool.h"
+
+namespace audio
+{
+    /**
+     * Load of a stress run, read from a scenario file of "key = value" lines, '#' starts a comment
+     * The rates are per second, those of the sounds and their volumes per trigger thread, the storms for the whole engine
+     * See tools/stress/scenarios/ for the keys in use
+     */
+    struct StressScenario
+    {
+        struct Asset
+        {
+            std::string path; // relative to the assets directory
+            double seconds; // of the generated file, a .wav holds a tone and anything else plays as silence
+        };
+
+        std::string name;
+        int durationMs = 10000;
+        int threads = 1; // concurrent trigger threads
+        double triggerRate = 10.0;
+        size_t maxVoices = 16; // per thread, its oldest voice is stopped to make room
+        int lifetimeMs = 0; // after which a voice is stopped, 0 lets it end by itself or by maxVoices if it loops
+        double loopRatio = 0.0;
+        int maxPriority = 0; // each sound draws its priority in [0, maxPriority]
+        bool cycleAssets = false; // play the assets in turn instead of drawing them
+        double volumeRate = 0.0; // volume change of a live voice
+        double pauseResumeRate = 0.0; // pauseAll then resumeAll pauseMs later
+        int pauseMs = 50;
+        double stopAllRate = 0.0;
+        double preloadRate = 0.0; // batches of every asset, each with its listener
+        double busRate = 0.0; // duck or pause of one of the buses of the sounds, undone pauseMs later
+        size_t maxRealVoices = AudioEngine::DEFAULT_MAX_REAL_VOICES;
+        size_t playerPoolSize = AudioPlayerPool::DEFAULT_CAPACITY;
+        bool commandThread = true; // off runs the creations and the plays on the trigger threads
+        bool mixer = false;
+        double maxFailureRate = 0.0; // of the triggers, above it the run fails
+        AudioHostBackend::Config backend;
+        std::vector<Asset> assets;
+
+        bool load(const std::string &path) noexcept;
+    };
+}
+
+#endif